@@ -36,9 +36,12 @@ struct PC_MortonGlobal {
     uint64_t bvhTrianglesAddress;
     uint64_t bvhTriangleIndicesAddress;
     uint64_t auxBufferAddress;
+    // config::SpaceFilling, the 64 bit curves share the keyval with the cluster id in its clusterIdBits low bits
+    uint32_t spaceFilling;
+    uint32_t clusterIdBits;
 
 #ifndef INCLUDE_FROM_SHADER
-    static constexpr uint32_t SCALAR_SIZE { 56 };
+    static constexpr uint32_t SCALAR_SIZE { 64 };
 #endif
 };
 
@@ -58,9 +61,10 @@ struct PC_CopySortedNodeIds {
     uint64_t mortonAddress;
     uint64_t nodeIdAddress;
     uint32_t clusterCount;
+    uint32_t clusterIdMask;
 
 #ifndef INCLUDE_FROM_SHADER
-    static constexpr uint32_t SCALAR_SIZE { 20 };
+    static constexpr uint32_t SCALAR_SIZE { 24 };
 #endif
 };
 
@@ -0,0 +1,42 @@
+#ifndef HILBERT64_GLSL
+#define HILBERT64_GLSL 1
+
+#include "morton64.glsl"
+
+// Skilling's axes to transposed Hilbert index, same as backend/cpu/bvh/SpaceFilling.h
+uint64_t hilbertCode64(in uvec3 p)
+{
+    uint x[3] = uint[3](p.x, p.y, p.z);
+    for (uint m = 1u << 20; m > 1u; m >>= 1) {
+        const uint q = m - 1u;
+        for (int i = 0; i < 3; ++i) {
+            if ((x[i] & m) != 0u) {
+                x[0] ^= q;
+            } else {
+                const uint t = (x[0] ^ x[i]) & q;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // gray code
+    x[1] ^= x[0];
+    x[2] ^= x[1];
+    uint t = 0u;
+    for (uint m = 1u << 20; m > 1u; m >>= 1)
+        if ((x[2] & m) != 0u)
+            t ^= m - 1u;
+    x[0] ^= t;
+    x[1] ^= t;
+    x[2] ^= t;
+
+    return mortonCode64(uvec3(x[2], x[1], x[0]));
+}
+
+uint64_t hilbertCode64(in vec3 p)
+{
+    return hilbertCode64(uvec3(p * MORTON_SCALE_TO_U64));
+}
+
+#endif
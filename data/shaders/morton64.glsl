@@ -1,7 +1,7 @@
 #ifndef MORTON64_GLSL
 #define MORTON64_GLSL 1
 
-const uint MORTON_SCALE_TO_U64 = (1u << 20) - 1;
+const uint MORTON_SCALE_TO_U64 = (1u << 21) - 1;
 
 uint64_t mortonCode64_part(in uint a)
 {
@@ -0,0 +1,24 @@
+#ifndef SPACE_FILLING_GLSL
+#define SPACE_FILLING_GLSL 1
+
+#include "morton32.glsl"
+#include "morton64.glsl"
+#include "hilbert64.glsl"
+
+// config::SpaceFilling
+const uint32_t SFC_MORTON32 = 0;
+const uint32_t SFC_MORTON64 = 1;
+const uint32_t SFC_HILBERT64 = 2;
+
+// the 64 bit codes keep their 64 - clusterIdBits most significant bits, the cluster id fills the rest of the key
+Morton32KeyVal clusterKeyVal(in uint32_t sfc, in uint32_t clusterIdBits, in vec3 p, in uint32_t clusterId)
+{
+    if (sfc == SFC_MORTON32)
+        return Morton32KeyVal(clusterId, mortonCode32(p));
+
+    const uint64_t code = sfc == SFC_HILBERT64 ? hilbertCode64(p) : mortonCode64(p);
+    const uint64_t key = ((code << 1) & (~0UL << clusterIdBits)) | uint64_t(clusterId);
+    return Morton32KeyVal(uint32_t(key), uint32_t(key >> 32));
+}
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <vLime/types.h>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
+
+#if defined(__linux__)
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+// minimal single-threaded timing harness, all numbers are per core
+namespace bench {
+
+[[nodiscard]] inline u64 cycles()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// keeps the optimizer from discarding a computed value
+template<typename T>
+inline void doNotOptimize(T const& value)
+{
+#if defined(_MSC_VER)
+    static_cast<void>(*static_cast<T const volatile*>(&value));
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+struct Result {
+    f64 opsPerSecond { 0. };
+    f64 cyclesPerOp { 0. };
+};
+
+// calls f() until minSeconds elapse, each call performs opsPerCall operations
+//   cycles are reference (TSC) cycles, not core clock cycles
+template<typename F>
+Result run(std::string_view name, u64 opsPerCall, F&& f, f64 minSeconds = .25)
+{
+    using Clock = std::chrono::steady_clock;
+
+    f();
+    u64 calls { 0 };
+    auto const c0 { cycles() };
+    auto const t0 { Clock::now() };
+    f64 elapsed { 0. };
+    do {
+        f();
+        ++calls;
+        elapsed = std::chrono::duration<f64>(Clock::now() - t0).count();
+    } while (elapsed < minSeconds);
+    auto const c1 { cycles() };
+
+    auto const ops { static_cast<f64>(calls * opsPerCall) };
+    Result const r { ops / elapsed, static_cast<f64>(c1 - c0) / ops };
+    std::printf("%-40.*s %12.2f Mops/s %10.2f cycles/op\n", static_cast<int>(name.size()), name.data(), r.opsPerSecond * 1e-6, r.cyclesPerOp);
+    return r;
+}
+
+// L1D read and last level cache misses of the process, Linux perf events only
+//   counters are inherited by the threads created after Open(), i.e. the executor has to be created afterwards
+class CacheMisses {
+public:
+    struct Value {
+        u64 l1d { 0 };
+        u64 llc { 0 };
+    };
+
+    CacheMisses() = default;
+    CacheMisses(CacheMisses const&) = delete;
+    CacheMisses& operator=(CacheMisses const&) = delete;
+    ~CacheMisses()
+    {
+#if defined(__linux__)
+        for (auto const fd : { fdL1d, fdLlc })
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    // false if the counters are not available, e.g. with perf_event_paranoid > 2 or in a VM
+    bool Open()
+    {
+#if defined(__linux__)
+        fdL1d = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        fdLlc = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        return fdL1d >= 0 && fdLlc >= 0;
+#else
+        return false;
+#endif
+    }
+
+    void Start()
+    {
+#if defined(__linux__)
+        for (auto const fd : { fdL1d, fdLlc }) {
+            if (fd < 0)
+                continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    [[nodiscard]] Value Stop()
+    {
+        Value result;
+#if defined(__linux__)
+        for (auto const fd : { fdL1d, fdLlc })
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        result.l1d = read(fdL1d);
+        result.llc = read(fdLlc);
+#endif
+        return result;
+    }
+
+private:
+#if defined(__linux__)
+    int fdL1d { -1 };
+    int fdLlc { -1 };
+
+    static int open(u32 type, u64 config)
+    {
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static u64 read(int fd)
+    {
+        u64 value { 0 };
+        if (fd < 0 || ::read(fd, &value, sizeof(value)) != sizeof(value))
+            return 0;
+        return value;
+    }
+#endif
+};
+
+inline void section(std::string_view name)
+{
+    std::printf("\n-- %.*s\n", static_cast<int>(name.size()), name.data());
+}
+
+}
@@ -0,0 +1,76 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include <backend/cpu/bv/Dop14Soa.h>
+#include <random>
+#include <string>
+
+using namespace backend::cpu;
+
+namespace bench {
+
+void dop14()
+{
+    section(std::string("dop14 fit/merge, ") + simd::NAME);
+
+    constexpr u32 TRIANGLE_COUNT { 1 << 16 };
+    constexpr u32 VERTEX_COUNT { TRIANGLE_COUNT / 2 };
+
+    std::mt19937 rng { 7 };
+    std::uniform_real_distribution<f32> coord { -10.f, 10.f };
+    std::vector<glm::vec3> vertices(VERTEX_COUNT);
+    for (auto& v : vertices)
+        v = { coord(rng), coord(rng), coord(rng) };
+    std::vector<u32> indices(3 * TRIANGLE_COUNT);
+    for (auto& i : indices)
+        i = rng() % VERTEX_COUNT;
+
+    std::vector<bv::Dop14> aos(TRIANGLE_COUNT);
+    run("fit triangle (scalar)", TRIANGLE_COUNT, [&] {
+        for (u32 i = 0; i < TRIANGLE_COUNT; ++i)
+            aos[i] = bv::dopInit(vertices[indices[3 * i + 0]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]]);
+        doNotOptimize(aos.data());
+    });
+
+    bv::Dop14Soa a;
+    run("fit triangle (soa)", TRIANGLE_COUNT, [&] {
+        bv::dopFitTriangles(vertices, indices, a);
+        doNotOptimize(a.Slab(0));
+    });
+
+    std::vector<bv::Dop14> aosMerged(TRIANGLE_COUNT);
+    run("merge dop (scalar)", TRIANGLE_COUNT, [&] {
+        for (u32 i = 0; i < TRIANGLE_COUNT; ++i) {
+            aosMerged[i] = aos[i];
+            bv::bvFit(aosMerged[i], aos[TRIANGLE_COUNT - 1 - i]);
+        }
+        doNotOptimize(aosMerged.data());
+    });
+
+    bv::Dop14Soa b(TRIANGLE_COUNT);
+    for (u32 i = 0; i < TRIANGLE_COUNT; ++i)
+        b.Set(i, aos[TRIANGLE_COUNT - 1 - i]);
+    bv::Dop14Soa merged;
+    run("merge dop (soa)", TRIANGLE_COUNT, [&] {
+        bv::dopMerge(a, b, merged);
+        doNotOptimize(merged.Slab(0));
+    });
+
+    run("reduce dop (soa)", TRIANGLE_COUNT, [&] {
+        auto const dop { bv::dopReduce(a) };
+        doNotOptimize(dop);
+    });
+
+    std::vector<f32> area(TRIANGLE_COUNT);
+    run("area dop (scalar)", TRIANGLE_COUNT, [&] {
+        for (u32 i = 0; i < TRIANGLE_COUNT; ++i)
+            area[i] = bv::bvArea(aosMerged[i]);
+        doNotOptimize(area.data());
+    });
+    run("area dop (soa)", TRIANGLE_COUNT, [&] {
+        bv::dopArea(merged, area);
+        doNotOptimize(area.data());
+    });
+}
+
+}
@@ -0,0 +1,187 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include <backend/cpu/RadixSort.h>
+#include <backend/cpu/bvh/PLOCpp.h>
+#include <backend/cpu/bvh/Traversal.h>
+#include <data_plocpp.h>
+#include <scene/Scene.h>
+#include <random>
+
+using namespace backend;
+
+namespace bench {
+
+static constexpr u32 RAY_COUNT { 64 };
+// 48 to 128 B nodes and triangles, each set fits into L2
+static constexpr u32 NODE_COUNT { 1 << 11 };
+static constexpr u32 TRIANGLE_COUNT { 1 << 11 };
+static constexpr u32 KEY_COUNT { 1 << 20 };
+
+// origins around the unit cube, directions uniform on the sphere
+static std::vector<cpu::bvh::traversal::Ray> makeRays(std::mt19937& rng)
+{
+    std::uniform_real_distribution<f32> coord { -2.f, 2.f };
+    std::normal_distribution<f32> normal;
+    std::vector<cpu::bvh::traversal::Ray> rays;
+    rays.reserve(RAY_COUNT);
+    for (u32 i = 0; i < RAY_COUNT; ++i) {
+        auto const d { glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng))) };
+        rays.emplace_back(data_bvh::Ray { { coord(rng), coord(rng), coord(rng), 0.f }, { d.x, d.y, d.z, cpu::bvh::traversal::BIG_FLOAT } });
+    }
+    return rays;
+}
+
+// [lo, hi] pairs inside the unit cube
+static void randomSlabs(std::mt19937& rng, f32* bv, u32 pairCount)
+{
+    std::uniform_real_distribution<f32> coord { -1.f, 1.f };
+    for (u32 i = 0; i < pairCount; ++i) {
+        auto const a { coord(rng) };
+        auto const b { coord(rng) };
+        bv[2 * i] = std::min(a, b);
+        bv[2 * i + 1] = std::max(a, b);
+    }
+}
+
+// world -> unit cube matrices of a random rotation, scale and translation per child, column major
+static void randomObbs(std::mt19937& rng, f32* bv)
+{
+    std::uniform_real_distribution<f32> unit { -1.f, 1.f };
+    std::uniform_real_distribution<f32> scale { .1f, 1.f };
+    for (u32 child = 0; child < 2; ++child) {
+        auto const axis { glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.f, 0.f, 1e-3f)) };
+        auto const b0 { glm::normalize(glm::cross(axis, std::abs(axis.x) < .9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f))) };
+        auto const b1 { glm::cross(axis, b0) };
+        glm::vec3 const s { scale(rng), scale(rng), scale(rng) };
+        glm::vec3 const t { unit(rng), unit(rng), unit(rng) };
+        auto* m { bv + 12 * child };
+        for (u32 row = 0; row < 3; ++row) {
+            auto const b { row == 0 ? b0 : row == 1 ? b1 : axis };
+            for (u32 col = 0; col < 3; ++col)
+                m[3 * col + row] = b[col] / s[row];
+            m[9 + row] = -glm::dot(b, t) / s[row];
+        }
+    }
+}
+
+// the per ray test objects are built outside of the timed loop, once per ray as in the traversal
+template<typename Node, typename Test, typename Apply>
+static void pairTest(std::string_view name, std::vector<Node> const& nodes, std::vector<Test> const& tests, Apply apply)
+{
+    run(name, static_cast<u64>(tests.size()) * nodes.size(), [&] {
+        u32 hits { 0 };
+        for (auto const& test : tests)
+            for (auto const& node : nodes)
+                hits += apply(test, node).Hits();
+        doNotOptimize(hits);
+    });
+}
+
+static void slabTests(std::mt19937& rng, std::vector<cpu::bvh::traversal::Ray> const& rays)
+{
+    using namespace cpu::bvh::traversal;
+
+    std::vector<data_bvh::NodeBvhBinaryCompressed> aabbs(NODE_COUNT);
+    for (auto& node : aabbs)
+        randomSlabs(rng, node.bv, 6);
+    std::vector<AabbPairTest> aabbTests;
+    for (auto const& ray : rays)
+        aabbTests.emplace_back(ray);
+    pairTest("ray-aabb pair", aabbs, aabbTests, [](AabbPairTest const& test, auto const& node) { return test(node, BIG_FLOAT); });
+
+    // all 7 slabs are tested only if both children pass the first 3
+    std::vector<data_bvh::NodeBvhBinaryDOP14Compressed> dops(NODE_COUNT);
+    for (auto& node : dops)
+        randomSlabs(rng, node.bv, 14);
+    std::vector<RayDop14> raysDop;
+    raysDop.reserve(rays.size());
+    std::vector<Dop14PairTest> dopTests;
+    for (auto const& ray : rays)
+        dopTests.emplace_back(ray, raysDop.emplace_back(ray));
+    Counters counters;
+    pairTest("ray-dop14 pair", dops, dopTests, [&counters](Dop14PairTest const& test, auto const& node) { return test(node, BIG_FLOAT, counters); });
+
+    std::vector<data_bvh::NodeBvhBinaryOBBCompressed> obbs(NODE_COUNT);
+    for (auto& node : obbs)
+        randomObbs(rng, node.bv);
+    std::vector<ObbPairTest> obbTests;
+    for (auto const& ray : rays)
+        obbTests.emplace_back(ray);
+    pairTest("ray-obb pair", obbs, obbTests, [](ObbPairTest const& test, auto const& node) { return test(node, BIG_FLOAT); });
+}
+
+// woopified as PLOC++ stores them, small triangles spread over the unit cube
+static void triangleTest(std::mt19937& rng, std::vector<cpu::bvh::traversal::Ray> const& rays, Executor& executor)
+{
+    std::uniform_real_distribution<f32> coord { -1.f, 1.f };
+    std::uniform_real_distribution<f32> offset { -.2f, .2f };
+    Scene scene;
+    auto& g { scene.geometries.emplace_back() };
+    for (u32 i = 0; i < TRIANGLE_COUNT; ++i) {
+        glm::vec3 const center { coord(rng), coord(rng), coord(rng) };
+        for (u32 v = 0; v < 3; ++v) {
+            g.indices.push_back(static_cast<u32>(g.vertices.size()));
+            scene.aabb.Fit(g.vertices.emplace_back(center + glm::vec3(offset(rng), offset(rng), offset(rng))));
+        }
+    }
+    scene.triangleCount = TRIANGLE_COUNT;
+
+    config::PLOC plocConfig;
+    plocConfig.bv = config::BV::eAABB;
+    cpu::bvh::PLOCpp plocpp { executor };
+    static_cast<void>(plocpp.NeedsRecompute(plocConfig));
+    plocpp.Compute(scene);
+    auto const& triangles { plocpp.GetBVH().triangles };
+
+    run("ray-triangle", static_cast<u64>(rays.size()) * triangles.size(), [&] {
+        u32 hits { 0 };
+        for (auto const& ray : rays) {
+            auto result { cpu::bvh::traversal::missResult(ray) };
+            for (auto const& tri : triangles) {
+                result.t = ray.tmax;
+                hits += cpu::bvh::traversal::intersectTriangle(tri, ray, result);
+            }
+        }
+        doNotOptimize(hits);
+    });
+}
+
+// every call sorts a fresh copy of the unsorted keys, the copy is included
+static void radixSortTest(std::mt19937& rng, Executor& executor)
+{
+    std::vector<data_plocpp::Morton32KeyVal> keyvals(KEY_COUNT);
+    for (u32 i = 0; i < KEY_COUNT; ++i)
+        keyvals[i] = { i, static_cast<u32>(rng()) & 0x3FFFFFFFu };
+    std::vector<data_plocpp::Morton32KeyVal> sortedKeyvals;
+    run("radix sort 32 bit keyval", KEY_COUNT, [&] {
+        sortedKeyvals = keyvals;
+        cpu::radixSort<32>(executor, sortedKeyvals, [](data_plocpp::Morton32KeyVal const& kv) { return kv.mortonCode; });
+        doNotOptimize(sortedKeyvals.data());
+    });
+
+    std::vector<u64> keys(KEY_COUNT);
+    for (auto& key : keys)
+        key = static_cast<u64>(rng()) << 32 | rng();
+    std::vector<u64> sortedKeys;
+    run("radix sort 64 bit key", KEY_COUNT, [&] {
+        sortedKeys = keys;
+        cpu::radixSort<64>(executor, sortedKeys, [](u64 key) { return key; });
+        doNotOptimize(sortedKeys.data());
+    });
+}
+
+void kernels()
+{
+    section("ray and BV kernels, radix sort, 1 thread");
+
+    Executor executor { 1 };
+    std::mt19937 rng { 11 };
+    auto const rays { makeRays(rng) };
+
+    slabTests(rng, rays);
+    triangleTest(rng, rays, executor);
+    radixSortTest(rng, executor);
+}
+
+}
@@ -0,0 +1,92 @@
+#include "Bench.h"
+#include "Scenes.h"
+#include "Suites.h"
+
+#include <backend/cpu/RadixSort.h>
+#include <backend/cpu/bvh/PLOCpp.h>
+#include <backend/cpu/bvh/SpaceFilling.h>
+#include <data_plocpp.h>
+#include <algorithm>
+#include <string>
+
+using namespace backend;
+
+namespace bench {
+
+static char const* to_string(config::BV bv)
+{
+    switch (bv) {
+    case config::BV::eAABB:
+        return "aabb";
+    case config::BV::eDOP14:
+        return "dop14";
+    case config::BV::eOBB:
+        return "obb (dito14 points)";
+    case config::BV::eNone:
+        break;
+    }
+    return "none";
+}
+
+// the first merge iteration on 1 thread over a contiguous range of the leaves in Morton order, ops are input clusters
+//   the range keeps a call of the DiTO14 points BV below seconds, every call restores the clusters, the merged nodes are overwritten in place
+void plocpp(std::string_view scenePath)
+{
+    constexpr u32 RADIUS { 16 };
+    constexpr u32 MAX_CLUSTER_COUNT { 1 << 17 };
+
+    Executor executor;
+    auto const scene { loadScene(scenePath, executor) };
+    if (scene.triangleCount == 0) {
+        std::printf("plocpp: can't load '%.*s'\n", static_cast<int>(scenePath.size()), scenePath.data());
+        return;
+    }
+
+    // the same initial clusters as PLOCpp::Compute, leaves [0, N) are in scene triangle order
+    auto const centroids { makeCentroids(scene) };
+    auto const n { static_cast<u32>(centroids.size()) };
+    std::vector<data_plocpp::Morton32KeyVal> keyvals(n);
+    for (u32 i = 0; i < n; ++i)
+        keyvals[i] = { i, cpu::bvh::mortonCode32(centroids[i]) };
+    cpu::radixSort<32>(executor, keyvals, [](data_plocpp::Morton32KeyVal const& kv) { return kv.mortonCode; });
+    auto const clusterCount { std::min(n, MAX_CLUSTER_COUNT) };
+    auto const first { (n - clusterCount) / 2 };
+    std::vector<u32> sorted(clusterCount);
+    for (u32 i = 0; i < clusterCount; ++i)
+        sorted[i] = keyvals[first + i].key;
+
+    section(std::string("PLOC++ merge iteration, ") + std::to_string(clusterCount) + " of " + std::to_string(n) + " clusters, radius " + std::to_string(RADIUS) + ", 1 thread");
+
+    Executor single { 1 };
+    cpu::bvh::PLOCpp builder { executor };
+    cpu::bvh::PLOCpp::MergeBuffers buffers;
+    std::vector<u32> clusters;
+    for (auto const bv : { config::BV::eAABB, config::BV::eDOP14, config::BV::eOBB }) {
+        config::PLOC plocConfig;
+        plocConfig.bv = bv;
+        static_cast<void>(builder.NeedsRecompute(plocConfig));
+        builder.Compute(scene);
+        auto bvh { builder.GetBVH() };
+
+        u32 merged { 0 };
+        auto const iteration { [&] {
+            clusters = sorted;
+            switch (bv) {
+            case config::BV::eAABB:
+                merged = cpu::bvh::PLOCpp::MergeIteration<config::BV::eAABB>(single, bvh, RADIUS, clusters, buffers, n);
+                break;
+            case config::BV::eDOP14:
+                merged = cpu::bvh::PLOCpp::MergeIteration<config::BV::eDOP14>(single, bvh, RADIUS, clusters, buffers, n);
+                break;
+            default:
+                merged = cpu::bvh::PLOCpp::MergeIteration<config::BV::eOBB>(single, bvh, RADIUS, clusters, buffers, n);
+                break;
+            }
+            doNotOptimize(clusters.data());
+        } };
+        run(to_string(bv), clusterCount, iteration);
+        std::printf("%-40s %12.2f %%\n", "  merged clusters", 200. * merged / clusterCount);
+    }
+}
+
+}
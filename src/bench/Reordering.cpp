@@ -0,0 +1,117 @@
+#include "Bench.h"
+#include "Scenes.h"
+#include "Suites.h"
+
+#include <backend/cpu/Builder.h>
+#include <backend/cpu/bvh/Tracer.h>
+#include <limits>
+#include <string>
+
+using namespace backend;
+
+namespace bench {
+
+static char const* to_string(config::NodeOrder order)
+{
+    switch (order) {
+    case config::NodeOrder::eNone:
+        return "compressed";
+    case config::NodeOrder::eDFS:
+        return "dfs";
+    case config::NodeOrder::eTreeletBFS:
+        return "treelet";
+    case config::NodeOrder::eVanEmdeBoas:
+        return "veb";
+    }
+    return "unknown";
+}
+
+// the same rays through every node order of each layout, all threads, best of REPETITIONS runs
+//   the cache misses are the mean of the runs, per ray
+void reordering(std::string_view scenePath)
+{
+    constexpr u32 RAY_COUNT { 1 << 19 };
+    constexpr u32 REPETITIONS { 3 };
+
+    // before the executor, its workers inherit the counters
+    CacheMisses misses;
+    auto const countMisses { misses.Open() };
+
+    Executor executor;
+    auto const scene { loadScene(scenePath, executor) };
+    if (scene.triangleCount == 0) {
+        std::printf("reorder: can't load '%.*s'\n", static_cast<int>(scenePath.size()), scenePath.data());
+        return;
+    }
+    section(std::string("node order, ") + std::to_string(scene.triangleCount) + " triangles, " + std::to_string(executor.num_workers()) + " threads"
+        + (countMisses ? "" : ", no perf counters"));
+
+    struct Layout {
+        char const* name;
+        config::BV bv;
+        config::CompressedLayout layout;
+    };
+    static constexpr Layout LAYOUTS[] {
+        { "aabb", config::BV::eAABB, config::CompressedLayout::eBinaryStandard },
+        { "aabb q8", config::BV::eAABB, config::CompressedLayout::eBinaryQuantized8 },
+        { "aabb wide8", config::BV::eAABB, config::CompressedLayout::eWide8 },
+        { "dop14", config::BV::eDOP14, config::CompressedLayout::eBinaryStandard },
+        { "dop14 split", config::BV::eDOP14, config::CompressedLayout::eBinaryDOP14Split },
+    };
+    static constexpr config::NodeOrder ORDERS[] { config::NodeOrder::eNone, config::NodeOrder::eDFS, config::NodeOrder::eTreeletBFS, config::NodeOrder::eVanEmdeBoas };
+
+    std::vector<data_bvh::Ray> const rays[] { makeRays(scene, true, RAY_COUNT), makeRays(scene, false, RAY_COUNT) };
+    std::vector<data_bvh::RayTraceResult> results(RAY_COUNT);
+    std::vector<data_bvh::RayTraceResult> reference[2];
+
+    cpu::Builder builder { executor };
+    cpu::bvh::Tracer tracer { executor };
+    for (auto const& l : LAYOUTS) {
+        for (auto const order : ORDERS) {
+            auto pipeline { makePipeline(l.bv, l.layout) };
+            pipeline.reordering.order = order;
+            builder.SetPipelineConfiguration(pipeline);
+            builder.Build(scene);
+            if (builder.Failed()) {
+                std::printf("%-40s %12s\n", l.name, "build failed");
+                break;
+            }
+            auto const& bvh { builder.GetBVH() };
+
+            for (u32 r = 0; r < 2; ++r) {
+                static_cast<void>(tracer.TraceRays(bvh, rays[r], results));
+
+                f32 timeMs { std::numeric_limits<f32>::max() };
+                CacheMisses::Value missSum;
+                for (u32 i = 0; i < REPETITIONS; ++i) {
+                    misses.Start();
+                    auto const s { tracer.TraceRays(bvh, rays[r], results) };
+                    auto const m { misses.Stop() };
+                    timeMs = std::min(timeMs, s.traceTimeMs);
+                    missSum.l1d += m.l1d;
+                    missSum.llc += m.llc;
+                }
+
+                // the node order must not change a single hit
+                u32 mismatches { 0 };
+                if (order == config::NodeOrder::eNone)
+                    reference[r] = results;
+                else
+                    for (u32 i = 0; i < RAY_COUNT; ++i)
+                        if (results[i].t != reference[r][i].t || results[i].primitiveId != reference[r][i].primitiveId)
+                            ++mismatches;
+
+                auto const name { std::string(l.name) + ", " + to_string(order) + (r == 0 ? ", coherent" : ", incoherent") };
+                auto const perRay { [&](u64 count) { return static_cast<f64>(count) / (static_cast<f64>(REPETITIONS) * RAY_COUNT); } };
+                std::printf("%-40s %10.2f ms %8.2f MRays/s", name.c_str(), timeMs, RAY_COUNT * 1e-3 / timeMs);
+                if (countMisses)
+                    std::printf(" %8.2f L1D/ray %8.2f LLC/ray", perRay(missSum.l1d), perRay(missSum.llc));
+                if (mismatches > 0)
+                    std::printf(" %u hits differ", mismatches);
+                std::printf("\n");
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,122 @@
+#include "Scenes.h"
+
+#include <backend/cpu/bvh/Traversal.h>
+#include <scene/Serialization.h>
+#include <cmath>
+#include <filesystem>
+#include <numbers>
+#include <random>
+
+using namespace backend;
+
+namespace bench {
+
+static Scene makeHeightField()
+{
+    constexpr u32 N { 725 };
+    constexpr f32 CELL { 1.f };
+
+    Scene scene;
+    auto& g { scene.geometries.emplace_back() };
+    g.id = 0;
+    g.name = "height field";
+    std::mt19937 rng { 3 };
+    std::uniform_real_distribution<f32> noise { -.5f, .5f };
+    for (u32 y = 0; y < N; ++y) {
+        for (u32 x = 0; x < N; ++x) {
+            auto const fx { static_cast<f32>(x) };
+            auto const fy { static_cast<f32>(y) };
+            glm::vec3 const v { fx * CELL, fy * CELL, 40.f * std::sin(fx * .013f) * std::cos(fy * .021f) + 8.f * std::sin(fx * .11f + fy * .07f) + noise(rng) };
+            g.vertices.push_back(v);
+            g.aabb.Fit(v);
+        }
+    }
+    for (u32 y = 0; y + 1 < N; ++y) {
+        for (u32 x = 0; x + 1 < N; ++x) {
+            auto const i { y * N + x };
+            g.indices.insert(g.indices.end(), { i, i + 1, i + N, i + 1, i + N + 1, i + N });
+        }
+    }
+    scene.aabb = g.aabb;
+    scene.triangleCount = static_cast<u32>(g.indices.size() / 3);
+    return scene;
+}
+
+std::vector<glm::vec3> makeCentroids(Scene const& scene)
+{
+    auto const cubedAabb { scene.aabb.GetCubed() };
+    auto const scale { 1.f / (cubedAabb.max - cubedAabb.min).x };
+
+    std::vector<glm::vec3> centroids;
+    centroids.reserve(scene.triangleCount);
+    for (auto const& g : scene.geometries) {
+        auto const vertices { g.Vertices() };
+        auto const indices { g.Indices() };
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            auto const& v0 { vertices[indices[i + 0]] };
+            auto const& v1 { vertices[indices[i + 1]] };
+            auto const& v2 { vertices[indices[i + 2]] };
+            auto const centroid { .5f * (glm::min(v0, glm::min(v1, v2)) + glm::max(v0, glm::max(v1, v2))) };
+            centroids.push_back((centroid - cubedAabb.min) * scale);
+        }
+    }
+    return centroids;
+}
+
+std::vector<data_bvh::Ray> makeRays(Scene const& scene, bool coherent, u32 rayCount)
+{
+    std::vector<data_bvh::Ray> rays(rayCount);
+    auto const extent { scene.aabb.max - scene.aabb.min };
+    auto const center { scene.aabb.Centroid() };
+    std::mt19937 rng { 5 };
+    std::uniform_real_distribution<f32> uniform { 0.f, 1.f };
+
+    if (coherent) {
+        auto const origin { scene.aabb.min - .2f * extent + glm::vec3(0.f, 0.f, .8f * glm::length(extent)) };
+        auto const forward { glm::normalize(center - origin) };
+        auto const right { glm::normalize(glm::cross(forward, glm::vec3(0.f, 0.f, 1.f))) };
+        auto const up { glm::cross(right, forward) };
+        constexpr u32 WIDTH { 1024 };
+        auto const height { rayCount / WIDTH };
+        for (u32 i = 0; i < rayCount; ++i) {
+            auto const u { (static_cast<f32>(i % WIDTH) + .5f) / WIDTH * 2.f - 1.f };
+            auto const v { (static_cast<f32>(i / WIDTH) + .5f) / static_cast<f32>(height) * 2.f - 1.f };
+            auto const d { glm::normalize(forward + .6f * u * right + .3f * v * up) };
+            rays[i] = { { origin.x, origin.y, origin.z, 0.f }, { d.x, d.y, d.z, cpu::bvh::traversal::BIG_FLOAT } };
+        }
+    } else {
+        for (auto& r : rays) {
+            auto const o { scene.aabb.min + glm::vec3(uniform(rng), uniform(rng), uniform(rng)) * extent };
+            auto const z { 2.f * uniform(rng) - 1.f };
+            auto const phi { 2.f * std::numbers::pi_v<f32> * uniform(rng) };
+            auto const s { std::sqrt(1.f - z * z) };
+            r = { { o.x, o.y, o.z, 0.f }, { s * std::cos(phi), s * std::sin(phi), z, cpu::bvh::traversal::BIG_FLOAT } };
+        }
+    }
+    return rays;
+}
+
+config::BVHPipeline makePipeline(config::BV bv, config::CompressedLayout layout)
+{
+    // OBBs are transformed from the collapsed AABB BVH, as "->OBB" of benchmark.toml
+    auto const buildBv { bv == config::BV::eOBB ? config::BV::eAABB : bv };
+    config::BVHPipeline p;
+    p.plocpp.bv = buildBv;
+    p.collapsing.bv = buildBv;
+    p.collapsing.c_t = bv == config::BV::eAABB ? 3.f : 4.5f;
+    if (bv == config::BV::eOBB)
+        p.transformation.bv = bv;
+    p.compression.bv = bv;
+    p.compression.layout = layout;
+    p.tracer.bv = bv;
+    return p;
+}
+
+Scene loadScene(std::string_view scenePath, Executor& executor)
+{
+    if (scenePath.empty())
+        return makeHeightField();
+    return scene::deserialize(std::filesystem::path(scenePath), executor);
+}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <backend/Config.h>
+#include <core/Taskflow.h>
+#include <data_bvh.h>
+#include <scene/Scene.h>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+// '*.ob' scene, a generated height field of about 1M triangles if scenePath is empty
+//   an empty scene (triangleCount == 0) if the file can't be loaded
+Scene loadScene(std::string_view scenePath, Executor& executor);
+
+// triangle AABB centroids normalized to the cubed scene AABB, as in the initial clusters of PLOC++, in PLOC++ leaf order
+std::vector<glm::vec3> makeCentroids(Scene const& scene);
+
+// coherent: pinhole camera looking at the scene center from above one corner, scanline order
+//   incoherent: random origins inside the scene AABB, uniform directions
+std::vector<data_bvh::Ray> makeRays(Scene const& scene, bool coherent, u32 rayCount);
+
+// PLOC++, collapsing and compression of one BV into a traced layout
+backend::config::BVHPipeline makePipeline(backend::config::BV bv, backend::config::CompressedLayout layout);
+
+}
@@ -0,0 +1,112 @@
+#include "Bench.h"
+#include "Scenes.h"
+#include "Suites.h"
+
+#include <backend/cpu/Builder.h>
+#include <backend/cpu/RadixSort.h>
+#include <backend/cpu/bvh/SpaceFilling.h>
+#include <data_plocpp.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+
+using namespace backend;
+
+namespace bench {
+
+static char const* to_string(config::SpaceFilling sfc)
+{
+    switch (sfc) {
+    case config::SpaceFilling::eMorton32:
+        return "morton32";
+    case config::SpaceFilling::eMorton64:
+        return "morton64";
+    case config::SpaceFilling::eHilbert64:
+        return "hilbert64";
+    }
+    return "unknown";
+}
+
+// per curve: single thread encoding, then encode and sort time on all threads (best of REPETITIONS runs),
+//   clusters sharing their sort code with the previous one, and the SAH cost of the PLOC++ and collapsed AABB BVH
+void spaceFilling(std::string_view scenePath)
+{
+    constexpr u32 REPETITIONS { 3 };
+    constexpr size_t CHUNK_SIZE { 1 << 14 };
+
+    Executor executor;
+    auto const scene { loadScene(scenePath, executor) };
+    if (scene.triangleCount == 0) {
+        std::printf("sfc: can't load '%.*s'\n", static_cast<int>(scenePath.size()), scenePath.data());
+        return;
+    }
+    auto const centroids { makeCentroids(scene) };
+    auto const n { static_cast<u32>(centroids.size()) };
+    auto const idBits { cpu::bvh::clusterIdBits(n) };
+
+    section(std::string("space filling curves, ") + std::to_string(n) + " triangles, " + std::to_string(executor.num_workers()) + " threads, "
+        + std::to_string(64 - idBits) + " of 63 code bits in the 64 bit keys");
+
+    std::vector<u64> keys(n);
+    std::vector<data_plocpp::Morton32KeyVal> keyvals(n);
+    auto const batch { std::min(n, 1u << 12) };
+    run("morton32 encode", batch, [&] {
+        for (u32 i = 0; i < batch; ++i)
+            keyvals[i] = { i, cpu::bvh::mortonCode32(centroids[i]) };
+        doNotOptimize(keyvals.data());
+    });
+    for (auto const sfc : { config::SpaceFilling::eMorton64, config::SpaceFilling::eHilbert64 }) {
+        run(std::string(to_string(sfc)) + " encode (scalar)", batch, [&] {
+            for (u32 i = 0; i < batch; ++i)
+                keys[i] = cpu::bvh::clusterKey64(sfc, centroids[i], i, idBits);
+            doNotOptimize(keys.data());
+        });
+        run(std::string(to_string(sfc)) + " encode (batch)", batch, [&] {
+            cpu::bvh::clusterKeys64(sfc, std::span { centroids }.first(batch), 0, idBits, std::span { keys }.first(batch));
+            doNotOptimize(keys.data());
+        });
+    }
+    std::printf("\n");
+
+    cpu::Builder builder { executor };
+    for (auto const sfc : { config::SpaceFilling::eMorton32, config::SpaceFilling::eMorton64, config::SpaceFilling::eHilbert64 }) {
+        auto const sfc64 { sfc != config::SpaceFilling::eMorton32 };
+        f32 encodeMs { std::numeric_limits<f32>::max() };
+        f32 sortMs { std::numeric_limits<f32>::max() };
+        for (u32 r = 0; r < REPETITIONS; ++r) {
+            cpu::bvh::Stopwatch stopwatch;
+            parallelForChunks(executor, n, CHUNK_SIZE, [&](size_t begin, size_t end) {
+                if (sfc64) {
+                    cpu::bvh::clusterKeys64(sfc, std::span { centroids }.subspan(begin, end - begin), static_cast<u32>(begin), idBits, std::span { keys }.subspan(begin, end - begin));
+                } else {
+                    for (auto i { begin }; i < end; ++i)
+                        keyvals[i] = { static_cast<u32>(i), cpu::bvh::mortonCode32(centroids[i]) };
+                }
+            });
+            encodeMs = std::min(encodeMs, stopwatch.Lap());
+
+            if (sfc64)
+                cpu::radixSort<64>(executor, keys, [](u64 key) { return key; });
+            else
+                cpu::radixSort<32>(executor, keyvals, [](data_plocpp::Morton32KeyVal const& kv) { return kv.mortonCode; });
+            sortMs = std::min(sortMs, stopwatch.Lap());
+        }
+
+        u32 collisions { 0 };
+        for (u32 i = 1; i < n; ++i)
+            collisions += sfc64 ? (keys[i] >> idBits) == (keys[i - 1] >> idBits) : keyvals[i].mortonCode == keyvals[i - 1].mortonCode;
+
+        config::BVHPipeline pipeline;
+        pipeline.plocpp.bv = config::BV::eAABB;
+        pipeline.plocpp.sfc = sfc;
+        pipeline.collapsing.bv = config::BV::eAABB;
+        builder.SetPipelineConfiguration(pipeline);
+        builder.Build(scene);
+        auto const& stats { builder.GetStatsBuild() };
+
+        std::printf("%-12s %8.2f ms encode %8.2f ms sort %8.3f %% collisions %10.2f PLOC++ cost %10.2f collapsed cost %8.2f ms build\n", to_string(sfc), encodeMs, sortMs,
+            100. * collisions / n, stats.plocpp.costTotal, stats.collapsing.costTotal, stats.plocpp.timeTotal + stats.collapsing.timeTotal);
+    }
+}
+
+}
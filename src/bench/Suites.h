@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string_view>
+
+namespace bench {
+
+void dop14();
+// synthetic rays, nodes and triangles
+void kernels();
+// scenePath: '*.ob' scene, a generated height field if empty
+void reordering(std::string_view scenePath);
+void spaceFilling(std::string_view scenePath);
+void plocpp(std::string_view scenePath);
+void traversal(std::string_view scenePath);
+
+}
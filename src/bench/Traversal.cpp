@@ -0,0 +1,69 @@
+#include "Bench.h"
+#include "Scenes.h"
+#include "Suites.h"
+
+#include <backend/cpu/Builder.h>
+#include <backend/cpu/bvh/Tracer.h>
+#include <string>
+
+using namespace backend;
+
+namespace bench {
+
+// single ray traversal of every compressed layout, the BVHs are built on all threads and traced on 1 thread, ops are rays
+void traversal(std::string_view scenePath)
+{
+    constexpr u32 RAY_COUNT { 1 << 16 };
+
+    Executor executor;
+    auto const scene { loadScene(scenePath, executor) };
+    if (scene.triangleCount == 0) {
+        std::printf("traversal: can't load '%.*s'\n", static_cast<int>(scenePath.size()), scenePath.data());
+        return;
+    }
+    section(std::string("single ray traversal, ") + std::to_string(scene.triangleCount) + " triangles, 1 thread");
+
+    struct Layout {
+        char const* name;
+        config::BV bv;
+        config::CompressedLayout layout;
+    };
+    static constexpr Layout LAYOUTS[] {
+        { "aabb", config::BV::eAABB, config::CompressedLayout::eBinaryStandard },
+        { "aabb q8", config::BV::eAABB, config::CompressedLayout::eBinaryQuantized8 },
+        { "aabb q16", config::BV::eAABB, config::CompressedLayout::eBinaryQuantized16 },
+        { "aabb wide4", config::BV::eAABB, config::CompressedLayout::eWide4 },
+        { "aabb wide8", config::BV::eAABB, config::CompressedLayout::eWide8 },
+        { "dop14", config::BV::eDOP14, config::CompressedLayout::eBinaryStandard },
+        { "dop14 split", config::BV::eDOP14, config::CompressedLayout::eBinaryDOP14Split },
+        { "dop14 q8", config::BV::eDOP14, config::CompressedLayout::eBinaryQuantized8 },
+        { "dop14 q16", config::BV::eDOP14, config::CompressedLayout::eBinaryQuantized16 },
+        { "dop14 wide4", config::BV::eDOP14, config::CompressedLayout::eWide4 },
+        { "dop14 wide8", config::BV::eDOP14, config::CompressedLayout::eWide8 },
+        { "obb", config::BV::eOBB, config::CompressedLayout::eBinaryStandard },
+    };
+
+    std::vector<data_bvh::Ray> const rays[] { makeRays(scene, true, RAY_COUNT), makeRays(scene, false, RAY_COUNT) };
+    std::vector<data_bvh::RayTraceResult> results(RAY_COUNT);
+
+    Executor single { 1 };
+    cpu::Builder builder { executor };
+    cpu::bvh::Tracer tracer { single };
+    for (auto const& l : LAYOUTS) {
+        builder.SetPipelineConfiguration(makePipeline(l.bv, l.layout));
+        builder.Build(scene);
+        if (builder.Failed()) {
+            std::printf("%-40s %12s\n", l.name, "build failed");
+            continue;
+        }
+        auto const& bvh { builder.GetBVH() };
+
+        for (u32 r = 0; r < 2; ++r) {
+            auto const s { tracer.TraceRays(bvh, rays[r], results) };
+            auto const name { std::string(l.name) + (r == 0 ? ", coherent, " : ", incoherent, ") + std::to_string(s.traversedNodes / RAY_COUNT) + " nodes/ray" };
+            run(name, RAY_COUNT, [&] { doNotOptimize(tracer.TraceRays(bvh, rays[r], results)); });
+        }
+    }
+}
+
+}
@@ -0,0 +1,31 @@
+#include "Suites.h"
+
+#include <berries/lib_helper/spdlog.h>
+#include <cstdio>
+#include <string_view>
+
+int main(int argc, char* argv[])
+{
+    berry::Log::Init();
+
+    // optional arguments select a single suite by name and the scene of the scene based suites
+    std::string_view const filter { argc > 1 ? argv[1] : "" };
+    std::string_view const scenePath { argc > 2 ? argv[2] : "" };
+    auto const enabled { [&](std::string_view name) { return filter.empty() || filter == name; } };
+
+    if (enabled("dop14"))
+        bench::dop14();
+    if (enabled("kernels"))
+        bench::kernels();
+    if (enabled("reorder"))
+        bench::reordering(scenePath);
+    if (enabled("sfc"))
+        bench::spaceFilling(scenePath);
+    if (enabled("plocpp"))
+        bench::plocpp(scenePath);
+    if (enabled("traversal"))
+        bench::traversal(scenePath);
+
+    std::printf("\n");
+    return 0;
+}
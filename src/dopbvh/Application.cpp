@@ -1,8 +1,11 @@
 #include "Application.h"
 
 #include "core/GUI.h"
+#include "scene/SceneCache.h"
 #include "scene/SceneIO.h"
+#include "scene/SceneUpload.h"
 #include "util/pexec.h"
+#include "util/pmem.h"
 
 #include <berries/lib_helper/spdlog.h>
 #include <filesystem>
@@ -202,7 +205,9 @@ void Application::loadSceneBinary(std::string_view path)
     }
     berry::log::timer("Scene load started (binary)", glfwGetTime());
     asyncProcessing.scenes.push_back(mainExecutor.async([this, path = std::filesystem::path(path)]() {
-        Scene result { scene::deserialize(path) };
+        Scene result { scene::deserialize(path, mainExecutor, [](std::string_view phase) {
+            berry::log::timer(phase, glfwGetTime());
+        }) };
         berry::log::timer("  deserialized", glfwGetTime());
         UploadScene(result, backend);
         berry::log::timer("  uploaded to GPU", glfwGetTime());
@@ -225,13 +230,38 @@ void Application::loadSceneAssimp(std::string_view path)
     berry::log::timer("Scene load started", glfwGetTime());
     asyncProcessing.scenes.push_back(mainExecutor.async([this, path = std::filesystem::path(path)]() {
         Scene result;
-        SceneIO io;
 
-        berry::log::timer("  importing..", glfwGetTime());
-        io.ImportScene(path.generic_string(), &state.progress);
-        berry::log::timer("  imported", glfwGetTime());
-        result = io.CreateScene();
-        berry::log::timer("  created", glfwGetTime());
+        // imported scenes are cached as '*.ob', keyed by the source content and the import settings
+        auto const cacheDir { directory.res / "scene" / "cache" };
+        auto const cachePath { scene::cache::entry(cacheDir, scene::cache::makeKey(path, SceneIO::IMPORT_FLAGS, SceneIO::GEOMETRY_GLOBAL_SCALE)) };
+        berry::log::timer("  hashed", glfwGetTime());
+
+        bool cacheHit { false };
+        if (std::filesystem::exists(cachePath)) {
+            result = scene::deserialize(cachePath, mainExecutor, [](std::string_view phase) {
+                berry::log::timer(phase, glfwGetTime());
+            });
+            cacheHit = !result.nodes.empty();
+        }
+
+        if (cacheHit)
+            berry::log::timer(fmt::format("  cache hit: {}", cachePath.filename().generic_string()), glfwGetTime());
+        else {
+            berry::log::timer("  cache miss", glfwGetTime());
+            SceneIO io;
+
+            auto const logMemory { [](std::string_view phase) {
+                berry::Log::debug("  memory {:<10} current: {:>9.1f} MiB, peak: {:>9.1f} MiB", phase, pmem::to_MiB(pmem::get_current_rss()), pmem::to_MiB(pmem::get_peak_rss()));
+            } };
+            logMemory("start");
+            berry::log::timer("  importing..", glfwGetTime());
+            io.ImportScene(path.generic_string(), &state.progress);
+            berry::log::timer("  imported", glfwGetTime());
+            logMemory("imported");
+            result = io.CreateSceneStreaming(mainExecutor);
+            berry::log::timer("  created", glfwGetTime());
+            logMemory("created");
+        }
         UploadScene(result, backend);
         berry::log::timer("  uploaded to GPU", glfwGetTime());
 
@@ -239,6 +269,9 @@ void Application::loadSceneAssimp(std::string_view path)
         backend.selectScene(0);
         backend.ResetAccumulation();
 
+        if (!cacheHit && scene::cache::store(cachePath, result))
+            berry::log::timer(fmt::format("  cached: {}", cachePath.filename().generic_string()), glfwGetTime());
+
         result.path = path;
         return result;
     }));
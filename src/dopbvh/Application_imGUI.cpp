@@ -19,6 +19,13 @@ void Application::ProcessGUI()
     ImGui::Text("path: %s", pathOb.generic_string().c_str());
     if (ImGui::Button("serialize scene to '*.ob' binary"))
         scene::serialize(*scenes.back(), pathOb);
+    ImGui::SameLine();
+    if (ImGui::Button("compressed"))
+        scene::serialize(*scenes.back(), pathOb, scene::codec::Encoding::eAll);
+    if (ImGui::Button("convert '*.ob' binaries to current version") && std::filesystem::exists(pathOb))
+        for (auto const& entry : std::filesystem::directory_iterator(pathOb))
+            if (entry.path().extension() == ".ob" && scene::convert(entry.path(), pathOb))
+                berry::Log::info("Converted: {}", entry.path().generic_string());
 
     static auto const pathImg { directory.res / "image\\" };
     static char buf[48] = "";
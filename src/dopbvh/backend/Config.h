@@ -12,14 +12,22 @@ enum class BV {
     eOBB,
 };
 
+// the 64 bit curves share a 64 bit sort key with the cluster id, see backend/cpu/bvh/SpaceFilling.h
 enum class SpaceFilling {
     eMorton32,
-    // eMorton64,
+    eMorton64,
+    eHilbert64,
 };
 
 enum class CompressedLayout {
     eBinaryStandard,
     eBinaryDOP14Split,
+    // CPU only, 4 or 8 children per node, AABB or DOP14
+    eWide4,
+    eWide8,
+    // CPU only, binary AABB or DOP14 with 8 or 16 bit child slabs
+    eBinaryQuantized8,
+    eBinaryQuantized16,
 };
 
 struct PLOC {
@@ -64,6 +72,23 @@ struct Compression {
     }
 };
 
+// CPU only, node order of the compressed BVH, see backend/cpu/bvh/Reordering.h
+enum class NodeOrder {
+    eNone,
+    eDFS,
+    eTreeletBFS,
+    eVanEmdeBoas,
+};
+
+struct Reordering {
+    NodeOrder order { NodeOrder::eNone };
+
+    bool operator==(Reordering const& rhs) const
+    {
+        return order == rhs.order;
+    }
+};
+
 struct Tracer {
     BV bv { BV::eNone };
     u32 workgroupCount { 512 };
@@ -87,10 +112,12 @@ struct Stats {
     BV bv { BV::eNone };
     float c_t { 1.f };
     float c_i { 1.f };
+    // CPU only, triangles sampled for the end-point overlap of the output BVH, 0 disables it
+    u32 epoSamples { 0 };
 
     bool operator==(Stats const& rhs) const
     {
-        return bv == rhs.bv && c_t == rhs.c_t && c_i == rhs.c_i;
+        return bv == rhs.bv && c_t == rhs.c_t && c_i == rhs.c_i && epoSamples == rhs.epoSamples;
     }
 };
 
@@ -101,6 +128,7 @@ struct BVHPipeline {
     Collapsing collapsing;
     Transformation transformation;
     Compression compression;
+    Reordering reordering;
     Tracer tracer;
 
     Stats stats;
@@ -3,6 +3,7 @@
 #include <berries/lib_helper/spdlog.h>
 #include <vLime/types.h>
 
+#include <array>
 #include <vector>
 
 namespace backend::stats {
@@ -103,6 +104,8 @@ struct Compression {
     u32 leafSizeMin { 0 };
     u32 leafSizeMax { 0 };
     f32 leafSizeAvg { 0.f };
+    // node and aux buffers in bytes
+    u64 memorySize { 0 };
 
     void print() const
     {
@@ -115,6 +118,59 @@ struct Compression {
         berry::Log::info("    Leaf size min: {}", leafSizeMin);
         berry::Log::info("    Leaf size max: {}", leafSizeMax);
         berry::Log::info("    Leaf size avg: {:.2f}", leafSizeAvg);
+        berry::Log::info("    Memory: {:.2f} MB", static_cast<f64>(memorySize) / (1024. * 1024.));
+    }
+};
+
+struct Reordering {
+    f32 timeTotal { 0.f };
+
+    // interior child references within the 4 KiB page of their parent
+    f32 pageLocalRatio { 0.f };
+
+    void print() const
+    {
+        berry::Log::info("  Reordering:");
+        berry::Log::info("    Time total: {:.2f} ms", timeTotal);
+        berry::Log::info("    Page local children: {:.2f} %", 100.f * pageLocalRatio);
+    }
+};
+
+// tree shape of the output BVH, CPU only, see backend/cpu/bvh/Stats.h
+//   areas are relative to the scene AABB, the root is depth 0
+struct Shape {
+    struct Depth {
+        u32 interiorCount { 0 };
+        u32 leafCount { 0 };
+        u32 triangleCount { 0 };
+        f32 saTraverse { 0.f };
+        f32 saIntersect { 0.f };
+    };
+
+    f32 timeTotal { 0.f };
+
+    std::vector<Depth> depths;
+    // leaf count by triangle count, the last bin holds the larger leaves
+    std::array<u32, 16> leafSizeHistogram {};
+    // pairwise overlap of the sibling bounds
+    f32 saOverlap { 0.f };
+    // end-point overlap of the sampled triangles relative to their area, 0 if not sampled
+    f32 epo { 0.f };
+    u32 epoSampleCount { 0 };
+
+    void print() const
+    {
+        if (depths.empty())
+            return;
+        berry::Log::info("  Shape:");
+        berry::Log::info("    Time total: {:.2f} ms", timeTotal);
+        berry::Log::info("    Depth max: {}", depths.size() - 1);
+        berry::Log::info("    Sibling overlap: {:.2f}", saOverlap);
+        if (epoSampleCount > 0)
+            berry::Log::info("    EPO: {:.2f} ({} triangles sampled)", epo, epoSampleCount);
+        for (u32 i = 0; i < leafSizeHistogram.size(); ++i)
+            if (leafSizeHistogram[i] > 0)
+                berry::Log::info("{:>17}  - leaves of size {}{}", leafSizeHistogram[i], i, i + 1 == leafSizeHistogram.size() ? "+" : "");
     }
 };
 
@@ -123,6 +179,8 @@ struct BVHPipeline {
     Collapsing collapsing;
     Transformation transformation;
     Compression compression;
+    Reordering reordering;
+    Shape shape;
 
     void print() const
     {
@@ -130,6 +188,8 @@ struct BVHPipeline {
         collapsing.print();
         transformation.print();
         compression.print();
+        reordering.print();
+        shape.print();
     }
 };
 
@@ -137,8 +197,47 @@ struct Trace {
     struct PerDepth {
         u32 rayCount { 0 };
         f32 traceTimeMs { 0.f };
+        // filled by the CPU tracer only
+        u64 traversedNodes { 0 };
+        u64 testedTriangles { 0 };
+        // diagonal slab tests of the DOP14 layouts, per child
+        u64 dopTests { 0 };
+
+        [[nodiscard]] f32 MRaysPerSecond() const
+        {
+            return traceTimeMs > 0.f ? (static_cast<f32>(rayCount) * 1e-6f) / (traceTimeMs * 1e-3f) : 0.f;
+        }
     };
     std::array<PerDepth, 8> data;
+
+    // same split as pMRps / sMRps of Benchmark::ExportPipeline
+    [[nodiscard]] f32 PrimaryMRaysPerSecond() const
+    {
+        return data[0].MRaysPerSecond();
+    }
+    [[nodiscard]] f32 SecondaryMRaysPerSecond() const
+    {
+        u64 rayCount { 0 };
+        f32 traceTimeMs { 0.f };
+        for (u32 i = 1; i < data.size(); ++i) {
+            rayCount += data[i].rayCount;
+            traceTimeMs += data[i].traceTimeMs;
+        }
+        return traceTimeMs > 0.f ? (static_cast<f32>(rayCount) * 1e-6f) / (traceTimeMs * 1e-3f) : 0.f;
+    }
+
+    void print() const
+    {
+        berry::Log::info("  Trace: {:.2f} primary MRays/s, {:.2f} secondary MRays/s", PrimaryMRaysPerSecond(), SecondaryMRaysPerSecond());
+        for (u32 i = 0; i < data.size() && data[i].rayCount > 0; ++i) {
+            auto const& d { data[i] };
+            berry::Log::info("    depth {}: {:>10} rays {:>10.2f} ms {:>8.2f} MRays/s", i, d.rayCount, d.traceTimeMs, d.MRaysPerSecond());
+            if (d.traversedNodes > 0)
+                berry::Log::info("{:>17.2f}  - nodes/ray, {:.2f} triangles/ray", static_cast<f64>(d.traversedNodes) / d.rayCount, static_cast<f64>(d.testedTriangles) / d.rayCount);
+            if (d.dopTests > 0)
+                berry::Log::info("{:>17.2f}  - DOP tests/ray", static_cast<f64>(d.dopTests) / d.rayCount);
+        }
+    }
 };
 
 }
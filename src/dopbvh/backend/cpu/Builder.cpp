@@ -0,0 +1,229 @@
+#include "Builder.h"
+
+#include "../../core/Profiler.h"
+#include "../../scene/Scene.h"
+#include "bvh/Cache.h"
+#include "bvh/Serialization.h"
+#include <algorithm>
+
+namespace backend::cpu {
+
+Builder::Builder(Executor& executor)
+    : executor(executor)
+    , plocpp(executor)
+    , collapsing(executor)
+    , transformation(executor)
+    , compression(executor)
+    , reordering(executor)
+    , stats(executor)
+{
+}
+
+void Builder::SetPipelineConfiguration(config::BVHPipeline config)
+{
+    buildConfig = std::move(config);
+
+    // an earlier pending stage, e.g. after Invalidate(), is kept, the later ones were computed for another scene or config
+    if (reordering.NeedsRecompute(buildConfig.reordering))
+        buildState = std::min(buildState, BuildState::eReordering);
+    if (compression.NeedsRecompute(buildConfig.compression))
+        buildState = std::min(buildState, BuildState::eCompression);
+    if (transformation.NeedsRecompute(buildConfig.transformation))
+        buildState = std::min(buildState, BuildState::eTransformation);
+    if (collapsing.NeedsRecompute(buildConfig.collapsing))
+        buildState = std::min(buildState, BuildState::eCollapsing);
+    if (plocpp.NeedsRecompute(buildConfig.plocpp))
+        buildState = BuildState::ePLOC;
+    // the stages did not compute the cached BVH, any change starts over
+    if (fromCache && (buildState != BuildState::eDone || bvh::cache::hashPipeline(buildConfig) != cachedPipelineHash))
+        buildState = BuildState::ePLOC;
+}
+
+void Builder::Invalidate()
+{
+    buildState = BuildState::ePLOC;
+    sceneHash.reset();
+}
+
+void Builder::SetCacheDirectory(std::filesystem::path dir)
+{
+    cacheDir = std::move(dir);
+}
+
+// the stats of the output stage are recomputed on the loaded BVH, all times are zero
+template<typename StageStats>
+static StageStats cachedStats(bvh::BvhStats const& bvhStats, bvh::Bvh const& bvh)
+{
+    StageStats stats;
+    stats.saIntersect = bvhStats.saIntersect;
+    stats.saTraverse = bvhStats.saTraverse;
+    stats.costTotal = bvhStats.costIntersect + bvhStats.costTraverse;
+    stats.nodeCountTotal = bvh.nodeCountTotal;
+    stats.leafSizeMin = bvhStats.leafSizeMin;
+    stats.leafSizeMax = bvhStats.leafSizeMax;
+    stats.leafSizeAvg = static_cast<f32>(bvhStats.leafSizeSum) / static_cast<f32>(bvh.nodeCountLeaf);
+    if constexpr (requires { stats.memorySize; })
+        stats.memorySize = bvh.nodes.size() + bvh.aux.size();
+    return stats;
+}
+
+bool Builder::loadCached(std::filesystem::path const& path)
+{
+    PROFILE_ZONE("BVH cache load");
+    if (!std::filesystem::exists(path))
+        return false;
+    auto bvh { bvh::deserialize(path) };
+    if (bvh.nodeCountTotal == 0) {
+        berry::Log::warn("BVH cache: can't read '{}', rebuilding", path.generic_string());
+        return false;
+    }
+    berry::Log::debug("BVH cache hit: {}", path.generic_string());
+
+    cached = std::move(bvh);
+    fromCache = true;
+    buildState = BuildState::eDone;
+
+    buildConfig.stats.bv = cached.bv;
+    stats.Compute(buildConfig.stats, cached);
+    statsBuild = {};
+    if (buildConfig.compression.bv != config::BV::eNone)
+        statsBuild.compression = cachedStats<stats::Compression>(stats.data, cached);
+    else if (buildConfig.transformation.bv != config::BV::eNone)
+        statsBuild.transformation = cachedStats<stats::Transformation>(stats.data, cached);
+    else if (buildConfig.collapsing.bv != config::BV::eNone)
+        statsBuild.collapsing = cachedStats<stats::Collapsing>(stats.data, cached);
+    else
+        statsBuild.plocpp = cachedStats<stats::PLOC>(stats.data, cached);
+    statsBuild.plocpp.times.assign(4, 0.f);
+    stats.ComputeShape(buildConfig.stats, cached);
+    statsBuild.shape = stats.shape;
+    return true;
+}
+
+bool Builder::Build(Scene const& scene)
+{
+    if (buildState == BuildState::eDone)
+        return false;
+    PROFILE_ZONE("BVH build");
+
+    stats.SetSceneAabbSurfaceArea(scene.aabb.Area());
+
+    std::filesystem::path cachePath;
+    if (!cacheDir.empty()) {
+        if (!sceneHash)
+            sceneHash = bvh::cache::hashScene(scene, executor);
+        auto const pipelineHash { bvh::cache::hashPipeline(buildConfig) };
+        cachePath = bvh::cache::entry(cacheDir, { *sceneHash, pipelineHash });
+        if (loadCached(cachePath)) {
+            cachedPipelineHash = pipelineHash;
+            failed = false;
+            return true;
+        }
+    }
+    fromCache = false;
+    cached = {};
+
+    berry::Log::debug("BVH build (CPU): {}", buildConfig.name);
+    while (buildState != BuildState::eDone) {
+        switch (buildState) {
+        case BuildState::ePLOC:
+            berry::Log::debug("BVH build stage: PLOCpp");
+            plocpp.Compute(scene);
+            stagesSceneHash = sceneHash;
+
+            buildConfig.stats.bv = buildConfig.plocpp.bv;
+            stats.Compute(buildConfig.stats, plocpp.GetBVH());
+            statsBuild.plocpp = plocpp.GatherStats(stats.data);
+            buildState = BuildState::eCollapsing;
+            break;
+        case BuildState::eCollapsing:
+            if (buildConfig.collapsing.bv != config::BV::eNone) {
+                berry::Log::debug("BVH build stage: Collapsing");
+                collapsing.Compute(plocpp.GetBVH(), scene);
+
+                buildConfig.stats.bv = buildConfig.collapsing.bv;
+                stats.Compute(buildConfig.stats, collapsing.GetBVH());
+                statsBuild.collapsing = collapsing.GatherStats(stats.data);
+            }
+            buildState = buildConfig.transformation.bv == config::BV::eNone ? BuildState::eCompression : BuildState::eTransformation;
+            break;
+        case BuildState::eTransformation:
+            if (buildConfig.transformation.bv != config::BV::eNone) {
+                berry::Log::debug("BVH build stage: Transformation");
+                transformation.Compute(collapsing.GetBVH(), scene);
+
+                buildConfig.stats.bv = buildConfig.transformation.bv;
+                stats.Compute(buildConfig.stats, transformation.GetBVH());
+                statsBuild.transformation = transformation.GatherStats(stats.data);
+            }
+            buildState = BuildState::eCompression;
+            break;
+        case BuildState::eCompression:
+            // the only stage that rejects a config, the flag lives as long as its output
+            failed = false;
+            if (buildConfig.compression.bv != config::BV::eNone) {
+                berry::Log::debug("BVH build stage: Compression");
+                failed = !compression.Compute(buildConfig.transformation.bv == config::BV::eNone ? collapsing.GetBVH() : transformation.GetBVH());
+
+                buildConfig.stats.bv = buildConfig.compression.bv;
+                stats.Compute(buildConfig.stats, compression.GetBVH());
+                statsBuild.compression = compression.GatherStats(stats.data);
+            }
+            buildState = BuildState::eReordering;
+            break;
+        case BuildState::eReordering:
+            // the node order does not change the SAH stats of the compressed BVH, an empty input empties the reordered BVH too
+            if (buildConfig.compression.bv != config::BV::eNone && buildConfig.reordering.order != config::NodeOrder::eNone) {
+                berry::Log::debug("BVH build stage: Reordering");
+                reordering.Compute(compression.GetBVH());
+                statsBuild.reordering = reordering.GatherStats();
+            }
+            buildState = BuildState::eDone;
+            break;
+        case BuildState::eDone:
+            break;
+        }
+    }
+    if (buildConfig.transformation.bv == config::BV::eNone)
+        statsBuild.transformation = {};
+    if (buildConfig.compression.bv == config::BV::eNone)
+        statsBuild.compression = {};
+    if (buildConfig.compression.bv == config::BV::eNone || buildConfig.reordering.order == config::NodeOrder::eNone)
+        statsBuild.reordering = {};
+
+    // tree shape and EPO of the output BVH only
+    stats.ComputeShape(buildConfig.stats, GetBVH());
+    statsBuild.shape = stats.shape;
+
+    if (failed) {
+        berry::Log::error("BVH build failed: {}", buildConfig.name);
+        return true;
+    }
+
+    // an entry is stored only for a BVH the stages computed from this scene, anything else would be loaded for it by every later run
+    if (!cachePath.empty() && stagesSceneHash == sceneHash && GetBVH().nodeCountTotal != 0) {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        if (!bvh::serializeToFile(GetBVH(), cachePath))
+            berry::Log::warn("BVH cache: can't write '{}'", cachePath.generic_string());
+    }
+    berry::Log::debug("BVH build done.");
+    return true;
+}
+
+bvh::Bvh const& Builder::GetBVH() const
+{
+    if (fromCache)
+        return cached;
+    if (buildConfig.compression.bv != config::BV::eNone && buildConfig.reordering.order != config::NodeOrder::eNone)
+        return reordering.GetBVH();
+    if (buildConfig.compression.bv != config::BV::eNone)
+        return compression.GetBVH();
+    if (buildConfig.transformation.bv != config::BV::eNone)
+        return transformation.GetBVH();
+    if (buildConfig.collapsing.bv != config::BV::eNone)
+        return collapsing.GetBVH();
+    return plocpp.GetBVH();
+}
+
+}
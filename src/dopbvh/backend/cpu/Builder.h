@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../../core/Taskflow.h"
+#include "../Config.h"
+#include "../Stats.h"
+#include "bvh/Collapsing.h"
+#include "bvh/Compression.h"
+#include "bvh/PLOCpp.h"
+#include "bvh/Reordering.h"
+#include "bvh/Stats.h"
+#include "bvh/Transformation.h"
+#include <filesystem>
+#include <optional>
+
+struct Scene;
+
+namespace backend::cpu {
+
+// host counterpart of the BVH build of vulkan::PathTracing: PLOC++ -> collapsing -> transformation -> compression -> reordering
+//   only the stages whose config changed since the last build are recomputed, stats are gathered after each stage
+//   with a cache directory, the output BVH is looked up by scene and pipeline hash before building and stored after (see bvh/Cache.h)
+class Builder {
+public:
+    explicit Builder(Executor& executor);
+
+    [[nodiscard]] config::BVHPipeline GetConfig() const
+    {
+        return buildConfig;
+    }
+    void SetPipelineConfiguration(config::BVHPipeline config);
+    // forces a full rebuild on the next Build(), e.g. after a scene change
+    void Invalidate();
+    // empty disables the cache
+    void SetCacheDirectory(std::filesystem::path dir);
+
+    // returns false if the BVH was already up to date
+    bool Build(Scene const& scene);
+    // a stage rejected its input or config in the last Build(), the output BVH is empty and not cached
+    [[nodiscard]] bool Failed() const
+    {
+        return failed;
+    }
+
+    // output of the last enabled stage
+    [[nodiscard]] bvh::Bvh const& GetBVH() const;
+    [[nodiscard]] stats::BVHPipeline const& GetStatsBuild() const
+    {
+        return statsBuild;
+    }
+
+private:
+    Executor& executor;
+
+    bvh::PLOCpp plocpp;
+    bvh::Collapsing collapsing;
+    bvh::Transformation transformation;
+    bvh::Compression compression;
+    bvh::Reordering reordering;
+    bvh::Stats stats;
+
+    // in stage order, a config change only ever moves the state back, see SetPipelineConfiguration
+    enum class BuildState {
+        ePLOC,
+        eCollapsing,
+        eTransformation,
+        eCompression,
+        eReordering,
+        eDone,
+    } buildState { BuildState::ePLOC };
+    config::BVHPipeline buildConfig;
+    bool failed { false };
+
+    stats::BVHPipeline statsBuild;
+
+    std::filesystem::path cacheDir;
+    // output of the last Build() if it was a cache hit, the stages are stale then
+    bvh::Bvh cached;
+    bool fromCache { false };
+    u64 cachedPipelineHash { 0 };
+    std::optional<u64> sceneHash;
+    // scene hash at the last PLOC++ run, the stage outputs belong to that scene, empty if the cache was disabled then
+    std::optional<u64> stagesSceneHash;
+
+    bool loadCached(std::filesystem::path const& path);
+};
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../../core/Taskflow.h"
+#include <vLime/types.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace backend::cpu {
+
+// stable LSD radix sort of 'data' by the lowest KeyBits of key(element), 8 bits per pass
+//   each pass builds per-chunk digit histograms and scatters the chunks in parallel,
+//   chunks keep their order so equal keys stay in the input order (same as the GPU sort)
+template<u32 KeyBits, typename T, typename KeyFn>
+void radixSort(Executor& executor, std::vector<T>& data, KeyFn key)
+{
+    static_assert(KeyBits % 8 == 0 && KeyBits <= 64);
+    static constexpr u32 RADIX { 256 };
+    static constexpr size_t CHUNK_SIZE { 1 << 16 };
+
+    size_t const n { data.size() };
+    if (n < 2)
+        return;
+
+    size_t const chunkCount { (n + CHUNK_SIZE - 1) / CHUNK_SIZE };
+    std::vector<std::array<size_t, RADIX>> offsets(chunkCount);
+    std::vector<T> tmp(n);
+    auto* src { &data };
+    auto* dst { &tmp };
+
+    for (u32 shift = 0; shift < KeyBits; shift += 8) {
+        auto const digit { [&key, shift](T const& v) { return static_cast<u32>((static_cast<u64>(key(v)) >> shift) & (RADIX - 1)); } };
+
+        parallelFor(executor, chunkCount, [&, digit](size_t c) {
+            auto& histogram { offsets[c] };
+            histogram.fill(0);
+            size_t const end { std::min(n, (c + 1) * CHUNK_SIZE) };
+            for (size_t i = c * CHUNK_SIZE; i < end; ++i)
+                ++histogram[digit((*src)[i])];
+        });
+
+        // exclusive scan in (digit, chunk) order
+        size_t sum { 0 };
+        bool skipPass { false };
+        for (u32 d = 0; d < RADIX; ++d) {
+            size_t digitCount { 0 };
+            for (size_t c = 0; c < chunkCount; ++c) {
+                auto const count { offsets[c][d] };
+                offsets[c][d] = sum;
+                sum += count;
+                digitCount += count;
+            }
+            skipPass |= digitCount == n;
+        }
+        // all keys share the digit, the pass would only copy
+        if (skipPass)
+            continue;
+
+        parallelFor(executor, chunkCount, [&, digit](size_t c) {
+            auto& offset { offsets[c] };
+            size_t const end { std::min(n, (c + 1) * CHUNK_SIZE) };
+            for (size_t i = c * CHUNK_SIZE; i < end; ++i) {
+                auto const& v { (*src)[i] };
+                (*dst)[offset[digit(v)]++] = v;
+            }
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != &data)
+        data.swap(tmp);
+}
+
+}
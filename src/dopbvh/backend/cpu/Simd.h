@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vLime/types.h>
+#include <algorithm>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#    include <immintrin.h>
+#endif
+
+// thin wrapper over the widest float vector enabled at compile time (AVX-512, AVX2 or scalar)
+//   kernels are written once against VecF/VecI/Mask and run WIDTH lanes per iteration
+namespace backend::cpu::simd {
+
+#if defined(__AVX512F__)
+
+inline constexpr u32 WIDTH { 16 };
+inline constexpr char const* NAME { "AVX-512" };
+
+struct Mask {
+    __mmask16 m;
+};
+struct VecI {
+    __m512i v;
+};
+struct VecF {
+    __m512 v;
+};
+
+[[nodiscard]] inline VecF load(f32 const* p) { return { _mm512_loadu_ps(p) }; }
+inline void store(f32* p, VecF a) { _mm512_storeu_ps(p, a.v); }
+[[nodiscard]] inline VecF broadcast(f32 a) { return { _mm512_set1_ps(a) }; }
+[[nodiscard]] inline VecF operator+(VecF a, VecF b) { return { _mm512_add_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF operator-(VecF a, VecF b) { return { _mm512_sub_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF operator*(VecF a, VecF b) { return { _mm512_mul_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF operator/(VecF a, VecF b) { return { _mm512_div_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF min(VecF a, VecF b) { return { _mm512_min_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF max(VecF a, VecF b) { return { _mm512_max_ps(a.v, b.v) }; }
+[[nodiscard]] inline Mask operator<(VecF a, VecF b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+[[nodiscard]] inline Mask operator<=(VecF a, VecF b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ) }; }
+[[nodiscard]] inline Mask operator|(Mask a, Mask b) { return { static_cast<__mmask16>(a.m | b.m) }; }
+[[nodiscard]] inline Mask operator&(Mask a, Mask b) { return { static_cast<__mmask16>(a.m & b.m) }; }
+[[nodiscard]] inline bool any(Mask a) { return a.m != 0; }
+[[nodiscard]] inline u32 bits(Mask a) { return a.m; }
+// lanes of 'a' where the mask is set, 'b' elsewhere
+[[nodiscard]] inline VecF select(Mask m, VecF a, VecF b) { return { _mm512_mask_blend_ps(m.m, b.v, a.v) }; }
+[[nodiscard]] inline f32 reduceMin(VecF a) { return _mm512_reduce_min_ps(a.v); }
+[[nodiscard]] inline f32 reduceMax(VecF a) { return _mm512_reduce_max_ps(a.v); }
+
+[[nodiscard]] inline VecI loadI(u32 const* p) { return { _mm512_loadu_si512(p) }; }
+[[nodiscard]] inline VecI broadcastI(i32 a) { return { _mm512_set1_epi32(a) }; }
+[[nodiscard]] inline VecI iota() { return { _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15) }; }
+[[nodiscard]] inline VecI operator+(VecI a, VecI b) { return { _mm512_add_epi32(a.v, b.v) }; }
+[[nodiscard]] inline VecI operator*(VecI a, i32 b) { return { _mm512_mullo_epi32(a.v, _mm512_set1_epi32(b)) }; }
+[[nodiscard]] inline VecI gather(u32 const* base, VecI idx) { return { _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xffff, idx.v, base, 4) }; }
+[[nodiscard]] inline VecF gather(f32 const* base, VecI idx) { return { _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xffff, idx.v, base, 4) }; }
+
+#elif defined(__AVX2__)
+
+inline constexpr u32 WIDTH { 8 };
+inline constexpr char const* NAME { "AVX2" };
+
+struct Mask {
+    __m256 m;
+};
+struct VecI {
+    __m256i v;
+};
+struct VecF {
+    __m256 v;
+};
+
+[[nodiscard]] inline VecF load(f32 const* p) { return { _mm256_loadu_ps(p) }; }
+inline void store(f32* p, VecF a) { _mm256_storeu_ps(p, a.v); }
+[[nodiscard]] inline VecF broadcast(f32 a) { return { _mm256_set1_ps(a) }; }
+[[nodiscard]] inline VecF operator+(VecF a, VecF b) { return { _mm256_add_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF operator-(VecF a, VecF b) { return { _mm256_sub_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF operator*(VecF a, VecF b) { return { _mm256_mul_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF operator/(VecF a, VecF b) { return { _mm256_div_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF min(VecF a, VecF b) { return { _mm256_min_ps(a.v, b.v) }; }
+[[nodiscard]] inline VecF max(VecF a, VecF b) { return { _mm256_max_ps(a.v, b.v) }; }
+[[nodiscard]] inline Mask operator<(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+[[nodiscard]] inline Mask operator<=(VecF a, VecF b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+[[nodiscard]] inline Mask operator|(Mask a, Mask b) { return { _mm256_or_ps(a.m, b.m) }; }
+[[nodiscard]] inline Mask operator&(Mask a, Mask b) { return { _mm256_and_ps(a.m, b.m) }; }
+[[nodiscard]] inline bool any(Mask a) { return _mm256_movemask_ps(a.m) != 0; }
+[[nodiscard]] inline u32 bits(Mask a) { return static_cast<u32>(_mm256_movemask_ps(a.m)); }
+[[nodiscard]] inline VecF select(Mask m, VecF a, VecF b) { return { _mm256_blendv_ps(b.v, a.v, m.m) }; }
+[[nodiscard]] inline f32 reduceMin(VecF a)
+{
+    auto r { _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1)) };
+    r = _mm_min_ps(r, _mm_movehl_ps(r, r));
+    return _mm_cvtss_f32(_mm_min_ss(r, _mm_movehdup_ps(r)));
+}
+[[nodiscard]] inline f32 reduceMax(VecF a)
+{
+    auto r { _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1)) };
+    r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+    return _mm_cvtss_f32(_mm_max_ss(r, _mm_movehdup_ps(r)));
+}
+
+[[nodiscard]] inline VecI loadI(u32 const* p) { return { _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)) }; }
+[[nodiscard]] inline VecI broadcastI(i32 a) { return { _mm256_set1_epi32(a) }; }
+[[nodiscard]] inline VecI iota() { return { _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) }; }
+[[nodiscard]] inline VecI operator+(VecI a, VecI b) { return { _mm256_add_epi32(a.v, b.v) }; }
+[[nodiscard]] inline VecI operator*(VecI a, i32 b) { return { _mm256_mullo_epi32(a.v, _mm256_set1_epi32(b)) }; }
+[[nodiscard]] inline VecI gather(u32 const* base, VecI idx) { return { _mm256_i32gather_epi32(reinterpret_cast<int const*>(base), idx.v, 4) }; }
+[[nodiscard]] inline VecF gather(f32 const* base, VecI idx) { return { _mm256_i32gather_ps(base, idx.v, 4) }; }
+
+#else
+
+inline constexpr u32 WIDTH { 1 };
+inline constexpr char const* NAME { "scalar" };
+
+struct Mask {
+    bool m;
+};
+struct VecI {
+    i32 v;
+};
+struct VecF {
+    f32 v;
+};
+
+[[nodiscard]] inline VecF load(f32 const* p) { return { *p }; }
+inline void store(f32* p, VecF a) { *p = a.v; }
+[[nodiscard]] inline VecF broadcast(f32 a) { return { a }; }
+[[nodiscard]] inline VecF operator+(VecF a, VecF b) { return { a.v + b.v }; }
+[[nodiscard]] inline VecF operator-(VecF a, VecF b) { return { a.v - b.v }; }
+[[nodiscard]] inline VecF operator*(VecF a, VecF b) { return { a.v * b.v }; }
+[[nodiscard]] inline VecF operator/(VecF a, VecF b) { return { a.v / b.v }; }
+[[nodiscard]] inline VecF min(VecF a, VecF b) { return { std::min(a.v, b.v) }; }
+[[nodiscard]] inline VecF max(VecF a, VecF b) { return { std::max(a.v, b.v) }; }
+[[nodiscard]] inline Mask operator<(VecF a, VecF b) { return { a.v < b.v }; }
+[[nodiscard]] inline Mask operator<=(VecF a, VecF b) { return { a.v <= b.v }; }
+[[nodiscard]] inline Mask operator|(Mask a, Mask b) { return { a.m || b.m }; }
+[[nodiscard]] inline Mask operator&(Mask a, Mask b) { return { a.m && b.m }; }
+[[nodiscard]] inline bool any(Mask a) { return a.m; }
+[[nodiscard]] inline u32 bits(Mask a) { return a.m ? 1 : 0; }
+[[nodiscard]] inline VecF select(Mask m, VecF a, VecF b) { return m.m ? a : b; }
+[[nodiscard]] inline f32 reduceMin(VecF a) { return a.v; }
+[[nodiscard]] inline f32 reduceMax(VecF a) { return a.v; }
+
+[[nodiscard]] inline VecI loadI(u32 const* p) { return { static_cast<i32>(*p) }; }
+[[nodiscard]] inline VecI broadcastI(i32 a) { return { a }; }
+[[nodiscard]] inline VecI iota() { return { 0 }; }
+[[nodiscard]] inline VecI operator+(VecI a, VecI b) { return { a.v + b.v }; }
+[[nodiscard]] inline VecI operator*(VecI a, i32 b) { return { a.v * b }; }
+[[nodiscard]] inline VecI gather(u32 const* base, VecI idx) { return { static_cast<i32>(base[idx.v]) }; }
+[[nodiscard]] inline VecF gather(f32 const* base, VecI idx) { return { base[idx.v] }; }
+
+#endif
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vLime/types.h>
+#include <glm/glm.hpp>
+
+// host side of bv_aabb.glsl
+namespace backend::cpu::bv {
+
+inline constexpr f32 BIG_FLOAT { 1e30f };
+
+struct Aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+inline void bvFit(Aabb& aabb, glm::vec3 const& v)
+{
+    aabb.min = glm::min(aabb.min, v);
+    aabb.max = glm::max(aabb.max, v);
+}
+
+inline void bvFit(Aabb& aabb, Aabb const& aabbToFit)
+{
+    bvFit(aabb, aabbToFit.min);
+    bvFit(aabb, aabbToFit.max);
+}
+
+[[nodiscard]] inline Aabb aabbInit(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2)
+{
+    Aabb aabb { v0, v0 };
+    bvFit(aabb, v1);
+    bvFit(aabb, v2);
+    return aabb;
+}
+
+[[nodiscard]] inline Aabb overlapAabb(Aabb const& a, Aabb const& b)
+{
+    Aabb result { glm::max(a.min, b.min), glm::min(a.max, b.max) };
+    if (result.min.x > result.max.x || result.min.y > result.max.y || result.min.z > result.max.z)
+        result = { glm::vec3(0.f), glm::vec3(0.f) };
+    return result;
+}
+
+[[nodiscard]] inline glm::vec3 aabbCentroid(Aabb const& aabb)
+{
+    return (aabb.min + aabb.max) * .5f;
+}
+
+[[nodiscard]] inline f32 bvArea(Aabb const& aabb)
+{
+    auto const d { aabb.max - aabb.min };
+    return 2.f * (d.x * d.y + d.x * d.z + d.z * d.y);
+}
+
+[[nodiscard]] inline Aabb aabbDummy()
+{
+    return { glm::vec3(-BIG_FLOAT), glm::vec3(BIG_FLOAT) };
+}
+
+}
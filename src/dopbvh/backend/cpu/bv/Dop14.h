@@ -0,0 +1,192 @@
+#pragma once
+
+#include "Aabb.h"
+#include <array>
+
+// host side of bv_dop14.glsl, slabs are stored as [min0, max0, min1, max1, ...]
+namespace backend::cpu::bv {
+
+using Dop14 = std::array<f32, 14>;
+// extremal vertex of each slab, same order as the slabs
+using Dop14Points = std::array<glm::vec3, 14>;
+
+// dop14 with integer coordinates [-1, 0, 1]
+[[nodiscard]] inline f32 dot_dop14_n0(glm::vec3 const& v) { return v.x; }
+[[nodiscard]] inline f32 dot_dop14_n1(glm::vec3 const& v) { return v.y; }
+[[nodiscard]] inline f32 dot_dop14_n2(glm::vec3 const& v) { return v.z; }
+[[nodiscard]] inline f32 dot_dop14_n3(glm::vec3 const& v) { return v.x + v.y + v.z; }
+[[nodiscard]] inline f32 dot_dop14_n4(glm::vec3 const& v) { return v.x + v.y - v.z; }
+[[nodiscard]] inline f32 dot_dop14_n5(glm::vec3 const& v) { return v.x - v.y + v.z; }
+[[nodiscard]] inline f32 dot_dop14_n6(glm::vec3 const& v) { return v.x - v.y - v.z; }
+
+[[nodiscard]] inline std::array<f32, 7> dopProject(glm::vec3 const& v)
+{
+    return { dot_dop14_n0(v), dot_dop14_n1(v), dot_dop14_n2(v), dot_dop14_n3(v), dot_dop14_n4(v), dot_dop14_n5(v), dot_dop14_n6(v) };
+}
+
+[[nodiscard]] inline Dop14 dopInit(glm::vec3 const& v)
+{
+    auto const d { dopProject(v) };
+    Dop14 dop;
+    for (u32 i = 0; i < 7; ++i) {
+        dop[2 * i + 0] = d[i];
+        dop[2 * i + 1] = d[i];
+    }
+    return dop;
+}
+
+// empty dop, neutral element of bvFit
+[[nodiscard]] inline Dop14 dopInit()
+{
+    Dop14 dop;
+    for (u32 i = 0; i < 7; ++i) {
+        dop[2 * i + 0] = BIG_FLOAT;
+        dop[2 * i + 1] = -BIG_FLOAT;
+    }
+    return dop;
+}
+
+// result of dopFit(vec3(-BIG_FLOAT), vec3(BIG_FLOAT))
+[[nodiscard]] inline Dop14 dopDummy()
+{
+    return { -1e30f, 1e30f, -1e30f, 1e30f, -1e30f, 1e30f, -1.73205e30f, 1.73205e30f, -5.7735e29f, 5.7735e29f, -5.7735e29f, 5.7735e29f, -5.7735e29f, 5.7735e29f };
+}
+
+inline void bvFit(Dop14& dop, glm::vec3 const& v)
+{
+    auto const d { dopProject(v) };
+    for (u32 i = 0; i < 7; ++i) {
+        dop[2 * i + 0] = std::min(dop[2 * i + 0], d[i]);
+        dop[2 * i + 1] = std::max(dop[2 * i + 1], d[i]);
+    }
+}
+
+[[nodiscard]] inline Dop14 dopInit(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2)
+{
+    auto dop { dopInit(v0) };
+    bvFit(dop, v1);
+    bvFit(dop, v2);
+    return dop;
+}
+
+inline void bvFit(Dop14& dop, Dop14 const& dopToFit)
+{
+    for (u32 i = 0; i < 7; ++i) {
+        dop[2 * i + 0] = std::min(dop[2 * i + 0], dopToFit[2 * i + 0]);
+        dop[2 * i + 1] = std::max(dop[2 * i + 1], dopToFit[2 * i + 1]);
+    }
+}
+
+// intersection of two dops, empty intersection results in a zero dop
+[[nodiscard]] inline Dop14 overlapDop(Dop14 dop, Dop14 const& dop1)
+{
+    bool empty { false };
+    for (u32 i = 0; i < 7; ++i) {
+        dop[2 * i + 0] = std::max(dop[2 * i + 0], dop1[2 * i + 0]);
+        dop[2 * i + 1] = std::min(dop[2 * i + 1], dop1[2 * i + 1]);
+        empty |= dop[2 * i + 0] > dop[2 * i + 1];
+    }
+    if (empty)
+        dop.fill(0.f);
+    return dop;
+}
+
+[[nodiscard]] inline Dop14 dopInitWithPoints(glm::vec3 const& v, Dop14Points& points)
+{
+    points.fill(v);
+    return dopInit(v);
+}
+
+inline void bvFitWithPoints(Dop14& dop, glm::vec3 const& v, Dop14Points& points)
+{
+    auto const d { dopProject(v) };
+    for (u32 i = 0; i < 7; ++i) {
+        dop[2 * i + 0] = std::min(dop[2 * i + 0], d[i]);
+        if (d[i] == dop[2 * i + 0])
+            points[2 * i + 0] = v;
+        dop[2 * i + 1] = std::max(dop[2 * i + 1], d[i]);
+        if (d[i] == dop[2 * i + 1])
+            points[2 * i + 1] = v;
+    }
+}
+
+// merges the extremal points of p1 into p0
+inline void bvFit(Dop14Points& p0, Dop14Points const& p1)
+{
+    auto dop { dopInit(p0[0]) };
+    for (u32 i = 1; i < 14; ++i)
+        bvFit(dop, p0[i]);
+    for (auto const& p : p1)
+        bvFitWithPoints(dop, p, p0);
+}
+
+[[nodiscard]] inline glm::vec3 aabbCentroid(Dop14 const& dop)
+{
+    return .5f * glm::vec3(dop[0] + dop[1], dop[2] + dop[3], dop[4] + dop[5]);
+}
+
+[[nodiscard]] inline f32 aabbSurfaceArea(Dop14 const& dop)
+{
+    glm::vec3 const d { dop[1] - dop[0], dop[3] - dop[2], dop[5] - dop[4] };
+    return 2.f * (d.x * d.y + d.x * d.z + d.z * d.y);
+}
+
+// surface area of a DOP14 by corner cutting
+//   to improve numeric stability for certain scenes with small coordinates,
+//   we scale the DOP14 by 1e3 and return the result scaled by 1e-6
+[[nodiscard]] inline f32 bvArea(Dop14 dop)
+{
+    for (auto& d : dop)
+        d *= 1e3f;
+
+    glm::vec3 const diag { dop[1] - dop[0], dop[3] - dop[2], dop[5] - dop[4] };
+    f32 const result { 2.f * (diag.x * diag.y + diag.x * diag.z + diag.z * diag.y) };
+
+    // fast path for dummy dop (max area)
+    if (dop[0] <= -1e30f && dop[1] >= 1e30f)
+        return result;
+
+    std::array<f32, 8> const d {
+        dop[6] - dot_dop14_n3({ dop[0], dop[2], dop[4] }),
+        dot_dop14_n3({ dop[1], dop[3], dop[5] }) - dop[7],
+        dop[8] - dot_dop14_n4({ dop[0], dop[2], dop[5] }),
+        dot_dop14_n4({ dop[1], dop[3], dop[4] }) - dop[9],
+        dop[10] - dot_dop14_n5({ dop[0], dop[3], dop[4] }),
+        dot_dop14_n5({ dop[1], dop[2], dop[5] }) - dop[11],
+        dop[12] - dot_dop14_n6({ dop[0], dop[3], dop[5] }),
+        dot_dop14_n6({ dop[1], dop[2], dop[4] }) - dop[13],
+    };
+
+    // dop normals are not normalized, so we need to multiply by 1/sqrt(3)
+    f32 accToSubtract { 0.f };
+    for (auto const di : d)
+        accToSubtract += di * di;
+    accToSubtract *= .6339745962155614f;
+
+    auto const s { [](f32 a, f32 b, f32 edge) { return std::max(0.f, a + b - edge); } };
+    std::array<f32, 12> const corner {
+        // X pairs: 0:7, 1:6, 2:5, 3:4
+        s(d[0], d[7], diag.x),
+        s(d[1], d[6], diag.x),
+        s(d[2], d[5], diag.x),
+        s(d[3], d[4], diag.x),
+        // Y pairs: 0:4, 1:5, 2:6, 3:7
+        s(d[0], d[4], diag.y),
+        s(d[1], d[5], diag.y),
+        s(d[2], d[6], diag.y),
+        s(d[3], d[7], diag.y),
+        // Z pairs: 0:2, 1:3, 4:6, 5:7
+        s(d[0], d[2], diag.z),
+        s(d[1], d[3], diag.z),
+        s(d[4], d[6], diag.z),
+        s(d[5], d[7], diag.z),
+    };
+    f32 accToAdd { 0.f };
+    for (auto const c : corner)
+        accToAdd += c * c;
+    accToAdd *= .13397459621556135f;
+
+    return (result - accToSubtract + accToAdd) * 1e-6f;
+}
+
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "../Simd.h"
+#include "Dop14.h"
+#include <span>
+#include <vector>
+
+// batched dop14 kernels, one array per slab so that simd::WIDTH dops are processed per instruction
+//   entries past Size() are padding initialized to the empty dop, rows are padded to 16 entries
+namespace backend::cpu::bv {
+
+class Dop14Soa {
+public:
+    static constexpr u32 SLABS { 14 };
+
+    Dop14Soa() = default;
+    explicit Dop14Soa(u32 count)
+    {
+        Resize(count);
+    }
+
+    void Resize(u32 count)
+    {
+        size = count;
+        stride = (count + 15) & ~15u;
+        auto const empty { dopInit() };
+        data.resize(static_cast<size_t>(SLABS) * stride);
+        for (u32 s = 0; s < SLABS; ++s)
+            std::fill_n(Slab(s) + size, stride - size, empty[s]);
+    }
+
+    [[nodiscard]] u32 Size() const
+    {
+        return size;
+    }
+    [[nodiscard]] u32 Stride() const
+    {
+        return stride;
+    }
+
+    [[nodiscard]] f32* Slab(u32 s)
+    {
+        return data.data() + static_cast<size_t>(s) * stride;
+    }
+    [[nodiscard]] f32 const* Slab(u32 s) const
+    {
+        return data.data() + static_cast<size_t>(s) * stride;
+    }
+
+    [[nodiscard]] Dop14 Get(u32 i) const
+    {
+        Dop14 dop;
+        for (u32 s = 0; s < SLABS; ++s)
+            dop[s] = Slab(s)[i];
+        return dop;
+    }
+    void Set(u32 i, Dop14 const& dop)
+    {
+        for (u32 s = 0; s < SLABS; ++s)
+            Slab(s)[i] = dop[s];
+    }
+
+private:
+    std::vector<f32> data;
+    u32 size { 0 };
+    u32 stride { 0 };
+};
+
+// one dop per indexed triangle, out is resized to indices.size() / 3
+inline void dopFitTriangles(std::span<glm::vec3 const> vertices, std::span<u32 const> indices, Dop14Soa& out)
+{
+    using namespace simd;
+    auto const count { static_cast<u32>(indices.size() / 3) };
+    out.Resize(count);
+
+    auto const* v { reinterpret_cast<f32 const*>(vertices.data()) };
+    auto const* idx { indices.data() };
+
+    u32 i { 0 };
+    if constexpr (WIDTH > 1) {
+        for (; i + WIDTH <= count; i += WIDTH) {
+            auto const tri { (iota() + broadcastI(static_cast<i32>(i))) * 3 };
+            std::array<VecF, Dop14Soa::SLABS> d;
+            for (i32 k = 0; k < 3; ++k) {
+                auto const vId { gather(idx, tri + broadcastI(k)) * 3 };
+                auto const x { gather(v, vId) };
+                auto const y { gather(v, vId + broadcastI(1)) };
+                auto const z { gather(v, vId + broadcastI(2)) };
+                std::array<VecF, 7> const p { x, y, z, x + y + z, x + y - z, x - y + z, x - y - z };
+                for (u32 s = 0; s < 7; ++s) {
+                    d[2 * s + 0] = k == 0 ? p[s] : min(d[2 * s + 0], p[s]);
+                    d[2 * s + 1] = k == 0 ? p[s] : max(d[2 * s + 1], p[s]);
+                }
+            }
+            for (u32 s = 0; s < Dop14Soa::SLABS; ++s)
+                store(out.Slab(s) + i, d[s]);
+        }
+    }
+    for (; i < count; ++i)
+        out.Set(i, dopInit(vertices[idx[3 * i + 0]], vertices[idx[3 * i + 1]], vertices[idx[3 * i + 2]]));
+}
+
+// out[i] = bvFit(a[i], b[i]), out may alias a or b
+inline void dopMerge(Dop14Soa const& a, Dop14Soa const& b, Dop14Soa& out)
+{
+    using namespace simd;
+    auto const count { std::min(a.Size(), b.Size()) };
+    if (&out != &a && &out != &b)
+        out.Resize(count);
+
+    // rows are padded with empty dops, so the loop runs over whole vectors
+    for (u32 s = 0; s < Dop14Soa::SLABS; s += 2) {
+        auto const *aMin { a.Slab(s) }, *aMax { a.Slab(s + 1) };
+        auto const *bMin { b.Slab(s) }, *bMax { b.Slab(s + 1) };
+        auto *oMin { out.Slab(s) }, *oMax { out.Slab(s + 1) };
+        for (u32 i = 0; i < count; i += WIDTH) {
+            store(oMin + i, min(load(aMin + i), load(bMin + i)));
+            store(oMax + i, max(load(aMax + i), load(bMax + i)));
+        }
+    }
+}
+
+// out[i] = overlapDop(a[i], b[i]), out may alias a or b
+inline void dopOverlap(Dop14Soa const& a, Dop14Soa const& b, Dop14Soa& out)
+{
+    using namespace simd;
+    auto const count { std::min(a.Size(), b.Size()) };
+    if (&out != &a && &out != &b)
+        out.Resize(count);
+
+    auto const zero { broadcast(0.f) };
+    for (u32 i = 0; i < count; i += WIDTH) {
+        std::array<VecF, Dop14Soa::SLABS> d;
+        Mask empty { broadcast(1.f) < zero };
+        for (u32 s = 0; s < Dop14Soa::SLABS; s += 2) {
+            d[s + 0] = max(load(a.Slab(s + 0) + i), load(b.Slab(s + 0) + i));
+            d[s + 1] = min(load(a.Slab(s + 1) + i), load(b.Slab(s + 1) + i));
+            empty = empty | (d[s + 1] < d[s + 0]);
+        }
+        for (u32 s = 0; s < Dop14Soa::SLABS; ++s)
+            store(out.Slab(s) + i, select(empty, zero, d[s]));
+    }
+}
+
+// bounding dop of all entries
+[[nodiscard]] inline Dop14 dopReduce(Dop14Soa const& in)
+{
+    using namespace simd;
+    Dop14 dop { dopInit() };
+    for (u32 s = 0; s < Dop14Soa::SLABS; s += 2) {
+        auto vMin { broadcast(dop[s + 0]) };
+        auto vMax { broadcast(dop[s + 1]) };
+        for (u32 i = 0; i < in.Size(); i += WIDTH) {
+            vMin = min(vMin, load(in.Slab(s + 0) + i));
+            vMax = max(vMax, load(in.Slab(s + 1) + i));
+        }
+        std::array<f32, WIDTH> lMin, lMax;
+        store(lMin.data(), vMin);
+        store(lMax.data(), vMax);
+        for (u32 l = 0; l < WIDTH; ++l) {
+            dop[s + 0] = std::min(dop[s + 0], lMin[l]);
+            dop[s + 1] = std::max(dop[s + 1], lMax[l]);
+        }
+    }
+    return dop;
+}
+
+// out[i] = bvArea(in[i]), same corner cutting as the scalar version
+inline void dopArea(Dop14Soa const& in, std::span<f32> out)
+{
+    using namespace simd;
+    auto const count { std::min(in.Size(), static_cast<u32>(out.size())) };
+
+    u32 i { 0 };
+    if constexpr (WIDTH > 1) {
+        auto const scale { broadcast(1e3f) };
+        auto const zero { broadcast(0.f) };
+        auto const two { broadcast(2.f) };
+        auto const s { [&](VecF a, VecF b, VecF edge) { return max(zero, a + b - edge); } };
+
+        for (; i + WIDTH <= count; i += WIDTH) {
+            std::array<VecF, Dop14Soa::SLABS> dop;
+            for (u32 k = 0; k < Dop14Soa::SLABS; ++k)
+                dop[k] = load(in.Slab(k) + i) * scale;
+
+            auto const dx { dop[1] - dop[0] };
+            auto const dy { dop[3] - dop[2] };
+            auto const dz { dop[5] - dop[4] };
+            auto const result { two * (dx * dy + dx * dz + dz * dy) };
+            auto const dummy { (dop[0] <= broadcast(-1e30f)) & (broadcast(1e30f) <= dop[1]) };
+
+            std::array<VecF, 8> const d {
+                dop[6] - (dop[0] + dop[2] + dop[4]),
+                (dop[1] + dop[3] + dop[5]) - dop[7],
+                dop[8] - (dop[0] + dop[2] - dop[5]),
+                (dop[1] + dop[3] - dop[4]) - dop[9],
+                dop[10] - (dop[0] - dop[3] + dop[4]),
+                (dop[1] - dop[2] + dop[5]) - dop[11],
+                dop[12] - (dop[0] - dop[3] - dop[5]),
+                (dop[1] - dop[2] - dop[4]) - dop[13],
+            };
+
+            auto accToSubtract { zero };
+            for (auto const di : d)
+                accToSubtract = accToSubtract + di * di;
+
+            std::array<VecF, 12> const corner {
+                s(d[0], d[7], dx), s(d[1], d[6], dx), s(d[2], d[5], dx), s(d[3], d[4], dx),
+                s(d[0], d[4], dy), s(d[1], d[5], dy), s(d[2], d[6], dy), s(d[3], d[7], dy),
+                s(d[0], d[2], dz), s(d[1], d[3], dz), s(d[4], d[6], dz), s(d[5], d[7], dz)
+            };
+            auto accToAdd { zero };
+            for (auto const c : corner)
+                accToAdd = accToAdd + c * c;
+
+            auto const area { (result - accToSubtract * broadcast(.6339745962155614f) + accToAdd * broadcast(.13397459621556135f)) * broadcast(1e-6f) };
+            store(out.data() + i, select(dummy, result, area));
+        }
+    }
+    for (; i < count; ++i)
+        out[i] = bvArea(in.Get(i));
+}
+
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "../Simd.h"
+#include "Dop14.h"
+
+// host side of bv_obb.glsl
+namespace backend::cpu::bv {
+
+struct Obb {
+    glm::vec3 b0;
+    glm::vec3 b1;
+    glm::vec3 b2;
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+[[nodiscard]] inline f32 distancePointToEdge(glm::vec3 const& point, glm::vec3 const& edgePoint, glm::vec3 const& edgeDir)
+{
+    auto const u { point - edgePoint };
+    f32 const t { glm::dot(edgeDir, u) };
+    f32 const distSq { glm::dot(edgeDir, edgeDir) };
+    return glm::dot(u, u) - t * t / distSq;
+}
+
+[[nodiscard]] inline f32 obbCost(glm::vec3 dim)
+{
+    dim = glm::abs(dim);
+    return dim.x * dim.y + dim.y * dim.z + dim.z * dim.x;
+}
+
+// extremal points padded to 16 entries (by the first point) and stored per coordinate for simd projections
+struct ExtremalPointsSoa {
+    alignas(64) std::array<f32, 16> x;
+    alignas(64) std::array<f32, 16> y;
+    alignas(64) std::array<f32, 16> z;
+
+    explicit ExtremalPointsSoa(Dop14Points const& points)
+    {
+        for (u32 i = 0; i < 16; ++i) {
+            auto const& p { points[i < 14 ? i : 0] };
+            x[i] = p.x;
+            y[i] = p.y;
+            z[i] = p.z;
+        }
+    }
+};
+
+[[nodiscard]] inline glm::vec2 extremalPointsMinMax(ExtremalPointsSoa const& points, glm::vec3 const& normalizedAxis)
+{
+    using namespace simd;
+    auto const ax { broadcast(normalizedAxis.x) };
+    auto const ay { broadcast(normalizedAxis.y) };
+    auto const az { broadcast(normalizedAxis.z) };
+    auto const project { [&](u32 i) { return load(points.x.data() + i) * ax + load(points.y.data() + i) * ay + load(points.z.data() + i) * az; } };
+    auto vMin { project(0) };
+    auto vMax { vMin };
+    for (u32 i = WIDTH; i < 16; i += WIDTH) {
+        auto const dist { project(i) };
+        vMin = min(vMin, dist);
+        vMax = max(vMax, dist);
+    }
+    return { reduceMin(vMin), reduceMax(vMax) };
+}
+
+inline f32 extremalPointsDistance(Dop14Points const& points, glm::vec3 const& normalizedAxis, glm::ivec2& idx, glm::vec2& mDist)
+{
+    mDist = glm::vec2(glm::dot(points[0], normalizedAxis));
+    idx = glm::ivec2(0);
+    for (i32 i = 1; i < 14; ++i) {
+        f32 const dist { glm::dot(points[i], normalizedAxis) };
+        mDist.x = std::min(mDist.x, dist);
+        mDist.y = std::max(mDist.y, dist);
+        if (dist == mDist.x)
+            idx.x = i;
+        if (dist == mDist.y)
+            idx.y = i;
+    }
+    return mDist.y - mDist.x;
+}
+
+inline void refitObb(Obb& obb, glm::vec3 const& v)
+{
+    glm::vec3 const proj { glm::dot(v, obb.b0), glm::dot(v, obb.b1), glm::dot(v, obb.b2) };
+    obb.min = glm::min(obb.min, proj);
+    obb.max = glm::max(obb.max, proj);
+}
+
+// tests the three OBBs given by the triangle edges, its normal and the corresponding perpendicular axes
+inline void obbFromTriangle(Obb& obb, f32& minObbCost, ExtremalPointsSoa const& points, glm::vec3 const& e0, glm::vec3 const& e1, glm::vec3 const& e2, glm::vec3 const& n)
+{
+    auto const b2mm { extremalPointsMinMax(points, n) };
+    for (auto const& e : { e0, e1, e2 }) {
+        auto const obbAxis { glm::normalize(glm::cross(n, e)) };
+        auto const b0mm { extremalPointsMinMax(points, e) };
+        auto const b1mm { extremalPointsMinMax(points, obbAxis) };
+        f32 const cost { obbCost({ b0mm.y - b0mm.x, b1mm.y - b1mm.x, b2mm.y - b2mm.x }) };
+        if (cost < minObbCost) {
+            minObbCost = cost;
+            obb.b0 = e;
+            obb.b1 = obbAxis;
+            obb.b2 = n;
+            obb.min = { b0mm.x, b1mm.x, b2mm.x };
+            obb.max = { b0mm.y, b1mm.y, b2mm.y };
+        }
+    }
+}
+
+// expects obb initialized to aabb of the node
+inline void obbByDiTO14(Obb& obb, Dop14Points const& points)
+{
+    f32 minObbCost { obbCost(obb.max - obb.min) };
+
+    // find the ditetrahedron base triangle
+    // 1. find the two points that are furthest apart
+    glm::ivec3 baseTriangleIdx { 0, 1, 0 };
+    auto dVec { points[1] - points[0] };
+    f32 maxDistSq { glm::dot(dVec, dVec) };
+    for (i32 i = 1; i < 7; ++i) {
+        dVec = points[i * 2 + 1] - points[i * 2 + 0];
+        f32 const distSq { glm::dot(dVec, dVec) };
+        if (distSq > maxDistSq) {
+            maxDistSq = distSq;
+            baseTriangleIdx.x = i * 2 + 0;
+            baseTriangleIdx.y = i * 2 + 1;
+        }
+    }
+    auto const p0 { points[baseTriangleIdx.x] };
+    auto const p1 { points[baseTriangleIdx.y] };
+    auto const e0 { glm::normalize(p1 - p0) };
+    // 2. find the point furthest from the line between the two points
+    maxDistSq = distancePointToEdge(points[0], p0, e0);
+    for (i32 i = 1; i < 14; ++i) {
+        f32 const distSq { distancePointToEdge(points[i], p0, e0) };
+        if (distSq > maxDistSq) {
+            maxDistSq = distSq;
+            baseTriangleIdx.z = i;
+        }
+    }
+    auto const p2 { points[baseTriangleIdx.z] };
+    auto const e1 { glm::normalize(p2 - p0) };
+    auto const e2 { glm::normalize(p2 - p1) };
+    auto const normal { glm::normalize(glm::cross(e0, e1)) };
+
+    // 3. find the top and bottom tetrahedron points
+    glm::ivec2 ditPointsIdx;
+    glm::vec2 ditPointsDist;
+    extremalPointsDistance(points, normal, ditPointsIdx, ditPointsDist);
+
+    // form OBB axes from each triangle edge, normal and corresponding perpendicular axis
+    ExtremalPointsSoa const pointsSoa { points };
+    obbFromTriangle(obb, minObbCost, pointsSoa, e0, e1, e2, normal);
+
+    // test all triangles of the ditetrahedron for better OBB
+    auto const ditetrahedron { [&](glm::vec3 const& q) {
+        auto const m0 { glm::normalize(q - p0) };
+        auto const m1 { glm::normalize(q - p1) };
+        auto const m2 { glm::normalize(q - p2) };
+        auto const n0 { glm::normalize(glm::cross(m0, m1)) };
+        auto const n1 { glm::normalize(glm::cross(m1, m2)) };
+        auto const n2 { glm::normalize(glm::cross(m2, m0)) };
+
+        obbFromTriangle(obb, minObbCost, pointsSoa, e0, m0, m1, n0);
+        obbFromTriangle(obb, minObbCost, pointsSoa, e2, m1, m2, n1);
+        obbFromTriangle(obb, minObbCost, pointsSoa, e1, m2, m0, n2);
+    } };
+    if (std::abs(ditPointsDist.x) > .01f)
+        ditetrahedron(points[ditPointsIdx.x]);
+    if (std::abs(ditPointsDist.y) > .01f)
+        ditetrahedron(points[ditPointsIdx.y]);
+}
+
+[[nodiscard]] inline Dop14Points ditoDummy()
+{
+    Dop14Points points;
+    auto dop { dopInitWithPoints(glm::vec3(-BIG_FLOAT), points) };
+    bvFitWithPoints(dop, glm::vec3(BIG_FLOAT), points);
+    return points;
+}
+
+// surface area of the DiTO14 OBB fitted to the extremal points, used as the PLOC++ merge metric
+[[nodiscard]] inline f32 bvArea(Dop14Points const& points)
+{
+    Obb obb {
+        .b0 = { 1.f, 0.f, 0.f },
+        .b1 = { 0.f, 1.f, 0.f },
+        .b2 = { 0.f, 0.f, 1.f },
+        .min = { points[0].x, points[2].y, points[4].z },
+        .max = { points[1].x, points[3].y, points[5].z },
+    };
+    obbByDiTO14(obb, points);
+
+    auto const d { (obb.max - obb.min) * glm::vec3(glm::length(obb.b0), glm::length(obb.b1), glm::length(obb.b2)) };
+    return 2.f * (d.x * d.y + d.x * d.z + d.z * d.y);
+}
+
+[[nodiscard]] inline glm::vec3 aabbCentroid(Dop14Points const& points)
+{
+    return .5f * glm::vec3(points[0].x + points[1].x, points[2].y + points[3].y, points[4].z + points[5].z);
+}
+
+// OBB as the inverse of its unit cube transformation, flat OBBs are inflated to .001 half extent
+[[nodiscard]] inline glm::mat4x3 obbMatrix(Obb const& obb)
+{
+    auto const obbCenter_lcs { (obb.min + obb.max) * .5f };
+    auto const obbDim { glm::max((obb.max - obb.min) * .5f, glm::vec3(.001f)) };
+    auto const obbCenter_gcs { obb.b0 * obbCenter_lcs.x + obb.b1 * obbCenter_lcs.y + obb.b2 * obbCenter_lcs.z };
+
+    glm::mat4 const r { glm::vec4(obb.b0, 0.f), glm::vec4(obb.b1, 0.f), glm::vec4(obb.b2, 0.f), glm::vec4(0.f, 0.f, 0.f, 1.f) };
+    glm::mat4 const s {
+        glm::vec4(obbDim.x * 2.f, 0.f, 0.f, 0.f),
+        glm::vec4(0.f, obbDim.y * 2.f, 0.f, 0.f),
+        glm::vec4(0.f, 0.f, obbDim.z * 2.f, 0.f),
+        glm::vec4(0.f, 0.f, 0.f, 1.f),
+    };
+    glm::mat4 const t { glm::vec4(1.f, 0.f, 0.f, 0.f), glm::vec4(0.f, 1.f, 0.f, 0.f), glm::vec4(0.f, 0.f, 1.f, 0.f), glm::vec4(obbCenter_gcs, 1.f) };
+
+    return glm::mat4x3(glm::inverse(t * (r * s)));
+}
+
+// surface area of an OBB stored as the inverse transformation (world -> unit cube)
+[[nodiscard]] inline f32 bvArea(glm::mat4x3 const& m)
+{
+    auto const m0 { glm::inverse(glm::mat3(m)) };
+    glm::vec3 const scale { glm::length(m0[0]), glm::length(m0[1]), glm::length(m0[2]) };
+    return (scale.x * scale.y + scale.y * scale.z + scale.z * scale.x) * 2.f;
+}
+
+}
@@ -0,0 +1,61 @@
+#include "Cache.h"
+
+#include "../../../scene/Scene.h"
+#include "../../../scene/SceneCache.h"
+#include <bit>
+#include <format>
+#include <utility>
+
+namespace backend::cpu::bvh::cache {
+
+// bump when a build stage changes its output without a config change
+static constexpr u64 CACHE_VERSION { 1 };
+
+static constexpr size_t HASH_CHUNK_SIZE { 16 << 20 };
+
+u64 hashScene(Scene const& scene, Executor& executor)
+{
+    std::vector<std::span<std::byte const>> chunks;
+    for (auto const& g : scene.geometries)
+        for (auto const data : { std::as_bytes(g.Vertices()), std::as_bytes(g.Indices()) })
+            for (size_t offset = 0; offset < data.size(); offset += HASH_CHUNK_SIZE)
+                chunks.push_back(data.subspan(offset, std::min(HASH_CHUNK_SIZE, data.size() - offset)));
+
+    std::vector<u64> hashes(chunks.size());
+    parallelFor(executor, chunks.size(), [&](size_t i) {
+        hashes[i] = scene::cache::hashBytes(chunks[i]);
+    });
+
+    u64 h { scene.geometries.size() };
+    for (auto const hash : hashes)
+        h = scene::cache::hashCombine(h, hash);
+    return h;
+}
+
+u64 hashPipeline(config::BVHPipeline const& pipeline)
+{
+    auto const& p { pipeline };
+    u64 h { CACHE_VERSION };
+    for (u64 const v : {
+             static_cast<u64>(std::to_underlying(p.plocpp.bv)),
+             static_cast<u64>(std::to_underlying(p.plocpp.sfc)),
+             u64 { p.plocpp.radius },
+             static_cast<u64>(std::to_underlying(p.collapsing.bv)),
+             u64 { p.collapsing.maxLeafSize },
+             u64 { std::bit_cast<u32>(p.collapsing.c_t) },
+             u64 { std::bit_cast<u32>(p.collapsing.c_i) },
+             static_cast<u64>(std::to_underlying(p.transformation.bv)),
+             static_cast<u64>(std::to_underlying(p.compression.bv)),
+             static_cast<u64>(std::to_underlying(p.compression.layout)),
+             static_cast<u64>(std::to_underlying(p.reordering.order)),
+         })
+        h = scene::cache::hashCombine(h, v);
+    return h;
+}
+
+std::filesystem::path entry(std::filesystem::path const& cacheDir, Key const& key)
+{
+    return cacheDir / std::format("{:016x}-{:016x}.bvh", key.sceneHash, key.pipelineHash);
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include <filesystem>
+
+struct Scene;
+
+// cache of built BVHs, entries are '*.bvh' files (see Serialization.h) named by their key
+namespace backend::cpu::bvh::cache {
+
+// key of a built BVH: scene geometry + the configuration of every build stage
+struct Key {
+    u64 sceneHash { 0 };
+    u64 pipelineHash { 0 };
+};
+
+// vertices and indices of all geometries, hashed in parallel chunks and combined in order
+[[nodiscard]] u64 hashScene(Scene const& scene, Executor& executor);
+// PLOC++ to reordering, the name, stats and tracer settings do not change the BVH
+[[nodiscard]] u64 hashPipeline(config::BVHPipeline const& pipeline);
+// cached '*.bvh' file for the key, it may not exist yet
+[[nodiscard]] std::filesystem::path entry(std::filesystem::path const& cacheDir, Key const& key);
+
+}
@@ -0,0 +1,340 @@
+#include "Collapsing.h"
+
+#include "../../../core/Profiler.h"
+#include "../../../scene/Scene.h"
+#include "../bv/Obb.h"
+#include <atomic>
+#include <limits>
+
+namespace backend::cpu::bvh {
+
+template<config::BV>
+struct Volume;
+
+template<>
+struct Volume<config::BV::eAABB> {
+    using Node = data_bvh::NodeBvhBinary;
+    using NodeCollapsed = data_bvh::NodeBvhBinary;
+    using BV = bv::Aabb;
+};
+
+template<>
+struct Volume<config::BV::eDOP14> {
+    using Node = data_bvh::NodeBvhBinaryDOP14;
+    using NodeCollapsed = data_bvh::NodeBvhBinaryDOP14;
+    using BV = bv::Dop14;
+};
+
+template<>
+struct Volume<config::BV::eOBB> {
+    using Node = data_bvh::NodeBvhBinaryDiTO14Points;
+    using NodeCollapsed = data_bvh::NodeBvhBinaryOBB;
+    using BV = bv::Dop14Points;
+};
+
+enum class NodeState : u8 {
+    eInvalid,
+    eSubtree,
+    eLeaf,
+};
+
+static constexpr size_t CHUNK_SIZE { 1 << 14 };
+
+Collapsing::Collapsing(Executor& executor)
+    : executor(executor)
+{
+}
+
+void Collapsing::Compute(Bvh const& inputBvh, Scene const& scene)
+{
+    PROFILE_ZONE("collapsing");
+    switch (config.bv) {
+    case config::BV::eAABB:
+        collapse<config::BV::eAABB>(inputBvh, scene);
+        break;
+    case config::BV::eDOP14:
+        collapse<config::BV::eDOP14>(inputBvh, scene);
+        break;
+    case config::BV::eOBB:
+        collapse<config::BV::eOBB>(inputBvh, scene);
+        break;
+    case config::BV::eNone:
+        break;
+    }
+}
+
+template<config::BV BV>
+void Collapsing::collapse(Bvh const& inputBvh, Scene const& scene)
+{
+    using Node = typename Volume<BV>::Node;
+    using NodeCollapsed = typename Volume<BV>::NodeCollapsed;
+    using Bv = typename Volume<BV>::BV;
+
+    metadata = {};
+    timeTotal = 0.f;
+    bvh = {};
+
+    u32 const leafNodeCount { inputBvh.nodeCountLeaf };
+    if (leafNodeCount == 0)
+        return;
+
+    Stopwatch stopwatch;
+
+    auto const nodes { inputBvh.Nodes<Node>() };
+    u32 const totalNodeCount { 2 * leafNodeCount - 1 };
+    u32 const rootId { totalNodeCount - 1 };
+
+    std::vector<std::atomic<u32>> counter(totalNodeCount);
+    std::vector<NodeState> nodeState(totalNodeCount, NodeState::eInvalid);
+    std::vector<f32> sahCost(totalNodeCount);
+    std::vector<u32> leafId(leafNodeCount);
+
+    // 1. bottom-up SAH cost, the second child to arrive at a node evaluates it
+    parallelForChunks(executor, leafNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto nodeId { static_cast<i32>(begin) }; nodeId < static_cast<i32>(end); ++nodeId) {
+            // leaf node size is always 1
+            sahCost[nodeId] = bv::bvArea(loadBv<Bv>(nodes[nodeId])) * config.c_i;
+            nodeState[nodeId] = NodeState::eLeaf;
+
+            i32 id { nodes[nodeId].parent };
+            while (id != INVALID_ID && counter[id].fetch_add(1, std::memory_order_acq_rel) > 0) {
+                auto const& node { nodes[id] };
+                f32 const nodeSurfaceArea { bv::bvArea(loadBv<Bv>(node)) };
+
+                f32 const costAsSubtree { nodeSurfaceArea * config.c_t + sahCost[node.c0] + sahCost[node.c1] };
+                f32 costAsLeaf { std::numeric_limits<f32>::max() };
+                if (static_cast<u32>(node.size) <= config.maxLeafSize)
+                    costAsLeaf = nodeSurfaceArea * static_cast<f32>(node.size) * config.c_i;
+
+                if (costAsSubtree > costAsLeaf) {
+                    nodeState[id] = NodeState::eLeaf;
+                    sahCost[id] = costAsLeaf;
+                } else {
+                    nodeState[id] = NodeState::eSubtree;
+                    sahCost[id] = costAsSubtree;
+                }
+                id = node.parent;
+            }
+        }
+    });
+
+    // 2. the topmost leaf on the path to the root becomes the collapsed leaf of the triangle
+    parallelForChunks(executor, leafNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto nodeId { static_cast<u32>(begin) }; nodeId < end; ++nodeId) {
+            u32 leafNodeId { nodeId };
+            for (i32 id { nodes[nodeId].parent }; id != INVALID_ID; id = nodes[id].parent)
+                if (nodeState[id] == NodeState::eLeaf)
+                    leafNodeId = static_cast<u32>(id);
+            leafId[nodeId] = leafNodeId;
+        }
+    });
+
+    // 3. invalidate the nodes below the collapsed leaves, each node is visited once thanks to the counters
+    for (auto& c : counter)
+        c.store(0, std::memory_order_relaxed);
+    parallelForChunks(executor, leafNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto nodeId { static_cast<u32>(begin) }; nodeId < end; ++nodeId) {
+            u32 const leafNodeId { leafId[nodeId] };
+            if (nodeId == leafNodeId)
+                continue;
+            nodeState[nodeId] = NodeState::eInvalid;
+
+            i32 id { nodes[nodeId].parent };
+            while (id != INVALID_ID && counter[id].fetch_add(1, std::memory_order_acq_rel) > 0) {
+                if (static_cast<u32>(id) == leafNodeId)
+                    break;
+                nodeState[id] = NodeState::eInvalid;
+                id = nodes[id].parent;
+            }
+        }
+    });
+
+    // 4. new node ids and triangle offsets, prefix sums in the original node order
+    //   the root is kept out of the interior ids and placed last
+    u32 const chunkCount { static_cast<u32>((totalNodeCount + CHUNK_SIZE - 1) / CHUNK_SIZE) };
+    struct ChunkCounts {
+        u32 subtree { 0 };
+        u32 leaf { 0 };
+        u32 triangle { 0 };
+    };
+    std::vector<ChunkCounts> chunkCounts(chunkCount);
+    parallelForChunks(executor, totalNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto& counts { chunkCounts[begin / CHUNK_SIZE] };
+        for (auto nodeId { begin }; nodeId < end; ++nodeId) {
+            if (nodeState[nodeId] == NodeState::eSubtree && nodeId != rootId)
+                ++counts.subtree;
+            if (nodeState[nodeId] == NodeState::eLeaf) {
+                ++counts.leaf;
+                counts.triangle += static_cast<u32>(nodes[nodeId].size);
+            }
+        }
+    });
+    ChunkCounts sum;
+    for (auto& counts : chunkCounts) {
+        auto const c { counts };
+        counts = sum;
+        sum.subtree += c.subtree;
+        sum.leaf += c.leaf;
+        sum.triangle += c.triangle;
+    }
+
+    std::vector<i32> nodeIdNew(totalNodeCount);
+    std::vector<i32> triOffsetNew(totalNodeCount);
+    parallelForChunks(executor, totalNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto counts { chunkCounts[begin / CHUNK_SIZE] };
+        for (auto nodeId { begin }; nodeId < end; ++nodeId) {
+            if (nodeState[nodeId] == NodeState::eSubtree && nodeId != rootId)
+                nodeIdNew[nodeId] = static_cast<i32>(counts.subtree++);
+            if (nodeState[nodeId] == NodeState::eLeaf) {
+                nodeIdNew[nodeId] = static_cast<i32>(counts.leaf++);
+                triOffsetNew[nodeId] = static_cast<i32>(counts.triangle);
+                counts.triangle += static_cast<u32>(nodes[nodeId].size);
+            }
+        }
+    });
+    // root id is resolved in the collapse step
+    nodeIdNew[rootId] = INVALID_ID;
+
+    auto const numberOfLeaves { static_cast<i32>(sum.leaf) };
+    auto const numberOfSubtrees { static_cast<i32>(sum.subtree) };
+    metadata.nodeCountLeaf = sum.leaf;
+    // a root collapsed into a single leaf occupies slot 0 and the tree has one node
+    metadata.nodeCountTotal = nodeState[rootId] == NodeState::eLeaf ? sum.leaf : sum.subtree + sum.leaf + 1;
+
+    bvh.nodes.resize(sizeof(NodeCollapsed) * metadata.nodeCountTotal);
+    bvh.triangles.resize(leafNodeCount);
+    bvh.triangleIDs.resize(leafNodeCount);
+    bvh.nodeCountLeaf = metadata.nodeCountLeaf;
+    bvh.nodeCountTotal = metadata.nodeCountTotal;
+    bvh.bv = BV;
+    bvh.layout = Bvh::Layout::eBinaryStandard;
+    auto const nodesCollapsed { bvh.Nodes<NodeCollapsed>() };
+
+    // OBB only, DiTO14 fit of each collapsed node, indexed by the new node id
+    std::vector<bv::Obb> obbs;
+    if constexpr (BV == config::BV::eOBB)
+        obbs.resize(metadata.nodeCountTotal);
+
+    // 5. write the collapsed nodes and copy the triangles of each collapsed leaf in depth-first order
+    parallelForChunks(executor, totalNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        std::vector<i32> stack;
+        for (auto nodeId { begin }; nodeId < end; ++nodeId) {
+            auto const myState { nodeState[nodeId] };
+            if (myState == NodeState::eInvalid)
+                continue;
+
+            i32 newNodeId { nodeIdNew[nodeId] };
+            // unresolved root remap to keep root on defined (last) position
+            if (nodeId == rootId)
+                newNodeId = numberOfSubtrees;
+            if (myState == NodeState::eSubtree)
+                newNodeId += numberOfLeaves;
+
+            auto const& node { nodes[nodeId] };
+            NodeCollapsed result;
+            result.size = node.size;
+            result.parent = INVALID_ID;
+            if (node.parent != INVALID_ID) {
+                i32 newParentOffset { nodeIdNew[node.parent] };
+                if (newParentOffset == INVALID_ID)
+                    newParentOffset = numberOfSubtrees;
+                result.parent = newParentOffset + numberOfLeaves;
+            }
+
+            if (myState == NodeState::eLeaf) {
+                result.c0 = triOffsetNew[nodeId];
+                result.c1 = result.c0 + node.size;
+                result.size = -node.size;
+
+                auto triOffset { static_cast<u32>(result.c0) };
+                stack.push_back(static_cast<i32>(nodeId));
+                while (!stack.empty()) {
+                    auto const id { stack.back() };
+                    stack.pop_back();
+                    if (static_cast<u32>(id) < leafNodeCount) {
+                        bvh.triangles[triOffset] = inputBvh.triangles[id];
+                        bvh.triangleIDs[triOffset] = inputBvh.triangleIDs[id];
+                        ++triOffset;
+                        continue;
+                    }
+                    stack.push_back(nodes[id].c1);
+                    stack.push_back(nodes[id].c0);
+                }
+            } else {
+                result.c0 = (nodeState[node.c0] == NodeState::eLeaf) ? -nodeIdNew[node.c0] : nodeIdNew[node.c0] + numberOfLeaves;
+                result.c1 = (nodeState[node.c1] == NodeState::eLeaf) ? -nodeIdNew[node.c1] : nodeIdNew[node.c1] + numberOfLeaves;
+            }
+
+            if constexpr (BV == config::BV::eOBB) {
+                auto const points { loadBv<Bv>(node) };
+                auto& obb { obbs[newNodeId] };
+                obb = {
+                    .b0 = { 1.f, 0.f, 0.f },
+                    .b1 = { 0.f, 1.f, 0.f },
+                    .b2 = { 0.f, 0.f, 1.f },
+                    .min = { points[0].x, points[2].y, points[4].z },
+                    .max = { points[1].x, points[3].y, points[5].z },
+                };
+                bv::obbByDiTO14(obb, points);
+            } else
+                storeBv(result, loadBv<Bv>(node));
+
+            nodesCollapsed[newNodeId] = result;
+        }
+    });
+
+    // 6. OBB only, refit the OBBs on the path to the root by the leaf triangles and store them as matrices
+    if constexpr (BV == config::BV::eOBB) {
+        parallelForChunks(executor, metadata.nodeCountLeaf, CHUNK_SIZE, [&](size_t begin, size_t end) {
+            std::vector<glm::vec3> points;
+            for (auto nodeId { static_cast<i32>(begin) }; nodeId < static_cast<i32>(end); ++nodeId) {
+                auto const& leaf { nodesCollapsed[nodeId] };
+                points.clear();
+                for (i32 triId = leaf.c0; triId < leaf.c1; ++triId) {
+                    auto const& ids { bvh.triangleIDs[triId] };
+                    auto const& g { scene.geometries[ids.nodeId] };
+                    auto const vertices { g.Vertices() };
+                    auto const indices { g.Indices() };
+                    for (u32 i = 0; i < 3; ++i)
+                        points.push_back(vertices[indices[ids.triangleId * 3 + i]]);
+                }
+
+                for (i32 id { nodeId }; id != INVALID_ID; id = nodesCollapsed[id].parent) {
+                    auto& obb { obbs[id] };
+                    bv::Obb fobb { obb.b0, obb.b1, obb.b2, glm::vec3(std::numeric_limits<f32>::max()), glm::vec3(std::numeric_limits<f32>::lowest()) };
+                    for (auto const& p : points)
+                        bv::refitObb(fobb, p);
+                    for (i32 axis = 0; axis < 3; ++axis) {
+                        atomicMin(obb.min[axis], fobb.min[axis]);
+                        atomicMax(obb.max[axis], fobb.max[axis]);
+                    }
+                }
+            }
+        });
+        parallelForChunks(executor, metadata.nodeCountTotal, CHUNK_SIZE, [&](size_t begin, size_t end) {
+            for (auto nodeId { begin }; nodeId < end; ++nodeId)
+                storeBv(nodesCollapsed[nodeId], bv::obbMatrix(obbs[nodeId]));
+        });
+    }
+
+    timeTotal = stopwatch.Lap();
+}
+
+stats::Collapsing Collapsing::GatherStats(BvhStats const& bvhStats) const
+{
+    stats::Collapsing stats;
+    stats.timeTotal = timeTotal;
+
+    stats.saIntersect = bvhStats.saIntersect;
+    stats.saTraverse = bvhStats.saTraverse;
+    stats.costTotal = bvhStats.costIntersect + bvhStats.costTraverse;
+
+    stats.nodeCountTotal = metadata.nodeCountTotal;
+    stats.leafSizeMin = bvhStats.leafSizeMin;
+    stats.leafSizeMax = bvhStats.leafSizeMax;
+    stats.leafSizeAvg = static_cast<f32>(bvhStats.leafSizeSum) / static_cast<f32>(metadata.nodeCountLeaf);
+
+    return stats;
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "Types.h"
+
+struct Scene;
+
+namespace backend::cpu::bvh {
+
+// host implementation of vulkan::bvh::Collapsing, SAH driven collapse of a binary PLOC++ tree into multi-triangle leaves
+//   output layout: leaves [0, nodeCountLeaf), interior nodes after them, root is the last node
+//   leaves store [c0, c1) triangle range and negative size, interior children referencing leaves are negated leaf ids
+//   OBB trees are fitted by DiTO14 per collapsed node, refitted to the leaf triangles and stored as NodeBvhBinaryOBB
+struct Collapsing {
+    explicit Collapsing(Executor& executor);
+
+    [[nodiscard]] Bvh const& GetBVH() const
+    {
+        return bvh;
+    }
+    [[nodiscard]] bool NeedsRecompute(config::Collapsing const& buildConfig)
+    {
+        auto const cfgChanged { config != buildConfig };
+        config = buildConfig;
+        return cfgChanged && config.bv != config::BV::eNone;
+    }
+
+    void Compute(Bvh const& inputBvh, Scene const& scene);
+    [[nodiscard]] stats::Collapsing GatherStats(BvhStats const& bvhStats) const;
+
+private:
+    Executor& executor;
+    config::Collapsing config;
+    Bvh bvh;
+
+    struct Metadata {
+        u32 nodeCountLeaf { 0 };
+        u32 nodeCountTotal { 0 };
+    } metadata;
+    f32 timeTotal { 0.f };
+
+    template<config::BV BV>
+    void collapse(Bvh const& inputBvh, Scene const& scene);
+};
+
+}
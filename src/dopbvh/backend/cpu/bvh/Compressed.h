@@ -0,0 +1,158 @@
+#pragma once
+
+#include "../bv/Dop14.h"
+#include "Types.h"
+#include <glm/mat4x3.hpp>
+
+// host side of bvh_compressed_binary.glsl, child bounding volumes of the compressed binary node layouts
+namespace backend::cpu::bvh {
+
+// leaf child reference: sign (isLeafFlag) : 1; leafSize : 4; triAddress : 27;
+//   size is the negative leaf size of the collapsed node, the encoding keeps its low 4 bits
+[[nodiscard]] inline i32 encodeLeaf(i32 size, i32 triOffset)
+{
+    return -((size & 0xF) << 27) | triOffset;
+}
+[[nodiscard]] inline u32 leafSize(i32 child)
+{
+    return static_cast<u32>((child >> 27) & 0xF);
+}
+[[nodiscard]] inline u32 leafTriangleOffset(i32 child)
+{
+    return static_cast<u32>(child & 0x07FFFFFF);
+}
+
+// AABB in the c0|c1 interleaved x, y slabs followed by the z slabs
+inline void setBoxC0(data_bvh::NodeBvhBinaryCompressed& node, bv::Aabb const& c0Box)
+{
+    node.bv[0] = c0Box.min.x;
+    node.bv[1] = c0Box.max.x;
+    node.bv[2] = c0Box.min.y;
+    node.bv[3] = c0Box.max.y;
+    node.bv[8] = c0Box.min.z;
+    node.bv[9] = c0Box.max.z;
+}
+
+inline void setBoxC1(data_bvh::NodeBvhBinaryCompressed& node, bv::Aabb const& c1Box)
+{
+    node.bv[4] = c1Box.min.x;
+    node.bv[5] = c1Box.max.x;
+    node.bv[6] = c1Box.min.y;
+    node.bv[7] = c1Box.max.y;
+    node.bv[10] = c1Box.min.z;
+    node.bv[11] = c1Box.max.z;
+}
+
+[[nodiscard]] inline bv::Aabb getBoxC0(data_bvh::NodeBvhBinaryCompressed const& node)
+{
+    return { { node.bv[0], node.bv[2], node.bv[8] }, { node.bv[1], node.bv[3], node.bv[9] } };
+}
+
+[[nodiscard]] inline bv::Aabb getBoxC1(data_bvh::NodeBvhBinaryCompressed const& node)
+{
+    return { { node.bv[4], node.bv[6], node.bv[10] }, { node.bv[5], node.bv[7], node.bv[11] } };
+}
+
+// DOP14 interleaved c0|c1 layout
+// bv[0] = c0[0]
+// bv[1] = c0[1]
+// bv[2] = c1[0]
+// bv[3] = c1[1]
+// ...
+inline void setBoxC0(data_bvh::NodeBvhBinaryDOP14Compressed& node, bv::Dop14 const& c0Dop)
+{
+    for (u32 i = 0; i < 7; ++i) {
+        node.bv[4 * i] = c0Dop[2 * i];
+        node.bv[4 * i + 1] = c0Dop[2 * i + 1];
+    }
+}
+
+inline void setBoxC1(data_bvh::NodeBvhBinaryDOP14Compressed& node, bv::Dop14 const& c1Dop)
+{
+    for (u32 i = 0; i < 7; ++i) {
+        node.bv[4 * i + 2] = c1Dop[2 * i];
+        node.bv[4 * i + 3] = c1Dop[2 * i + 1];
+    }
+}
+
+[[nodiscard]] inline bv::Dop14 getBoxC0(data_bvh::NodeBvhBinaryDOP14Compressed const& node)
+{
+    bv::Dop14 result;
+    for (u32 i = 0; i < 7; ++i) {
+        result[2 * i] = node.bv[4 * i];
+        result[2 * i + 1] = node.bv[4 * i + 1];
+    }
+    return result;
+}
+
+[[nodiscard]] inline bv::Dop14 getBoxC1(data_bvh::NodeBvhBinaryDOP14Compressed const& node)
+{
+    bv::Dop14 result;
+    for (u32 i = 0; i < 7; ++i) {
+        result[2 * i] = node.bv[4 * i + 2];
+        result[2 * i + 1] = node.bv[4 * i + 3];
+    }
+    return result;
+}
+
+// DOP14 split layout, the AABB slabs stay in the main node, the 4 diagonal slabs go to the aux node
+inline void setBoxC0(data_bvh::NodeBvhBinaryCompressed& node, bv::Dop14 const& c0Dop)
+{
+    setBoxC0(node, bv::Aabb { { c0Dop[0], c0Dop[2], c0Dop[4] }, { c0Dop[1], c0Dop[3], c0Dop[5] } });
+}
+
+inline void setBoxC1(data_bvh::NodeBvhBinaryCompressed& node, bv::Dop14 const& c1Dop)
+{
+    setBoxC1(node, bv::Aabb { { c1Dop[0], c1Dop[2], c1Dop[4] }, { c1Dop[1], c1Dop[3], c1Dop[5] } });
+}
+
+inline void setBoxC0(data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT& node, bv::Dop14 const& c0Dop)
+{
+    memcpy(node.bv, c0Dop.data() + 6, 8 * sizeof(f32));
+}
+
+inline void setBoxC1(data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT& node, bv::Dop14 const& c1Dop)
+{
+    memcpy(node.bv + 8, c1Dop.data() + 6, 8 * sizeof(f32));
+}
+
+[[nodiscard]] inline bv::Dop14 getBoxC0(data_bvh::NodeBvhBinaryCompressed const& node, data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT const& nodeSplit)
+{
+    bv::Dop14 result { node.bv[0], node.bv[1], node.bv[2], node.bv[3], node.bv[8], node.bv[9] };
+    memcpy(result.data() + 6, nodeSplit.bv, 8 * sizeof(f32));
+    return result;
+}
+
+[[nodiscard]] inline bv::Dop14 getBoxC1(data_bvh::NodeBvhBinaryCompressed const& node, data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT const& nodeSplit)
+{
+    bv::Dop14 result { node.bv[4], node.bv[5], node.bv[6], node.bv[7], node.bv[10], node.bv[11] };
+    memcpy(result.data() + 6, nodeSplit.bv + 8, 8 * sizeof(f32));
+    return result;
+}
+
+// OBB as two world -> unit cube matrices
+inline void setBoxC0(data_bvh::NodeBvhBinaryOBBCompressed& node, glm::mat4x3 const& m0)
+{
+    memcpy(node.bv, &m0, sizeof(m0));
+}
+
+inline void setBoxC1(data_bvh::NodeBvhBinaryOBBCompressed& node, glm::mat4x3 const& m1)
+{
+    memcpy(node.bv + 12, &m1, sizeof(m1));
+}
+
+[[nodiscard]] inline glm::mat4x3 getBoxC0(data_bvh::NodeBvhBinaryOBBCompressed const& node)
+{
+    glm::mat4x3 result;
+    memcpy(&result, node.bv, sizeof(result));
+    return result;
+}
+
+[[nodiscard]] inline glm::mat4x3 getBoxC1(data_bvh::NodeBvhBinaryOBBCompressed const& node)
+{
+    glm::mat4x3 result;
+    memcpy(&result, node.bv + 12, sizeof(result));
+    return result;
+}
+
+}
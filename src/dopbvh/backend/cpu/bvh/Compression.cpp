@@ -0,0 +1,401 @@
+#include "Compression.h"
+
+#include "../../../core/Profiler.h"
+#include "../bv/Obb.h"
+#include "Compressed.h"
+#include "Quantized.h"
+#include "Wide.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+
+namespace backend::cpu::bvh {
+
+template<config::BV>
+struct CompressedVolume;
+
+template<>
+struct CompressedVolume<config::BV::eAABB> {
+    using Node = data_bvh::NodeBvhBinary;
+    using NodeCompressed = data_bvh::NodeBvhBinaryCompressed;
+    using BV = bv::Aabb;
+};
+
+template<>
+struct CompressedVolume<config::BV::eDOP14> {
+    using Node = data_bvh::NodeBvhBinaryDOP14;
+    using NodeCompressed = data_bvh::NodeBvhBinaryDOP14Compressed;
+    using BV = bv::Dop14;
+};
+
+template<>
+struct CompressedVolume<config::BV::eOBB> {
+    using Node = data_bvh::NodeBvhBinaryOBB;
+    using NodeCompressed = data_bvh::NodeBvhBinaryOBBCompressed;
+    using BV = glm::mat4x3;
+};
+
+static constexpr size_t CHUNK_SIZE { 1 << 14 };
+
+Compression::Compression(Executor& executor)
+    : executor(executor)
+{
+}
+
+bool Compression::Compute(Bvh const& inputBvh)
+{
+    PROFILE_ZONE("compression");
+    // the output of a previous config must not outlive a rejected one
+    metadata = {};
+    timeTotal = 0.f;
+    bvh = {};
+
+    if (inputBvh.bv != config.bv || inputBvh.layout != Bvh::Layout::eBinaryStandard) {
+        berry::Log::error("Compression: input BVH does not match the compressed bounding volume");
+        return false;
+    }
+
+    auto const cpuOnly { config.layout != config::CompressedLayout::eBinaryStandard && config.layout != config::CompressedLayout::eBinaryDOP14Split };
+    if (cpuOnly && config.bv == config::BV::eOBB) {
+        berry::Log::error("Compression: wide and quantized layouts are AABB or DOP14 only");
+        return false;
+    }
+
+    switch (config.bv) {
+    case config::BV::eAABB:
+        if (config.layout == config::CompressedLayout::eWide4)
+            compressWide<config::BV::eAABB, 4>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eWide8)
+            compressWide<config::BV::eAABB, 8>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eBinaryQuantized8)
+            compressQuantized<config::BV::eAABB, u8>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eBinaryQuantized16)
+            compressQuantized<config::BV::eAABB, u16>(inputBvh);
+        else
+            compress<config::BV::eAABB, Bvh::Layout::eBinaryCompressed>(inputBvh);
+        break;
+    case config::BV::eDOP14:
+        if (config.layout == config::CompressedLayout::eWide4)
+            compressWide<config::BV::eDOP14, 4>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eWide8)
+            compressWide<config::BV::eDOP14, 8>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eBinaryQuantized8)
+            compressQuantized<config::BV::eDOP14, u8>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eBinaryQuantized16)
+            compressQuantized<config::BV::eDOP14, u16>(inputBvh);
+        else if (config.layout == config::CompressedLayout::eBinaryDOP14Split)
+            compress<config::BV::eDOP14, Bvh::Layout::eBinaryCompressed_dop14Split>(inputBvh);
+        else
+            compress<config::BV::eDOP14, Bvh::Layout::eBinaryCompressed>(inputBvh);
+        break;
+    case config::BV::eOBB:
+        compress<config::BV::eOBB, Bvh::Layout::eBinaryCompressed>(inputBvh);
+        break;
+    case config::BV::eNone:
+        break;
+    }
+    return bvh.nodeCountTotal != 0;
+}
+
+template<config::BV BV, Bvh::Layout Layout>
+void Compression::compress(Bvh const& inputBvh)
+{
+    static constexpr bool SPLIT { Layout == Bvh::Layout::eBinaryCompressed_dop14Split };
+    using Node = typename CompressedVolume<BV>::Node;
+    using NodeCompressed = std::conditional_t<SPLIT, data_bvh::NodeBvhBinaryCompressed, typename CompressedVolume<BV>::NodeCompressed>;
+    using NodeSplit = data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT;
+    using Bv = typename CompressedVolume<BV>::BV;
+
+    metadata = {};
+    timeTotal = 0.f;
+    bvh = {};
+
+    // a root collapsed into a single leaf has no interior node to hold it
+    if (inputBvh.nodeCountTotal < 3) {
+        berry::Log::warn("Compression: BVH without interior nodes, skipped");
+        return;
+    }
+
+    Stopwatch stopwatch;
+
+    auto const nodes { inputBvh.Nodes<Node>() };
+    metadata.nodeCountLeaf = inputBvh.nodeCountLeaf;
+    metadata.nodeCountTotal = (inputBvh.nodeCountTotal - 1) / 2;
+
+    bvh.nodes.resize(sizeof(NodeCompressed) * metadata.nodeCountTotal);
+    if constexpr (SPLIT)
+        bvh.aux.resize(sizeof(NodeSplit) * metadata.nodeCountTotal);
+    bvh.triangles = inputBvh.triangles;
+    bvh.triangleIDs = inputBvh.triangleIDs;
+    bvh.nodeCountLeaf = metadata.nodeCountLeaf;
+    bvh.nodeCountTotal = metadata.nodeCountTotal;
+    bvh.bv = BV;
+    bvh.layout = Layout;
+    auto const nodesCompressed { bvh.Nodes<NodeCompressed>() };
+    auto const nodesSplit { bvh.Aux<NodeSplit>() };
+
+    // the root keeps the child references of the old root, the rest is resolved level by level
+    auto const& oldRoot { nodes[inputBvh.nodeCountTotal - 1] };
+    nodesCompressed[0].parent = INVALID_ID;
+    nodesCompressed[0].c0 = oldRoot.c0;
+    nodesCompressed[0].c1 = oldRoot.c1;
+    nodesCompressed[0].size = oldRoot.size;
+
+    std::vector<u32> chunkOffsets;
+    u32 levelBegin { 0 };
+    u32 levelEnd { 1 };
+    while (levelBegin < levelEnd) {
+        u32 const levelNodeCount { levelEnd - levelBegin };
+        chunkOffsets.assign((levelNodeCount + CHUNK_SIZE - 1) / CHUNK_SIZE, 0);
+
+        // 1. child bounding volumes, larger child first, leaf children are encoded in place
+        //   interior children keep the old node id until step 2
+        parallelForChunks(executor, levelNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+            auto& nonLeafChildCount { chunkOffsets[begin / CHUNK_SIZE] };
+            for (auto i { begin }; i < end; ++i) {
+                auto const nodeId { levelBegin + static_cast<u32>(i) };
+                auto& node { nodesCompressed[nodeId] };
+
+                auto bv0 { loadBv<Bv>(nodes[std::abs(node.c0)]) };
+                auto bv1 { loadBv<Bv>(nodes[std::abs(node.c1)]) };
+                auto sa0 { bv::bvArea(bv0) };
+                auto sa1 { bv::bvArea(bv1) };
+                if (sa1 > sa0) {
+                    std::swap(node.c0, node.c1);
+                    std::swap(bv0, bv1);
+                    std::swap(sa0, sa1);
+                }
+
+                if constexpr (SPLIT) {
+                    // children whose DOP14 is notably tighter than their AABB vote for the diagonal slab test
+                    i32 voteMask { 0 };
+                    if (sa0 < .75f * bv::aabbSurfaceArea(bv0))
+                        voteMask |= 1;
+                    if (sa1 < .75f * bv::aabbSurfaceArea(bv1))
+                        voteMask |= 2;
+                    node.parent = voteMask;
+
+                    setBoxC0(nodesSplit[nodeId], bv0);
+                    setBoxC1(nodesSplit[nodeId], bv1);
+                }
+                setBoxC0(node, bv0);
+                setBoxC1(node, bv1);
+
+                for (auto* c : { &node.c0, &node.c1 }) {
+                    if (*c > 0)
+                        ++nonLeafChildCount;
+                    else {
+                        auto const& cNode { nodes[-*c] };
+                        *c = encodeLeaf(cNode.size, cNode.c0);
+                    }
+                }
+            }
+        });
+
+        u32 nextLevelNodeCount { 0 };
+        for (auto& offset : chunkOffsets) {
+            auto const count { offset };
+            offset = nextLevelNodeCount;
+            nextLevelNodeCount += count;
+        }
+
+        // 2. interior children get consecutive ids after this level, in the node order of this level
+        parallelForChunks(executor, levelNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+            auto childId { static_cast<i32>(levelEnd + chunkOffsets[begin / CHUNK_SIZE]) };
+            for (auto i { begin }; i < end; ++i) {
+                auto const nodeId { static_cast<i32>(levelBegin + i) };
+                auto& node { nodesCompressed[nodeId] };
+                for (auto* c : { &node.c0, &node.c1 }) {
+                    if (*c <= 0)
+                        continue;
+                    auto const& cNode { nodes[*c] };
+                    auto& child { nodesCompressed[childId] };
+                    child.parent = nodeId;
+                    child.c0 = cNode.c0;
+                    child.c1 = cNode.c1;
+                    child.size = cNode.size;
+                    *c = childId++;
+                }
+            }
+        });
+
+        levelBegin = levelEnd;
+        levelEnd += nextLevelNodeCount;
+    }
+
+    timeTotal = stopwatch.Lap();
+}
+
+template<config::BV BV, u32 W>
+void Compression::compressWide(Bvh const& inputBvh)
+{
+    using Node = typename CompressedVolume<BV>::Node;
+    using Bv = typename CompressedVolume<BV>::BV;
+    using NodeWide = NodeBvhWide<W, WIDE_SLAB_COUNT<Bv>>;
+
+    metadata = {};
+    timeTotal = 0.f;
+    bvh = {};
+
+    if (inputBvh.nodeCountTotal < 3) {
+        berry::Log::warn("Compression: BVH without interior nodes, skipped");
+        return;
+    }
+
+    Stopwatch stopwatch;
+
+    auto const nodes { inputBvh.Nodes<Node>() };
+    metadata.nodeCountLeaf = inputBvh.nodeCountLeaf;
+    // every wide node replaces at least one binary interior node, the buffer is trimmed at the end
+    auto const maxNodeCount { (inputBvh.nodeCountTotal - 1) / 2 };
+
+    bvh.nodes.resize(sizeof(NodeWide) * maxNodeCount);
+    bvh.triangles = inputBvh.triangles;
+    bvh.triangleIDs = inputBvh.triangleIDs;
+    bvh.nodeCountLeaf = metadata.nodeCountLeaf;
+    bvh.bv = BV;
+    bvh.layout = W == 4 ? Bvh::Layout::eWide4 : Bvh::Layout::eWide8;
+    auto const nodesWide { bvh.Nodes<NodeWide>() };
+
+    // binary interior node each wide node is opened from
+    std::vector<i32> sources(maxNodeCount);
+    sources[0] = static_cast<i32>(inputBvh.nodeCountTotal - 1);
+
+    std::vector<u32> chunkOffsets;
+    u32 levelBegin { 0 };
+    u32 levelEnd { 1 };
+    while (levelBegin < levelEnd) {
+        u32 const levelNodeCount { levelEnd - levelBegin };
+        chunkOffsets.assign((levelNodeCount + CHUNK_SIZE - 1) / CHUNK_SIZE, 0);
+
+        // 1. the largest interior child is opened until there are W children, larger children first
+        //   interior children keep the old node id until step 2
+        parallelForChunks(executor, levelNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+            auto& nonLeafChildCount { chunkOffsets[begin / CHUNK_SIZE] };
+            for (auto i { begin }; i < end; ++i) {
+                auto const nodeId { levelBegin + static_cast<u32>(i) };
+                auto const& source { nodes[sources[nodeId]] };
+
+                std::array<i32, W> children { source.c0, source.c1 };
+                std::array<f32, W> areas {};
+                areas[0] = bv::bvArea(loadBv<Bv>(nodes[std::abs(children[0])]));
+                areas[1] = bv::bvArea(loadBv<Bv>(nodes[std::abs(children[1])]));
+                u32 childCount { 2 };
+                while (childCount < W) {
+                    i32 largest { -1 };
+                    for (u32 c = 0; c < childCount; ++c)
+                        if (children[c] > 0 && (largest < 0 || areas[c] > areas[largest]))
+                            largest = static_cast<i32>(c);
+                    if (largest < 0)
+                        break;
+
+                    auto const& opened { nodes[children[largest]] };
+                    children[largest] = opened.c0;
+                    areas[largest] = bv::bvArea(loadBv<Bv>(nodes[std::abs(opened.c0)]));
+                    children[childCount] = opened.c1;
+                    areas[childCount] = bv::bvArea(loadBv<Bv>(nodes[std::abs(opened.c1)]));
+                    ++childCount;
+                }
+
+                std::array<u32, W> order;
+                for (u32 c = 0; c < W; ++c)
+                    order[c] = c;
+                std::stable_sort(order.begin(), order.begin() + childCount, [&areas](u32 a, u32 b) { return areas[a] > areas[b]; });
+
+                auto& node { nodesWide[nodeId] };
+                for (u32 c = 0; c < W; ++c) {
+                    if (c >= childCount) {
+                        setChildEmpty(node, c);
+                        continue;
+                    }
+                    auto const child { children[order[c]] };
+                    auto const& cNode { nodes[std::abs(child)] };
+                    setChildBv(node, c, loadBv<Bv>(cNode));
+                    if (child > 0) {
+                        node.child[c] = child;
+                        ++nonLeafChildCount;
+                    } else
+                        node.child[c] = encodeLeaf(cNode.size, cNode.c0);
+                }
+            }
+        });
+
+        u32 nextLevelNodeCount { 0 };
+        for (auto& offset : chunkOffsets) {
+            auto const count { offset };
+            offset = nextLevelNodeCount;
+            nextLevelNodeCount += count;
+        }
+
+        // 2. interior children get consecutive ids after this level, in the node order of this level
+        parallelForChunks(executor, levelNodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+            auto childId { static_cast<i32>(levelEnd + chunkOffsets[begin / CHUNK_SIZE]) };
+            for (auto i { begin }; i < end; ++i) {
+                auto& node { nodesWide[levelBegin + i] };
+                for (auto& c : node.child) {
+                    if (c <= 0)
+                        continue;
+                    sources[childId] = c;
+                    c = childId++;
+                }
+            }
+        });
+
+        levelBegin = levelEnd;
+        levelEnd += nextLevelNodeCount;
+    }
+
+    metadata.nodeCountTotal = levelEnd;
+    bvh.nodeCountTotal = metadata.nodeCountTotal;
+    bvh.nodes.resize(sizeof(NodeWide) * metadata.nodeCountTotal);
+    bvh.nodes.shrink_to_fit();
+
+    timeTotal = stopwatch.Lap();
+}
+
+template<config::BV BV, typename Q>
+void Compression::compressQuantized(Bvh const& inputBvh)
+{
+    using NodeCompressed = typename CompressedVolume<BV>::NodeCompressed;
+    using NodeQuantized = NodeBvhBinaryQuantized<Q, BV == config::BV::eAABB ? 3 : 7>;
+
+    compress<BV, Bvh::Layout::eBinaryCompressed>(inputBvh);
+    if (bvh.nodeCountTotal == 0)
+        return;
+
+    Stopwatch stopwatch;
+
+    auto const nodes { bvh.Nodes<NodeCompressed>() };
+    std::vector<std::byte> nodesQuantized(sizeof(NodeQuantized) * bvh.nodeCountTotal);
+    std::span const out { reinterpret_cast<NodeQuantized*>(nodesQuantized.data()), bvh.nodeCountTotal };
+    parallelForChunks(executor, bvh.nodeCountTotal, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto nodeId { begin }; nodeId < end; ++nodeId)
+            quantize(nodes[nodeId], out[nodeId]);
+    });
+    bvh.nodes = std::move(nodesQuantized);
+    bvh.layout = std::is_same_v<Q, u8> ? Bvh::Layout::eBinaryQuantized8 : Bvh::Layout::eBinaryQuantized16;
+
+    timeTotal += stopwatch.Lap();
+}
+
+stats::Compression Compression::GatherStats(BvhStats const& bvhStats) const
+{
+    stats::Compression stats;
+    stats.timeTotal = timeTotal;
+
+    stats.saIntersect = bvhStats.saIntersect;
+    stats.saTraverse = bvhStats.saTraverse;
+    stats.costTotal = bvhStats.costIntersect + bvhStats.costTraverse;
+
+    stats.nodeCountTotal = metadata.nodeCountTotal;
+    stats.leafSizeMin = bvhStats.leafSizeMin;
+    stats.leafSizeMax = bvhStats.leafSizeMax;
+    stats.leafSizeAvg = static_cast<f32>(bvhStats.leafSizeSum) / static_cast<f32>(metadata.nodeCountLeaf);
+    stats.memorySize = bvh.nodes.size() + bvh.aux.size();
+
+    return stats;
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "Types.h"
+
+namespace backend::cpu::bvh {
+
+// host implementation of vulkan::bvh::Compression, stores both child bounding volumes in the parent node
+//   the tree is rebuilt top-down level by level, root is node 0, only the interior nodes are kept
+//   the larger child (by surface area) goes first, leaf children are encoded in the child references, see encodeLeaf
+//   new node ids follow the node order of the previous level, so the result does not depend on the thread count
+// the wide layouts (AABB, DOP14) open the binary nodes greedily, the interior child with the largest area is replaced
+//   by its two children until the node is full, i.e. the children most likely to be traversed are skipped, see Wide.h
+// the quantized layouts (AABB, DOP14) are the binary ones with the child slabs rounded outwards to 8 or 16 bits, see Quantized.h
+struct Compression {
+    explicit Compression(Executor& executor);
+
+    [[nodiscard]] Bvh const& GetBVH() const
+    {
+        return bvh;
+    }
+    [[nodiscard]] bool NeedsRecompute(config::Compression const& buildConfig)
+    {
+        auto const cfgChanged { config != buildConfig };
+        config = buildConfig;
+        return cfgChanged && config.bv != config::BV::eNone;
+    }
+
+    // false if the input BVH or the layout was rejected, the output BVH is empty then
+    bool Compute(Bvh const& inputBvh);
+    [[nodiscard]] stats::Compression GatherStats(BvhStats const& bvhStats) const;
+
+private:
+    Executor& executor;
+    config::Compression config;
+    Bvh bvh;
+
+    struct Metadata {
+        u32 nodeCountLeaf { 0 };
+        u32 nodeCountTotal { 0 };
+    } metadata;
+    f32 timeTotal { 0.f };
+
+    template<config::BV BV, Bvh::Layout Layout>
+    void compress(Bvh const& inputBvh);
+    template<config::BV BV, u32 W>
+    void compressWide(Bvh const& inputBvh);
+    template<config::BV BV, typename Q>
+    void compressQuantized(Bvh const& inputBvh);
+};
+
+}
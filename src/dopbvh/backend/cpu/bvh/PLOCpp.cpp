@@ -0,0 +1,364 @@
+#include "PLOCpp.h"
+
+#include "../../../core/Profiler.h"
+#include "../../../scene/Scene.h"
+#include "../RadixSort.h"
+#include "../bv/Obb.h"
+#include "SpaceFilling.h"
+#include "data_plocpp.h"
+#include <bit>
+#include <limits>
+
+namespace backend::cpu::bvh {
+
+template<config::BV>
+struct Volume;
+
+template<>
+struct Volume<config::BV::eAABB> {
+    using Node = data_bvh::NodeBvhBinary;
+    using BV = bv::Aabb;
+
+    static BV Init(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2)
+    {
+        return bv::aabbInit(v0, v1, v2);
+    }
+};
+
+template<>
+struct Volume<config::BV::eDOP14> {
+    using Node = data_bvh::NodeBvhBinaryDOP14;
+    using BV = bv::Dop14;
+
+    static BV Init(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2)
+    {
+        return bv::dopInit(v0, v1, v2);
+    }
+};
+
+// OBBs are built from the 14 extremal points of each cluster, see Transformation for the final OBB fit
+template<>
+struct Volume<config::BV::eOBB> {
+    using Node = data_bvh::NodeBvhBinaryDiTO14Points;
+    using BV = bv::Dop14Points;
+
+    static BV Init(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2)
+    {
+        BV points;
+        auto dop { bv::dopInitWithPoints(v0, points) };
+        bv::bvFitWithPoints(dop, v1, points);
+        bv::bvFitWithPoints(dop, v2, points);
+        return points;
+    }
+};
+
+// same transformation as gen_plocpp_*_InitialClusters.comp
+static data_bvh::BvhTriangle woopify(glm::vec3 const& v0, glm::vec3 const& v1, glm::vec3 const& v2)
+{
+    glm::mat4 matrix;
+    matrix[0] = glm::vec4(v0 - v2, 0.f);
+    matrix[1] = glm::vec4(v1 - v2, 0.f);
+    matrix[2] = glm::vec4(glm::cross(v0 - v2, v1 - v2), 0.f);
+    matrix[3] = glm::vec4(v2, 1.f);
+    matrix = glm::inverse(matrix);
+    return {
+        { matrix[0][2], matrix[1][2], matrix[2][2], -matrix[3][2] },
+        { matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0] },
+        { matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1] },
+    };
+}
+
+PLOCpp::PLOCpp(Executor& executor)
+    : executor(executor)
+{
+}
+
+void PLOCpp::Compute(Scene const& scene)
+{
+    PROFILE_ZONE("PLOC++");
+    switch (config.bv) {
+    case config::BV::eAABB:
+        compute<config::BV::eAABB>(scene);
+        break;
+    case config::BV::eDOP14:
+        compute<config::BV::eDOP14>(scene);
+        break;
+    case config::BV::eOBB:
+        compute<config::BV::eOBB>(scene);
+        break;
+    case config::BV::eNone:
+        break;
+    }
+}
+
+template<config::BV BV>
+void PLOCpp::compute(Scene const& scene)
+{
+    using Node = typename Volume<BV>::Node;
+
+    // triangles are processed in slices, so a single large geometry still spreads over all workers
+    static constexpr u32 SLICE_SIZE { 1 << 14 };
+    struct Slice {
+        u32 geometryId;
+        u32 localBegin;
+        u32 localEnd;
+        u32 globalBase;
+    };
+    std::vector<Slice> slices;
+    u32 triangleCount { 0 };
+    for (u32 gId = 0; gId < scene.geometries.size(); ++gId) {
+        u32 const count { csize<u32>(scene.geometries[gId].Indices()) / 3 };
+        for (u32 begin = 0; begin < count; begin += SLICE_SIZE)
+            slices.push_back({ gId, begin, std::min(count, begin + SLICE_SIZE), triangleCount + begin });
+        triangleCount += count;
+    }
+
+    metadata = {};
+    times = {};
+    bvh = {};
+    if (triangleCount == 0)
+        return;
+
+    metadata.nodeCountLeaf = triangleCount;
+    metadata.nodeCountTotal = triangleCount * 2 - 1;
+
+    bvh.nodes.resize(sizeof(Node) * metadata.nodeCountTotal);
+    bvh.triangles.resize(triangleCount);
+    bvh.triangleIDs.resize(triangleCount);
+    bvh.nodeCountLeaf = metadata.nodeCountLeaf;
+    bvh.nodeCountTotal = metadata.nodeCountTotal;
+    bvh.bv = BV;
+    bvh.layout = Bvh::Layout::eBinaryStandard;
+
+    auto const nodes { bvh.Nodes<Node>() };
+    // 32 bit Morton codes sort as keyvals, the 64 bit curves pack the cluster id into the key (see SpaceFilling.h)
+    auto const sfc64 { config.sfc != config::SpaceFilling::eMorton32 };
+    auto const idBits { clusterIdBits(triangleCount) };
+    std::vector<data_plocpp::Morton32KeyVal> keyvals(sfc64 ? 0 : triangleCount);
+    std::vector<glm::vec3> centroids(sfc64 ? triangleCount : 0);
+    std::vector<u64> keys(sfc64 ? triangleCount : 0);
+
+    Stopwatch stopwatch;
+
+    auto const cubedAabb { scene.aabb.GetCubed() };
+    auto const sceneAabbCubedMin { cubedAabb.min };
+    f32 const sceneAabbNormalizationScale { 1.f / (cubedAabb.max - cubedAabb.min).x };
+
+    parallelFor(executor, slices.size(), [&](size_t s) {
+        auto const& slice { slices[s] };
+        auto const& g { scene.geometries[slice.geometryId] };
+        auto const vertices { g.Vertices() };
+        auto const indices { g.Indices() };
+
+        for (u32 localTriangleId = slice.localBegin; localTriangleId < slice.localEnd; ++localTriangleId) {
+            u32 const globalTriangleId { slice.globalBase + localTriangleId - slice.localBegin };
+            auto const& v0 { vertices[indices[localTriangleId * 3 + 0]] };
+            auto const& v1 { vertices[indices[localTriangleId * 3 + 1]] };
+            auto const& v2 { vertices[indices[localTriangleId * 3 + 2]] };
+
+            auto const bv { Volume<BV>::Init(v0, v1, v2) };
+            auto& node { nodes[globalTriangleId] };
+            storeBv(node, bv);
+            node.size = 1;
+            node.parent = INVALID_ID;
+            node.c0 = INVALID_ID;
+            node.c1 = INVALID_ID;
+
+            auto const bvCentroid { (bv::aabbCentroid(bv) - sceneAabbCubedMin) * sceneAabbNormalizationScale };
+            if (sfc64)
+                centroids[globalTriangleId] = bvCentroid;
+            else
+                keyvals[globalTriangleId] = { globalTriangleId, mortonCode32(bvCentroid) };
+
+            bvh.triangles[globalTriangleId] = woopify(v0, v1, v2);
+            bvh.triangleIDs[globalTriangleId] = { slice.geometryId, localTriangleId };
+        }
+
+        if (sfc64) {
+            auto const count { slice.localEnd - slice.localBegin };
+            clusterKeys64(config.sfc, std::span { centroids }.subspan(slice.globalBase, count), slice.globalBase, idBits, std::span { keys }.subspan(slice.globalBase, count));
+        }
+    });
+    centroids = {};
+    times[static_cast<u32>(Times::Stamp::eInitialClustersAndWoopify)] = stopwatch.Lap();
+
+    if (sfc64)
+        radixSort<64>(executor, keys, [](u64 key) { return key; });
+    else
+        radixSort<32>(executor, keyvals, [](data_plocpp::Morton32KeyVal const& kv) { return kv.mortonCode; });
+    times[static_cast<u32>(Times::Stamp::eSortClusterIDs)] = stopwatch.Lap();
+
+    std::vector<u32> nodeId0(triangleCount);
+    u64 const idMask { (1ull << idBits) - 1 };
+    parallelForChunks(executor, triangleCount, SLICE_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            nodeId0[i] = sfc64 ? static_cast<u32>(keys[i] & idMask) : keyvals[i].key;
+    });
+    keyvals = {};
+    keys = {};
+    times[static_cast<u32>(Times::Stamp::eCopySortedClusterIDs)] = stopwatch.Lap();
+
+    MergeBuffers buffers;
+    u32 clusterCount { triangleCount };
+    u32 bvOffset { triangleCount };
+    while (clusterCount > 1) {
+        bvOffset += MergeIteration<BV>(executor, bvh, config.radius, nodeId0, buffers, bvOffset);
+        clusterCount = csize<u32>(nodeId0);
+        ++metadata.iterationCount;
+    }
+    times[static_cast<u32>(Times::Stamp::ePLOCppIterations)] = stopwatch.Lap();
+}
+
+// each chunk of clusters searches its nearest neighbours in a window extended by 2 * radius on both sides,
+// like a GPU workgroup does in gen_plocpp_*_PLOCpp.comp; pairs near chunk borders are evaluated by both chunks
+template<config::BV BV>
+u32 PLOCpp::MergeIteration(Executor& executor, Bvh& bvh, u32 searchRadius, std::vector<u32>& clusters, MergeBuffers& buffers, u32 nodeOffset)
+{
+    using Node = typename Volume<BV>::Node;
+    using Bv = typename Volume<BV>::BV;
+
+    static constexpr u32 CHUNK_SIZE { 1 << 12 };
+    static constexpr i32 KEEP { -1 };
+    static constexpr i32 REMOVE { -2 };
+    i64 const radius { std::max<i64>(searchRadius, 1) };
+
+    PROFILE_ZONE("PLOC++ iteration");
+    auto const nodes { bvh.Nodes<Node>() };
+    auto const clusterCount { csize<u32>(clusters) };
+    auto const& nodeId0 { clusters };
+    auto& nodeId1 { buffers.clusters };
+    // KEEP, REMOVE, or the position of the right cluster to merge with
+    auto& action { buffers.action };
+    auto& chunkMergeCount { buffers.chunkMergeCount };
+    auto& chunkKeepCount { buffers.chunkKeepCount };
+
+    u32 const chunkCount { (clusterCount + CHUNK_SIZE - 1) / CHUNK_SIZE };
+    chunkMergeCount.assign(chunkCount, 0);
+    chunkKeepCount.assign(chunkCount, 0);
+    action.resize(clusterCount);
+    nodeId1.resize(clusterCount);
+
+    parallelFor(executor, chunkCount, [&](size_t c) {
+        i64 const begin { static_cast<i64>(c) * CHUNK_SIZE };
+        i64 const end { std::min<i64>(clusterCount, begin + CHUNK_SIZE) };
+        i64 const windowBegin { begin - 2 * radius };
+        i64 const windowEnd { end + 2 * radius };
+        u32 const windowSize { static_cast<u32>(windowEnd - windowBegin) };
+        auto const inRange { [&](i64 local) { return windowBegin + local >= 0 && windowBegin + local < clusterCount; } };
+
+        std::vector<Bv> cache(windowSize);
+        std::vector<u64> nn(windowSize, std::numeric_limits<u64>::max());
+        for (u32 p = 0; p < windowSize; ++p)
+            if (inRange(p))
+                cache[p] = loadBv<Bv>(nodes[nodeId0[windowBegin + p]]);
+
+        // the key orders by merged area first and position second, ties go to the lower position
+        for (u32 p = 0; p < windowSize; ++p) {
+            if (!inRange(p))
+                continue;
+            for (u32 q = p + 1; q < std::min<i64>(windowSize, p + 1 + radius) && inRange(q); ++q) {
+                auto merged { cache[q] };
+                bv::bvFit(merged, cache[p]);
+                u64 const encoded { static_cast<u64>(std::bit_cast<u32>(bv::bvArea(merged))) << 32 };
+                nn[p] = std::min(nn[p], encoded | q);
+                nn[q] = std::min(nn[q], encoded | p);
+            }
+        }
+
+        u32 mergeCount { 0 };
+        u32 keepCount { 0 };
+        for (i64 i = begin; i < end; ++i) {
+            auto const p { static_cast<u32>(i - windowBegin) };
+            auto const myNeighbour { static_cast<u32>(nn[p]) };
+            auto const hisNeighbour { static_cast<u32>(nn[myNeighbour]) };
+            if (p == hisNeighbour) {
+                if (p < myNeighbour) {
+                    action[i] = static_cast<i32>(windowBegin + myNeighbour);
+                    ++mergeCount;
+                    ++keepCount;
+                } else
+                    action[i] = REMOVE;
+            } else {
+                action[i] = KEEP;
+                ++keepCount;
+            }
+        }
+        chunkMergeCount[c] = mergeCount;
+        chunkKeepCount[c] = keepCount;
+    });
+
+    u32 mergeSum { 0 };
+    u32 keepSum { 0 };
+    for (u32 c = 0; c < chunkCount; ++c) {
+        mergeSum += std::exchange(chunkMergeCount[c], mergeSum);
+        keepSum += std::exchange(chunkKeepCount[c], keepSum);
+    }
+
+    // merge mutual nearest neighbours and compact the cluster IDs in one pass
+    parallelFor(executor, chunkCount, [&](size_t c) {
+        u32 const begin { static_cast<u32>(c) * CHUNK_SIZE };
+        u32 const end { std::min(clusterCount, begin + CHUNK_SIZE) };
+        u32 mergedId { nodeOffset + chunkMergeCount[c] };
+        u32 compactedId { chunkKeepCount[c] };
+
+        for (u32 i = begin; i < end; ++i) {
+            if (action[i] == REMOVE)
+                continue;
+            if (action[i] == KEEP) {
+                nodeId1[compactedId++] = nodeId0[i];
+                continue;
+            }
+
+            u32 const leftNodeId { nodeId0[i] };
+            u32 const rightNodeId { nodeId0[action[i]] };
+            auto& left { nodes[leftNodeId] };
+            auto& right { nodes[rightNodeId] };
+
+            auto bvC0 { loadBv<Bv>(left) };
+            bv::bvFit(bvC0, loadBv<Bv>(right));
+
+            auto& merged { nodes[mergedId] };
+            storeBv(merged, bvC0);
+            merged.size = left.size + right.size;
+            merged.parent = INVALID_ID;
+            merged.c0 = static_cast<i32>(leftNodeId);
+            merged.c1 = static_cast<i32>(rightNodeId);
+            left.parent = static_cast<i32>(mergedId);
+            right.parent = static_cast<i32>(mergedId);
+
+            nodeId1[compactedId++] = mergedId++;
+        }
+    });
+
+    nodeId1.resize(keepSum);
+    std::swap(clusters, nodeId1);
+    return mergeSum;
+}
+
+template u32 PLOCpp::MergeIteration<config::BV::eAABB>(Executor&, Bvh&, u32, std::vector<u32>&, MergeBuffers&, u32);
+template u32 PLOCpp::MergeIteration<config::BV::eDOP14>(Executor&, Bvh&, u32, std::vector<u32>&, MergeBuffers&, u32);
+template u32 PLOCpp::MergeIteration<config::BV::eOBB>(Executor&, Bvh&, u32, std::vector<u32>&, MergeBuffers&, u32);
+
+stats::PLOC PLOCpp::GatherStats(BvhStats const& bvhStats) const
+{
+    stats::PLOC stats;
+
+    stats.times.assign(times.begin(), times.end());
+    for (auto const t : stats.times)
+        stats.timeTotal += t;
+
+    stats.iterationCount = metadata.iterationCount;
+
+    stats.saIntersect = bvhStats.saIntersect;
+    stats.saTraverse = bvhStats.saTraverse;
+    stats.costTotal = bvhStats.costIntersect + bvhStats.costTraverse;
+
+    stats.nodeCountTotal = metadata.nodeCountTotal;
+    stats.leafSizeMin = bvhStats.leafSizeMin;
+    stats.leafSizeMax = bvhStats.leafSizeMax;
+    stats.leafSizeAvg = static_cast<f32>(bvhStats.leafSizeSum) / static_cast<f32>(metadata.nodeCountLeaf);
+
+    return stats;
+}
+
+}
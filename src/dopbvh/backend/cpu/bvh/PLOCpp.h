@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "Types.h"
+#include <array>
+#include <vector>
+
+struct Scene;
+
+namespace backend::cpu::bvh {
+
+// host implementation of vulkan::bvh::PLOCpp, produces the same binary node layouts
+//   nodes [0, N) are the leaves in scene triangle order, merged nodes follow, root is the last node
+//   merged node ids are assigned in cluster order, so the result does not depend on the thread count
+struct PLOCpp {
+    explicit PLOCpp(Executor& executor);
+
+    [[nodiscard]] Bvh const& GetBVH() const
+    {
+        return bvh;
+    }
+    [[nodiscard]] bool NeedsRecompute(config::PLOC const& buildConfig)
+    {
+        auto const cfgChanged { config != buildConfig };
+        config = buildConfig;
+        return cfgChanged && config.bv != config::BV::eNone;
+    }
+
+    void Compute(Scene const& scene);
+    [[nodiscard]] stats::PLOC GatherStats(BvhStats const& bvhStats) const;
+
+    // scratch of MergeIteration, kept over the iterations of a build
+    struct MergeBuffers {
+        std::vector<u32> clusters;
+        std::vector<i32> action;
+        std::vector<u32> chunkMergeCount;
+        std::vector<u32> chunkKeepCount;
+    };
+
+    // one iteration on the binary nodes of a BV: mutual nearest neighbours of the clusters (node ids in curve order) are merged
+    //   into new nodes from nodeOffset on, clusters is replaced by the remaining ones, returns the number of new nodes
+    template<config::BV BV>
+    static u32 MergeIteration(Executor& executor, Bvh& bvh, u32 searchRadius, std::vector<u32>& clusters, MergeBuffers& buffers, u32 nodeOffset);
+
+private:
+    Executor& executor;
+    config::PLOC config;
+    Bvh bvh;
+
+    struct Metadata {
+        u32 nodeCountLeaf { 0 };
+        u32 nodeCountTotal { 0 };
+
+        u32 iterationCount { 0 };
+    } metadata;
+
+    struct Times {
+        enum class Stamp : u32 {
+            eInitialClustersAndWoopify,
+            eSortClusterIDs,
+            eCopySortedClusterIDs,
+            ePLOCppIterations,
+            eCount,
+        };
+    };
+    std::array<f32, static_cast<u32>(Times::Stamp::eCount)> times {};
+
+    template<config::BV BV>
+    void compute(Scene const& scene);
+};
+
+}
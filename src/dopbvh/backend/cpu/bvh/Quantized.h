@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Types.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#endif
+
+// quantized binary node layouts of the CPU backend, the child slabs of a NodeBvhBinaryCompressed (AABB)
+// or NodeBvhBinaryDOP14Compressed are stored as 8 or 16 bit offsets from the parent slabs
+namespace backend::cpu::bvh {
+
+// bv[j] holds the float bv[j] of the compressed node it was quantized from, lo bounds at even j, hi at odd j
+//   the value of bv[j] is origin[s] + bv[j] * 2^exponent[s], s = quantizedSlab<K>(j), the product is exact
+//   lo bounds are rounded down and hi bounds up, so the decoded child always contains the original one
+template<typename Q, u32 K>
+struct NodeBvhBinaryQuantized {
+    static constexpr u32 SLAB_COUNT { K };
+    static constexpr u32 QUANTIZED_MAX { std::numeric_limits<Q>::max() };
+
+    f32 origin[K];
+    i8 exponent[K];
+    Q bv[4 * K];
+    i32 size;
+    i32 parent;
+    i32 c0;
+    i32 c1;
+};
+
+using NodeBvhBinaryQuantized8 = NodeBvhBinaryQuantized<u8, 3>;
+using NodeBvhBinaryQuantized16 = NodeBvhBinaryQuantized<u16, 3>;
+using NodeBvhBinaryDOP14Quantized8 = NodeBvhBinaryQuantized<u8, 7>;
+using NodeBvhBinaryDOP14Quantized16 = NodeBvhBinaryQuantized<u16, 7>;
+
+// slab of bv[j], AABB: c0 x y | c1 x y | z, DOP14: c0lo c0hi c1lo c1hi per slab, see Compressed.h
+template<u32 K>
+[[nodiscard]] constexpr u32 quantizedSlab(u32 j)
+{
+    if constexpr (K == 3)
+        return j < 8 ? (j >> 1) & 1 : 2;
+    else
+        return j >> 2;
+}
+
+[[nodiscard]] inline f32 quantizedScale(i32 exponent)
+{
+    return std::bit_cast<f32>((exponent + 127) << 23);
+}
+
+template<typename Q, u32 K>
+[[nodiscard]] inline f32 dequantize(NodeBvhBinaryQuantized<Q, K> const& node, u32 j)
+{
+    auto const s { quantizedSlab<K>(j) };
+    return node.origin[s] + static_cast<f32>(node.bv[j]) * quantizedScale(node.exponent[s]);
+}
+
+// NodeCompressed is the float node of the same slab count, NodeBvhBinaryCompressed or NodeBvhBinaryDOP14Compressed
+template<typename Q, u32 K, typename NodeCompressed>
+inline void quantize(NodeCompressed const& in, NodeBvhBinaryQuantized<Q, K>& out)
+{
+    static_assert(std::extent_v<decltype(in.bv)> == 4 * K);
+    static constexpr auto QMAX { NodeBvhBinaryQuantized<Q, K>::QUANTIZED_MAX };
+
+    f32 lo[K];
+    f32 hi[K];
+    for (u32 s = 0; s < K; ++s) {
+        lo[s] = std::numeric_limits<f32>::max();
+        hi[s] = std::numeric_limits<f32>::lowest();
+    }
+    for (u32 j = 0; j < 4 * K; ++j) {
+        auto const s { quantizedSlab<K>(j) };
+        if (j & 1)
+            hi[s] = std::max(hi[s], in.bv[j]);
+        else
+            lo[s] = std::min(lo[s], in.bv[j]);
+    }
+
+    // smallest power of two step covering the parent slab in QMAX steps, the float extent may be rounded down, hence the loop
+    for (u32 s = 0; s < K; ++s) {
+        i32 exponent { -126 };
+        if (hi[s] > lo[s])
+            std::frexp((hi[s] - lo[s]) / static_cast<f32>(QMAX), &exponent);
+        exponent = std::max(exponent, -126);
+        while (exponent < 127 && lo[s] + static_cast<f32>(QMAX) * quantizedScale(exponent) < hi[s])
+            ++exponent;
+        out.origin[s] = lo[s];
+        out.exponent[s] = static_cast<i8>(exponent);
+    }
+
+    for (u32 j = 0; j < 4 * K; ++j) {
+        auto const s { quantizedSlab<K>(j) };
+        auto const q { (in.bv[j] - out.origin[s]) / quantizedScale(out.exponent[s]) };
+        if (j & 1) {
+            out.bv[j] = static_cast<Q>(std::clamp(std::ceil(q), 0.f, static_cast<f32>(QMAX)));
+            while (out.bv[j] < QMAX && dequantize(out, j) < in.bv[j])
+                ++out.bv[j];
+        } else {
+            out.bv[j] = static_cast<Q>(std::clamp(std::floor(q), 0.f, static_cast<f32>(QMAX)));
+            while (out.bv[j] > 0 && dequantize(out, j) > in.bv[j])
+                --out.bv[j];
+        }
+    }
+
+    out.size = in.size;
+    out.parent = in.parent;
+    out.c0 = in.c0;
+    out.c1 = in.c1;
+}
+
+#if defined(__AVX2__)
+template<typename Q>
+[[nodiscard]] inline __m256i loadQuantized8(Q const* q)
+{
+    if constexpr (sizeof(Q) == 1)
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(q)));
+    else
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(q)));
+}
+
+template<typename Q>
+[[nodiscard]] inline __m128i loadQuantized4(Q const* q)
+{
+    if constexpr (sizeof(Q) == 1) {
+        i32 v;
+        memcpy(&v, q, sizeof(v));
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+    } else
+        return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(q)));
+}
+
+// slab of each of the 8 values from j0 on, the lane control of _mm256_permutevar8x32_ps
+template<u32 K>
+[[nodiscard]] inline __m256i quantizedSlabs(u32 j0)
+{
+    return _mm256_setr_epi32(quantizedSlab<K>(j0), quantizedSlab<K>(j0 + 1), quantizedSlab<K>(j0 + 2), quantizedSlab<K>(j0 + 3),
+        quantizedSlab<K>(j0 + 4), quantizedSlab<K>(j0 + 5), quantizedSlab<K>(j0 + 6), quantizedSlab<K>(j0 + 7));
+}
+#endif
+
+// back to the float node for the node tests and stats
+//   with AVX2 the origins and scales of all slabs are spread over 8 values at once by one permutation
+template<typename Q, u32 K, typename NodeCompressed>
+inline void dequantizeNode(NodeBvhBinaryQuantized<Q, K> const& in, NodeCompressed& out)
+{
+    static_assert(std::extent_v<decltype(out.bv)> == 4 * K);
+#if defined(__AVX2__)
+    // 8 origins and exponents are loaded at once, the lanes past K hold the bytes that follow in the node and are never selected
+    using Node = NodeBvhBinaryQuantized<Q, K>;
+    static_assert(K < 8 && (4 * K) % 8 == 4 && sizeof(Node) >= 8 * sizeof(f32) && offsetof(Node, exponent) + 8 <= sizeof(Node));
+    auto const origin { _mm256_loadu_ps(in.origin) };
+    auto const exponent { _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(in.exponent))) };
+    auto const scale { _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(exponent, _mm256_set1_epi32(127)), 23)) };
+
+    u32 j0 { 0 };
+    for (; j0 + 8 <= 4 * K; j0 += 8) {
+        auto const slabs { quantizedSlabs<K>(j0) };
+        auto const q { _mm256_cvtepi32_ps(loadQuantized8(in.bv + j0)) };
+        _mm256_storeu_ps(out.bv + j0, _mm256_add_ps(_mm256_permutevar8x32_ps(origin, slabs), _mm256_mul_ps(q, _mm256_permutevar8x32_ps(scale, slabs))));
+    }
+    auto const slabs { quantizedSlabs<K>(j0) };
+    auto const q { _mm_cvtepi32_ps(loadQuantized4(in.bv + j0)) };
+    auto const o4 { _mm256_castps256_ps128(_mm256_permutevar8x32_ps(origin, slabs)) };
+    auto const s4 { _mm256_castps256_ps128(_mm256_permutevar8x32_ps(scale, slabs)) };
+    _mm_storeu_ps(out.bv + j0, _mm_add_ps(o4, _mm_mul_ps(q, s4)));
+#else
+    f32 scale[K];
+    for (u32 s = 0; s < K; ++s)
+        scale[s] = quantizedScale(in.exponent[s]);
+    for (u32 j = 0; j < 4 * K; ++j) {
+        auto const s { quantizedSlab<K>(j) };
+        out.bv[j] = in.origin[s] + static_cast<f32>(in.bv[j]) * scale[s];
+    }
+#endif
+    out.size = in.size;
+    out.parent = in.parent;
+    out.c0 = in.c0;
+    out.c1 = in.c1;
+}
+
+}
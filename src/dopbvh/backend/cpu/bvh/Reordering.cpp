@@ -0,0 +1,258 @@
+#include "Reordering.h"
+
+#include "../../../core/Profiler.h"
+#include "Quantized.h"
+#include "Wide.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace backend::cpu::bvh {
+
+static constexpr size_t CHUNK_SIZE { 1 << 14 };
+
+// f(child) for each child reference of the node, in node order, interior children are > 0
+template<typename Node, typename F>
+static void forEachChild(Node& node, F f)
+{
+    if constexpr (requires { node.child; }) {
+        for (auto& c : node.child)
+            f(c);
+    } else {
+        f(node.c0);
+        f(node.c1);
+    }
+}
+
+// pushes the interior children of the node so that the first one is popped first
+template<typename Node, typename T, typename F>
+static void pushChildren(Node const& node, std::vector<T>& stack, F makeEntry)
+{
+    auto const stackSize { stack.size() };
+    forEachChild(node, [&](i32 c) {
+        if (c > 0)
+            stack.push_back(makeEntry(c));
+    });
+    std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(stackSize), stack.end());
+}
+
+template<typename Node>
+static void orderDfs(std::span<Node const> nodes, std::vector<i32>& order)
+{
+    std::vector<i32> stack { 0 };
+    while (!stack.empty()) {
+        auto const nodeId { stack.back() };
+        stack.pop_back();
+        order.push_back(nodeId);
+        pushChildren(nodes[nodeId], stack, [](i32 c) { return c; });
+    }
+}
+
+template<typename Node>
+static void orderTreelets(std::span<Node const> nodes, u32 treeletSize, std::vector<i32>& order)
+{
+    std::vector<i32> roots { 0 };
+    std::vector<i32> treelet;
+    while (!roots.empty()) {
+        treelet.assign(1, roots.back());
+        roots.pop_back();
+
+        // treelet is also the BFS queue, nodes past the expanded ones are the roots of the next treelets
+        size_t expanded { 0 };
+        for (; expanded < treelet.size() && expanded < treeletSize; ++expanded)
+            forEachChild(nodes[treelet[expanded]], [&](i32 c) {
+                if (c > 0)
+                    treelet.push_back(c);
+            });
+
+        order.insert(order.end(), treelet.begin(), treelet.begin() + static_cast<std::ptrdiff_t>(expanded));
+        roots.insert(roots.end(), treelet.rbegin(), treelet.rend() - static_cast<std::ptrdiff_t>(expanded));
+    }
+}
+
+// nodes of the subtree of root up to relative depth h - 1, top subtree of height h / 2 first, then the bottom ones left to right
+//   bottoms holds the bottom roots of each recursion level, stack is the scratch of the depth limited DFS
+template<typename Node>
+static void orderVanEmdeBoas(std::span<Node const> nodes, std::span<u32 const> height, i32 root, u32 h, u32 level, std::vector<std::vector<i32>>& bottoms, std::vector<std::pair<i32, u32>>& stack, std::vector<i32>& order)
+{
+    if (h == 1) {
+        order.push_back(root);
+        return;
+    }
+
+    auto const hTop { h / 2 };
+    orderVanEmdeBoas(nodes, height, root, hTop, level + 1, bottoms, stack, order);
+
+    auto& levelBottoms { bottoms[level] };
+    levelBottoms.clear();
+    stack.assign(1, { root, 0 });
+    while (!stack.empty()) {
+        auto const [nodeId, depth] { stack.back() };
+        stack.pop_back();
+        if (depth == hTop)
+            levelBottoms.push_back(nodeId);
+        else
+            pushChildren(nodes[nodeId], stack, [depth](i32 c) { return std::pair { c, depth + 1 }; });
+    }
+
+    for (auto const bottom : levelBottoms)
+        orderVanEmdeBoas(nodes, height, bottom, std::min(h - hTop, height[bottom]), level + 1, bottoms, stack, order);
+}
+
+template<typename Node>
+static void orderVanEmdeBoas(std::span<Node const> nodes, std::vector<i32>& order)
+{
+    // interior node heights bottom-up, i.e. in reverse DFS order
+    orderDfs(nodes, order);
+    std::vector<u32> height(nodes.size(), 1);
+    for (auto it { order.rbegin() }; it != order.rend(); ++it)
+        forEachChild(nodes[*it], [&](i32 c) {
+            if (c > 0)
+                height[*it] = std::max(height[*it], height[c] + 1);
+        });
+    order.clear();
+
+    // each recursion at least halves the height
+    std::vector<std::vector<i32>> bottoms(64);
+    std::vector<std::pair<i32, u32>> stack;
+    orderVanEmdeBoas(nodes, std::span<u32 const> { height }, 0, height[0], 0, bottoms, stack, order);
+}
+
+Reordering::Reordering(Executor& executor)
+    : executor(executor)
+{
+}
+
+void Reordering::Compute(Bvh const& inputBvh)
+{
+    PROFILE_ZONE("reordering");
+    timeTotal = 0.f;
+    pageLocalRatio = 0.f;
+    bvh = {};
+    if (inputBvh.nodeCountTotal == 0)
+        return;
+
+    auto const aabb { inputBvh.bv == config::BV::eAABB };
+    switch (inputBvh.layout) {
+    case Bvh::Layout::eBinaryStandard:
+        berry::Log::warn("Reordering: input BVH is not compressed, skipped");
+        break;
+    case Bvh::Layout::eBinaryCompressed:
+        if (inputBvh.bv == config::BV::eOBB)
+            reorder<data_bvh::NodeBvhBinaryOBBCompressed>(inputBvh);
+        else if (aabb)
+            reorder<data_bvh::NodeBvhBinaryCompressed>(inputBvh);
+        else
+            reorder<data_bvh::NodeBvhBinaryDOP14Compressed>(inputBvh);
+        break;
+    case Bvh::Layout::eBinaryCompressed_dop14Split:
+        reorder<data_bvh::NodeBvhBinaryCompressed, true>(inputBvh);
+        break;
+    case Bvh::Layout::eWide4:
+        aabb ? reorder<NodeBvhWide4>(inputBvh) : reorder<NodeBvhWide4DOP14>(inputBvh);
+        break;
+    case Bvh::Layout::eWide8:
+        aabb ? reorder<NodeBvhWide8>(inputBvh) : reorder<NodeBvhWide8DOP14>(inputBvh);
+        break;
+    case Bvh::Layout::eBinaryQuantized8:
+        aabb ? reorder<NodeBvhBinaryQuantized8>(inputBvh) : reorder<NodeBvhBinaryDOP14Quantized8>(inputBvh);
+        break;
+    case Bvh::Layout::eBinaryQuantized16:
+        aabb ? reorder<NodeBvhBinaryQuantized16>(inputBvh) : reorder<NodeBvhBinaryDOP14Quantized16>(inputBvh);
+        break;
+    }
+}
+
+// SPLIT: parent of the main node is the DOP test vote mask (see Compression), the aux nodes move with the main ones
+template<typename Node, bool SPLIT>
+void Reordering::reorder(Bvh const& inputBvh)
+{
+    using NodeSplit = data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT;
+
+    Stopwatch stopwatch;
+
+    auto const nodes { inputBvh.Nodes<Node>() };
+    auto const nodeCount { static_cast<u32>(nodes.size()) };
+
+    // order[newId] = oldId
+    std::vector<i32> order;
+    order.reserve(nodeCount);
+    switch (config.order) {
+    case config::NodeOrder::eDFS:
+        orderDfs(nodes, order);
+        break;
+    case config::NodeOrder::eTreeletBFS:
+        orderTreelets(nodes, std::max(1u, PAGE_SIZE / static_cast<u32>(sizeof(Node))), order);
+        break;
+    case config::NodeOrder::eVanEmdeBoas:
+        orderVanEmdeBoas(nodes, order);
+        break;
+    case config::NodeOrder::eNone:
+        for (u32 i = 0; i < nodeCount; ++i)
+            order.push_back(static_cast<i32>(i));
+        break;
+    }
+    assert(order.size() == nodeCount && order[0] == 0);
+
+    std::vector<i32> newIds(nodeCount);
+    parallelForChunks(executor, nodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto i { begin }; i < end; ++i)
+            newIds[order[i]] = static_cast<i32>(i);
+    });
+
+    bvh.nodes.resize(inputBvh.nodes.size());
+    bvh.aux.resize(inputBvh.aux.size());
+    bvh.triangles = inputBvh.triangles;
+    bvh.triangleIDs = inputBvh.triangleIDs;
+    bvh.nodeCountLeaf = inputBvh.nodeCountLeaf;
+    bvh.nodeCountTotal = inputBvh.nodeCountTotal;
+    bvh.bv = inputBvh.bv;
+    bvh.layout = inputBvh.layout;
+    auto const nodesOut { bvh.Nodes<Node>() };
+    auto const nodesSplit { inputBvh.Aux<NodeSplit>() };
+    auto const nodesSplitOut { bvh.Aux<NodeSplit>() };
+
+    struct PageLocality {
+        u64 childCount { 0 };
+        u64 localCount { 0 };
+    };
+    std::vector<PageLocality> chunks((nodeCount + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    parallelForChunks(executor, nodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto& locality { chunks[begin / CHUNK_SIZE] };
+        for (auto nodeId { begin }; nodeId < end; ++nodeId) {
+            auto node { nodes[order[nodeId]] };
+            forEachChild(node, [&](i32& c) {
+                if (c <= 0)
+                    return;
+                c = newIds[c];
+                ++locality.childCount;
+                if (nodeId * sizeof(Node) / PAGE_SIZE == static_cast<size_t>(c) * sizeof(Node) / PAGE_SIZE)
+                    ++locality.localCount;
+            });
+            if constexpr (SPLIT)
+                nodesSplitOut[nodeId] = nodesSplit[order[nodeId]];
+            else if constexpr (requires { node.parent; })
+                node.parent = node.parent == INVALID_ID ? INVALID_ID : newIds[node.parent];
+            nodesOut[nodeId] = node;
+        }
+    });
+
+    PageLocality locality;
+    for (auto const& c : chunks) {
+        locality.childCount += c.childCount;
+        locality.localCount += c.localCount;
+    }
+    pageLocalRatio = locality.childCount > 0 ? static_cast<f32>(static_cast<f64>(locality.localCount) / static_cast<f64>(locality.childCount)) : 0.f;
+
+    timeTotal = stopwatch.Lap();
+}
+
+stats::Reordering Reordering::GatherStats() const
+{
+    stats::Reordering stats;
+    stats.timeTotal = timeTotal;
+    stats.pageLocalRatio = pageLocalRatio;
+    return stats;
+}
+
+}
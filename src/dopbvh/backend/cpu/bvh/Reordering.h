@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "Types.h"
+
+namespace backend::cpu::bvh {
+
+// optional stage after compression, permutes the compressed nodes for cache locality of the traversal
+//   DFS: pre-order, the first (larger) child right after its parent
+//   treelet BFS: breadth-first treelets filling one 4 KiB page each, the treelets themselves in depth-first order
+//   van Emde Boas: the top half of the tree (by height) first, then each bottom subtree, recursively
+// the root stays node 0, child references, parents and the aux nodes of the split layout are remapped, triangles are kept
+//   the order itself is computed serially, the nodes are moved in parallel
+struct Reordering {
+    static constexpr u32 PAGE_SIZE { 4096 };
+
+    explicit Reordering(Executor& executor);
+
+    [[nodiscard]] Bvh const& GetBVH() const
+    {
+        return bvh;
+    }
+    [[nodiscard]] bool NeedsRecompute(config::Reordering const& buildConfig)
+    {
+        auto const cfgChanged { config != buildConfig };
+        config = buildConfig;
+        return cfgChanged && config.order != config::NodeOrder::eNone;
+    }
+
+    void Compute(Bvh const& inputBvh);
+    [[nodiscard]] stats::Reordering GatherStats() const;
+
+private:
+    Executor& executor;
+    config::Reordering config;
+    Bvh bvh;
+
+    f32 timeTotal { 0.f };
+    f32 pageLocalRatio { 0.f };
+
+    template<typename Node, bool SPLIT = false>
+    void reorder(Bvh const& inputBvh);
+};
+
+}
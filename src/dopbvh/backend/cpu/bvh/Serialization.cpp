@@ -0,0 +1,216 @@
+#include "Serialization.h"
+
+#include "../../../scene/MappedFile.h"
+#include "Quantized.h"
+#include "Wide.h"
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace backend::cpu::bvh::file {
+
+// "DBVH" in little endian
+inline constexpr u32 MAGIC { 0x48564244 };
+inline constexpr u32 VERSION { 1 };
+inline constexpr u64 ALIGNMENT { 64 };
+
+enum class Section : u32 {
+    eNodes,
+    eTriangles,
+    eTriangleIDs,
+    eAux,
+    eCount,
+};
+
+struct Header {
+    u32 magic { MAGIC };
+    u32 version { VERSION };
+    u32 sectionCount { static_cast<u32>(Section::eCount) };
+    config::BV bv { config::BV::eNone };
+    Bvh::Layout layout { Bvh::Layout::eBinaryStandard };
+    u32 nodeCountLeaf { 0 };
+    u32 nodeCountTotal { 0 };
+    u32 padding { 0 };
+};
+
+// offsets are absolute within the file and ALIGNMENT aligned
+struct SectionEntry {
+    Section type { Section::eCount };
+    u32 padding { 0 };
+    u64 offset { 0 };
+    u64 size { 0 };
+};
+
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(std::is_trivially_copyable_v<SectionEntry>);
+
+inline static u64 alignUp(u64 value)
+{
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+}
+
+namespace backend::cpu::bvh {
+
+template<typename T>
+static std::span<std::byte const> bytes(std::vector<T> const& data)
+{
+    return std::as_bytes(std::span { data });
+}
+
+// false if the block is not a whole number of elements
+template<typename T>
+static bool assign(std::vector<T>& data, std::span<std::byte const> block)
+{
+    if (block.size() % sizeof(T) != 0)
+        return false;
+    data.resize(block.size() / sizeof(T));
+    memcpy(data.data(), block.data(), data.size() * sizeof(T));
+    return true;
+}
+
+// the node and aux buffers hold exactly nodeCountTotal nodes of the layout, as the stages write them
+static bool validNodes(Bvh const& bvh)
+{
+    using namespace data_bvh;
+    auto const n { static_cast<size_t>(bvh.nodeCountTotal) };
+    auto const holds { [&](size_t nodeSize, size_t auxSize = 0) { return bvh.nodes.size() == nodeSize * n && bvh.aux.size() == auxSize * n; } };
+    auto const aabb { bvh.bv == config::BV::eAABB };
+    auto const dop14 { bvh.bv == config::BV::eDOP14 };
+    switch (bvh.layout) {
+    case Bvh::Layout::eBinaryStandard:
+        if (aabb)
+            return holds(sizeof(NodeBvhBinary));
+        if (dop14)
+            return holds(sizeof(NodeBvhBinaryDOP14));
+        // PLOC++ points or the transformed OBBs
+        return holds(sizeof(NodeBvhBinaryDiTO14Points)) || holds(sizeof(NodeBvhBinaryOBB));
+    case Bvh::Layout::eBinaryCompressed:
+        if (aabb)
+            return holds(sizeof(NodeBvhBinaryCompressed));
+        if (dop14)
+            return holds(sizeof(NodeBvhBinaryDOP14Compressed));
+        return holds(sizeof(NodeBvhBinaryOBBCompressed));
+    case Bvh::Layout::eBinaryCompressed_dop14Split:
+        return dop14 && holds(sizeof(NodeBvhBinaryCompressed), sizeof(NodeBvhBinaryDOP14Compressed_SPLIT));
+    case Bvh::Layout::eWide4:
+        return aabb ? holds(sizeof(NodeBvhWide4)) : dop14 && holds(sizeof(NodeBvhWide4DOP14));
+    case Bvh::Layout::eWide8:
+        return aabb ? holds(sizeof(NodeBvhWide8)) : dop14 && holds(sizeof(NodeBvhWide8DOP14));
+    case Bvh::Layout::eBinaryQuantized8:
+        return aabb ? holds(sizeof(NodeBvhBinaryQuantized8)) : dop14 && holds(sizeof(NodeBvhBinaryDOP14Quantized8));
+    case Bvh::Layout::eBinaryQuantized16:
+        return aabb ? holds(sizeof(NodeBvhBinaryQuantized16)) : dop14 && holds(sizeof(NodeBvhBinaryDOP14Quantized16));
+    }
+    return false;
+}
+
+bool serializeToFile(Bvh const& bvh, std::filesystem::path const& path)
+{
+    using namespace file;
+
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    Header const header {
+        .bv = bvh.bv,
+        .layout = bvh.layout,
+        .nodeCountLeaf = bvh.nodeCountLeaf,
+        .nodeCountTotal = bvh.nodeCountTotal,
+    };
+    std::array const blocks { bytes(bvh.nodes), bytes(bvh.triangles), bytes(bvh.triangleIDs), bytes(bvh.aux) };
+
+    std::array<SectionEntry, static_cast<size_t>(Section::eCount)> sections {};
+    u64 offset { alignUp(sizeof(Header) + sizeof(sections)) };
+    for (u32 i = 0; i < sections.size(); ++i) {
+        sections[i] = { .type = static_cast<Section>(i), .offset = offset, .size = blocks[i].size() };
+        offset = alignUp(offset + blocks[i].size());
+    }
+
+    static constexpr char zeros[ALIGNMENT] {};
+    out.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+    out.write(reinterpret_cast<char const*>(sections.data()), sizeof(sections));
+    for (u32 i = 0; i < sections.size(); ++i) {
+        auto const pos { static_cast<u64>(out.tellp()) };
+        out.write(zeros, static_cast<std::streamsize>(sections[i].offset - pos));
+        out.write(reinterpret_cast<char const*>(blocks[i].data()), static_cast<std::streamsize>(blocks[i].size()));
+    }
+    return out.good();
+}
+
+Bvh deserialize(std::filesystem::path const& path)
+{
+    using namespace file;
+
+    Bvh result;
+    scene::MappedFile const file { path };
+    if (!file.IsValid())
+        return result;
+
+    using Sections = std::array<SectionEntry, static_cast<size_t>(Section::eCount)>;
+    auto const data { file.Data() };
+    if (data.size() < sizeof(Header) + sizeof(Sections))
+        return result;
+
+    Header header;
+    Sections sections;
+    memcpy(&header, data.data(), sizeof(Header));
+    memcpy(sections.data(), data.data() + sizeof(Header), sizeof(Sections));
+    if (header.magic != MAGIC || header.version != VERSION || header.sectionCount != static_cast<u32>(Section::eCount))
+        return result;
+
+    // the blocks are copied straight from the mapping, a Bvh owns its buffers, every section is stored once
+    u32 sectionMask { 0 };
+    for (auto const& s : sections) {
+        if (s.offset > data.size() || s.size > data.size() - s.offset)
+            return {};
+        if (static_cast<u32>(s.type) >= static_cast<u32>(Section::eCount) || (sectionMask & 1u << static_cast<u32>(s.type)))
+            return {};
+        sectionMask |= 1u << static_cast<u32>(s.type);
+        auto const block { data.subspan(s.offset, s.size) };
+
+        bool valid { false };
+        switch (s.type) {
+        case Section::eNodes:
+            valid = assign(result.nodes, block);
+            break;
+        case Section::eTriangles:
+            valid = assign(result.triangles, block);
+            break;
+        case Section::eTriangleIDs:
+            valid = assign(result.triangleIDs, block);
+            break;
+        case Section::eAux:
+            valid = assign(result.aux, block);
+            break;
+        case Section::eCount:
+            break;
+        }
+        if (!valid)
+            return {};
+    }
+
+    switch (header.bv) {
+    case config::BV::eAABB:
+    case config::BV::eDOP14:
+    case config::BV::eOBB:
+        break;
+    default:
+        return {};
+    }
+
+    result.bv = header.bv;
+    result.layout = header.layout;
+    result.nodeCountLeaf = header.nodeCountLeaf;
+    result.nodeCountTotal = header.nodeCountTotal;
+    // one triangle id per triangle, every leaf holds at least one triangle
+    if (result.nodeCountTotal == 0 || !validNodes(result) || result.triangles.size() != result.triangleIDs.size() || result.nodeCountLeaf == 0
+        || result.nodeCountLeaf > result.triangles.size())
+        return {};
+    return result;
+}
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Types.h"
+#include <filesystem>
+
+namespace backend::cpu::bvh {
+
+// '*.bvh': header, section table and 64B aligned node/triangle/triangle id/aux blocks, buffers are stored as is
+bool serializeToFile(Bvh const& bvh, std::filesystem::path const& path);
+// memory mapped, empty Bvh (nodeCountTotal == 0) if the file is missing or not a valid '*.bvh'
+Bvh deserialize(std::filesystem::path const& path);
+
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../../Config.h"
+#include <vLime/types.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <utility>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#endif
+
+// space filling curves ordering the initial PLOC++ clusters, the same codes as morton32.glsl, morton64.glsl and hilbert64.glsl
+//   points are centroids normalized to the cubed scene AABB, i.e. within [0, 1]
+// the 64 bit curves quantize to 21 bits per axis, the 63 bit code and the cluster id share one 64 bit sort key:
+//   the code keeps its 64 - clusterIdBits most significant bits, the id fills the rest, equal codes stay in cluster id order
+//   (the GPU radix sort holds 64 bit keyvals at most)
+namespace backend::cpu::bvh {
+
+inline constexpr u32 SFC64_AXIS_BITS { 21 };
+
+[[nodiscard]] inline u32 mortonCode32_part(u32 a)
+{
+    u32 x = a & 0x000003ff;
+    x = (x | x << 16) & 0x30000ff;
+    x = (x | x << 8) & 0x0300f00f;
+    x = (x | x << 4) & 0x30c30c3;
+    x = (x | x << 2) & 0x9249249;
+    return x;
+}
+
+[[nodiscard]] inline u32 mortonCode32(glm::vec3 const& p)
+{
+    static constexpr f32 MORTON_SCALE_TO_U32 { (1u << 10) - 1 };
+    glm::uvec3 const q { p * MORTON_SCALE_TO_U32 };
+    return mortonCode32_part(q.x) | (mortonCode32_part(q.y) << 1) | (mortonCode32_part(q.z) << 2);
+}
+
+[[nodiscard]] inline glm::uvec3 quantize64(glm::vec3 const& p)
+{
+    static constexpr f32 SCALE_TO_U64 { (1u << SFC64_AXIS_BITS) - 1 };
+    return glm::uvec3 { p * SCALE_TO_U64 };
+}
+
+[[nodiscard]] inline u64 mortonCode64_part(u32 a)
+{
+    u64 x = a & 0x1fffffull;
+    x = (x | x << 32) & 0x1f00000000ffffull;
+    x = (x | x << 16) & 0x1f0000ff0000ffull;
+    x = (x | x << 8) & 0x100f00f00f00f00full;
+    x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2) & 0x1249249249249249ull;
+    return x;
+}
+
+[[nodiscard]] inline u64 mortonCode64(glm::uvec3 const& q)
+{
+    return mortonCode64_part(q.x) | (mortonCode64_part(q.y) << 1) | (mortonCode64_part(q.z) << 2);
+}
+
+// Skilling's axes to transposed Hilbert index, x[0] ends up with the most significant bit of each triple
+[[nodiscard]] inline u64 hilbertCode64(glm::uvec3 const& q)
+{
+    u32 x[3] { q.x, q.y, q.z };
+    for (u32 m = 1u << (SFC64_AXIS_BITS - 1); m > 1; m >>= 1) {
+        auto const p { m - 1 };
+        for (u32 i = 0; i < 3; ++i) {
+            if (x[i] & m) {
+                x[0] ^= p;
+            } else {
+                auto const t { (x[0] ^ x[i]) & p };
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // gray code
+    x[1] ^= x[0];
+    x[2] ^= x[1];
+    u32 t { 0 };
+    for (u32 m = 1u << (SFC64_AXIS_BITS - 1); m > 1; m >>= 1)
+        if (x[2] & m)
+            t ^= m - 1;
+    for (auto& v : x)
+        v ^= t;
+
+    return mortonCode64({ x[2], x[1], x[0] });
+}
+
+[[nodiscard]] inline u32 clusterIdBits(u32 clusterCount)
+{
+    return static_cast<u32>(std::bit_width(std::max(clusterCount, 2u) - 1));
+}
+
+[[nodiscard]] inline u64 clusterKey64(u64 code, u32 clusterId, u32 idBits)
+{
+    return ((code << 1) & (~0ull << idBits)) | clusterId;
+}
+
+[[nodiscard]] inline u64 clusterKey64(config::SpaceFilling sfc, glm::vec3 const& p, u32 clusterId, u32 idBits)
+{
+    auto const q { quantize64(p) };
+    return clusterKey64(sfc == config::SpaceFilling::eHilbert64 ? hilbertCode64(q) : mortonCode64(q), clusterId, idBits);
+}
+
+#if defined(__AVX2__)
+[[nodiscard]] inline __m256i mortonCode64_part(__m256i x)
+{
+    x = _mm256_and_si256(x, _mm256_set1_epi64x(0x1fffffll));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 32)), _mm256_set1_epi64x(0x1f00000000ffffll));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 16)), _mm256_set1_epi64x(0x1f0000ff0000ffll));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 8)), _mm256_set1_epi64x(0x100f00f00f00f00fll));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 4)), _mm256_set1_epi64x(0x10c30c30c30c30c3ll));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 2)), _mm256_set1_epi64x(0x1249249249249249ll));
+    return x;
+}
+
+// transposed axes of hilbertCode64 for 8 points, the branches become masks, x[0] and x[2] end up in the mortonCode64 order
+inline void hilbertTranspose(__m256i (&x)[3])
+{
+    for (u32 m = 1u << (SFC64_AXIS_BITS - 1); m > 1; m >>= 1) {
+        auto const vm { _mm256_set1_epi32(static_cast<i32>(m)) };
+        auto const p { _mm256_set1_epi32(static_cast<i32>(m - 1)) };
+        for (u32 i = 0; i < 3; ++i) {
+            auto const set { _mm256_cmpeq_epi32(_mm256_and_si256(x[i], vm), vm) };
+            auto const t { _mm256_andnot_si256(set, _mm256_and_si256(_mm256_xor_si256(x[0], x[i]), p)) };
+            x[0] = _mm256_xor_si256(x[0], _mm256_or_si256(_mm256_and_si256(set, p), t));
+            if (i > 0)
+                x[i] = _mm256_xor_si256(x[i], t);
+        }
+    }
+
+    x[1] = _mm256_xor_si256(x[1], x[0]);
+    x[2] = _mm256_xor_si256(x[2], x[1]);
+    auto t { _mm256_setzero_si256() };
+    for (u32 m = 1u << (SFC64_AXIS_BITS - 1); m > 1; m >>= 1) {
+        auto const vm { _mm256_set1_epi32(static_cast<i32>(m)) };
+        auto const set { _mm256_cmpeq_epi32(_mm256_and_si256(x[2], vm), vm) };
+        t = _mm256_xor_si256(t, _mm256_and_si256(set, _mm256_set1_epi32(static_cast<i32>(m - 1))));
+    }
+    for (auto& v : x)
+        v = _mm256_xor_si256(v, t);
+    std::swap(x[0], x[2]);
+}
+#endif
+
+// keys[i] = clusterKey64 of points[i] and cluster idBase + i, with AVX2 8 points at a time
+inline void clusterKeys64(config::SpaceFilling sfc, std::span<glm::vec3 const> points, u32 idBase, u32 idBits, std::span<u64> keys)
+{
+    size_t i { 0 };
+#if defined(__AVX2__)
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(f32));
+    auto const gather { _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21) };
+    auto const scale { _mm256_set1_ps(static_cast<f32>((1u << SFC64_AXIS_BITS) - 1)) };
+    auto const codeMask { _mm256_set1_epi64x(static_cast<i64>(~0ull << idBits)) };
+    for (; i + 8 <= points.size(); i += 8) {
+        auto const* p { &points[i].x };
+        __m256i q[3];
+        for (u32 a = 0; a < 3; ++a)
+            q[a] = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_i32gather_ps(p + a, gather, 4), scale));
+        if (sfc == config::SpaceFilling::eHilbert64)
+            hilbertTranspose(q);
+
+        for (u32 h = 0; h < 2; ++h) {
+            auto const spread { [h](__m256i v) {
+                return mortonCode64_part(_mm256_cvtepu32_epi64(h == 0 ? _mm256_castsi256_si128(v) : _mm256_extracti128_si256(v, 1)));
+            } };
+            auto const code { _mm256_or_si256(spread(q[0]), _mm256_or_si256(_mm256_slli_epi64(spread(q[1]), 1), _mm256_slli_epi64(spread(q[2]), 2))) };
+            auto const id { static_cast<i64>(idBase + i + 4 * h) };
+            auto const ids { _mm256_setr_epi64x(id, id + 1, id + 2, id + 3) };
+            auto const key { _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi64(code, 1), codeMask), ids) };
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(keys.data() + i + 4 * h), key);
+        }
+    }
+#endif
+    for (; i < points.size(); ++i)
+        keys[i] = clusterKey64(sfc, points[i], idBase + static_cast<u32>(i), idBits);
+}
+
+}
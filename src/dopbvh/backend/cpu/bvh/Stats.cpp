@@ -0,0 +1,768 @@
+#include "Stats.h"
+
+#include "../../../core/Profiler.h"
+#include "../bv/Obb.h"
+#include "Compressed.h"
+#include "Quantized.h"
+#include "Wide.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <type_traits>
+
+namespace backend::cpu::bvh {
+
+static constexpr size_t CHUNK_SIZE { 1 << 14 };
+
+// partial sums of one chunk, doubles keep the sums over millions of nodes stable
+struct Aggregate {
+    f64 saTraverse { 0. };
+    f64 saIntersect { 0. };
+    f64 costIntersect { 0. };
+
+    u32 leafSizeSum { 0 };
+    u32 leafSizeMin { 0xFFFFFFFF };
+    u32 leafSizeMax { 0 };
+
+    void AddInterior(f32 area)
+    {
+        saTraverse += area;
+    }
+
+    void AddLeaf(f32 area, u32 size)
+    {
+        saIntersect += area;
+        costIntersect += static_cast<f64>(size) * area;
+
+        leafSizeSum += size;
+        leafSizeMin = std::min(leafSizeMin, size);
+        leafSizeMax = std::max(leafSizeMax, size);
+    }
+
+    void Add(Aggregate const& other)
+    {
+        saTraverse += other.saTraverse;
+        saIntersect += other.saIntersect;
+        costIntersect += other.costIntersect;
+
+        leafSizeSum += other.leafSizeSum;
+        leafSizeMin = std::min(leafSizeMin, other.leafSizeMin);
+        leafSizeMax = std::max(leafSizeMax, other.leafSizeMax);
+    }
+};
+
+template<typename PerNode>
+static Aggregate aggregate(Executor& executor, u32 nodeCount, PerNode perNode)
+{
+    std::vector<Aggregate> chunks((nodeCount + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    parallelForChunks(executor, nodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto& a { chunks[begin / CHUNK_SIZE] };
+        for (auto nodeId { begin }; nodeId < end; ++nodeId)
+            perNode(nodeId, a);
+    });
+
+    Aggregate result;
+    for (auto const& a : chunks)
+        result.Add(a);
+    return result;
+}
+
+template<typename Node, typename Bv>
+static Aggregate aggregateStandard(Executor& executor, Bvh const& bvh)
+{
+    auto const nodes { bvh.Nodes<Node>() };
+    // root is the last node, its area is the same for every tree of the scene
+    return aggregate(executor, bvh.nodeCountTotal - 1, [nodes](size_t nodeId, Aggregate& a) {
+        auto const& node { nodes[nodeId] };
+        auto const area { bv::bvArea(loadBv<Bv>(node)) };
+        // PLOC++ leaves have size 1, collapsed leaves store the negative triangle count
+        if (node.size <= 1)
+            a.AddLeaf(area, static_cast<u32>(std::abs(node.size)));
+        else
+            a.AddInterior(area);
+    });
+}
+
+template<typename NodeCompressed, typename ChildAreas>
+static Aggregate aggregateCompressed(Executor& executor, Bvh const& bvh, ChildAreas childAreas)
+{
+    auto const nodes { bvh.Nodes<NodeCompressed>() };
+    // every node holds the areas of its children, root is the only node not counted
+    return aggregate(executor, bvh.nodeCountTotal, [nodes, &childAreas](size_t nodeId, Aggregate& a) {
+        auto const& node { nodes[nodeId] };
+        std::array<f32, 2> const sa { childAreas(nodeId) };
+        std::array<i32, 2> const children { node.c0, node.c1 };
+        for (u32 i = 0; i < 2; ++i) {
+            if (children[i] > 0)
+                a.AddInterior(sa[i]);
+            else
+                a.AddLeaf(sa[i], leafSize(children[i]));
+        }
+    });
+}
+
+template<typename NodeWide>
+static Aggregate aggregateWide(Executor& executor, Bvh const& bvh)
+{
+    auto const nodes { bvh.Nodes<NodeWide>() };
+    return aggregate(executor, bvh.nodeCountTotal, [nodes](size_t nodeId, Aggregate& a) {
+        auto const& node { nodes[nodeId] };
+        for (u32 c = 0; c < NodeWide::WIDTH; ++c) {
+            if (isEmptyChild(node, c))
+                continue;
+            auto const area { bv::bvArea(getChildBv(node, c)) };
+            if (node.child[c] > 0)
+                a.AddInterior(area);
+            else
+                a.AddLeaf(area, leafSize(node.child[c]));
+        }
+    });
+}
+
+template<u32 W>
+static Aggregate aggregateWide(Executor& executor, Bvh const& bvh, config::BV bv)
+{
+    if (bv == config::BV::eDOP14)
+        return aggregateWide<NodeBvhWide<W, 7>>(executor, bvh);
+    return aggregateWide<NodeBvhWide<W, 3>>(executor, bvh);
+}
+
+// areas of the dequantized children, i.e. of the bounds the traversal sees
+template<typename NodeCompressed, typename NodeQuantized>
+static Aggregate aggregateQuantized(Executor& executor, Bvh const& bvh)
+{
+    auto const nodes { bvh.Nodes<NodeQuantized>() };
+    return aggregateCompressed<NodeQuantized>(executor, bvh, [nodes](size_t nodeId) {
+        NodeCompressed node;
+        dequantizeNode(nodes[nodeId], node);
+        return std::array { bv::bvArea(getBoxC0(node)), bv::bvArea(getBoxC1(node)) };
+    });
+}
+
+template<typename Q>
+static Aggregate aggregateQuantized(Executor& executor, Bvh const& bvh, config::BV bv)
+{
+    if (bv == config::BV::eDOP14)
+        return aggregateQuantized<data_bvh::NodeBvhBinaryDOP14Compressed, NodeBvhBinaryQuantized<Q, 7>>(executor, bvh);
+    return aggregateQuantized<data_bvh::NodeBvhBinaryCompressed, NodeBvhBinaryQuantized<Q, 3>>(executor, bvh);
+}
+
+// inverse of woopify in PLOCpp.cpp, the stored rows are rows 2 (w negated), 0 and 1 of the inverse triangle matrix
+static std::array<glm::vec3, 3> triangleVertices(data_bvh::BvhTriangle const& t)
+{
+    glm::mat4 inverse;
+    for (u32 c = 0; c < 3; ++c)
+        inverse[c] = glm::vec4(t.v1[c], t.v2[c], t.v0[c], 0.f);
+    inverse[3] = glm::vec4(t.v1[3], t.v2[3], -t.v0[3], 1.f);
+    auto const matrix { glm::inverse(inverse) };
+    glm::vec3 const v2 { matrix[3] };
+    return { glm::vec3(matrix[0]) + v2, glm::vec3(matrix[1]) + v2, v2 };
+}
+
+static f32 triangleArea(std::array<glm::vec3, 3> const& v)
+{
+    return .5f * glm::length(glm::cross(v[1] - v[0], v[2] - v[0]));
+}
+
+// child slot of an interior node, node is INVALID_ID for leaves
+template<typename Bv>
+struct ChildSlot {
+    i32 node { INVALID_ID };
+    u32 triangleOffset { 0 };
+    u32 triangleCount { 0 };
+    Bv bv;
+};
+
+static constexpr u32 MAX_CHILD_COUNT { 8 };
+
+// child reference of the compressed, quantized and wide layouts, see encodeLeaf
+template<typename Bv>
+static void setSlot(ChildSlot<Bv>& slot, i32 child, Bv const& bv)
+{
+    slot.node = child > 0 ? child : INVALID_ID;
+    slot.triangleOffset = child > 0 ? 0 : leafTriangleOffset(child);
+    slot.triangleCount = child > 0 ? 0 : leafSize(child);
+    slot.bv = bv;
+}
+
+// views: children(nodeId, slots) fills the child slots of an interior node and returns their count
+template<typename Node, typename Bv>
+static auto viewStandard(Bvh const& bvh)
+{
+    return [nodes = bvh.Nodes<Node>()](u32 nodeId, ChildSlot<Bv>* slots) {
+        auto const& node { nodes[nodeId] };
+        u32 count { 0 };
+        for (auto const c : { node.c0, node.c1 }) {
+            auto const childId { std::abs(c) };
+            auto const& child { nodes[childId] };
+            auto& slot { slots[count++] };
+            slot.bv = loadBv<Bv>(child);
+            slot.node = child.size > 1 ? childId : INVALID_ID;
+            // PLOC++ leaves are the triangles themselves, collapsed leaves store their triangle range
+            slot.triangleOffset = child.size == 1 ? static_cast<u32>(childId) : static_cast<u32>(child.c0);
+            slot.triangleCount = child.size > 1 ? 0 : static_cast<u32>(std::abs(child.size));
+        }
+        return count;
+    };
+}
+
+template<typename NodeCompressed, typename Bv>
+static auto viewCompressed(Bvh const& bvh)
+{
+    return [nodes = bvh.Nodes<NodeCompressed>()](u32 nodeId, ChildSlot<Bv>* slots) {
+        auto const& node { nodes[nodeId] };
+        setSlot(slots[0], node.c0, getBoxC0(node));
+        setSlot(slots[1], node.c1, getBoxC1(node));
+        return 2u;
+    };
+}
+
+static auto viewCompressedSplit(Bvh const& bvh)
+{
+    return [nodes = bvh.Nodes<data_bvh::NodeBvhBinaryCompressed>(), nodesSplit = bvh.Aux<data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT>()](u32 nodeId, ChildSlot<bv::Dop14>* slots) {
+        auto const& node { nodes[nodeId] };
+        setSlot(slots[0], node.c0, getBoxC0(node, nodesSplit[nodeId]));
+        setSlot(slots[1], node.c1, getBoxC1(node, nodesSplit[nodeId]));
+        return 2u;
+    };
+}
+
+template<typename NodeCompressed, typename NodeQuantized, typename Bv>
+static auto viewQuantized(Bvh const& bvh)
+{
+    return [nodes = bvh.Nodes<NodeQuantized>()](u32 nodeId, ChildSlot<Bv>* slots) {
+        NodeCompressed node;
+        dequantizeNode(nodes[nodeId], node);
+        setSlot(slots[0], node.c0, getBoxC0(node));
+        setSlot(slots[1], node.c1, getBoxC1(node));
+        return 2u;
+    };
+}
+
+template<typename NodeWide, typename Bv>
+static auto viewWide(Bvh const& bvh)
+{
+    static_assert(NodeWide::WIDTH <= MAX_CHILD_COUNT);
+    return [nodes = bvh.Nodes<NodeWide>()](u32 nodeId, ChildSlot<Bv>* slots) {
+        auto const& node { nodes[nodeId] };
+        u32 count { 0 };
+        for (u32 c = 0; c < NodeWide::WIDTH; ++c)
+            if (!isEmptyChild(node, c))
+                setSlot(slots[count++], node.child[c], getChildBv(node, c));
+        return count;
+    };
+}
+
+// f(std::type_identity<Bv>, children, rootId) with the view of the layout, nothing for unsupported combinations
+template<typename F>
+static void withView(Bvh const& bvh, F f)
+{
+    using namespace data_bvh;
+    auto const aabb { bvh.bv == config::BV::eAABB };
+    auto const dop14 { bvh.bv == config::BV::eDOP14 };
+    switch (bvh.layout) {
+    case Bvh::Layout::eBinaryStandard: {
+        // a root collapsed into a single leaf has no children
+        if (bvh.nodeCountTotal < 3)
+            return;
+        auto const root { bvh.nodeCountTotal - 1 };
+        if (aabb)
+            f(std::type_identity<bv::Aabb> {}, viewStandard<NodeBvhBinary, bv::Aabb>(bvh), root);
+        else if (dop14)
+            f(std::type_identity<bv::Dop14> {}, viewStandard<NodeBvhBinaryDOP14, bv::Dop14>(bvh), root);
+        else if (bvh.bv == config::BV::eOBB && bvh.nodes.size() == sizeof(NodeBvhBinaryDiTO14Points) * bvh.nodeCountTotal)
+            f(std::type_identity<bv::Dop14Points> {}, viewStandard<NodeBvhBinaryDiTO14Points, bv::Dop14Points>(bvh), root);
+        else if (bvh.bv == config::BV::eOBB)
+            f(std::type_identity<glm::mat4x3> {}, viewStandard<NodeBvhBinaryOBB, glm::mat4x3>(bvh), root);
+        break;
+    }
+    case Bvh::Layout::eBinaryCompressed:
+        if (aabb)
+            f(std::type_identity<bv::Aabb> {}, viewCompressed<NodeBvhBinaryCompressed, bv::Aabb>(bvh), 0u);
+        else if (dop14)
+            f(std::type_identity<bv::Dop14> {}, viewCompressed<NodeBvhBinaryDOP14Compressed, bv::Dop14>(bvh), 0u);
+        else if (bvh.bv == config::BV::eOBB)
+            f(std::type_identity<glm::mat4x3> {}, viewCompressed<NodeBvhBinaryOBBCompressed, glm::mat4x3>(bvh), 0u);
+        break;
+    case Bvh::Layout::eBinaryCompressed_dop14Split:
+        f(std::type_identity<bv::Dop14> {}, viewCompressedSplit(bvh), 0u);
+        break;
+    case Bvh::Layout::eWide4:
+        if (aabb)
+            f(std::type_identity<bv::Aabb> {}, viewWide<NodeBvhWide4, bv::Aabb>(bvh), 0u);
+        else if (dop14)
+            f(std::type_identity<bv::Dop14> {}, viewWide<NodeBvhWide4DOP14, bv::Dop14>(bvh), 0u);
+        break;
+    case Bvh::Layout::eWide8:
+        if (aabb)
+            f(std::type_identity<bv::Aabb> {}, viewWide<NodeBvhWide8, bv::Aabb>(bvh), 0u);
+        else if (dop14)
+            f(std::type_identity<bv::Dop14> {}, viewWide<NodeBvhWide8DOP14, bv::Dop14>(bvh), 0u);
+        break;
+    case Bvh::Layout::eBinaryQuantized8:
+        if (aabb)
+            f(std::type_identity<bv::Aabb> {}, viewQuantized<NodeBvhBinaryCompressed, NodeBvhBinaryQuantized8, bv::Aabb>(bvh), 0u);
+        else if (dop14)
+            f(std::type_identity<bv::Dop14> {}, viewQuantized<NodeBvhBinaryDOP14Compressed, NodeBvhBinaryDOP14Quantized8, bv::Dop14>(bvh), 0u);
+        break;
+    case Bvh::Layout::eBinaryQuantized16:
+        if (aabb)
+            f(std::type_identity<bv::Aabb> {}, viewQuantized<NodeBvhBinaryCompressed, NodeBvhBinaryQuantized16, bv::Aabb>(bvh), 0u);
+        else if (dop14)
+            f(std::type_identity<bv::Dop14> {}, viewQuantized<NodeBvhBinaryDOP14Compressed, NodeBvhBinaryDOP14Quantized16, bv::Dop14>(bvh), 0u);
+        break;
+    }
+}
+
+// slab normals of bv::dopProject
+static std::array<glm::vec3, 7> const DOP14_NORMALS {
+    glm::vec3 { 1.f, 0.f, 0.f }, glm::vec3 { 0.f, 1.f, 0.f }, glm::vec3 { 0.f, 0.f, 1.f },
+    glm::vec3 { 1.f, 1.f, 1.f }, glm::vec3 { 1.f, 1.f, -1.f }, glm::vec3 { 1.f, -1.f, 1.f }, glm::vec3 { 1.f, -1.f, -1.f }
+};
+
+static f32 overlapArea(bv::Aabb const& a, bv::Aabb const& b)
+{
+    return bv::bvArea(bv::overlapAabb(a, b));
+}
+
+// corner cutting expects the diagonal slabs to cut the box of the slabs 0-2, which the intersection of two DOPs
+//   does not guarantee, so they are clamped to the extent of that box first
+static f32 overlapArea(bv::Dop14 const& a, bv::Dop14 const& b)
+{
+    auto dop { bv::overlapDop(a, b) };
+    glm::vec3 const lo { dop[0], dop[2], dop[4] };
+    glm::vec3 const hi { dop[1], dop[3], dop[5] };
+    for (u32 k = 3; k < 7; ++k) {
+        auto const& n { DOP14_NORMALS[k] };
+        f32 boxLo { 0.f };
+        f32 boxHi { 0.f };
+        for (u32 i = 0; i < 3; ++i) {
+            boxLo += n[i] * (n[i] > 0.f ? lo[i] : hi[i]);
+            boxHi += n[i] * (n[i] > 0.f ? hi[i] : lo[i]);
+        }
+        dop[2 * k] = std::max(dop[2 * k], boxLo);
+        dop[2 * k + 1] = std::min(dop[2 * k + 1], boxHi);
+    }
+    return bv::bvArea(dop);
+}
+
+template<typename Bv>
+static f32 overlapArea(Bv const&, Bv const&)
+{
+    return 0.f;
+}
+
+// lo <= dot(n, x) <= hi for each slab, the clipping planes of the end-point overlap
+struct Slabs {
+    std::array<glm::vec3, 7> n;
+    std::array<f32, 7> lo;
+    std::array<f32, 7> hi;
+    u32 count { 0 };
+};
+
+static Slabs slabs(bv::Aabb const& aabb)
+{
+    Slabs result;
+    result.count = 3;
+    for (u32 k = 0; k < 3; ++k) {
+        result.n[k] = glm::vec3(0.f);
+        result.n[k][k] = 1.f;
+        result.lo[k] = aabb.min[k];
+        result.hi[k] = aabb.max[k];
+    }
+    return result;
+}
+
+static Slabs slabs(bv::Dop14 const& dop)
+{
+    Slabs result;
+    result.count = 7;
+    result.n = DOP14_NORMALS;
+    for (u32 k = 0; k < 7; ++k) {
+        result.lo[k] = dop[2 * k];
+        result.hi[k] = dop[2 * k + 1];
+    }
+    return result;
+}
+
+// rows of the world -> unit cube transformation, the cube is [-.5, .5]
+static Slabs slabs(glm::mat4x3 const& m)
+{
+    Slabs result;
+    result.count = 3;
+    for (u32 k = 0; k < 3; ++k) {
+        result.n[k] = glm::vec3(m[0][k], m[1][k], m[2][k]);
+        result.lo[k] = -.5f - m[3][k];
+        result.hi[k] = .5f - m[3][k];
+    }
+    return result;
+}
+
+// area of the part of the triangle within the slabs, only the slab sides the triangle crosses clip it
+static f32 clippedArea(std::array<glm::vec3, 3> const& triangle, f32 area, Slabs const& s)
+{
+    std::array<glm::vec2, 7> extent;
+    bool inside { true };
+    for (u32 k = 0; k < s.count; ++k) {
+        glm::vec3 const d { glm::dot(s.n[k], triangle[0]), glm::dot(s.n[k], triangle[1]), glm::dot(s.n[k], triangle[2]) };
+        extent[k] = { std::min({ d.x, d.y, d.z }), std::max({ d.x, d.y, d.z }) };
+        if (extent[k].y < s.lo[k] || extent[k].x > s.hi[k])
+            return 0.f;
+        inside &= extent[k].x >= s.lo[k] && extent[k].y <= s.hi[k];
+    }
+    if (inside)
+        return area;
+
+    // Sutherland-Hodgman, each plane adds at most one vertex
+    std::array<glm::vec3, 3 + 14> polygon[2];
+    std::copy(triangle.begin(), triangle.end(), polygon[0].begin());
+    u32 count { 3 };
+    u32 current { 0 };
+    auto const clip { [&](glm::vec3 const& n, f32 offset) {
+        auto const& in { polygon[current] };
+        auto& out { polygon[current ^ 1] };
+        u32 outCount { 0 };
+        for (u32 i = 0; i < count; ++i) {
+            auto const& a { in[i] };
+            auto const& b { in[(i + 1) % count] };
+            auto const da { glm::dot(n, a) - offset };
+            auto const db { glm::dot(n, b) - offset };
+            if (da >= 0.f)
+                out[outCount++] = a;
+            if ((da >= 0.f) != (db >= 0.f))
+                out[outCount++] = a + (b - a) * (da / (da - db));
+        }
+        count = outCount;
+        current ^= 1;
+    } };
+    for (u32 k = 0; k < s.count && count >= 3; ++k) {
+        if (extent[k].x < s.lo[k])
+            clip(s.n[k], s.lo[k]);
+        if (extent[k].y > s.hi[k] && count >= 3)
+            clip(-s.n[k], -s.hi[k]);
+    }
+    if (count < 3)
+        return 0.f;
+
+    auto const& p { polygon[current] };
+    glm::vec3 sum { 0.f };
+    for (u32 i = 1; i + 1 < count; ++i)
+        sum += glm::cross(p[i] - p[0], p[i + 1] - p[0]);
+    return .5f * glm::length(sum);
+}
+
+// partial sums of one chunk of a BFS level, the children of the level are one depth below
+struct LevelAggregate {
+    u32 leafCount { 0 };
+    u32 triangleCount { 0 };
+    f64 saTraverse { 0. };
+    f64 saIntersect { 0. };
+    f64 saOverlap { 0. };
+    std::array<u32, 16> leafSizes {};
+
+    void Add(LevelAggregate const& other)
+    {
+        leafCount += other.leafCount;
+        triangleCount += other.triangleCount;
+        saTraverse += other.saTraverse;
+        saIntersect += other.saIntersect;
+        saOverlap += other.saOverlap;
+        for (u32 i = 0; i < leafSizes.size(); ++i)
+            leafSizes[i] += other.leafSizes[i];
+    }
+};
+
+// the leaf of a sampled triangle, by its parent and child slot
+struct LeafRef {
+    i32 parent { INVALID_ID };
+    u32 slot { 0 };
+};
+
+// parents and depths of the interior nodes and the leaves of the sampled triangles, for the ancestor test of the EPO
+struct Ancestry {
+    std::vector<i32> parent;
+    std::vector<u32> depth;
+    std::vector<LeafRef> leaves;
+    u32 sampleStride { 1 };
+};
+
+template<typename Bv, typename Children>
+static void aggregateShape(Executor& executor, Children const& children, u32 root, f64 sceneSA, stats::Shape& shape, Ancestry* ancestry)
+{
+    shape.depths.assign(1, { .interiorCount = 1 });
+
+    std::vector<u32> level { root };
+    std::vector<LevelAggregate> chunks;
+    std::vector<std::vector<u32>> chunkChildren;
+    f64 saOverlap { 0. };
+    while (!level.empty()) {
+        auto const depth { static_cast<u32>(shape.depths.size()) };
+        auto const chunkCount { (level.size() + CHUNK_SIZE - 1) / CHUNK_SIZE };
+        chunks.assign(chunkCount, {});
+        chunkChildren.resize(chunkCount);
+        parallelForChunks(executor, level.size(), CHUNK_SIZE, [&](size_t begin, size_t end) {
+            auto& a { chunks[begin / CHUNK_SIZE] };
+            auto& next { chunkChildren[begin / CHUNK_SIZE] };
+            next.clear();
+            std::array<ChildSlot<Bv>, MAX_CHILD_COUNT> slots;
+            for (auto i { begin }; i < end; ++i) {
+                auto const nodeId { level[i] };
+                auto const count { children(nodeId, slots.data()) };
+                for (u32 c = 0; c < count; ++c) {
+                    auto const& slot { slots[c] };
+                    auto const area { bv::bvArea(slot.bv) };
+                    for (u32 o = c + 1; o < count; ++o)
+                        a.saOverlap += overlapArea(slot.bv, slots[o].bv);
+
+                    if (slot.node != INVALID_ID) {
+                        a.saTraverse += area;
+                        next.push_back(static_cast<u32>(slot.node));
+                        if (ancestry) {
+                            ancestry->parent[slot.node] = static_cast<i32>(nodeId);
+                            ancestry->depth[slot.node] = depth;
+                        }
+                        continue;
+                    }
+
+                    ++a.leafCount;
+                    a.triangleCount += slot.triangleCount;
+                    a.saIntersect += area;
+                    ++a.leafSizes[std::min<u32>(slot.triangleCount, a.leafSizes.size() - 1)];
+                    if (ancestry) {
+                        auto const stride { ancestry->sampleStride };
+                        auto const sampleCount { static_cast<u32>(ancestry->leaves.size()) };
+                        for (auto s { (slot.triangleOffset + stride - 1) / stride }; s < sampleCount && s * stride < slot.triangleOffset + slot.triangleCount; ++s)
+                            ancestry->leaves[s] = { static_cast<i32>(nodeId), c };
+                    }
+                }
+            }
+        });
+
+        LevelAggregate a;
+        level.clear();
+        for (u32 i = 0; i < chunkCount; ++i) {
+            a.Add(chunks[i]);
+            level.insert(level.end(), chunkChildren[i].begin(), chunkChildren[i].end());
+        }
+        shape.depths.push_back({
+            .interiorCount = static_cast<u32>(level.size()),
+            .leafCount = a.leafCount,
+            .triangleCount = a.triangleCount,
+            .saTraverse = static_cast<f32>(a.saTraverse / sceneSA),
+            .saIntersect = static_cast<f32>(a.saIntersect / sceneSA),
+        });
+        saOverlap += a.saOverlap;
+        for (u32 i = 0; i < a.leafSizes.size(); ++i)
+            shape.leafSizeHistogram[i] += a.leafSizes[i];
+    }
+    shape.saOverlap = static_cast<f32>(saOverlap / sceneSA);
+}
+
+// each sampled triangle walks down from the root, every bound it overlaps outside its own ancestors adds its cost times the overlap
+template<typename Bv, typename Children>
+static void aggregateEpo(Executor& executor, Children const& children, u32 root, std::span<data_bvh::BvhTriangle const> triangles, Ancestry const& ancestry, config::Stats const& config, stats::Shape& shape)
+{
+    static constexpr size_t EPO_CHUNK_SIZE { 256 };
+
+    struct Partial {
+        f64 cost { 0. };
+        f64 area { 0. };
+    };
+
+    auto const sampleCount { ancestry.leaves.size() };
+    auto const maxDepth { static_cast<u32>(shape.depths.size()) };
+    std::vector<Partial> chunks((sampleCount + EPO_CHUNK_SIZE - 1) / EPO_CHUNK_SIZE);
+    parallelForChunks(executor, sampleCount, EPO_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto& partial { chunks[begin / EPO_CHUNK_SIZE] };
+        std::vector<i32> path(maxDepth + 1);
+        std::vector<std::pair<u32, u32>> stack;
+        std::array<ChildSlot<Bv>, MAX_CHILD_COUNT> slots;
+        for (auto s { begin }; s < end; ++s) {
+            auto const& leaf { ancestry.leaves[s] };
+            auto const triangle { triangleVertices(triangles[s * ancestry.sampleStride]) };
+            auto const area { triangleArea(triangle) };
+            // degenerate triangles have no Woop transformation to recover them from
+            if (leaf.parent == INVALID_ID || !std::isfinite(area) || area <= 0.f)
+                continue;
+            partial.area += area;
+
+            // interior ancestors by depth, the leaf parent is the deepest
+            auto const leafDepth { ancestry.depth[leaf.parent] };
+            for (auto a { leaf.parent }; a != INVALID_ID; a = ancestry.parent[a])
+                path[ancestry.depth[a]] = a;
+
+            stack.assign(1, { root, 0 });
+            while (!stack.empty()) {
+                auto const [nodeId, depth] { stack.back() };
+                stack.pop_back();
+                auto const count { children(nodeId, slots.data()) };
+                for (u32 c = 0; c < count; ++c) {
+                    auto const& slot { slots[c] };
+                    auto const interior { slot.node != INVALID_ID };
+                    auto const ancestor { interior ? depth + 1 <= leafDepth && path[depth + 1] == slot.node : static_cast<i32>(nodeId) == leaf.parent && c == leaf.slot };
+                    if (ancestor) {
+                        if (interior)
+                            stack.push_back({ static_cast<u32>(slot.node), depth + 1 });
+                        continue;
+                    }
+
+                    auto const overlap { clippedArea(triangle, area, slabs(slot.bv)) };
+                    if (overlap <= 0.f)
+                        continue;
+                    partial.cost += static_cast<f64>(interior ? config.c_t : config.c_i * static_cast<f32>(slot.triangleCount)) * overlap;
+                    if (interior)
+                        stack.push_back({ static_cast<u32>(slot.node), depth + 1 });
+                }
+            }
+        }
+    });
+
+    Partial result;
+    for (auto const& p : chunks) {
+        result.cost += p.cost;
+        result.area += p.area;
+    }
+    shape.epo = result.area > 0. ? static_cast<f32>(result.cost / result.area) : 0.f;
+    shape.epoSampleCount = static_cast<u32>(sampleCount);
+}
+
+Stats::Stats(Executor& executor)
+    : executor(executor)
+{
+}
+
+void Stats::Compute(config::Stats const& buildCfg, Bvh const& bvh)
+{
+    PROFILE_ZONE("BVH stats");
+    config = buildCfg;
+    data = {};
+    if (bvh.nodeCountTotal == 0)
+        return;
+
+    Aggregate a;
+    if (bvh.layout == Bvh::Layout::eWide4 || bvh.layout == Bvh::Layout::eWide8) {
+        if (config.bv != config::BV::eAABB && config.bv != config::BV::eDOP14)
+            return;
+        a = bvh.layout == Bvh::Layout::eWide4 ? aggregateWide<4>(executor, bvh, config.bv) : aggregateWide<8>(executor, bvh, config.bv);
+    } else if (bvh.layout == Bvh::Layout::eBinaryQuantized8 || bvh.layout == Bvh::Layout::eBinaryQuantized16) {
+        if (config.bv != config::BV::eAABB && config.bv != config::BV::eDOP14)
+            return;
+        a = bvh.layout == Bvh::Layout::eBinaryQuantized8 ? aggregateQuantized<u8>(executor, bvh, config.bv) : aggregateQuantized<u16>(executor, bvh, config.bv);
+    } else if (bvh.layout == Bvh::Layout::eBinaryStandard) {
+        switch (config.bv) {
+        case config::BV::eAABB:
+            a = aggregateStandard<data_bvh::NodeBvhBinary, bv::Aabb>(executor, bvh);
+            break;
+        case config::BV::eDOP14:
+            a = aggregateStandard<data_bvh::NodeBvhBinaryDOP14, bv::Dop14>(executor, bvh);
+            break;
+        case config::BV::eOBB:
+            // PLOC++ keeps the DiTO14 points of each node, the OBB matrices are fitted by collapsing
+            if (bvh.nodes.size() == sizeof(data_bvh::NodeBvhBinaryDiTO14Points) * bvh.nodeCountTotal)
+                a = aggregateStandard<data_bvh::NodeBvhBinaryDiTO14Points, bv::Dop14Points>(executor, bvh);
+            else
+                a = aggregateStandard<data_bvh::NodeBvhBinaryOBB, glm::mat4x3>(executor, bvh);
+            break;
+        case config::BV::eNone:
+            return;
+        }
+    } else {
+        switch (config.bv) {
+        case config::BV::eAABB: {
+            auto const nodes { bvh.Nodes<data_bvh::NodeBvhBinaryCompressed>() };
+            a = aggregateCompressed<data_bvh::NodeBvhBinaryCompressed>(executor, bvh, [nodes](size_t nodeId) {
+                return std::array { bv::bvArea(getBoxC0(nodes[nodeId])), bv::bvArea(getBoxC1(nodes[nodeId])) };
+            });
+            break;
+        }
+        case config::BV::eDOP14:
+            if (bvh.layout == Bvh::Layout::eBinaryCompressed_dop14Split) {
+                auto const nodes { bvh.Nodes<data_bvh::NodeBvhBinaryCompressed>() };
+                auto const nodesSplit { bvh.Aux<data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT>() };
+                a = aggregateCompressed<data_bvh::NodeBvhBinaryCompressed>(executor, bvh, [nodes, nodesSplit](size_t nodeId) {
+                    return std::array { bv::bvArea(getBoxC0(nodes[nodeId], nodesSplit[nodeId])), bv::bvArea(getBoxC1(nodes[nodeId], nodesSplit[nodeId])) };
+                });
+            } else {
+                auto const nodes { bvh.Nodes<data_bvh::NodeBvhBinaryDOP14Compressed>() };
+                a = aggregateCompressed<data_bvh::NodeBvhBinaryDOP14Compressed>(executor, bvh, [nodes](size_t nodeId) {
+                    return std::array { bv::bvArea(getBoxC0(nodes[nodeId])), bv::bvArea(getBoxC1(nodes[nodeId])) };
+                });
+            }
+            break;
+        case config::BV::eOBB: {
+            auto const nodes { bvh.Nodes<data_bvh::NodeBvhBinaryOBBCompressed>() };
+            a = aggregateCompressed<data_bvh::NodeBvhBinaryOBBCompressed>(executor, bvh, [nodes](size_t nodeId) {
+                return std::array { bv::bvArea(getBoxC0(nodes[nodeId])), bv::bvArea(getBoxC1(nodes[nodeId])) };
+            });
+            break;
+        }
+        case config::BV::eNone:
+            return;
+        }
+    }
+
+    auto const sceneSA { sceneAabbSurfaceArea(bvh) };
+    data.saTraverse = static_cast<f32>(a.saTraverse / sceneSA);
+    data.saIntersect = static_cast<f32>(a.saIntersect / sceneSA);
+    data.costTraverse = static_cast<f32>(config.c_t * a.saTraverse / sceneSA);
+    data.costIntersect = static_cast<f32>(config.c_i * a.costIntersect / sceneSA);
+
+    data.leafSizeSum = a.leafSizeSum;
+    data.leafSizeMin = a.leafSizeMin;
+    data.leafSizeMax = a.leafSizeMax;
+}
+
+void Stats::ComputeShape(config::Stats const& buildCfg, Bvh const& bvh)
+{
+    PROFILE_ZONE("BVH shape");
+    config = buildCfg;
+    shape = {};
+    if (bvh.nodeCountTotal == 0)
+        return;
+
+    Stopwatch stopwatch;
+    auto const sceneSA { sceneAabbSurfaceArea(bvh) };
+    withView(bvh, [&]<typename Bv>(std::type_identity<Bv>, auto const& children, u32 root) {
+        // the PLOC++ OBB tree has only the extremal points of each node, no bounds to clip against
+        if constexpr (!std::is_same_v<Bv, bv::Dop14Points>) {
+            if (config.epoSamples > 0 && !bvh.triangles.empty()) {
+                Ancestry ancestry;
+                auto const triangleCount { static_cast<u32>(bvh.triangles.size()) };
+                ancestry.sampleStride = std::max(1u, triangleCount / config.epoSamples);
+                ancestry.leaves.resize(std::min(config.epoSamples, triangleCount / ancestry.sampleStride));
+                ancestry.parent.resize(bvh.nodeCountTotal, INVALID_ID);
+                ancestry.depth.resize(bvh.nodeCountTotal, 0);
+                aggregateShape<Bv>(executor, children, root, sceneSA, shape, &ancestry);
+                aggregateEpo<Bv>(executor, children, root, std::span { bvh.triangles }, ancestry, config, shape);
+                return;
+            }
+        }
+        aggregateShape<Bv>(executor, children, root, sceneSA, shape, nullptr);
+    });
+    shape.timeTotal = stopwatch.Lap();
+}
+
+// a deserialized Bvh has no scene, its AABB is fitted to the triangles
+f64 Stats::sceneAabbSurfaceArea(Bvh const& bvh) const
+{
+    if (std::isfinite(metadata.sceneAabbSurfaceArea))
+        return metadata.sceneAabbSurfaceArea;
+
+    auto const triangleCount { bvh.triangles.size() };
+    std::vector<bv::Aabb> chunks((triangleCount + CHUNK_SIZE - 1) / CHUNK_SIZE, { glm::vec3(bv::BIG_FLOAT), glm::vec3(-bv::BIG_FLOAT) });
+    parallelForChunks(executor, triangleCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto& aabb { chunks[begin / CHUNK_SIZE] };
+        for (auto i { begin }; i < end; ++i)
+            for (auto const& v : triangleVertices(bvh.triangles[i]))
+                if (std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z))
+                    bv::bvFit(aabb, v);
+    });
+
+    bv::Aabb result { glm::vec3(bv::BIG_FLOAT), glm::vec3(-bv::BIG_FLOAT) };
+    for (auto const& aabb : chunks)
+        bv::bvFit(result, aabb);
+    return result.min.x <= result.max.x ? bv::bvArea(result) : std::numeric_limits<f64>::infinity();
+}
+
+}
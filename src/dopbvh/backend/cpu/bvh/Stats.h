@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "Types.h"
+#include <limits>
+
+namespace backend::cpu::bvh {
+
+// host implementation of vulkan::bvh::Stats, SAH areas and costs relative to the scene AABB, leaf sizes
+//   standard layouts sum the node areas without the root, compressed and wide layouts sum the child areas of all nodes
+//   per-chunk partial sums are reduced in chunk order, so the result does not depend on the thread count
+// ComputeShape walks any layout level by level from the root, for built as well as deserialized trees
+//   per-depth node counts and areas, leaf size histogram, pairwise overlap of sibling bounds (DOP14 by corner cutting, none for OBBs)
+//   end-point overlap (Aila et al. 2013) of config.epoSamples strided triangles, each clipped against the bounds it touches outside
+//   its ancestors, subtrees whose bound the triangle misses are skipped, which is exact for the nested AABBs and DOP14s
+// the scene AABB is recovered from the triangles if not set
+struct Stats {
+    config::Stats config;
+
+    BvhStats data;
+    stats::Shape shape;
+
+    explicit Stats(Executor& executor);
+
+    void Compute(config::Stats const& buildCfg, Bvh const& bvh);
+    void ComputeShape(config::Stats const& buildCfg, Bvh const& bvh);
+
+    void SetSceneAabbSurfaceArea(f32 sa) { metadata.sceneAabbSurfaceArea = sa; }
+
+private:
+    Executor& executor;
+
+    [[nodiscard]] f64 sceneAabbSurfaceArea(Bvh const& bvh) const;
+
+    struct Metadata {
+        f32 sceneAabbSurfaceArea { std::numeric_limits<f32>::infinity() };
+    } metadata;
+};
+
+}
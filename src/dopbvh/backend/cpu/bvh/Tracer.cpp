@@ -0,0 +1,348 @@
+#include "Tracer.h"
+
+#include "../../../core/Profiler.h"
+#include "../../../scene/Scene.h"
+#include <bit>
+#include <cassert>
+#include <type_traits>
+
+namespace backend::cpu::bvh {
+
+static constexpr size_t CHUNK_SIZE { 1 << 14 };
+static constexpr u32 TILE_SIZE { 32 };
+
+static constexpr f32 M_TWO_PI { 6.283185307179586476925286766559f };
+
+// random.glsl
+static u32 tea(u32 val0, u32 val1)
+{
+    u32 v0 { val0 };
+    u32 v1 { val1 };
+    u32 s0 { 0 };
+    for (u32 n = 0; n < 16; ++n) {
+        s0 += 0x9e3779b9;
+        v0 += ((v1 << 4) + 0xa341316c) ^ (v1 + s0) ^ ((v1 >> 5) + 0xc8013ea4);
+        v1 += ((v0 << 4) + 0xad90777d) ^ (v0 + s0) ^ ((v0 >> 5) + 0x7e95761e);
+    }
+    return v0;
+}
+
+static f32 rnd(u32& prev)
+{
+    prev = 1664525u * prev + 1013904223u;
+    return static_cast<f32>(prev & 0x00FFFFFF) / static_cast<f32>(0x01000000);
+}
+
+// rayCommon.glsl
+static glm::vec3 offsetRay(glm::vec3 const& p, glm::vec3 const& n)
+{
+    static constexpr f32 intScale { 256.f };
+    static constexpr f32 floatScale { 1.f / 65536.f };
+    static constexpr f32 origin { 1.f / 32.f };
+
+    glm::vec3 result;
+    for (u32 i = 0; i < 3; ++i) {
+        auto const offset { static_cast<i32>(intScale * n[i]) };
+        auto const pi { std::bit_cast<f32>(std::bit_cast<i32>(p[i]) + (p[i] < 0.f ? -offset : offset)) };
+        result[i] = std::abs(p[i]) < origin ? p[i] + floatScale * n[i] : pi;
+    }
+    return result;
+}
+
+static glm::vec3 sampleHemisphereCosineWorldSpace(f32 r1, f32 r2, glm::vec3 const& n)
+{
+    static constexpr f32 factor { .9999f };
+    auto const a { (1.f - 2.f * r1) * factor };
+    auto const b { std::sqrt(1.f - a * a) * factor };
+    auto const phi { M_TWO_PI * r2 };
+    return glm::normalize(n + glm::vec3(b * std::cos(phi), b * std::sin(phi), a));
+}
+
+Tracer::Tracer(Executor& executor)
+    : executor(executor)
+{
+}
+
+// calls f(batchSize, makeKernel), makeKernel() is called once per worker and returns kernel(rays, results, counters) tracing one batch
+//   layouts without a node view (Nodes = void) are always traced one ray at a time
+template<typename Nodes, typename Single, typename F>
+static void withMode(Bvh const& bvh, Tracer::Mode mode, Single single, F& f)
+{
+    if constexpr (!std::is_void_v<Nodes>) {
+        if (mode != Tracer::Mode::eSingleRay) {
+            auto const makeKernel = [&bvh, mode] {
+                using Batch = traversal::RayBatch<Nodes::NORMAL_COUNT>;
+                return [&bvh, mode, nodes = Nodes { bvh }, batch = Batch {}](std::span<data_bvh::Ray const> rays, std::span<data_bvh::RayTraceResult> results, traversal::Counters& counters) mutable {
+                    batch.Load(rays);
+                    if (mode == Tracer::Mode::ePacket)
+                        traversal::tracePackets(bvh, nodes, batch, counters);
+                    else
+                        traversal::traceStream(bvh, nodes, batch, counters);
+                    batch.Store(bvh, results);
+                };
+            };
+            f(mode == Tracer::Mode::ePacket ? Tracer::RAY_BATCH : Tracer::STREAM_BATCH, makeKernel);
+            return;
+        }
+    }
+
+    f(Tracer::RAY_BATCH, [&bvh, single] {
+        return [&bvh, single](std::span<data_bvh::Ray const> rays, std::span<data_bvh::RayTraceResult> results, traversal::Counters& counters) {
+            for (size_t i = 0; i < rays.size(); ++i)
+                results[i] = single(bvh, rays[i], counters);
+        };
+    });
+}
+
+// picks the kernels of the BVH layout, false if there are none
+template<typename F>
+static bool withKernel(Bvh const& bvh, Tracer::Mode mode, F&& f)
+{
+    using namespace traversal;
+    if (bvh.bv == config::BV::eAABB && bvh.layout == Bvh::Layout::eBinaryCompressed)
+        withMode<AabbNodes>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceAabbCompressed(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eDOP14 && bvh.layout == Bvh::Layout::eBinaryCompressed)
+        withMode<Dop14Nodes>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceDop14Compressed(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eDOP14 && bvh.layout == Bvh::Layout::eBinaryCompressed_dop14Split)
+        withMode<Dop14SplitNodes>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceDop14Split(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eOBB && bvh.layout == Bvh::Layout::eBinaryCompressed)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceObbCompressed(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eAABB && bvh.layout == Bvh::Layout::eBinaryQuantized8)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceAabbQuantized<u8>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eAABB && bvh.layout == Bvh::Layout::eBinaryQuantized16)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceAabbQuantized<u16>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eDOP14 && bvh.layout == Bvh::Layout::eBinaryQuantized8)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceDop14Quantized<u8>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eDOP14 && bvh.layout == Bvh::Layout::eBinaryQuantized16)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceDop14Quantized<u16>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eAABB && bvh.layout == Bvh::Layout::eWide4)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceWide<NodeBvhWide4>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eAABB && bvh.layout == Bvh::Layout::eWide8)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceWide<NodeBvhWide8>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eDOP14 && bvh.layout == Bvh::Layout::eWide4)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceWide<NodeBvhWide4DOP14>(bvh, ray, counters); }, f);
+    else if (bvh.bv == config::BV::eDOP14 && bvh.layout == Bvh::Layout::eWide8)
+        withMode<void>(bvh, mode, [](Bvh const& bvh, data_bvh::Ray const& ray, Counters& counters) { return traceWide<NodeBvhWide8DOP14>(bvh, ray, counters); }, f);
+    else
+        return false;
+    return true;
+}
+
+void Tracer::Trace(config::Tracer const& traceCfg, Runtime const& rt, Scene const& scene, Bvh const& inputBvh)
+{
+    PROFILE_ZONE("trace");
+    config = traceCfg;
+    stats = {};
+    costMaps = {};
+    if (config.bv == config::BV::eNone || inputBvh.nodeCountTotal == 0 || rt.x == 0 || rt.y == 0)
+        return;
+
+    auto rayCount { generatePrimaryRays(rt) };
+    if (recordCosts) {
+        costMaps.x = rt.x;
+        costMaps.y = rt.y;
+        costMaps.pathLength.assign(rayCount, 0);
+        for (u32 depth = 0; depth <= MAX_DEPTH; ++depth) {
+            costMaps.traversedNodes[depth].assign(rayCount, 0);
+            costMaps.testedTriangles[depth].assign(rayCount, 0);
+        }
+        rayCosts.resize(rayCount);
+    }
+
+    for (u32 depth = 0; rayCount > 0; ++depth) {
+        // secondary rays are incoherent, only the primary ones use the packet and stream kernels
+        //   a packet has no per ray counters, rays with recorded costs are traced alone
+        auto const traceMode { depth == 0 && !recordCosts ? mode : Mode::eSingleRay };
+        auto const costBuffer { recordCosts ? std::span(rayCosts).first(rayCount) : std::span<traversal::Counters> {} };
+        auto const traced { withKernel(inputBvh, traceMode, [&](u32 batchSize, auto makeKernel) {
+            stats.data[depth] = trace(std::span(rays[depth % 2]).first(rayCount), results, costBuffer, batchSize, makeKernel);
+        }) };
+        if (!traced) {
+            berry::Log::warn("Tracer (CPU): BVH layout not supported, only compressed BVHs are traced");
+            return;
+        }
+        if (recordCosts)
+            scatterCosts(depth, rayCount);
+        if (depth == MAX_DEPTH)
+            break;
+        rayCount = shadeAndCast(scene, depth, rayCount);
+    }
+}
+
+stats::Trace::PerDepth Tracer::TraceRays(Bvh const& inputBvh, std::span<data_bvh::Ray const> rayBuffer, std::span<data_bvh::RayTraceResult> resultBuffer)
+{
+    assert(resultBuffer.size() >= rayBuffer.size());
+    stats::Trace::PerDepth result;
+    if (inputBvh.nodeCountTotal == 0 || rayBuffer.empty())
+        return result;
+
+    if (!withKernel(inputBvh, mode, [&](u32 batchSize, auto makeKernel) { result = trace(rayBuffer, resultBuffer, {}, batchSize, makeKernel); }))
+        berry::Log::warn("Tracer (CPU): BVH layout not supported, only compressed BVHs are traced");
+    return result;
+}
+
+// per tile ray order of gen_ptrace_primary_rays.comp, columns of a tile are consecutive in the ray buffer
+u32 Tracer::generatePrimaryRays(Runtime const& rt)
+{
+    PROFILE_ZONE("primary rays");
+    auto const rayCount { rt.x * rt.y };
+    rays[0].resize(rayCount);
+    payloads[0].resize(rayCount);
+    results.resize(rayCount);
+    rays[1].resize(rayCount);
+    payloads[1].resize(rayCount);
+
+    auto const origin { rt.viewInv * glm::vec4(0.f, 0.f, 0.f, 1.f) };
+    auto const tileCountX { (rt.x + TILE_SIZE - 1) / TILE_SIZE };
+    auto const tileCountY { (rt.y + TILE_SIZE - 1) / TILE_SIZE };
+    parallelFor(executor, tileCountX * tileCountY, [&](size_t tile) {
+        auto const tileIdX { static_cast<u32>(tile) % tileCountX };
+        auto const tileIdY { static_cast<u32>(tile) / tileCountX };
+        auto const tileX { std::min(TILE_SIZE, rt.x - tileIdX * TILE_SIZE) };
+        auto const tileY { std::min(TILE_SIZE, rt.y - tileIdY * TILE_SIZE) };
+        auto const tileOffset { tileIdY * TILE_SIZE * rt.x + tileIdX * TILE_SIZE * tileY };
+
+        for (u32 localX = 0; localX < tileX; ++localX) {
+            for (u32 localY = 0; localY < tileY; ++localY) {
+                auto const px { tileIdX * TILE_SIZE + localX };
+                auto const py { tileIdY * TILE_SIZE + localY };
+
+                auto seed { tea(py * rt.x + px, rt.samplesComputed) };
+                glm::vec2 jitter { .5f };
+                if (rt.samplesComputed > 0) {
+                    jitter.x = rnd(seed);
+                    jitter.y = rnd(seed);
+                }
+                auto const d { (glm::vec2(px, py) + jitter) / glm::vec2(rt.x, rt.y) * 2.f - 1.f };
+                auto const target { rt.projectionInv * glm::vec4(d.x, d.y, 1.f, 1.f) };
+                auto const dir { rt.viewInv * glm::vec4(glm::normalize(glm::vec3(target)), 0.f) };
+
+                auto const rayId { tileOffset + localX * tileY + localY };
+                rays[0][rayId] = { { origin.x, origin.y, origin.z, .01f }, { dir.x, dir.y, dir.z, traversal::BIG_FLOAT } };
+                payloads[0][rayId] = { .pixel = px << 18 | py << 4 | RAY_TYPE_PRIMARY, .seed = seed };
+            }
+        }
+    });
+    return rayCount;
+}
+
+template<typename MakeKernel>
+stats::Trace::PerDepth Tracer::trace(std::span<data_bvh::Ray const> rayBuffer, std::span<data_bvh::RayTraceResult> resultBuffer, std::span<traversal::Counters> costBuffer, u32 batchSize,
+    MakeKernel makeKernel)
+{
+    auto const rayCount { static_cast<u32>(rayBuffer.size()) };
+
+    std::atomic<u32> rayTracedCount { 0 };
+    std::atomic<u64> traversedNodes { 0 };
+    std::atomic<u64> testedTriangles { 0 };
+    std::atomic<u64> dopTests { 0 };
+
+    Stopwatch stopwatch;
+    parallelFor(executor, executor.num_workers(), [&](size_t) {
+        PROFILE_ZONE("trace worker");
+        auto kernel { makeKernel() };
+        traversal::Counters counters;
+        for (auto begin { rayTracedCount.fetch_add(batchSize, std::memory_order_relaxed) }; begin < rayCount; begin = rayTracedCount.fetch_add(batchSize, std::memory_order_relaxed)) {
+            auto const count { std::min(rayCount - begin, batchSize) };
+            if (costBuffer.empty()) {
+                kernel(rayBuffer.subspan(begin, count), resultBuffer.subspan(begin, count), counters);
+                continue;
+            }
+            for (auto i { begin }; i < begin + count; ++i) {
+                costBuffer[i] = {};
+                kernel(rayBuffer.subspan(i, 1), resultBuffer.subspan(i, 1), costBuffer[i]);
+                counters += costBuffer[i];
+            }
+        }
+        traversedNodes.fetch_add(counters.traversedNodes, std::memory_order_relaxed);
+        testedTriangles.fetch_add(counters.testedTriangles, std::memory_order_relaxed);
+        dopTests.fetch_add(counters.dopTests, std::memory_order_relaxed);
+    });
+
+    stats::Trace::PerDepth s;
+    s.traceTimeMs = stopwatch.Lap();
+    s.rayCount = rayCount;
+    s.traversedNodes = traversedNodes.load();
+    s.testedTriangles = testedTriangles.load();
+    s.dopTests = dopTests.load();
+    return s;
+}
+
+// the rays of one depth cover distinct pixels, payload pixel is px << 18 | py << 4 | ray type
+void Tracer::scatterCosts(u32 depth, u32 rayCount)
+{
+    auto const& payload { payloads[depth % 2] };
+    parallelForChunks(executor, rayCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto i { begin }; i < end; ++i) {
+            auto const pixel { payload[i].pixel };
+            auto const id { (pixel >> 4 & 0x3FFFu) * costMaps.x + (pixel >> 18) };
+            costMaps.pathLength[id] = static_cast<u8>(depth + 1);
+            costMaps.traversedNodes[depth][id] = static_cast<u32>(rayCosts[i].traversedNodes);
+            costMaps.testedTriangles[depth][id] = static_cast<u32>(rayCosts[i].testedTriangles);
+        }
+    });
+}
+
+// one cosine weighted bounce per hit, rays of the next depth are compacted in the order of this depth
+u32 Tracer::shadeAndCast(Scene const& scene, u32 depth, u32 rayCount)
+{
+    PROFILE_ZONE("shade and cast");
+    auto const& rayRead { rays[depth % 2] };
+    auto const& payloadRead { payloads[depth % 2] };
+    auto& rayWrite { rays[(depth + 1) % 2] };
+    auto& payloadWrite { payloads[(depth + 1) % 2] };
+
+    chunkOffsets.assign((rayCount + CHUNK_SIZE - 1) / CHUNK_SIZE, 0);
+    parallelForChunks(executor, rayCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto& hitCount { chunkOffsets[begin / CHUNK_SIZE] };
+        for (auto i { begin }; i < end; ++i)
+            if (results[i].instanceId != traversal::INVALID_HIT)
+                ++hitCount;
+    });
+
+    u32 nextRayCount { 0 };
+    for (auto& offset : chunkOffsets) {
+        auto const count { offset };
+        offset = nextRayCount;
+        nextRayCount += count;
+    }
+
+    parallelForChunks(executor, rayCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        auto newRayId { chunkOffsets[begin / CHUNK_SIZE] };
+        for (auto i { begin }; i < end; ++i) {
+            auto const& result { results[i] };
+            if (result.instanceId == traversal::INVALID_HIT)
+                continue;
+
+            auto const& g { scene.geometries[result.instanceId] };
+            auto const indices { g.Indices().subspan(result.primitiveId * 3, 3) };
+            auto const normals { g.Normals() };
+
+            // same barycentric order as the shader, geometry without normals falls back to the face normal
+            glm::vec3 nrm;
+            if (!normals.empty())
+                nrm = normals[indices[0]] * result.u + normals[indices[1]] * result.v + normals[indices[2]] * (1.f - result.u - result.v);
+            else {
+                auto const vertices { g.Vertices() };
+                nrm = glm::normalize(glm::cross(vertices[indices[1]] - vertices[indices[0]], vertices[indices[2]] - vertices[indices[0]]));
+            }
+
+            auto const& r { rayRead[i] };
+            auto const pos { glm::vec3(r.o[0], r.o[1], r.o[2]) + glm::vec3(r.d[0], r.d[1], r.d[2]) * result.t };
+
+            auto seed { payloadRead[i].seed };
+            auto const r1 { rnd(seed) };
+            auto const r2 { rnd(seed) };
+            auto const dir { sampleHemisphereCosineWorldSpace(r1, r2, nrm) };
+            auto const o { offsetRay(pos, nrm) };
+
+            rayWrite[newRayId] = { { o.x, o.y, o.z, .01f }, { dir.x, dir.y, dir.z, traversal::BIG_FLOAT } };
+            payloadWrite[newRayId] = { .pixel = (payloadRead[i].pixel & ~0xFu) | RAY_TYPE_SECONDARY, .seed = seed };
+            ++newRayId;
+        }
+    });
+
+    return nextRayCount;
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "TraversalPacket.h"
+#include "TraversalWide.h"
+#include "Types.h"
+#include <glm/mat4x4.hpp>
+#include <span>
+
+struct Scene;
+
+namespace backend::cpu::bvh {
+
+// host implementation of vulkan::bvh::Tracer in the path tracing mode with separate kernels
+//   wavefront of up to MAX_DEPTH + 1 ray generations: primary rays, then one diffuse bounce per hit, as gen_ptrace_shadeAndCast.comp
+//   rays are traced by all executor workers, which fetch RAY_BATCH rays at a time from a shared counter
+//   primary rays may use the packet or stream kernels of TraversalPacket.h, a stream batch is one tile of primary rays
+//   the wide and quantized layouts and OBBs are always traced one ray at a time
+//   only the trace part is timed, per depth, the same as the GPU timestamps of stats::Trace
+//   with recordCosts the traversal counters of each ray are kept per pixel and depth, as PT_Stats of the *_heat.comp kernels,
+//     all rays are then traced one at a time and the trace times are not comparable
+struct Tracer {
+    static constexpr u32 MAX_DEPTH { 7 };
+    static constexpr u32 RAY_BATCH { 64 };
+    static constexpr u32 STREAM_BATCH { 1024 };
+
+    enum class Mode {
+        eSingleRay,
+        ePacket,
+        eStream,
+    } mode { Mode::eSingleRay };
+    bool recordCosts { false };
+
+    // costs of the last Trace, empty without recordCosts, [depth][py * x + px], zero where the path ended before the depth
+    struct CostMaps {
+        u32 x { 0 };
+        u32 y { 0 };
+        // rays traced per pixel, depth d was traced iff d < pathLength
+        std::vector<u8> pathLength;
+        std::vector<u32> traversedNodes[MAX_DEPTH + 1];
+        std::vector<u32> testedTriangles[MAX_DEPTH + 1];
+    };
+
+    struct Runtime {
+        u32 x { 0 };
+        u32 y { 0 };
+        u32 samplesComputed { 0 };
+
+        glm::mat4 viewInv { 1.f };
+        glm::mat4 projectionInv { 1.f };
+    };
+
+    explicit Tracer(Executor& executor);
+
+    [[nodiscard]] config::Tracer const& GetConfig() const
+    {
+        return config;
+    }
+
+    void Trace(config::Tracer const& traceCfg, Runtime const& rt, Scene const& scene, Bvh const& inputBvh);
+    [[nodiscard]] stats::Trace GetStats() const
+    {
+        return stats;
+    }
+    [[nodiscard]] CostMaps const& GetCostMaps() const
+    {
+        return costMaps;
+    }
+
+    // one batch of arbitrary rays traced in the current mode, resultBuffer[i] is the closest hit of rayBuffer[i]
+    [[nodiscard]] stats::Trace::PerDepth TraceRays(Bvh const& inputBvh, std::span<data_bvh::Ray const> rayBuffer, std::span<data_bvh::RayTraceResult> resultBuffer);
+
+private:
+    Executor& executor;
+    config::Tracer config;
+
+    struct Payload {
+        u32 pixel { 0 };
+        u32 seed { 0 };
+    };
+
+    std::vector<data_bvh::Ray> rays[2];
+    std::vector<Payload> payloads[2];
+    std::vector<data_bvh::RayTraceResult> results;
+    std::vector<u32> chunkOffsets;
+    std::vector<traversal::Counters> rayCosts;
+
+    stats::Trace stats;
+    CostMaps costMaps;
+
+    u32 generatePrimaryRays(Runtime const& rt);
+    template<typename MakeKernel>
+    stats::Trace::PerDepth trace(std::span<data_bvh::Ray const> rayBuffer, std::span<data_bvh::RayTraceResult> resultBuffer, std::span<traversal::Counters> costBuffer, u32 batchSize,
+        MakeKernel makeKernel);
+    void scatterCosts(u32 depth, u32 rayCount);
+    u32 shadeAndCast(Scene const& scene, u32 depth, u32 rayCount);
+};
+
+}
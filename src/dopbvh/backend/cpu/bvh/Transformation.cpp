@@ -0,0 +1,360 @@
+#include "Transformation.h"
+
+#include "../../../core/Profiler.h"
+#include "../../../scene/Scene.h"
+#include "../bv/Obb.h"
+#include <atomic>
+#include <limits>
+
+namespace backend::cpu::bvh {
+
+template<config::BV>
+struct Volume;
+
+template<>
+struct Volume<config::BV::eAABB> {
+    using Node = data_bvh::NodeBvhBinary;
+
+    [[nodiscard]] static bv::Aabb Aabb(Node const& node)
+    {
+        return loadBv<bv::Aabb>(node);
+    }
+};
+
+template<>
+struct Volume<config::BV::eDOP14> {
+    using Node = data_bvh::NodeBvhBinaryDOP14;
+
+    [[nodiscard]] static bv::Aabb Aabb(Node const& node)
+    {
+        return { { node.bv[0], node.bv[2], node.bv[4] }, { node.bv[1], node.bv[3], node.bv[5] } };
+    }
+};
+
+static constexpr size_t CHUNK_SIZE { 1 << 14 };
+
+// extremal vertex reference, 2 most significant bits encode the vertex of the triangle, same as the shaders
+static constexpr u32 TRI_ID_MASK { 0x3FFFFFFFu };
+using VertexIds = std::array<u32, 14>;
+
+template<typename Node>
+static void copyTopology(Node& dst, auto const& src)
+{
+    dst.size = src.size;
+    dst.parent = src.parent;
+    dst.c0 = src.c0;
+    dst.c1 = src.c1;
+}
+
+static glm::vec3 fetchVertex(Scene const& scene, std::span<data_bvh::BvhTriangleIndex const> triangleIDs, u32 triId, u32 vertex)
+{
+    auto const& ids { triangleIDs[triId] };
+    auto const& g { scene.geometries[ids.nodeId] };
+    return g.Vertices()[g.Indices()[ids.triangleId * 3 + vertex]];
+}
+
+// vertices of a leaf, stored per coordinate and padded by the last vertex to whole simd vectors
+//   the last vertex wins all its ties anyway, so the padding never changes the selected ids
+struct LeafVertices {
+    std::vector<f32> x;
+    std::vector<f32> y;
+    std::vector<f32> z;
+    std::vector<f32> id;
+    u32 count { 0 };
+
+    void Load(Scene const& scene, std::span<data_bvh::BvhTriangleIndex const> triangleIDs, i32 triStart, i32 triCount)
+    {
+        count = static_cast<u32>(triCount) * 3;
+        auto const padded { (count + simd::WIDTH - 1) / simd::WIDTH * simd::WIDTH };
+        x.resize(padded);
+        y.resize(padded);
+        z.resize(padded);
+        id.resize(padded);
+        for (u32 i = 0; i < padded; ++i) {
+            auto const local { std::min(i, count - 1) };
+            auto const v { fetchVertex(scene, triangleIDs, triStart + local / 3, local % 3) };
+            x[i] = v.x;
+            y[i] = v.y;
+            z[i] = v.z;
+            id[i] = static_cast<f32>(local);
+        }
+    }
+};
+
+// dop of the leaf vertices with the id of the last vertex reaching each slab, same result as sequential bvFitWithVertId
+static void projectLeaf(LeafVertices const& vertices, bv::Dop14& dop, std::array<u32, 14>& localIds)
+{
+    using namespace simd;
+
+    std::array<f32, WIDTH> laneValue;
+    std::array<f32, WIDTH> laneId;
+    auto const reduce { [&](VecF value, VecF ids, bool isMin, f32& outValue, u32& outId) {
+        store(laneValue.data(), value);
+        store(laneId.data(), ids);
+        outValue = laneValue[0];
+        f32 bestId { laneId[0] };
+        for (u32 l = 1; l < WIDTH; ++l) {
+            bool const better { isMin ? laneValue[l] < outValue : laneValue[l] > outValue };
+            if (better || (laneValue[l] == outValue && laneId[l] > bestId)) {
+                outValue = laneValue[l];
+                bestId = laneId[l];
+            }
+        }
+        outId = static_cast<u32>(bestId);
+    } };
+
+    for (u32 s = 0; s < 7; ++s) {
+        auto const project { [&](u32 i) {
+            auto const x { load(vertices.x.data() + i) };
+            auto const y { load(vertices.y.data() + i) };
+            auto const z { load(vertices.z.data() + i) };
+            switch (s) {
+            case 0:
+                return x;
+            case 1:
+                return y;
+            case 2:
+                return z;
+            case 3:
+                return x + y + z;
+            case 4:
+                return x + y - z;
+            case 5:
+                return x - y + z;
+            default:
+                return x - y - z;
+            }
+        } };
+
+        auto vMin { project(0) };
+        auto vMax { vMin };
+        auto idMin { load(vertices.id.data()) };
+        auto idMax { idMin };
+        for (u32 i = WIDTH; i < vertices.x.size(); i += WIDTH) {
+            auto const d { project(i) };
+            auto const ids { load(vertices.id.data() + i) };
+            // ties go to the later vertex
+            auto const isMin { d <= vMin };
+            auto const isMax { vMax <= d };
+            vMin = select(isMin, d, vMin);
+            idMin = select(isMin, ids, idMin);
+            vMax = select(isMax, d, vMax);
+            idMax = select(isMax, ids, idMax);
+        }
+        reduce(vMin, idMin, true, dop[2 * s + 0], localIds[2 * s + 0]);
+        reduce(vMax, idMax, false, dop[2 * s + 1], localIds[2 * s + 1]);
+    }
+}
+
+// bvFitWithVertId of bv_dop14.glsl, the fitted dop wins only if strictly better
+static void fitWithVertexIds(bv::Dop14& dop, VertexIds& ids, bv::Dop14 const& dopToFit, VertexIds const& idsToFit)
+{
+    for (u32 i = 0; i < 7; ++i) {
+        if (dopToFit[2 * i + 0] < dop[2 * i + 0]) {
+            dop[2 * i + 0] = dopToFit[2 * i + 0];
+            ids[2 * i + 0] = idsToFit[2 * i + 0];
+        }
+        if (dopToFit[2 * i + 1] > dop[2 * i + 1]) {
+            dop[2 * i + 1] = dopToFit[2 * i + 1];
+            ids[2 * i + 1] = idsToFit[2 * i + 1];
+        }
+    }
+}
+
+Transformation::Transformation(Executor& executor)
+    : executor(executor)
+{
+}
+
+void Transformation::Compute(Bvh const& inputBvh, Scene const& scene)
+{
+    PROFILE_ZONE("transformation");
+    metadata = {};
+    timeTotal = 0.f;
+    timesObb = {};
+    bvh = {};
+
+    if (inputBvh.nodeCountLeaf == 0)
+        return;
+
+    Stopwatch stopwatch;
+    metadata.nodeCountLeaf = inputBvh.nodeCountLeaf;
+    metadata.nodeCountTotal = inputBvh.nodeCountTotal;
+
+    bvh.triangles = inputBvh.triangles;
+    bvh.triangleIDs = inputBvh.triangleIDs;
+    bvh.nodeCountLeaf = metadata.nodeCountLeaf;
+    bvh.nodeCountTotal = metadata.nodeCountTotal;
+    bvh.bv = config.bv;
+    bvh.layout = Bvh::Layout::eBinaryStandard;
+
+    if (inputBvh.bv == config::BV::eAABB && config.bv == config::BV::eDOP14)
+        transform_dop14(inputBvh, scene);
+    else if (inputBvh.bv == config::BV::eAABB && config.bv == config::BV::eOBB)
+        transform_obb<config::BV::eAABB>(inputBvh, scene);
+    else if (inputBvh.bv == config::BV::eDOP14 && config.bv == config::BV::eOBB)
+        transform_obb<config::BV::eDOP14>(inputBvh, scene);
+    else {
+        berry::Log::warn("CPU transformation: unsupported combination of bounding volumes, BVH is passed through.");
+        bvh = inputBvh;
+    }
+
+    timeTotal = stopwatch.Lap();
+}
+
+void Transformation::transform_dop14(Bvh const& inputBvh, Scene const& scene)
+{
+    using Node = data_bvh::NodeBvhBinary;
+    using NodeOut = data_bvh::NodeBvhBinaryDOP14;
+
+    auto const nodes { inputBvh.Nodes<Node>() };
+    bvh.nodes.resize(sizeof(NodeOut) * metadata.nodeCountTotal);
+    auto const nodesOut { bvh.Nodes<NodeOut>() };
+
+    std::vector<std::atomic<u32>> counter(metadata.nodeCountTotal);
+
+    parallelForChunks(executor, metadata.nodeCountLeaf, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto nodeId { static_cast<i32>(begin) }; nodeId < static_cast<i32>(end); ++nodeId) {
+            auto const& leaf { nodes[nodeId] };
+            auto dop { bv::dopInit() };
+            for (i32 triId = leaf.c0; triId < leaf.c0 - leaf.size; ++triId)
+                for (u32 v = 0; v < 3; ++v)
+                    bv::bvFit(dop, fetchVertex(scene, bvh.triangleIDs, triId, v));
+            copyTopology(nodesOut[nodeId], leaf);
+            storeBv(nodesOut[nodeId], dop);
+
+            // the second child to arrive fits the node
+            i32 id { leaf.parent };
+            while (id != INVALID_ID && counter[id].fetch_add(1, std::memory_order_acq_rel) > 0) {
+                auto const& node { nodes[id] };
+                auto fitted { loadBv<bv::Dop14>(nodesOut[std::abs(node.c0)]) };
+                bv::bvFit(fitted, loadBv<bv::Dop14>(nodesOut[std::abs(node.c1)]));
+                copyTopology(nodesOut[id], node);
+                storeBv(nodesOut[id], fitted);
+                id = node.parent;
+            }
+        }
+    });
+}
+
+template<config::BV SrcBV>
+void Transformation::transform_obb(Bvh const& inputBvh, Scene const& scene)
+{
+    using Node = typename Volume<SrcBV>::Node;
+    using NodeOut = data_bvh::NodeBvhBinaryOBB;
+
+    auto const nodes { inputBvh.Nodes<Node>() };
+    u32 const nodeCount { metadata.nodeCountTotal };
+    bvh.nodes.resize(sizeof(NodeOut) * nodeCount);
+    auto const nodesOut { bvh.Nodes<NodeOut>() };
+
+    Stopwatch stopwatch;
+
+    std::vector<std::atomic<u32>> counter(nodeCount);
+    std::vector<bv::Dop14> dops(nodeCount);
+    std::vector<VertexIds> vertexIds(nodeCount);
+
+    // 1. extremal vertices of the leaves, merged bottom-up by the second child to arrive
+    parallelForChunks(executor, metadata.nodeCountLeaf, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        LeafVertices vertices;
+        std::array<u32, 14> localIds;
+        for (auto nodeId { static_cast<i32>(begin) }; nodeId < static_cast<i32>(end); ++nodeId) {
+            auto const& leaf { nodes[nodeId] };
+            vertices.Load(scene, bvh.triangleIDs, leaf.c0, -leaf.size);
+            projectLeaf(vertices, dops[nodeId], localIds);
+            for (u32 i = 0; i < 14; ++i)
+                vertexIds[nodeId][i] = ((localIds[i] % 3) << 30) | (static_cast<u32>(leaf.c0) + localIds[i] / 3);
+
+            i32 id { leaf.parent };
+            while (id != INVALID_ID && counter[id].fetch_add(1, std::memory_order_acq_rel) > 0) {
+                auto const& node { nodes[id] };
+                auto const c0 { std::abs(node.c0) };
+                auto const c1 { std::abs(node.c1) };
+                dops[id] = dops[c0];
+                vertexIds[id] = vertexIds[c0];
+                fitWithVertexIds(dops[id], vertexIds[id], dops[c1], vertexIds[c1]);
+                id = node.parent;
+            }
+        }
+    });
+    timesObb.project = stopwatch.Lap();
+
+    // 2. DiTO14 per node, starting from the axis aligned box of the source volume
+    std::vector<bv::Obb> obbs(nodeCount);
+    parallelForChunks(executor, nodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        bv::Dop14Points points;
+        for (auto nodeId { begin }; nodeId < end; ++nodeId) {
+            for (u32 i = 0; i < 14; ++i) {
+                auto const vId { vertexIds[nodeId][i] };
+                points[i] = fetchVertex(scene, bvh.triangleIDs, vId & TRI_ID_MASK, vId >> 30);
+            }
+            auto const aabb { Volume<SrcBV>::Aabb(nodes[nodeId]) };
+            auto& obb { obbs[nodeId] };
+            obb = {
+                .b0 = { 1.f, 0.f, 0.f },
+                .b1 = { 0.f, 1.f, 0.f },
+                .b2 = { 0.f, 0.f, 1.f },
+                .min = aabb.min,
+                .max = aabb.max,
+            };
+            bv::obbByDiTO14(obb, points);
+        }
+    });
+    timesObb.select = stopwatch.Lap();
+
+    // 3. refit the OBBs on the path to the root by the leaf triangles
+    parallelForChunks(executor, metadata.nodeCountLeaf, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        std::vector<glm::vec3> points;
+        for (auto nodeId { static_cast<i32>(begin) }; nodeId < static_cast<i32>(end); ++nodeId) {
+            auto const& leaf { nodes[nodeId] };
+            points.clear();
+            for (i32 triId = leaf.c0; triId < leaf.c0 - leaf.size; ++triId)
+                for (u32 v = 0; v < 3; ++v)
+                    points.push_back(fetchVertex(scene, bvh.triangleIDs, triId, v));
+
+            for (i32 id { nodeId }; id != INVALID_ID; id = nodes[id].parent) {
+                auto& obb { obbs[id] };
+                bv::Obb fobb { obb.b0, obb.b1, obb.b2, glm::vec3(std::numeric_limits<f32>::max()), glm::vec3(std::numeric_limits<f32>::lowest()) };
+                for (auto const& p : points)
+                    bv::refitObb(fobb, p);
+                for (i32 axis = 0; axis < 3; ++axis) {
+                    atomicMin(obb.min[axis], fobb.min[axis]);
+                    atomicMax(obb.max[axis], fobb.max[axis]);
+                }
+            }
+        }
+    });
+    timesObb.refit = stopwatch.Lap();
+
+    // 4. OBB matrices
+    parallelForChunks(executor, nodeCount, CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (auto nodeId { begin }; nodeId < end; ++nodeId) {
+            copyTopology(nodesOut[nodeId], nodes[nodeId]);
+            storeBv(nodesOut[nodeId], bv::obbMatrix(obbs[nodeId]));
+        }
+    });
+    timesObb.finalise = stopwatch.Lap();
+
+    berry::Log::debug("OBB DiTO transformation:");
+    berry::Log::debug("Project: {:.2f} ms, Select: {:.2f} ms, Refit: {:.2f} ms, Finalise: {:.2f} ms",
+        timesObb.project, timesObb.select, timesObb.refit, timesObb.finalise);
+}
+
+stats::Transformation Transformation::GatherStats(BvhStats const& bvhStats) const
+{
+    stats::Transformation stats;
+    stats.timeTotal = timeTotal;
+
+    stats.saIntersect = bvhStats.saIntersect;
+    stats.saTraverse = bvhStats.saTraverse;
+    stats.costTotal = bvhStats.costIntersect + bvhStats.costTraverse;
+
+    stats.nodeCountTotal = metadata.nodeCountTotal;
+    stats.leafSizeMin = bvhStats.leafSizeMin;
+    stats.leafSizeMax = bvhStats.leafSizeMax;
+    stats.leafSizeAvg = static_cast<f32>(bvhStats.leafSizeSum) / static_cast<f32>(metadata.nodeCountLeaf);
+
+    return stats;
+}
+
+}
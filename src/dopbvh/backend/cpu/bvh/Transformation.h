@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../../../core/Taskflow.h"
+#include "../../Config.h"
+#include "../../Stats.h"
+#include "Types.h"
+
+struct Scene;
+
+namespace backend::cpu::bvh {
+
+// host implementation of vulkan::bvh::Transformation, converts a collapsed binary BVH to another bounding volume
+//   AABB -> DOP14 by bottom-up refit, AABB/DOP14 -> OBB by DiTO14 over the 14 extremal vertices of each node
+//   the node topology is kept, only the bounding volumes are replaced
+struct Transformation {
+    explicit Transformation(Executor& executor);
+
+    [[nodiscard]] Bvh const& GetBVH() const
+    {
+        return bvh;
+    }
+    [[nodiscard]] bool NeedsRecompute(config::Transformation const& buildConfig)
+    {
+        auto const cfgChanged { config != buildConfig };
+        config = buildConfig;
+        return cfgChanged && config.bv != config::BV::eNone;
+    }
+
+    void Compute(Bvh const& inputBvh, Scene const& scene);
+    [[nodiscard]] stats::Transformation GatherStats(BvhStats const& bvhStats) const;
+
+private:
+    Executor& executor;
+    config::Transformation config;
+    Bvh bvh;
+
+    struct Metadata {
+        u32 nodeCountLeaf { 0 };
+        u32 nodeCountTotal { 0 };
+    } metadata;
+    f32 timeTotal { 0.f };
+
+    struct Times {
+        f32 project { 0.f };
+        f32 select { 0.f };
+        f32 refit { 0.f };
+        f32 finalise { 0.f };
+    } timesObb;
+
+    void transform_dop14(Bvh const& inputBvh, Scene const& scene);
+    template<config::BV SrcBV>
+    void transform_obb(Bvh const& inputBvh, Scene const& scene);
+};
+
+}
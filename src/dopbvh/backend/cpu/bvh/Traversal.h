@@ -0,0 +1,677 @@
+#pragma once
+
+#include "../bv/Dop14.h"
+#include "Compressed.h"
+#include "Quantized.h"
+#include "Types.h"
+#include <glm/glm.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX__)
+#    include <immintrin.h>
+#endif
+
+// host side of the gen_ptrace_*_sep.comp traversal loops, one ray per call
+//   while-while traversal with a STACK_SIZE entry stack, the nearer hit child is visited first, the other one is pushed
+//   a degenerate tree deeper than that spills the rest of the stack to the heap, see Stack
+//   the node tests take the near/far slab of each axis by a per ray lane permutation instead of min/max of both slabs
+namespace backend::cpu::bvh::traversal {
+
+inline constexpr u32 STACK_SIZE { 64 };
+inline constexpr i32 BOTTOM_OF_STACK { 0x76543210 };
+inline constexpr f32 EPS { 1e-5f };
+inline constexpr f32 BIG_FLOAT { 1e30f };
+inline constexpr u32 INVALID_HIT { static_cast<u32>(INVALID_ID) };
+
+struct Counters {
+    u64 traversedNodes { 0 };
+    u64 testedTriangles { 0 };
+    // second stage (diagonal slabs) tests of the DOP14 layouts, per child
+    u64 dopTests { 0 };
+
+    Counters& operator+=(Counters const& rhs)
+    {
+        traversedNodes += rhs.traversedNodes;
+        testedTriangles += rhs.testedTriangles;
+        dopTests += rhs.dopTests;
+        return *this;
+    }
+};
+
+// Capacity entries in place, the deeper ones go to the heap, the depth of a degenerate tree is bounded only by its leaf count
+template<typename Entry, u32 Capacity = STACK_SIZE>
+class Stack {
+public:
+    [[nodiscard]] bool Empty() const
+    {
+        return size == 0;
+    }
+    [[nodiscard]] u32 Size() const
+    {
+        return size;
+    }
+
+    void Push(Entry const& entry)
+    {
+        if (size < Capacity) [[likely]]
+            local[size] = entry;
+        else
+            spill.push_back(entry);
+        ++size;
+    }
+    Entry Pop()
+    {
+        --size;
+        if (size < Capacity) [[likely]]
+            return local[size];
+        auto const entry { spill.back() };
+        spill.pop_back();
+        return entry;
+    }
+
+    // 0 is the bottom of the stack
+    Entry& operator[](u32 i)
+    {
+        return i < Capacity ? local[i] : spill[i - Capacity];
+    }
+
+private:
+    Entry local[Capacity];
+    std::vector<Entry> spill;
+    u32 size { 0 };
+};
+
+[[nodiscard]] inline f32 safeInverse(f32 d)
+{
+    return 1.f / (std::abs(d) > EPS ? d : std::copysign(EPS, d));
+}
+
+// data_bvh::Ray with the per ray constants of the slab tests, near zero direction components are clamped to EPS as in the shaders
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 dir;
+    glm::vec3 idir;
+    glm::vec3 ood;
+    f32 tmin;
+    f32 tmax;
+
+    explicit Ray(data_bvh::Ray const& r)
+        : origin(r.o[0], r.o[1], r.o[2])
+        , dir(r.d[0], r.d[1], r.d[2])
+        , tmin(r.o[3])
+        , tmax(r.d[3])
+    {
+        for (u32 i = 0; i < 3; ++i)
+            idir[i] = safeInverse(dir[i]);
+        ood = origin * idir;
+    }
+};
+
+// the same for the 7 DOP14 slab normals, the first 3 are the AABB ones
+struct RayDop14 {
+    std::array<f32, 7> idir;
+    std::array<f32, 7> ood;
+    std::array<i32, 7> sign;
+
+    explicit RayDop14(Ray const& ray)
+    {
+        auto const d { bv::dopProject(ray.dir) };
+        auto const o { bv::dopProject(ray.origin) };
+        for (u32 i = 0; i < 7; ++i) {
+            idir[i] = safeInverse(d[i]);
+            ood[i] = o[i] * idir[i];
+            sign[i] = idir[i] < 0.f;
+        }
+    }
+};
+
+[[nodiscard]] inline data_bvh::RayTraceResult missResult(Ray const& ray)
+{
+    return { .instanceId = INVALID_HIT, .primitiveId = INVALID_HIT, .bvIntersectionCount = 0, .t = ray.tmax, .u = -1.f, .v = -1.f };
+}
+
+// woopified triangle (see PLOCpp), hit is accepted for tmin < t < result.t
+inline bool intersectTriangle(data_bvh::BvhTriangle const& tri, Ray const& ray, data_bvh::RayTraceResult& result)
+{
+    glm::vec3 const v0 { tri.v0[0], tri.v0[1], tri.v0[2] };
+    glm::vec3 const v1 { tri.v1[0], tri.v1[1], tri.v1[2] };
+    glm::vec3 const v2 { tri.v2[0], tri.v2[1], tri.v2[2] };
+
+    auto const t { (tri.v0[3] - glm::dot(ray.origin, v0)) / glm::dot(ray.dir, v0) };
+    if (!(t > ray.tmin && t < result.t))
+        return false;
+    auto const u { tri.v1[3] + glm::dot(ray.origin, v1) + t * glm::dot(ray.dir, v1) };
+    if (u < 0.f)
+        return false;
+    auto const v { tri.v2[3] + glm::dot(ray.origin, v2) + t * glm::dot(ray.dir, v2) };
+    if (v < 0.f || u + v > 1.f)
+        return false;
+
+    result.t = t;
+    result.u = u;
+    result.v = v;
+    return true;
+}
+
+// leaf child reference of the compressed layouts, updates the closest hit
+inline void intersectLeaf(Bvh const& bvh, i32 leaf, Ray const& ray, data_bvh::RayTraceResult& result, Counters& counters)
+{
+    auto const triBegin { leafTriangleOffset(leaf) };
+    auto const triEnd { triBegin + leafSize(leaf) };
+    for (auto triId { triBegin }; triId < triEnd; ++triId) {
+        ++counters.testedTriangles;
+        if (intersectTriangle(bvh.triangles[triId], ray, result)) {
+            result.instanceId = bvh.triangleIDs[triId].nodeId;
+            result.primitiveId = bvh.triangleIDs[triId].triangleId;
+        }
+    }
+}
+
+// ray parameter intervals of both children of a node, a child is hit if its interval is not empty
+struct ChildIntervals {
+    f32 c0min;
+    f32 c0max;
+    f32 c1min;
+    f32 c1max;
+
+    // bit 0: c0 hit, bit 1: c1 hit
+    [[nodiscard]] u32 Hits() const
+    {
+        return (c0max >= c0min ? 1u : 0u) | (c1max >= c1min ? 2u : 0u);
+    }
+    [[nodiscard]] bool C1First() const
+    {
+        return c1min < c0min;
+    }
+};
+
+#if defined(__AVX__)
+// lane control of _mm_permutevar_ps selecting [near, far] of a [lo, hi] slab pair
+[[nodiscard]] inline __m128i nearFarPermutation(i32 sA, i32 sB)
+{
+    return _mm_setr_epi32(sA, 1 - sA, 2 + sB, 3 - sB);
+}
+
+[[nodiscard]] inline __m256i nearFarPermutation(i32 sA, i32 sB, i32 sC, i32 sD)
+{
+    return _mm256_setr_epi32(sA, 1 - sA, 2 + sB, 3 - sB, sC, 1 - sC, 2 + sD, 3 - sD);
+}
+
+[[nodiscard]] inline ChildIntervals toIntervals(__m128 near, __m128 far)
+{
+    alignas(16) f32 n[4];
+    alignas(16) f32 f[4];
+    _mm_store_ps(n, near);
+    _mm_store_ps(f, far);
+    return { n[0], f[1], n[2], f[3] };
+}
+
+// slabs of both children interleaved as [c0lo, c0hi, c1lo, c1hi], near distances end up in lanes 0 and 2, far in lanes 1 and 3
+struct InterleavedSlabs {
+    __m128 near;
+    __m128 far;
+
+    InterleavedSlabs(f32 tmin, f32 tmax)
+        : near(_mm_set1_ps(tmin))
+        , far(_mm_set1_ps(tmax))
+    {
+    }
+
+    void Add(f32 const* bv, __m128i perm, __m128 idir, __m128 ood)
+    {
+        auto const t { _mm_sub_ps(_mm_mul_ps(_mm_permutevar_ps(_mm_loadu_ps(bv), perm), idir), ood) };
+        near = _mm_max_ps(near, t);
+        far = _mm_min_ps(far, t);
+    }
+
+    void Add(f32 const* bv, __m256i perm, __m256 idir, __m256 ood)
+    {
+        auto const t { _mm256_sub_ps(_mm256_mul_ps(_mm256_permutevar_ps(_mm256_loadu_ps(bv), perm), idir), ood) };
+        auto const lo { _mm256_castps256_ps128(t) };
+        auto const hi { _mm256_extractf128_ps(t, 1) };
+        near = _mm_max_ps(near, _mm_max_ps(lo, hi));
+        far = _mm_min_ps(far, _mm_min_ps(lo, hi));
+    }
+
+    [[nodiscard]] ChildIntervals Intervals() const
+    {
+        return toIntervals(near, far);
+    }
+};
+#endif
+
+// slab test of both children of a NodeBvhBinaryCompressed at once
+struct AabbPairTest {
+#if defined(__AVX__)
+    __m256i permXY;
+    __m256 idirXY;
+    __m256 oodXY;
+    __m128i permZ;
+    __m128 idirZ;
+    __m128 oodZ;
+    __m128 tmin;
+
+    explicit AabbPairTest(Ray const& ray)
+    {
+        i32 const sx { ray.idir.x < 0.f };
+        i32 const sy { ray.idir.y < 0.f };
+        i32 const sz { ray.idir.z < 0.f };
+        // bv[0..7]: c0 lox hix loy hiy | c1 lox hix loy hiy -> c0 nearx neary farx fary | c1 ...
+        permXY = _mm256_setr_epi32(sx, 2 + sy, 1 - sx, 3 - sy, sx, 2 + sy, 1 - sx, 3 - sy);
+        idirXY = _mm256_setr_ps(ray.idir.x, ray.idir.y, ray.idir.x, ray.idir.y, ray.idir.x, ray.idir.y, ray.idir.x, ray.idir.y);
+        oodXY = _mm256_setr_ps(ray.ood.x, ray.ood.y, ray.ood.x, ray.ood.y, ray.ood.x, ray.ood.y, ray.ood.x, ray.ood.y);
+        // bv[8..11]: c0 loz hiz | c1 loz hiz -> c0 nearz farz | c1 nearz farz
+        permZ = nearFarPermutation(sz, sz);
+        idirZ = _mm_set1_ps(ray.idir.z);
+        oodZ = _mm_set1_ps(ray.ood.z);
+        tmin = _mm_set1_ps(ray.tmin);
+    }
+
+    [[nodiscard]] ChildIntervals operator()(data_bvh::NodeBvhBinaryCompressed const& node, f32 tmax) const
+    {
+        auto const xy { _mm256_sub_ps(_mm256_mul_ps(_mm256_permutevar_ps(_mm256_loadu_ps(node.bv), permXY), idirXY), oodXY) };
+        auto const z { _mm_sub_ps(_mm_mul_ps(_mm_permutevar_ps(_mm_loadu_ps(node.bv + 8), permZ), idirZ), oodZ) };
+        auto const lo { _mm256_castps256_ps128(xy) };
+        auto const hi { _mm256_extractf128_ps(xy, 1) };
+
+        // lanes: c0 x|z, c0 y|t, c1 x|z, c1 y|t, then reduced pairwise into lanes 0 and 2
+        auto near { _mm_max_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(1, 0, 1, 0)), _mm_blend_ps(z, tmin, 0b1010)) };
+        auto far { _mm_min_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 2, 3, 2)), _mm_blend_ps(_mm_movehdup_ps(z), _mm_set1_ps(tmax), 0b1010)) };
+        near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(2, 3, 0, 1)));
+        far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(2, 3, 0, 1)));
+        // far of c0 back to lane 1 and of c1 to lane 3
+        return toIntervals(near, _mm_moveldup_ps(far));
+    }
+#else
+    Ray const& ray;
+
+    explicit AabbPairTest(Ray const& ray)
+        : ray(ray)
+    {
+    }
+
+    [[nodiscard]] ChildIntervals operator()(data_bvh::NodeBvhBinaryCompressed const& node, f32 tmax) const
+    {
+        ChildIntervals result { ray.tmin, tmax, ray.tmin, tmax };
+        auto const slab = [&](u32 lo, u32 axis, f32& tNear, f32& tFar) {
+            auto const t0 { node.bv[lo] * ray.idir[axis] - ray.ood[axis] };
+            auto const t1 { node.bv[lo + 1] * ray.idir[axis] - ray.ood[axis] };
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        };
+        slab(0, 0, result.c0min, result.c0max);
+        slab(2, 1, result.c0min, result.c0max);
+        slab(8, 2, result.c0min, result.c0max);
+        slab(4, 0, result.c1min, result.c1max);
+        slab(6, 1, result.c1min, result.c1max);
+        slab(10, 2, result.c1min, result.c1max);
+        return result;
+    }
+#endif
+};
+
+// slab test of both children of a NodeBvhBinaryDOP14Compressed, bv[4 * slab ..] = [c0lo, c0hi, c1lo, c1hi]
+//   the diagonal slabs are tested only if both children pass the AABB slabs, the same as gen_ptrace_dop14_standard_sep.comp
+struct Dop14PairTest {
+#if defined(__AVX__)
+    __m256i perm[3];
+    __m256 idir[3];
+    __m256 ood[3];
+    __m128i permZ;
+    __m128 idirZ;
+    __m128 oodZ;
+    f32 tmin;
+
+    Dop14PairTest(Ray const& ray, RayDop14 const& rayDop)
+        : tmin(ray.tmin)
+    {
+        // slab pairs (0, 1), (3, 4), (5, 6) as 8 lanes, slab 2 as 4 lanes
+        static constexpr std::array<std::array<u32, 2>, 3> PAIRS { { { 0, 1 }, { 3, 4 }, { 5, 6 } } };
+        for (u32 i = 0; i < 3; ++i) {
+            auto const [a, b] { PAIRS[i] };
+            perm[i] = nearFarPermutation(rayDop.sign[a], rayDop.sign[a], rayDop.sign[b], rayDop.sign[b]);
+            idir[i] = _mm256_setr_ps(rayDop.idir[a], rayDop.idir[a], rayDop.idir[a], rayDop.idir[a], rayDop.idir[b], rayDop.idir[b], rayDop.idir[b], rayDop.idir[b]);
+            ood[i] = _mm256_setr_ps(rayDop.ood[a], rayDop.ood[a], rayDop.ood[a], rayDop.ood[a], rayDop.ood[b], rayDop.ood[b], rayDop.ood[b], rayDop.ood[b]);
+        }
+        permZ = nearFarPermutation(rayDop.sign[2], rayDop.sign[2]);
+        idirZ = _mm_set1_ps(rayDop.idir[2]);
+        oodZ = _mm_set1_ps(rayDop.ood[2]);
+    }
+
+    [[nodiscard]] ChildIntervals operator()(data_bvh::NodeBvhBinaryDOP14Compressed const& node, f32 tmax, Counters& counters) const
+    {
+        InterleavedSlabs slabs { tmin, tmax };
+        slabs.Add(node.bv, perm[0], idir[0], ood[0]);
+        slabs.Add(node.bv + 8, permZ, idirZ, oodZ);
+        if (slabs.Intervals().Hits() != 3)
+            return slabs.Intervals();
+
+        counters.dopTests += 2;
+        slabs.Add(node.bv + 12, perm[1], idir[1], ood[1]);
+        slabs.Add(node.bv + 20, perm[2], idir[2], ood[2]);
+        return slabs.Intervals();
+    }
+#else
+    RayDop14 const& rayDop;
+    f32 tmin;
+
+    Dop14PairTest(Ray const& ray, RayDop14 const& rayDop)
+        : rayDop(rayDop)
+        , tmin(ray.tmin)
+    {
+    }
+
+    void slab(data_bvh::NodeBvhBinaryDOP14Compressed const& node, u32 i, ChildIntervals& result) const
+    {
+        auto const t = [&](u32 j) { return node.bv[4 * i + j] * rayDop.idir[i] - rayDop.ood[i]; };
+        result.c0min = std::max(result.c0min, std::min(t(0), t(1)));
+        result.c0max = std::min(result.c0max, std::max(t(0), t(1)));
+        result.c1min = std::max(result.c1min, std::min(t(2), t(3)));
+        result.c1max = std::min(result.c1max, std::max(t(2), t(3)));
+    }
+
+    [[nodiscard]] ChildIntervals operator()(data_bvh::NodeBvhBinaryDOP14Compressed const& node, f32 tmax, Counters& counters) const
+    {
+        ChildIntervals result { tmin, tmax, tmin, tmax };
+        for (u32 i = 0; i < 3; ++i)
+            slab(node, i, result);
+        if (result.Hits() != 3)
+            return result;
+
+        counters.dopTests += 2;
+        for (u32 i = 3; i < 7; ++i)
+            slab(node, i, result);
+        return result;
+    }
+#endif
+};
+
+// diagonal slabs of one child in NodeBvhBinaryDOP14Compressed_SPLIT, bv[8 * child ..] = [lo3, hi3, lo4, hi4, lo5, hi5, lo6, hi6]
+struct Dop14SplitTest {
+#if defined(__AVX__)
+    __m256i perm;
+    __m256 idir;
+    __m256 ood;
+
+    explicit Dop14SplitTest(RayDop14 const& rayDop)
+    {
+        auto const& s { rayDop.sign };
+        perm = nearFarPermutation(s[3], s[4], s[5], s[6]);
+        idir = _mm256_setr_ps(rayDop.idir[3], rayDop.idir[3], rayDop.idir[4], rayDop.idir[4], rayDop.idir[5], rayDop.idir[5], rayDop.idir[6], rayDop.idir[6]);
+        ood = _mm256_setr_ps(rayDop.ood[3], rayDop.ood[3], rayDop.ood[4], rayDop.ood[4], rayDop.ood[5], rayDop.ood[5], rayDop.ood[6], rayDop.ood[6]);
+    }
+
+    void operator()(f32 const* bv, f32& tNear, f32& tFar) const
+    {
+        // lanes: near3 far3 near4 far4 | near5 far5 near6 far6
+        auto const t { _mm256_sub_ps(_mm256_mul_ps(_mm256_permutevar_ps(_mm256_loadu_ps(bv), perm), idir), ood) };
+        auto near { _mm_max_ps(_mm256_castps256_ps128(t), _mm256_extractf128_ps(t, 1)) };
+        auto far { _mm_min_ps(_mm256_castps256_ps128(t), _mm256_extractf128_ps(t, 1)) };
+        near = _mm_max_ps(near, _mm_movehl_ps(near, near));
+        far = _mm_min_ps(far, _mm_movehl_ps(far, far));
+        tNear = std::max(tNear, _mm_cvtss_f32(near));
+        tFar = std::min(tFar, _mm_cvtss_f32(_mm_movehdup_ps(far)));
+    }
+#else
+    RayDop14 const& rayDop;
+
+    explicit Dop14SplitTest(RayDop14 const& rayDop)
+        : rayDop(rayDop)
+    {
+    }
+
+    void operator()(f32 const* bv, f32& tNear, f32& tFar) const
+    {
+        for (u32 i = 3; i < 7; ++i) {
+            auto const t0 { bv[2 * (i - 3)] * rayDop.idir[i] - rayDop.ood[i] };
+            auto const t1 { bv[2 * (i - 3) + 1] * rayDop.idir[i] - rayDop.ood[i] };
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+    }
+#endif
+};
+
+// both children of a NodeBvhBinaryOBBCompressed, bv[12 * child ..] = column major world -> unit cube matrix
+//   the ray is transformed into both child frames at once, lanes [c0x, c0y, c0z, -, c1x, c1y, c1z, -]
+//   in the unit cube the slabs are [-.5, .5], so near/far are -/+ .5 * |idir| - ood without a min/max
+struct ObbPairTest {
+#if defined(__AVX__)
+    __m256 dx;
+    __m256 dy;
+    __m256 dz;
+    __m256 ox;
+    __m256 oy;
+    __m256 oz;
+    f32 tmin;
+
+    explicit ObbPairTest(Ray const& ray)
+        : dx(_mm256_set1_ps(ray.dir.x))
+        , dy(_mm256_set1_ps(ray.dir.y))
+        , dz(_mm256_set1_ps(ray.dir.z))
+        , ox(_mm256_set1_ps(ray.origin.x))
+        , oy(_mm256_set1_ps(ray.origin.y))
+        , oz(_mm256_set1_ps(ray.origin.z))
+        , tmin(ray.tmin)
+    {
+    }
+
+    [[nodiscard]] ChildIntervals operator()(data_bvh::NodeBvhBinaryOBBCompressed const& node, f32 tmax) const
+    {
+        // column j of both matrices, the 4th lane reads past the column (the last load ends in node.size, still inside the node)
+        //   and is replaced by a unit direction before the division, so garbage does not end up in denormals or NaNs
+        auto const column = [&](u32 j) { return _mm256_insertf128_ps(_mm256_zextps128_ps256(_mm_loadu_ps(node.bv + 3 * j)), _mm_loadu_ps(node.bv + 12 + 3 * j), 1); };
+        auto const c0 { column(0) };
+        auto const c1 { column(1) };
+        auto const c2 { column(2) };
+        auto const d { _mm256_blend_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0, dx), _mm256_mul_ps(c1, dy)), _mm256_mul_ps(c2, dz)), _mm256_set1_ps(1.f), 0b10001000) };
+        auto const o { _mm256_blend_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0, ox), _mm256_mul_ps(c1, oy)), _mm256_mul_ps(c2, oz)), column(3)), _mm256_setzero_ps(), 0b10001000) };
+
+        auto const signMask { _mm256_set1_ps(-0.f) };
+        auto const absD { _mm256_andnot_ps(signMask, d) };
+        auto const dClamped { _mm256_blendv_ps(_mm256_or_ps(_mm256_and_ps(signMask, d), _mm256_set1_ps(EPS)), d, _mm256_cmp_ps(absD, _mm256_set1_ps(EPS), _CMP_GT_OQ)) };
+        auto const idir { _mm256_div_ps(_mm256_set1_ps(1.f), dClamped) };
+        auto const ood { _mm256_mul_ps(o, idir) };
+        auto const halfExtent { _mm256_mul_ps(_mm256_andnot_ps(signMask, idir), _mm256_set1_ps(.5f)) };
+
+        auto const near { _mm256_blend_ps(_mm256_sub_ps(_mm256_setzero_ps(), _mm256_add_ps(halfExtent, ood)), _mm256_set1_ps(tmin), 0b10001000) };
+        auto const far { _mm256_blend_ps(_mm256_sub_ps(halfExtent, ood), _mm256_set1_ps(tmax), 0b10001000) };
+
+        // horizontal max/min of each 128 bit half, c0 ends up in lane 0, c1 in lane 4
+        auto nearR { _mm256_max_ps(near, _mm256_permute_ps(near, _MM_SHUFFLE(1, 0, 3, 2))) };
+        auto farR { _mm256_min_ps(far, _mm256_permute_ps(far, _MM_SHUFFLE(1, 0, 3, 2))) };
+        nearR = _mm256_max_ps(nearR, _mm256_permute_ps(nearR, _MM_SHUFFLE(2, 3, 0, 1)));
+        farR = _mm256_min_ps(farR, _mm256_permute_ps(farR, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return {
+            _mm256_cvtss_f32(nearR),
+            _mm256_cvtss_f32(farR),
+            _mm_cvtss_f32(_mm256_extractf128_ps(nearR, 1)),
+            _mm_cvtss_f32(_mm256_extractf128_ps(farR, 1)),
+        };
+    }
+#else
+    Ray const& ray;
+
+    explicit ObbPairTest(Ray const& ray)
+        : ray(ray)
+    {
+    }
+
+    void child(f32 const* bv, f32& tNear, f32& tFar) const
+    {
+        for (u32 i = 0; i < 3; ++i) {
+            auto const d { bv[i] * ray.dir.x + bv[3 + i] * ray.dir.y + bv[6 + i] * ray.dir.z };
+            auto const o { bv[i] * ray.origin.x + bv[3 + i] * ray.origin.y + bv[6 + i] * ray.origin.z + bv[9 + i] };
+            auto const idir { safeInverse(d) };
+            auto const ood { o * idir };
+            auto const halfExtent { .5f * std::abs(idir) };
+            tNear = std::max(tNear, -halfExtent - ood);
+            tFar = std::min(tFar, halfExtent - ood);
+        }
+    }
+
+    [[nodiscard]] ChildIntervals operator()(data_bvh::NodeBvhBinaryOBBCompressed const& node, f32 tmax) const
+    {
+        ChildIntervals result { ray.tmin, tmax, ray.tmin, tmax };
+        child(node.bv, result.c0min, result.c0max);
+        child(node.bv + 12, result.c1min, result.c1max);
+        return result;
+    }
+#endif
+};
+
+// the while-while loop shared by the binary compressed layouts
+//   nodeTest(nodeId, tmax) returns the child intervals, children are read from the main node buffer
+template<typename NodeCompressed, typename NodeTest>
+[[nodiscard]] inline data_bvh::RayTraceResult traverse(Bvh const& bvh, Ray const& ray, Counters& counters, NodeTest nodeTest)
+{
+    auto const nodes { bvh.Nodes<NodeCompressed>() };
+    auto result { missResult(ray) };
+
+    Stack<i32> stack;
+    stack.Push(BOTTOM_OF_STACK);
+
+    u32 traversedNodes { 0 };
+    i32 nodeId { 0 };
+    while (nodeId != BOTTOM_OF_STACK) {
+        // interior nodes until a leaf or an empty stack
+        while (static_cast<u32>(nodeId) < static_cast<u32>(BOTTOM_OF_STACK)) {
+            ++traversedNodes;
+            auto const& node { nodes[nodeId] };
+            auto const intervals { nodeTest(nodeId, result.t) };
+
+            switch (intervals.Hits()) {
+            case 0:
+                nodeId = stack.Pop();
+                break;
+            case 1:
+                nodeId = node.c0;
+                break;
+            case 2:
+                nodeId = node.c1;
+                break;
+            default: {
+                auto const c1First { intervals.C1First() };
+                nodeId = c1First ? node.c1 : node.c0;
+                stack.Push(c1First ? node.c0 : node.c1);
+                break;
+            }
+            }
+        }
+
+        if (nodeId < 0) {
+            intersectLeaf(bvh, nodeId, ray, result, counters);
+            nodeId = stack.Pop();
+        }
+    }
+
+    result.bvIntersectionCount = traversedNodes;
+    counters.traversedNodes += traversedNodes;
+    return result;
+}
+
+// NodeBvhBinaryCompressed, gen_ptrace_aabb_sep.comp
+[[nodiscard]] inline data_bvh::RayTraceResult traceAabbCompressed(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    using Node = data_bvh::NodeBvhBinaryCompressed;
+    auto const nodes { bvh.Nodes<Node>() };
+    Ray const ray { r };
+    AabbPairTest const test { ray };
+
+    return traverse<Node>(bvh, ray, counters, [&](i32 nodeId, f32 tmax) {
+        return test(nodes[nodeId], tmax);
+    });
+}
+
+// NodeBvhBinaryDOP14Compressed, gen_ptrace_dop14_standard_sep.comp
+[[nodiscard]] inline data_bvh::RayTraceResult traceDop14Compressed(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    using Node = data_bvh::NodeBvhBinaryDOP14Compressed;
+    auto const nodes { bvh.Nodes<Node>() };
+    Ray const ray { r };
+    RayDop14 const rayDop { ray };
+    Dop14PairTest const test { ray, rayDop };
+
+    return traverse<Node>(bvh, ray, counters, [&](i32 nodeId, f32 tmax) {
+        return test(nodes[nodeId], tmax, counters);
+    });
+}
+
+// NodeBvhBinaryCompressed + NodeBvhBinaryDOP14Compressed_SPLIT aux nodes, gen_ptrace_dop14_split_sep.comp
+//   the diagonal slabs of a child are read and tested only if the child passes its AABB and voted for the DOP test (parent bit)
+[[nodiscard]] inline data_bvh::RayTraceResult traceDop14Split(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    using Node = data_bvh::NodeBvhBinaryCompressed;
+    auto const nodes { bvh.Nodes<Node>() };
+    auto const nodesSplit { bvh.Aux<data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT>() };
+    Ray const ray { r };
+    RayDop14 const rayDop { ray };
+    AabbPairTest const test { ray };
+    Dop14SplitTest const testSplit { rayDop };
+
+    return traverse<Node>(bvh, ray, counters, [&](i32 nodeId, f32 tmax) {
+        auto const& node { nodes[nodeId] };
+        auto intervals { test(node, tmax) };
+        if ((node.parent & 1) && intervals.c0max >= intervals.c0min) {
+            ++counters.dopTests;
+            testSplit(nodesSplit[nodeId].bv, intervals.c0min, intervals.c0max);
+        }
+        if ((node.parent & 2) && intervals.c1max >= intervals.c1min) {
+            ++counters.dopTests;
+            testSplit(nodesSplit[nodeId].bv + 8, intervals.c1min, intervals.c1max);
+        }
+        return intervals;
+    });
+}
+
+// NodeBvhBinaryOBBCompressed, gen_ptrace_obb_sep.comp
+[[nodiscard]] inline data_bvh::RayTraceResult traceObbCompressed(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    using Node = data_bvh::NodeBvhBinaryOBBCompressed;
+    auto const nodes { bvh.Nodes<Node>() };
+    Ray const ray { r };
+    ObbPairTest const test { ray };
+
+    return traverse<Node>(bvh, ray, counters, [&](i32 nodeId, f32 tmax) {
+        return test(nodes[nodeId], tmax);
+    });
+}
+
+// NodeBvhBinaryQuantized, children are dequantized to the float node and tested as in traceAabbCompressed
+template<typename Q>
+[[nodiscard]] inline data_bvh::RayTraceResult traceAabbQuantized(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    using Node = NodeBvhBinaryQuantized<Q, 3>;
+    auto const nodes { bvh.Nodes<Node>() };
+    Ray const ray { r };
+    AabbPairTest const test { ray };
+
+    return traverse<Node>(bvh, ray, counters, [&](i32 nodeId, f32 tmax) {
+        data_bvh::NodeBvhBinaryCompressed node;
+        dequantizeNode(nodes[nodeId], node);
+        return test(node, tmax);
+    });
+}
+
+// NodeBvhBinaryQuantized with the 7 DOP14 slabs, as traceDop14Compressed
+template<typename Q>
+[[nodiscard]] inline data_bvh::RayTraceResult traceDop14Quantized(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    using Node = NodeBvhBinaryQuantized<Q, 7>;
+    auto const nodes { bvh.Nodes<Node>() };
+    Ray const ray { r };
+    RayDop14 const rayDop { ray };
+    Dop14PairTest const test { ray, rayDop };
+
+    return traverse<Node>(bvh, ray, counters, [&](i32 nodeId, f32 tmax) {
+        data_bvh::NodeBvhBinaryDOP14Compressed node;
+        dequantizeNode(nodes[nodeId], node);
+        return test(node, tmax, counters);
+    });
+}
+
+}
@@ -0,0 +1,560 @@
+#pragma once
+
+#include "../Simd.h"
+#include "Traversal.h"
+
+#include <bit>
+#include <limits>
+
+// coherent ray kernels of the binary compressed layouts, simd::WIDTH rays share one instruction sequence
+//   packet: consecutive rays of a batch traverse together with an active lane mask, children are first culled
+//     by an interval arithmetic frustum of the whole packet, then tested per lane
+//   stream: the ray ids of a batch are partitioned at every node into the ids hitting each child,
+//     gathered simd::WIDTH at a time
+// results are the same as the single ray kernels, except the DOP14 diagonal slabs are tested per child
+namespace backend::cpu::bvh::traversal {
+
+// node views for the packet and stream kernels
+//   Slabs() enumerates the AABB slabs of a child as (normal, lo, hi), DiagonalSlabs() the DOP14 ones if HasDiagonalSlabs()
+struct AabbNodes {
+    using Node = data_bvh::NodeBvhBinaryCompressed;
+    static constexpr u32 NORMAL_COUNT { 3 };
+
+    std::span<Node const> nodes;
+
+    explicit AabbNodes(Bvh const& bvh)
+        : nodes(bvh.Nodes<Node>())
+    {
+    }
+
+    [[nodiscard]] std::array<i32, 2> Children(i32 nodeId) const
+    {
+        return { nodes[nodeId].c0, nodes[nodeId].c1 };
+    }
+
+    template<typename F>
+    void Slabs(i32 nodeId, u32 child, F&& slab) const
+    {
+        auto const& bv { nodes[nodeId].bv };
+        slab(0, bv[4 * child], bv[4 * child + 1]);
+        slab(1, bv[4 * child + 2], bv[4 * child + 3]);
+        slab(2, bv[8 + 2 * child], bv[9 + 2 * child]);
+    }
+
+    [[nodiscard]] bool HasDiagonalSlabs(i32, u32) const
+    {
+        return false;
+    }
+
+    template<typename F>
+    void DiagonalSlabs(i32, u32, F&&) const
+    {
+    }
+};
+
+struct Dop14Nodes {
+    using Node = data_bvh::NodeBvhBinaryDOP14Compressed;
+    static constexpr u32 NORMAL_COUNT { 7 };
+
+    std::span<Node const> nodes;
+
+    explicit Dop14Nodes(Bvh const& bvh)
+        : nodes(bvh.Nodes<Node>())
+    {
+    }
+
+    [[nodiscard]] std::array<i32, 2> Children(i32 nodeId) const
+    {
+        return { nodes[nodeId].c0, nodes[nodeId].c1 };
+    }
+
+    template<typename F>
+    void Slabs(i32 nodeId, u32 child, F&& slab) const
+    {
+        auto const& bv { nodes[nodeId].bv };
+        for (u32 i = 0; i < 3; ++i)
+            slab(i, bv[4 * i + 2 * child], bv[4 * i + 2 * child + 1]);
+    }
+
+    [[nodiscard]] bool HasDiagonalSlabs(i32, u32) const
+    {
+        return true;
+    }
+
+    template<typename F>
+    void DiagonalSlabs(i32 nodeId, u32 child, F&& slab) const
+    {
+        auto const& bv { nodes[nodeId].bv };
+        for (u32 i = 3; i < 7; ++i)
+            slab(i, bv[4 * i + 2 * child], bv[4 * i + 2 * child + 1]);
+    }
+};
+
+struct Dop14SplitNodes {
+    using Node = data_bvh::NodeBvhBinaryCompressed;
+    using NodeSplit = data_bvh::NodeBvhBinaryDOP14Compressed_SPLIT;
+    static constexpr u32 NORMAL_COUNT { 7 };
+
+    AabbNodes aabb;
+    std::span<NodeSplit const> nodesSplit;
+
+    explicit Dop14SplitNodes(Bvh const& bvh)
+        : aabb(bvh)
+        , nodesSplit(bvh.Aux<NodeSplit>())
+    {
+    }
+
+    [[nodiscard]] std::array<i32, 2> Children(i32 nodeId) const
+    {
+        return aabb.Children(nodeId);
+    }
+
+    template<typename F>
+    void Slabs(i32 nodeId, u32 child, F&& slab) const
+    {
+        aabb.Slabs(nodeId, child, slab);
+    }
+
+    // parent of the main node is the vote mask, bit 0: c0, bit 1: c1
+    [[nodiscard]] bool HasDiagonalSlabs(i32 nodeId, u32 child) const
+    {
+        return (aabb.nodes[nodeId].parent >> child) & 1;
+    }
+
+    template<typename F>
+    void DiagonalSlabs(i32 nodeId, u32 child, F&& slab) const
+    {
+        auto const* bv { nodesSplit[nodeId].bv + 8 * child };
+        for (u32 i = 0; i < 4; ++i)
+            slab(3 + i, bv[2 * i], bv[2 * i + 1]);
+    }
+};
+
+// rays of one batch stored per component, padded to simd::WIDTH with inactive rays (tmin > t)
+template<u32 N>
+struct RayBatch {
+    static constexpr u32 ORIGIN { 0 };
+    static constexpr u32 DIR { 3 };
+    static constexpr u32 IDIR { 6 };
+    static constexpr u32 OOD { IDIR + N };
+    static constexpr u32 TMIN { OOD + N };
+    static constexpr u32 T { TMIN + 1 };
+    static constexpr u32 U { T + 1 };
+    static constexpr u32 V { U + 1 };
+    static constexpr u32 COMPONENT_COUNT { V + 1 };
+
+    u32 count { 0 };
+    u32 stride { 0 };
+    std::vector<f32> data;
+    std::vector<u32> hitTriangles;
+    std::vector<u32> bvIntersectionCounts;
+    // ray id lists of the stream kernel
+    std::vector<u32> ids;
+
+    [[nodiscard]] f32* operator[](u32 component)
+    {
+        return data.data() + static_cast<size_t>(component) * stride;
+    }
+    [[nodiscard]] f32 const* operator[](u32 component) const
+    {
+        return data.data() + static_cast<size_t>(component) * stride;
+    }
+
+    void Load(std::span<data_bvh::Ray const> rays)
+    {
+        count = static_cast<u32>(rays.size());
+        stride = (count + simd::WIDTH - 1) / simd::WIDTH * simd::WIDTH;
+        data.assign(static_cast<size_t>(COMPONENT_COUNT) * stride, 0.f);
+        hitTriangles.assign(stride, INVALID_HIT);
+        bvIntersectionCounts.assign(stride, 0);
+
+        auto& self { *this };
+        for (u32 i = 0; i < count; ++i) {
+            Ray const ray { rays[i] };
+            for (u32 j = 0; j < 3; ++j) {
+                self[ORIGIN + j][i] = ray.origin[j];
+                self[DIR + j][i] = ray.dir[j];
+            }
+            if constexpr (N == 7) {
+                RayDop14 const rayDop { ray };
+                for (u32 j = 0; j < N; ++j) {
+                    self[IDIR + j][i] = rayDop.idir[j];
+                    self[OOD + j][i] = rayDop.ood[j];
+                }
+            } else {
+                for (u32 j = 0; j < N; ++j) {
+                    self[IDIR + j][i] = ray.idir[j];
+                    self[OOD + j][i] = ray.ood[j];
+                }
+            }
+            self[TMIN][i] = ray.tmin;
+            self[T][i] = ray.tmax;
+            self[U][i] = -1.f;
+            self[V][i] = -1.f;
+        }
+        for (u32 i = count; i < stride; ++i) {
+            for (u32 j = 0; j < N; ++j)
+                self[IDIR + j][i] = 1.f;
+            self[TMIN][i] = 1.f;
+        }
+    }
+
+    void Store(Bvh const& bvh, std::span<data_bvh::RayTraceResult> results) const
+    {
+        auto const& self { *this };
+        for (u32 i = 0; i < count; ++i) {
+            auto& result { results[i] };
+            auto const triId { hitTriangles[i] };
+            result.instanceId = triId == INVALID_HIT ? INVALID_HIT : bvh.triangleIDs[triId].nodeId;
+            result.primitiveId = triId == INVALID_HIT ? INVALID_HIT : bvh.triangleIDs[triId].triangleId;
+            result.bvIntersectionCount = bvIntersectionCounts[i];
+            result.t = self[T][i];
+            result.u = self[U][i];
+            result.v = self[V][i];
+        }
+    }
+};
+
+template<typename F>
+inline void forEachLane(simd::Mask mask, F&& f)
+{
+    for (auto b { simd::bits(mask) }; b != 0; b &= b - 1)
+        f(static_cast<u32>(std::countr_zero(b)));
+}
+
+[[nodiscard]] inline u32 laneCount(simd::Mask mask)
+{
+    return static_cast<u32>(std::popcount(simd::bits(mask)));
+}
+
+// lanes of one child hit by the rays in 'active', near is the entry distance per lane
+//   fetch(component) returns the component of the tested rays, loaded or gathered from a RayBatch
+template<typename Nodes, typename Fetch>
+[[nodiscard]] inline simd::Mask testChildLanes(Nodes const& nodes, i32 nodeId, u32 child, Fetch const& fetch, simd::Mask active, simd::VecF& near, Counters& counters)
+{
+    using Batch = RayBatch<Nodes::NORMAL_COUNT>;
+
+    near = fetch(Batch::TMIN);
+    auto far { fetch(Batch::T) };
+    auto const slab = [&](u32 normal, f32 lo, f32 hi) {
+        auto const idir { fetch(Batch::IDIR + normal) };
+        auto const ood { fetch(Batch::OOD + normal) };
+        auto const t0 { simd::broadcast(lo) * idir - ood };
+        auto const t1 { simd::broadcast(hi) * idir - ood };
+        near = simd::max(near, simd::min(t0, t1));
+        far = simd::min(far, simd::max(t0, t1));
+    };
+
+    nodes.Slabs(nodeId, child, slab);
+    auto hit { active & (near <= far) };
+    if (simd::any(hit) && nodes.HasDiagonalSlabs(nodeId, child)) {
+        counters.dopTests += laneCount(hit);
+        nodes.DiagonalSlabs(nodeId, child, slab);
+        hit = active & (near <= far);
+    }
+    return hit;
+}
+
+// closest hit of the leaf triangles for the rays in 'active', t/u/v hold the current closest hits
+//   hit lanes are reported by onHit(lane, triangleId)
+template<u32 N, typename Fetch, typename OnHit>
+inline void intersectLeafLanes(Bvh const& bvh, i32 leaf, Fetch const& fetch, simd::Mask active, simd::VecF& t, simd::VecF& u, simd::VecF& v, Counters& counters, OnHit&& onHit)
+{
+    using Batch = RayBatch<N>;
+    using namespace simd;
+
+    VecF const o[3] { fetch(Batch::ORIGIN), fetch(Batch::ORIGIN + 1), fetch(Batch::ORIGIN + 2) };
+    VecF const d[3] { fetch(Batch::DIR), fetch(Batch::DIR + 1), fetch(Batch::DIR + 2) };
+    auto const tmin { fetch(Batch::TMIN) };
+    auto const zero { broadcast(0.f) };
+    auto const one { broadcast(1.f) };
+    auto const dot = [](VecF const (&a)[3], f32 const (&b)[4]) { return a[0] * broadcast(b[0]) + a[1] * broadcast(b[1]) + a[2] * broadcast(b[2]); };
+
+    auto const triBegin { leafTriangleOffset(leaf) };
+    auto const triEnd { triBegin + leafSize(leaf) };
+    counters.testedTriangles += static_cast<u64>(triEnd - triBegin) * laneCount(active);
+    for (auto triId { triBegin }; triId < triEnd; ++triId) {
+        auto const& tri { bvh.triangles[triId] };
+
+        auto const tHit { (broadcast(tri.v0[3]) - dot(o, tri.v0)) / dot(d, tri.v0) };
+        auto hit { active & (tmin < tHit) & (tHit < t) };
+        if (!any(hit))
+            continue;
+        auto const uHit { broadcast(tri.v1[3]) + dot(o, tri.v1) + tHit * dot(d, tri.v1) };
+        hit = hit & (zero <= uHit);
+        auto const vHit { broadcast(tri.v2[3]) + dot(o, tri.v2) + tHit * dot(d, tri.v2) };
+        hit = hit & (zero <= vHit) & (uHit + vHit <= one);
+        if (!any(hit))
+            continue;
+
+        t = select(hit, tHit, t);
+        u = select(hit, uHit, u);
+        v = select(hit, vHit, v);
+        forEachLane(hit, [&](u32 lane) { onHit(lane, triId); });
+    }
+}
+
+// conservative bounds of the ray parameters of a packet, a child missed by the bounds is missed by every ray
+template<u32 N>
+struct Frustum {
+    std::array<f32, N> idirMin;
+    std::array<f32, N> idirMax;
+    std::array<f32, N> oodMin;
+    std::array<f32, N> oodMax;
+    f32 tmin;
+    f32 tmax;
+
+    template<typename Fetch>
+    Frustum(Fetch const& fetch, simd::Mask active)
+    {
+        using Batch = RayBatch<N>;
+        for (u32 i = 0; i < N; ++i) {
+            idirMin[i] = reduceMin(fetch(Batch::IDIR + i), active);
+            idirMax[i] = reduceMax(fetch(Batch::IDIR + i), active);
+            oodMin[i] = reduceMin(fetch(Batch::OOD + i), active);
+            oodMax[i] = reduceMax(fetch(Batch::OOD + i), active);
+        }
+        tmin = reduceMin(fetch(Batch::TMIN), active);
+        tmax = reduceMax(fetch(Batch::T), active);
+    }
+
+    [[nodiscard]] static f32 reduceMin(simd::VecF a, simd::Mask active)
+    {
+        return simd::reduceMin(simd::select(active, a, simd::broadcast(std::numeric_limits<f32>::infinity())));
+    }
+    [[nodiscard]] static f32 reduceMax(simd::VecF a, simd::Mask active)
+    {
+        return simd::reduceMax(simd::select(active, a, simd::broadcast(-std::numeric_limits<f32>::infinity())));
+    }
+
+    // interval arithmetic on t = plane * idir - ood, rounding is monotonic so the bounds hold for the per lane test
+    template<typename Nodes>
+    [[nodiscard]] bool Test(Nodes const& nodes, i32 nodeId, u32 child) const
+    {
+        auto nearLower { tmin };
+        auto farUpper { tmax };
+        auto const slab = [&](u32 normal, f32 lo, f32 hi) {
+            auto const bounds = [&](f32 plane) {
+                auto const a { plane * idirMin[normal] };
+                auto const b { plane * idirMax[normal] };
+                return std::pair { std::min(a, b) - oodMax[normal], std::max(a, b) - oodMin[normal] };
+            };
+            auto const [lo0, hi0] { bounds(lo) };
+            auto const [lo1, hi1] { bounds(hi) };
+            nearLower = std::max(nearLower, std::min(lo0, lo1));
+            farUpper = std::min(farUpper, std::max(hi0, hi1));
+        };
+
+        nodes.Slabs(nodeId, child, slab);
+        if (nearLower > farUpper)
+            return false;
+        if (nodes.HasDiagonalSlabs(nodeId, child))
+            nodes.DiagonalSlabs(nodeId, child, slab);
+        return nearLower <= farUpper;
+    }
+};
+
+// packets of simd::WIDTH consecutive rays of the batch
+template<typename Nodes>
+inline void tracePackets(Bvh const& bvh, Nodes const& nodes, RayBatch<Nodes::NORMAL_COUNT>& batch, Counters& counters)
+{
+    static constexpr u32 N { Nodes::NORMAL_COUNT };
+    using Batch = RayBatch<N>;
+    using namespace simd;
+
+    struct Entry {
+        i32 nodeId;
+        Mask mask;
+    };
+    Stack<Entry> stack;
+
+    auto const none { broadcast(1.f) < broadcast(0.f) };
+    auto const inf { broadcast(std::numeric_limits<f32>::infinity()) };
+
+    for (u32 offset = 0; offset < batch.count; offset += WIDTH) {
+        auto const fetch = [&](u32 component) { return load(batch[component] + offset); };
+        auto const active { fetch(Batch::TMIN) <= fetch(Batch::T) };
+        if (!any(active))
+            continue;
+
+        Frustum<N> frustum { fetch, active };
+        auto bvCount { broadcast(0.f) };
+
+        i32 nodeId { 0 };
+        auto mask { active };
+        for (;;) {
+            if (nodeId >= 0) {
+                counters.traversedNodes += laneCount(mask);
+                bvCount = bvCount + select(mask, broadcast(1.f), broadcast(0.f));
+
+                auto const children { nodes.Children(nodeId) };
+                VecF near[2] { inf, inf };
+                Mask hits[2] { none, none };
+                for (u32 c = 0; c < 2; ++c)
+                    if (frustum.Test(nodes, nodeId, c))
+                        hits[c] = testChildLanes(nodes, nodeId, c, fetch, mask, near[c], counters);
+
+                auto const hit0 { any(hits[0]) };
+                auto const hit1 { any(hits[1]) };
+                if (hit0 && hit1) {
+                    u32 const first { reduceMin(select(hits[1], near[1], inf)) < reduceMin(select(hits[0], near[0], inf)) };
+                    stack.Push({ children[1 - first], hits[1 - first] });
+                    nodeId = children[first];
+                    mask = hits[first];
+                    continue;
+                }
+                if (hit0 || hit1) {
+                    nodeId = children[hit0 ? 0 : 1];
+                    mask = hits[hit0 ? 0 : 1];
+                    continue;
+                }
+            } else {
+                auto t { fetch(Batch::T) };
+                auto u { fetch(Batch::U) };
+                auto v { fetch(Batch::V) };
+                bool anyHit { false };
+                intersectLeafLanes<N>(bvh, nodeId, fetch, mask, t, u, v, counters, [&](u32 lane, u32 triId) {
+                    batch.hitTriangles[offset + lane] = triId;
+                    anyHit = true;
+                });
+                if (anyHit) {
+                    store(batch[Batch::T] + offset, t);
+                    store(batch[Batch::U] + offset, u);
+                    store(batch[Batch::V] + offset, v);
+                    frustum.tmax = Frustum<N>::reduceMax(t, active);
+                }
+            }
+
+            if (stack.Empty())
+                break;
+            auto const entry { stack.Pop() };
+            nodeId = entry.nodeId;
+            mask = entry.mask;
+        }
+
+        alignas(64) f32 counts[WIDTH];
+        store(counts, bvCount);
+        for (u32 lane = 0; lane < WIDTH; ++lane)
+            batch.bvIntersectionCounts[offset + lane] = static_cast<u32>(counts[lane]);
+    }
+}
+
+// all rays of the batch at once, each node works on the list of ray ids that reached it
+//   ids of both children are appended after the current list, the farther child list is pushed
+//   a popped list is the last live one, so everything above its end is reused
+template<typename Nodes>
+inline void traceStream(Bvh const& bvh, Nodes const& nodes, RayBatch<Nodes::NORMAL_COUNT>& batch, Counters& counters)
+{
+    static constexpr u32 N { Nodes::NORMAL_COUNT };
+    using Batch = RayBatch<N>;
+    using namespace simd;
+
+    struct Entry {
+        i32 nodeId;
+        u32 begin;
+        u32 end;
+    };
+    Stack<Entry> stack;
+
+    alignas(64) static constexpr auto LANE_INDEX { [] {
+        std::array<f32, WIDTH> result {};
+        for (u32 i = 0; i < WIDTH; ++i)
+            result[i] = static_cast<f32>(i);
+        return result;
+    }() };
+
+    auto& ids { batch.ids };
+    ids.resize(2 * batch.stride + WIDTH);
+    u32 end { 0 };
+    for (u32 i = 0; i < batch.count; ++i)
+        if (batch[Batch::TMIN][i] <= batch[Batch::T][i])
+            ids[end++] = i;
+    if (end == 0)
+        return;
+
+    // calls f(fetch, lanes, ids) for every simd::WIDTH ids of [begin, end)
+    auto const forEachChunk = [&](u32 begin, u32 end, auto&& f) {
+        for (auto chunk { begin }; chunk < end; chunk += WIDTH) {
+            auto const lanes { load(LANE_INDEX.data()) < broadcast(static_cast<f32>(end - chunk)) };
+            auto const idx { loadI(ids.data() + chunk) };
+            auto const fetch = [&](u32 component) { return gather(batch[component], idx); };
+            f(fetch, lanes, ids.data() + chunk);
+        }
+    };
+
+    Entry current { 0, 0, end };
+    u32 top { end };
+    for (;;) {
+        auto const count { current.end - current.begin };
+        if (current.nodeId >= 0) {
+            counters.traversedNodes += count;
+            for (auto i { current.begin }; i < current.end; ++i)
+                ++batch.bvIntersectionCounts[ids[i]];
+
+            if (ids.size() < top + 2 * count + WIDTH)
+                ids.resize(2 * (top + 2 * count + WIDTH));
+
+            auto const children { nodes.Children(current.nodeId) };
+            u32 const begins[2] { top, top + count };
+            u32 counts[2] { 0, 0 };
+            u32 c1FirstVotes { 0 };
+            u32 bothCount { 0 };
+            forEachChunk(current.begin, current.end, [&](auto const& fetch, Mask lanes, u32 const* chunkIds) {
+                VecF near[2];
+                Mask hits[2];
+                for (u32 c = 0; c < 2; ++c) {
+                    hits[c] = testChildLanes(nodes, current.nodeId, c, fetch, lanes, near[c], counters);
+                    forEachLane(hits[c], [&](u32 lane) { ids[begins[c] + counts[c]++] = chunkIds[lane]; });
+                }
+                auto const both { hits[0] & hits[1] };
+                bothCount += laneCount(both);
+                c1FirstVotes += laneCount(both & (near[1] < near[0]));
+            });
+
+            if (counts[0] > 0 && counts[1] > 0) {
+                u32 const first { 2 * c1FirstVotes > bothCount };
+                stack.Push({ children[1 - first], begins[1 - first], begins[1 - first] + counts[1 - first] });
+                current = { children[first], begins[first], begins[first] + counts[first] };
+                top = begins[1] + counts[1];
+                continue;
+            }
+            if (counts[0] > 0 || counts[1] > 0) {
+                u32 const c { counts[0] > 0 ? 0u : 1u };
+                current = { children[c], begins[c], begins[c] + counts[c] };
+                top = begins[1] + counts[1];
+                continue;
+            }
+        } else {
+            forEachChunk(current.begin, current.end, [&](auto const& fetch, Mask lanes, u32 const* chunkIds) {
+                auto t { fetch(Batch::T) };
+                auto u { fetch(Batch::U) };
+                auto v { fetch(Batch::V) };
+                u32 hitMask { 0 };
+                intersectLeafLanes<N>(bvh, current.nodeId, fetch, lanes, t, u, v, counters, [&](u32 lane, u32 triId) {
+                    batch.hitTriangles[chunkIds[lane]] = triId;
+                    hitMask |= 1u << lane;
+                });
+                if (hitMask == 0)
+                    return;
+
+                alignas(64) f32 tuv[3][WIDTH];
+                store(tuv[0], t);
+                store(tuv[1], u);
+                store(tuv[2], v);
+                for (auto b { hitMask }; b != 0; b &= b - 1) {
+                    auto const lane { std::countr_zero(b) };
+                    batch[Batch::T][chunkIds[lane]] = tuv[0][lane];
+                    batch[Batch::U][chunkIds[lane]] = tuv[1][lane];
+                    batch[Batch::V][chunkIds[lane]] = tuv[2][lane];
+                }
+            });
+        }
+
+        if (stack.Empty())
+            break;
+        current = stack.Pop();
+        top = current.end;
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Traversal.h"
+#include "Wide.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+// single ray kernels of the wide layouts, all W children of a node are tested by one instruction sequence
+//   near and far sides of each slab are whole rows of the node, picked by the ray direction sign, so no lane shuffles
+//   hit children are pushed farthest first with their entry distance, entries behind the closest hit are dropped when popped
+namespace backend::cpu::bvh::traversal {
+
+template<typename NodeWide>
+struct WideTest {
+    static constexpr u32 W { NodeWide::WIDTH };
+    static constexpr u32 K { NodeWide::SLAB_COUNT };
+
+    // bv offsets of the near and far row of each slab
+    std::array<u32, K> nearRow;
+    std::array<u32, K> farRow;
+    std::array<f32, K> idir;
+    std::array<f32, K> ood;
+    f32 tmin;
+
+    explicit WideTest(Ray const& ray)
+        : tmin(ray.tmin)
+    {
+        if constexpr (K == 7) {
+            RayDop14 const rayDop { ray };
+            idir = rayDop.idir;
+            ood = rayDop.ood;
+        } else {
+            for (u32 k = 0; k < K; ++k) {
+                idir[k] = ray.idir[k];
+                ood[k] = ray.ood[k];
+            }
+        }
+        for (u32 k = 0; k < K; ++k) {
+            u32 const sign { idir[k] < 0.f };
+            nearRow[k] = (2 * k + sign) * W;
+            farRow[k] = (2 * k + 1 - sign) * W;
+        }
+    }
+
+    // bit c set if child c is hit, tNear[c] is its entry distance
+    [[nodiscard]] u32 operator()(NodeWide const& node, f32 tmax, f32* tNear) const
+    {
+#if defined(__AVX__)
+        if constexpr (W == 8) {
+            auto near { _mm256_set1_ps(tmin) };
+            auto far { _mm256_set1_ps(tmax) };
+            for (u32 k = 0; k < K; ++k) {
+                auto const i { _mm256_broadcast_ss(&idir[k]) };
+                auto const o { _mm256_broadcast_ss(&ood[k]) };
+                near = _mm256_max_ps(near, _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(node.bv + nearRow[k]), i), o));
+                far = _mm256_min_ps(far, _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(node.bv + farRow[k]), i), o));
+            }
+            _mm256_storeu_ps(tNear, near);
+            return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(far, near, _CMP_GE_OQ)));
+        } else {
+            auto near { _mm_set1_ps(tmin) };
+            auto far { _mm_set1_ps(tmax) };
+            for (u32 k = 0; k < K; ++k) {
+                auto const i { _mm_broadcast_ss(&idir[k]) };
+                auto const o { _mm_broadcast_ss(&ood[k]) };
+                near = _mm_max_ps(near, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(node.bv + nearRow[k]), i), o));
+                far = _mm_min_ps(far, _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(node.bv + farRow[k]), i), o));
+            }
+            _mm_storeu_ps(tNear, near);
+            return static_cast<u32>(_mm_movemask_ps(_mm_cmpge_ps(far, near)));
+        }
+#else
+        u32 hits { 0 };
+        for (u32 c = 0; c < W; ++c) {
+            auto near { tmin };
+            auto far { tmax };
+            for (u32 k = 0; k < K; ++k) {
+                near = std::max(near, node.bv[nearRow[k] + c] * idir[k] - ood[k]);
+                far = std::min(far, node.bv[farRow[k] + c] * idir[k] - ood[k]);
+            }
+            tNear[c] = near;
+            hits |= far >= near ? 1u << c : 0u;
+        }
+        return hits;
+#endif
+    }
+};
+
+// NodeBvhWide4/8, AABB or DOP14 by the slab count of the node
+template<typename NodeWide>
+[[nodiscard]] inline data_bvh::RayTraceResult traceWide(Bvh const& bvh, data_bvh::Ray const& r, Counters& counters)
+{
+    static constexpr u32 W { NodeWide::WIDTH };
+    auto const nodes { bvh.Nodes<NodeWide>() };
+    Ray const ray { r };
+    WideTest<NodeWide> const test { ray };
+    auto result { missResult(ray) };
+
+    struct Entry {
+        i32 nodeId;
+        f32 tNear;
+    };
+    Stack<Entry, STACK_SIZE * (W - 1)> stack;
+
+    u32 traversedNodes { 0 };
+    auto const visit { [&](i32 nodeId) {
+        ++traversedNodes;
+        auto const& node { nodes[nodeId] };
+        alignas(32) f32 tNear[W];
+        auto hits { test(node, result.t, tNear) };
+
+        // insertion sort of the hit children by descending entry distance, the closest one ends on top of the stack
+        auto const stackBegin { stack.Size() };
+        while (hits) {
+            auto const c { static_cast<u32>(std::countr_zero(hits)) };
+            hits &= hits - 1;
+            auto i { stack.Size() };
+            stack.Push({ node.child[c], tNear[c] });
+            for (; i > stackBegin && stack[i - 1].tNear < tNear[c]; --i)
+                stack[i] = stack[i - 1];
+            stack[i] = { node.child[c], tNear[c] };
+        }
+    } };
+
+    visit(0);
+    while (!stack.Empty()) {
+        auto const entry { stack.Pop() };
+        if (entry.tNear > result.t)
+            continue;
+        if (entry.nodeId > 0)
+            visit(entry.nodeId);
+        else
+            intersectLeaf(bvh, entry.nodeId, ray, result, counters);
+    }
+
+    result.bvIntersectionCount = traversedNodes;
+    counters.traversedNodes += traversedNodes;
+    return result;
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "../../Config.h"
+#include "data_bvh.h"
+#include <vLime/types.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace backend::cpu::bvh {
+
+// host copy of the vulkan::bvh::Bvh buffers, node layouts follow data_bvh.h
+struct Bvh {
+    enum class Layout {
+        eBinaryStandard,
+        eBinaryCompressed,
+        eBinaryCompressed_dop14Split,
+        // NodeBvhWide, see Wide.h
+        eWide4,
+        eWide8,
+        // NodeBvhBinaryQuantized, see Quantized.h
+        eBinaryQuantized8,
+        eBinaryQuantized16,
+    };
+
+    std::vector<std::byte> nodes;
+    std::vector<data_bvh::BvhTriangle> triangles;
+    std::vector<data_bvh::BvhTriangleIndex> triangleIDs;
+    std::vector<std::byte> aux;
+
+    u32 nodeCountLeaf { 0 };
+    u32 nodeCountTotal { 0 };
+
+    config::BV bv { config::BV::eNone };
+    Layout layout { Layout::eBinaryStandard };
+
+    template<typename Node>
+    [[nodiscard]] std::span<Node> Nodes()
+    {
+        return { reinterpret_cast<Node*>(nodes.data()), nodes.size() / sizeof(Node) };
+    }
+    template<typename Node>
+    [[nodiscard]] std::span<Node const> Nodes() const
+    {
+        return { reinterpret_cast<Node const*>(nodes.data()), nodes.size() / sizeof(Node) };
+    }
+    // aux nodes of the split layouts, e.g. NodeBvhBinaryDOP14Compressed_SPLIT
+    template<typename Node>
+    [[nodiscard]] std::span<Node> Aux()
+    {
+        return { reinterpret_cast<Node*>(aux.data()), aux.size() / sizeof(Node) };
+    }
+    template<typename Node>
+    [[nodiscard]] std::span<Node const> Aux() const
+    {
+        return { reinterpret_cast<Node const*>(aux.data()), aux.size() / sizeof(Node) };
+    }
+};
+
+struct BvhStats {
+    f32 saTraverse { 0.f };
+    f32 saIntersect { 0.f };
+    f32 costTraverse { 0.f };
+    f32 costIntersect { 0.f };
+    u32 leafSizeSum { 0 };
+    u32 leafSizeMin { 0xFFFFFFFF };
+    u32 leafSizeMax { 0 };
+};
+
+inline constexpr i32 INVALID_ID { -1 };
+
+// node bounding volumes are plain float arrays, these copy them from/to the bv:: types
+template<typename BV, typename Node>
+[[nodiscard]] inline BV loadBv(Node const& node)
+{
+    static_assert(sizeof(BV) == sizeof(node.bv));
+    BV bv;
+    memcpy(&bv, node.bv, sizeof(BV));
+    return bv;
+}
+
+template<typename BV, typename Node>
+inline void storeBv(Node& node, BV const& bv)
+{
+    static_assert(sizeof(BV) == sizeof(node.bv));
+    memcpy(node.bv, &bv, sizeof(BV));
+}
+
+// float min/max on memory shared by several tasks, used by the OBB refits
+inline void atomicMin(f32& target, f32 value)
+{
+    std::atomic_ref<f32> ref { target };
+    f32 current { ref.load(std::memory_order_relaxed) };
+    while (value < current && !ref.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+}
+
+inline void atomicMax(f32& target, f32 value)
+{
+    std::atomic_ref<f32> ref { target };
+    f32 current { ref.load(std::memory_order_relaxed) };
+    while (value > current && !ref.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+}
+
+struct Stopwatch {
+    std::chrono::steady_clock::time_point start { std::chrono::steady_clock::now() };
+
+    // elapsed time in ms since the last lap
+    f32 Lap()
+    {
+        auto const now { std::chrono::steady_clock::now() };
+        auto const result { std::chrono::duration<f32, std::milli>(now - start).count() };
+        start = now;
+        return result;
+    }
+};
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../bv/Aabb.h"
+#include "../bv/Dop14.h"
+#include "Types.h"
+
+// wide node layouts of the CPU backend, up to W children per node, built by Compression from the collapsed binary tree
+namespace backend::cpu::bvh {
+
+// children as struct of arrays, slab k of child c is [bv[2kW + c], bv[(2k + 1)W + c]]
+//   K is 3 for the AABB slabs or 7 for the DOP14 ones (normals of bv::dopProject), so one side of a slab is one W wide row
+//   child[c] > 0 is an interior node, otherwise a leaf reference (see encodeLeaf)
+//   empty slots are the leaf reference 0 with inverted slabs, no ray interval can hit them
+template<u32 W, u32 K>
+struct NodeBvhWide {
+    static constexpr u32 WIDTH { W };
+    static constexpr u32 SLAB_COUNT { K };
+
+    f32 bv[2 * K * W];
+    i32 child[W];
+};
+
+using NodeBvhWide4 = NodeBvhWide<4, 3>;
+using NodeBvhWide8 = NodeBvhWide<8, 3>;
+using NodeBvhWide4DOP14 = NodeBvhWide<4, 7>;
+using NodeBvhWide8DOP14 = NodeBvhWide<8, 7>;
+
+template<typename BV>
+inline constexpr u32 WIDE_SLAB_COUNT { 0 };
+template<>
+inline constexpr u32 WIDE_SLAB_COUNT<bv::Aabb> { 3 };
+template<>
+inline constexpr u32 WIDE_SLAB_COUNT<bv::Dop14> { 7 };
+
+inline constexpr i32 WIDE_EMPTY_CHILD { 0 };
+
+template<u32 W, u32 K>
+[[nodiscard]] inline bool isEmptyChild(NodeBvhWide<W, K> const& node, u32 c)
+{
+    return node.child[c] == WIDE_EMPTY_CHILD;
+}
+
+template<u32 W, u32 K>
+inline void setChildEmpty(NodeBvhWide<W, K>& node, u32 c)
+{
+    for (u32 k = 0; k < K; ++k) {
+        node.bv[2 * k * W + c] = bv::BIG_FLOAT;
+        node.bv[(2 * k + 1) * W + c] = -bv::BIG_FLOAT;
+    }
+    node.child[c] = WIDE_EMPTY_CHILD;
+}
+
+template<u32 W>
+inline void setChildBv(NodeBvhWide<W, 3>& node, u32 c, bv::Aabb const& box)
+{
+    for (u32 k = 0; k < 3; ++k) {
+        node.bv[2 * k * W + c] = box.min[k];
+        node.bv[(2 * k + 1) * W + c] = box.max[k];
+    }
+}
+
+template<u32 W>
+inline void setChildBv(NodeBvhWide<W, 7>& node, u32 c, bv::Dop14 const& dop)
+{
+    for (u32 k = 0; k < 7; ++k) {
+        node.bv[2 * k * W + c] = dop[2 * k];
+        node.bv[(2 * k + 1) * W + c] = dop[2 * k + 1];
+    }
+}
+
+template<u32 W>
+[[nodiscard]] inline bv::Aabb getChildBv(NodeBvhWide<W, 3> const& node, u32 c)
+{
+    bv::Aabb result;
+    for (u32 k = 0; k < 3; ++k) {
+        result.min[k] = node.bv[2 * k * W + c];
+        result.max[k] = node.bv[(2 * k + 1) * W + c];
+    }
+    return result;
+}
+
+template<u32 W>
+[[nodiscard]] inline bv::Dop14 getChildBv(NodeBvhWide<W, 7> const& node, u32 c)
+{
+    bv::Dop14 result;
+    for (u32 k = 0; k < 7; ++k) {
+        result[2 * k] = node.bv[2 * k * W + c];
+        result[2 * k + 1] = node.bv[(2 * k + 1) * W + c];
+    }
+    return result;
+}
+
+}
@@ -3,6 +3,7 @@
 #include <vLime/Queues.h>
 #include <vLime/RenderGraph.h>
 
+#include "../../core/Profiler.h"
 #include "VCtx.h"
 #include "data/AccelerationStructure.h"
 #include "data/ImGuiScene.h"
@@ -340,8 +341,13 @@ public:
         return buildConfig;
     }
 
-    void SetPipelineConfiguration(config::BVHPipeline config)
+    // false for a pipeline with a CPU only compressed layout, the current pipeline is kept then
+    bool SetPipelineConfiguration(config::BVHPipeline config)
     {
+        if (config.compression.bv != config::BV::eNone && !bvh::Compression::Supports(config.compression.layout)) {
+            berry::Log::error("Pipeline '{}': the compressed layout is CPU only, skipped", config.name);
+            return false;
+        }
         buildConfig = std::move(config);
 
         if (compression.NeedsRecompute(buildConfig.compression))
@@ -352,6 +358,7 @@ public:
             buildState = BuildState::eCollapsing;
         if (plocpp.NeedsRecompute(buildConfig.plocpp))
             buildState = BuildState::ePLOC;
+        return true;
     }
 
     bool BVHBuildPiecewise(data::Scene const& scene)
@@ -366,13 +373,17 @@ public:
         auto fence { lime::FenceFactory(ctx.d) };
         vk::CommandBuffer commandBuffer;
 
+        PROFILE_ZONE("BVH build (GPU)");
         berry::Log::debug("BVH build: {}", buildConfig.name);
+        // the timestamps of each stage are placed on the profiler timeline from the CPU time of its submission
+        u64 submitted { 0 };
         while (buildState != BuildState::eDone) {
             switch (buildState) {
             case BuildState::ePLOC:
                 berry::Log::debug("BVH build stage: PLOCpp");
                 commandBuffer = transientPool.BeginCommands();
                 plocpp.Compute(commandBuffer, scene);
+                submitted = profiler::Now();
                 transientPool.EndSubmitCommands(commandBuffer, fence.get());
                 plocpp.ReadRuntimeData();
 
@@ -383,6 +394,10 @@ public:
                 transientPool.EndSubmitCommands(commandBuffer, fence.get());
 
                 statsBuild.plocpp = plocpp.GatherStats(*stats.data);
+                submitted = profiler::RecordGpuStage("PLOC++ initial clusters", submitted, statsBuild.plocpp.times[0]);
+                submitted = profiler::RecordGpuStage("PLOC++ radix sort", submitted, statsBuild.plocpp.times[1]);
+                submitted = profiler::RecordGpuStage("PLOC++ copy clusters", submitted, statsBuild.plocpp.times[2]);
+                profiler::RecordGpuStage("PLOC++ iterations", submitted, statsBuild.plocpp.times[3]);
                 buildState = BuildState::eCollapsing;
                 break;
             case BuildState::eCollapsing:
@@ -390,6 +405,7 @@ public:
                     berry::Log::debug("BVH build stage: Collapsing");
                     commandBuffer = transientPool.BeginCommands();
                     collapsing.Compute(commandBuffer, plocpp.GetBVH(), traceRuntimeData.geometryDescriptorAddress);
+                    submitted = profiler::Now();
                     transientPool.EndSubmitCommands(commandBuffer, fence.get());
                     collapsing.ReadRuntimeData();
 
@@ -400,6 +416,7 @@ public:
                     transientPool.EndSubmitCommands(commandBuffer, fence.get());
 
                     statsBuild.collapsing = collapsing.GatherStats(*stats.data);
+                    profiler::RecordGpuStage("collapsing", submitted, statsBuild.collapsing.timeTotal);
                 }
                 buildState = buildConfig.transformation.bv == config::BV::eNone ? BuildState::eCompression : BuildState::eTransformation;
                 break;
@@ -408,6 +425,7 @@ public:
                     berry::Log::debug("BVH build stage: Transformation");
                     commandBuffer = transientPool.BeginCommands();
                     transformation.Compute(commandBuffer, collapsing.GetBVH(), traceRuntimeData.geometryDescriptorAddress);
+                    submitted = profiler::Now();
                     transientPool.EndSubmitCommands(commandBuffer, fence.get());
                     transformation.ReadRuntimeData();
 
@@ -418,6 +436,7 @@ public:
                     transientPool.EndSubmitCommands(commandBuffer, fence.get());
 
                     statsBuild.transformation = transformation.GatherStats(*stats.data);
+                    profiler::RecordGpuStage("transformation", submitted, statsBuild.transformation.timeTotal);
                 }
                 buildState = BuildState::eCompression;
                 break;
@@ -426,6 +445,7 @@ public:
                     berry::Log::debug("BVH build stage: Compression");
                     commandBuffer = transientPool.BeginCommands();
                     compression.Compute(commandBuffer, (buildConfig.transformation.bv == config::BV::eNone ? collapsing.GetBVH() : transformation.GetBVH()));
+                    submitted = profiler::Now();
                     transientPool.EndSubmitCommands(commandBuffer, fence.get());
                     compression.ReadRuntimeData();
 
@@ -436,6 +456,7 @@ public:
                     transientPool.EndSubmitCommands(commandBuffer, fence.get());
 
                     statsBuild.compression = compression.GatherStats(*stats.data);
+                    profiler::RecordGpuStage("compression", submitted, statsBuild.compression.timeTotal);
                 }
                 buildState = BuildState::eDone;
                 break;
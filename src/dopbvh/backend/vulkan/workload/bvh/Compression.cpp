@@ -70,6 +70,7 @@ stats::Compression Compression::GatherStats(BvhStats const& bvhStats)
     stats.leafSizeMin = bvhStats.leafSizeMin;
     stats.leafSizeMax = bvhStats.leafSizeMax;
     stats.leafSizeAvg = static_cast<f32>(bvhStats.leafSizeSum) / static_cast<f32>(metadata.nodeCountLeaf);
+    stats.memorySize = buffersOut.at(Buffer::eBVH).getBackingMemorySize() + (bBvhAux.isValid() ? bBvhAux.getBackingMemorySize() : 0);
 
     return stats;
 }
@@ -95,6 +96,12 @@ void Compression::reloadPipelines()
         case config::CompressedLayout::eBinaryDOP14Split:
             pCompress = { ctx.d, ctx.sCache, "gen_compress_dop14_split.comp.spv", sInfo };
             break;
+        // rejected by the pipeline, see Supports()
+        case config::CompressedLayout::eWide4:
+        case config::CompressedLayout::eWide8:
+        case config::CompressedLayout::eBinaryQuantized8:
+        case config::CompressedLayout::eBinaryQuantized16:
+            break;
         }
         break;
     case config::BV::eOBB:
@@ -164,6 +171,11 @@ void Compression::alloc()
                 return data_bvh::NodeBvhBinaryDOP14Compressed::SCALAR_SIZE;
             case config::CompressedLayout::eBinaryDOP14Split:
                 return data_bvh::NodeBvhBinaryCompressed::SCALAR_SIZE;
+            case config::CompressedLayout::eWide4:
+            case config::CompressedLayout::eWide8:
+            case config::CompressedLayout::eBinaryQuantized8:
+            case config::CompressedLayout::eBinaryQuantized16:
+                break;
             }
             break;
         case config::BV::eOBB:
@@ -13,6 +13,12 @@ namespace backend::vulkan::bvh {
 struct Compression {
     explicit Compression(VCtx ctx);
 
+    // the wide and quantized layouts are built by the CPU backend only
+    [[nodiscard]] static bool Supports(config::CompressedLayout layout)
+    {
+        return layout == config::CompressedLayout::eBinaryStandard || layout == config::CompressedLayout::eBinaryDOP14Split;
+    }
+
     [[nodiscard]] Bvh GetBVH() const;
     [[nodiscard]] bool NeedsRecompute(config::Compression const& buildConfig)
     {
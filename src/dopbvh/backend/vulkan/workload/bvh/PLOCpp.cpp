@@ -5,9 +5,18 @@
 #include "data_bvh.h"
 #include "data_plocpp.h"
 #include <radix_sort/platforms/vk/radix_sort_vk.h>
+#include <bit>
 
 namespace backend::vulkan::bvh {
 
+// low bits of the keyval holding the cluster id, all 32 for the Morton32KeyVal
+static u32 clusterIdBits(config::SpaceFilling sfc, u32 clusterCount)
+{
+    if (sfc == config::SpaceFilling::eMorton32)
+        return 32;
+    return static_cast<u32>(std::bit_width(std::max(clusterCount, 2u) - 1));
+}
+
 static data_plocpp::SC CreateSpecializationConstants(vk::PhysicalDevice pd, config::PLOC const& config)
 {
     auto const prop2 { pd.getProperties2<
@@ -154,6 +163,8 @@ void PLOCpp::initialClusters(vk::CommandBuffer commandBuffer, data::Scene const&
 
         .auxBufferAddress = 0,
         // .auxBufferAddress = buffersIntermediate[Buffer::eDbgBuffer].getDeviceAddress(ctx.d),
+        .spaceFilling = static_cast<u32>(config.sfc),
+        .clusterIdBits = clusterIdBits(config.sfc, metadata.nodeCountLeaf),
     };
 
     data_plocpp::PC_MortonPerGeometry pcPerGeometry {
@@ -202,7 +213,8 @@ void PLOCpp::sortClusterIDs(vk::CommandBuffer commandBuffer)
 
     radix_sort_vk_sort_info_t radixInfo;
     radixInfo.ext = nullptr;
-    radixInfo.key_bits = 32;
+    // the keyval is sorted by its key_bits most significant bits
+    radixInfo.key_bits = config.sfc == config::SpaceFilling::eMorton32 ? 32 : 64;
     radixInfo.count = metadata.nodeCountLeaf;
     radixInfo.keyvals_even = { buffersIntermediate[Buffer::eRadixEven].get(), 0, radixSortMemory.keyvals_size };
     radixInfo.keyvals_odd = { buffersIntermediate[Buffer::eRadixOdd].get(), 0, radixSortMemory.keyvals_size };
@@ -226,6 +238,7 @@ void PLOCpp::copySortedClusterIDs(vk::CommandBuffer commandBuffer)
         .mortonAddress = nodeBuffer1Address,
         .nodeIdAddress = nodeBuffer0Address,
         .clusterCount = metadata.nodeCountLeaf,
+        .clusterIdMask = static_cast<u32>((1ull << clusterIdBits(config.sfc, metadata.nodeCountLeaf)) - 1),
     };
 
     commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pCopySortedClusterIDs.get());
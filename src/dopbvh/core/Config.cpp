@@ -86,13 +86,36 @@ backend::config::CompressedLayout getCompressedLayout(std::string_view layout)
         return backend::config::CompressedLayout::eBinaryStandard;
     if (layout == "binary_dop14_split")
         return backend::config::CompressedLayout::eBinaryDOP14Split;
+    if (layout == "wide4")
+        return backend::config::CompressedLayout::eWide4;
+    if (layout == "wide8")
+        return backend::config::CompressedLayout::eWide8;
+    if (layout == "binary_quantized8")
+        return backend::config::CompressedLayout::eBinaryQuantized8;
+    if (layout == "binary_quantized16")
+        return backend::config::CompressedLayout::eBinaryQuantized16;
     return backend::config::CompressedLayout::eBinaryStandard;
 }
 
+backend::config::NodeOrder getNodeOrder(std::string_view order)
+{
+    if (order == "dfs")
+        return backend::config::NodeOrder::eDFS;
+    if (order == "treelet")
+        return backend::config::NodeOrder::eTreeletBFS;
+    if (order == "veb")
+        return backend::config::NodeOrder::eVanEmdeBoas;
+    return backend::config::NodeOrder::eNone;
+}
+
 backend::config::SpaceFilling getSFC(std::string_view sfc)
 {
     if (sfc == "morton32")
         return backend::config::SpaceFilling::eMorton32;
+    if (sfc == "morton64")
+        return backend::config::SpaceFilling::eMorton64;
+    if (sfc == "hilbert64")
+        return backend::config::SpaceFilling::eHilbert64;
     return backend::config::SpaceFilling::eMorton32;
 }
 
@@ -122,10 +145,15 @@ void getPipeline(toml::table const& table, backend::config::BVHPipeline& pipelin
     if (auto const value { table.at_path("compression.layout").value<std::string_view>() }; value)
         pipeline.compression.layout = getCompressedLayout(value.value());
 
+    if (auto const value { table.at_path("reordering.order").value<std::string_view>() }; value)
+        pipeline.reordering.order = getNodeOrder(value.value());
+
     if (auto const value { table.at_path("stats.c_t").value<f32>() }; value)
         pipeline.stats.c_t = value.value();
     if (auto const value { table.at_path("stats.c_i").value<f32>() }; value)
         pipeline.stats.c_i = value.value();
+    if (auto const value { table.at_path("stats.epo_samples").value<u32>() }; value)
+        pipeline.stats.epoSamples = value.value();
 
     if (auto const value { table.at_path("tracer.bv").value<std::string_view>() }; value)
         pipeline.tracer.bv = getBoundingVolume(value.value());
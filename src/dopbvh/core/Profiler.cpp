@@ -0,0 +1,154 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <berries/lib_helper/spdlog.h>
+
+namespace profiler {
+
+namespace {
+
+    struct Event {
+        char const* name { nullptr };
+        u64 begin { 0 };
+        u64 end { 0 };
+    };
+
+    // written by its thread only, head counts all the zones ever recorded
+    struct ThreadBuffer {
+        u32 id { 0 };
+        std::string name;
+        std::atomic<u64> head { 0 };
+        std::array<Event, RING_SIZE> events;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        // buffers outlive their threads, the zones of finished workers are still exported
+        std::vector<std::unique_ptr<ThreadBuffer>> threads;
+        std::vector<Event> gpu;
+        u64 start { 0 };
+    };
+
+    Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+
+    ThreadBuffer& threadBuffer()
+    {
+        thread_local ThreadBuffer* buffer { [] {
+            auto& r { registry() };
+            std::scoped_lock lock { r.mutex };
+            auto& b { r.threads.emplace_back(std::make_unique<ThreadBuffer>()) };
+            b->id = static_cast<u32>(r.threads.size());
+            b->name = fmt::format("thread {}", b->id);
+            return b.get();
+        }() };
+        return *buffer;
+    }
+
+    std::string jsonString(std::string_view s)
+    {
+        std::string result { "\"" };
+        for (auto const c : s) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        return result + "\"";
+    }
+
+}
+
+void Enable(bool enable)
+{
+    if (enable && !IsEnabled()) {
+        auto& r { registry() };
+        std::scoped_lock lock { r.mutex };
+        r.start = Now();
+    }
+    detail::enabled.store(enable, std::memory_order_relaxed);
+}
+
+void SetThreadName(std::string name)
+{
+    auto& b { threadBuffer() };
+    std::scoped_lock lock { registry().mutex };
+    b.name = std::move(name);
+}
+
+void Record(char const* name, u64 beginNs, u64 endNs)
+{
+    auto& b { threadBuffer() };
+    auto const head { b.head.load(std::memory_order_relaxed) };
+    b.events[head % RING_SIZE] = { name, beginNs, endNs };
+    b.head.store(head + 1, std::memory_order_release);
+}
+
+void RecordGpu(char const* name, u64 beginNs, u64 endNs)
+{
+    if (!IsEnabled())
+        return;
+    auto& r { registry() };
+    std::scoped_lock lock { r.mutex };
+    r.gpu.push_back({ name, beginNs, endNs });
+}
+
+// complete events ("ph": "X"), the CPU threads are pid 1, the GPU track is pid 2
+bool ExportChromeTrace(std::filesystem::path const& path)
+{
+    std::ofstream out(path);
+    if (!out) {
+        berry::Log::error("Profiler: can't write '{}'", path.generic_string());
+        return false;
+    }
+
+    auto& r { registry() };
+    std::scoped_lock lock { r.mutex };
+
+    bool first { true };
+    auto const separator { [&first] {
+        auto const result { first ? "\n" : ",\n" };
+        first = false;
+        return result;
+    } };
+    auto const writeEvent { [&](Event const& e, u32 pid, u32 tid) {
+        if (e.begin < r.start || e.end < e.begin)
+            return;
+        out << fmt::format("{}{{\"name\":{},\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}", separator(), jsonString(e.name), static_cast<f64>(e.begin - r.start) * 1e-3,
+            static_cast<f64>(e.end - e.begin) * 1e-3, pid, tid);
+    } };
+    auto const writeName { [&](std::string_view kind, u32 pid, u32 tid, std::string_view name) {
+        out << fmt::format("{}{{\"name\":\"{}\",\"ph\":\"M\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":{}}}}}", separator(), kind, pid, tid, jsonString(name));
+    } };
+
+    u64 eventCount { 0 };
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    writeName("process_name", 1, 0, "CPU");
+    for (auto const& b : r.threads) {
+        writeName("thread_name", 1, b->id, b->name);
+        auto const head { b->head.load(std::memory_order_acquire) };
+        for (auto i { head - std::min<u64>(head, RING_SIZE) }; i < head; ++i, ++eventCount)
+            writeEvent(b->events[i % RING_SIZE], 1, b->id);
+    }
+    if (!r.gpu.empty()) {
+        writeName("process_name", 2, 0, "GPU");
+        writeName("thread_name", 2, 1, "queue");
+        for (auto const& e : r.gpu)
+            writeEvent(e, 2, 1);
+        eventCount += r.gpu.size();
+    }
+    out << "\n]}\n";
+
+    berry::Log::info("Profiler: {} zones written to '{}'", eventCount, path.generic_string());
+    return static_cast<bool>(out);
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vLime/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+// scoped-zone CPU profiler, exported as Chrome trace_event JSON (chrome://tracing, ui.perfetto.dev)
+//   each thread records into its own ring buffer of the last RING_SIZE zones, the recording path takes no locks
+//   zone names are not copied, they must outlive the export (string literals)
+//   GPU timestamp results are added as zones of a separate GPU track, aligned to the CPU time of their submission
+//   disabled at runtime by default, PROFILE_ZONE compiles to nothing without DOPBVH_PROFILER
+namespace profiler {
+
+inline constexpr u32 RING_SIZE { 1 << 14 };
+
+namespace detail {
+    inline std::atomic<bool> enabled { false };
+}
+
+[[nodiscard]] inline u64 Now()
+{
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+[[nodiscard]] inline bool IsEnabled()
+{
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// the trace starts at the last Enable(true)
+void Enable(bool enable);
+// names the calling thread in the trace, "thread <id>" otherwise
+void SetThreadName(std::string name);
+
+void Record(char const* name, u64 beginNs, u64 endNs);
+void RecordGpu(char const* name, u64 beginNs, u64 endNs);
+
+// zones being overwritten at the time of export may be torn, export while the recording threads are idle
+bool ExportChromeTrace(std::filesystem::path const& path);
+
+class Zone {
+public:
+    explicit Zone(char const* name)
+        : name(name)
+        , enabled(IsEnabled())
+        , begin(enabled ? Now() : 0)
+    {
+    }
+    ~Zone()
+    {
+        if (enabled)
+            Record(name, begin, Now());
+    }
+
+    Zone(Zone const&) = delete;
+    Zone& operator=(Zone const&) = delete;
+
+private:
+    char const* name;
+    bool enabled;
+    u64 begin;
+};
+
+// consecutive GPU stages of one submission, durations in ms as the timestamps of the vulkan workloads, returns the end
+inline u64 RecordGpuStage(char const* name, u64 beginNs, f32 durationMs)
+{
+    auto const end { beginNs + static_cast<u64>(static_cast<f64>(durationMs) * 1e6) };
+    RecordGpu(name, beginNs, end);
+    return end;
+}
+
+}
+
+#if defined(DOPBVH_PROFILER)
+#    define PROFILE_CONCAT_IMPL(a, b) a##b
+#    define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#    define PROFILE_ZONE(name) profiler::Zone const PROFILE_CONCAT(profileZone, __LINE__) { name }
+#else
+#    define PROFILE_ZONE(name)
+#endif
@@ -22,3 +22,30 @@ using Taskflow = tf::Taskflow;
 using Subflow = tf::Subflow;
 template<typename T>
 using Future = tf::Future<T>;
+
+// runs the taskflow to completion, cooperatively when called from a worker of the same executor
+inline static void runAndWait(Executor& executor, Taskflow& taskflow)
+{
+    if (executor.this_worker_id() >= 0)
+        executor.corun(taskflow);
+    else
+        executor.run(taskflow).wait();
+}
+
+// calls f(i) for each i in [0, count) in parallel and waits for all of them
+template<typename F>
+inline static void parallelFor(Executor& executor, size_t count, F f)
+{
+    Taskflow taskflow;
+    taskflow.for_each_index(size_t { 0 }, count, size_t { 1 }, f);
+    runAndWait(executor, taskflow);
+}
+
+// calls f(begin, end) in parallel for consecutive ranges of at most chunkSize elements covering [0, count)
+template<typename F>
+inline static void parallelForChunks(Executor& executor, size_t count, size_t chunkSize, F f)
+{
+    parallelFor(executor, (count + chunkSize - 1) / chunkSize, [count, chunkSize, f](size_t c) {
+        f(c * chunkSize, std::min(count, (c + 1) * chunkSize));
+    });
+}
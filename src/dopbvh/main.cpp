@@ -1,11 +1,24 @@
 #include "Application.h"
+#include "core/Profiler.h"
 #include <berries/lib_helper/spdlog.h>
+#include <cstdlib>
 
 int main(int argc, char* argv[])
 {
     berry::Log::Init();
     berry::log::timer("Application start", glfwGetTime());
 
+    // DOPBVH_PROFILE=<file> records the profiler zones of the whole session as a Chrome trace, see core/Profiler.h
+    auto const* profile { std::getenv("DOPBVH_PROFILE") };
+    if (profile) {
+        profiler::SetThreadName("main");
+        profiler::Enable(true);
+    }
+
     Application app { argc, argv };
-    return app.Run();
+    auto const result { app.Run() };
+
+    if (profile)
+        profiler::ExportChromeTrace(profile);
+    return result;
 }
@@ -87,7 +87,9 @@ void Benchmark::Run()
         }
         rt.currentPipeline = rt.pipelines[rtPipelineIdx++];
         auto& pCfg { bPipelines[rt.currentPipeline] };
-        backend.pt_compute->SetPipelineConfiguration(pCfg);
+        // a CPU only pipeline is skipped, the next one is set in the next frame
+        if (!backend.pt_compute->SetPipelineConfiguration(pCfg))
+            return;
         sceneBenchmarks.back().pipelines.push_back({ .name = pCfg.name, .statsBuild = {}, .statsTrace = {} });
         bState = BenchmarkState::ePipelineGetStats;
     } break;
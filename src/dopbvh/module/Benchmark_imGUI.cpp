@@ -15,6 +15,19 @@ static std::string to_string(backend::config::BV bv)
     return "unknown";
 }
 
+static std::string to_string(backend::config::SpaceFilling sfc)
+{
+    switch (sfc) {
+    case backend::config::SpaceFilling::eMorton32:
+        return "morton32";
+    case backend::config::SpaceFilling::eMorton64:
+        return "morton64";
+    case backend::config::SpaceFilling::eHilbert64:
+        return "hilbert64";
+    }
+    return "unknown";
+}
+
 static std::string to_string(backend::config::CompressedLayout layout)
 {
     switch (layout) {
@@ -22,6 +35,29 @@ static std::string to_string(backend::config::CompressedLayout layout)
         return "bin standard";
     case backend::config::CompressedLayout::eBinaryDOP14Split:
         return "bin dop14 s";
+    case backend::config::CompressedLayout::eWide4:
+        return "wide4";
+    case backend::config::CompressedLayout::eWide8:
+        return "wide8";
+    case backend::config::CompressedLayout::eBinaryQuantized8:
+        return "bin q8";
+    case backend::config::CompressedLayout::eBinaryQuantized16:
+        return "bin q16";
+    }
+    return "unknown";
+}
+
+static std::string to_string(backend::config::NodeOrder order)
+{
+    switch (order) {
+    case backend::config::NodeOrder::eNone:
+        return "none";
+    case backend::config::NodeOrder::eDFS:
+        return "dfs";
+    case backend::config::NodeOrder::eTreeletBFS:
+        return "treelet";
+    case backend::config::NodeOrder::eVanEmdeBoas:
+        return "veb";
     }
     return "unknown";
 }
@@ -99,7 +135,7 @@ void Benchmark::ProcessGUI(State& state)
         ImGui::TableHeadersRow();
 
         printConfigValue("b. volume", "%s", to_string(bPipelines[bShowPreview].plocpp.bv).c_str());
-        printConfigValue("s. filling", "%s", "morton32");
+        printConfigValue("s. filling", "%s", to_string(bPipelines[bShowPreview].plocpp.sfc).c_str());
         printConfigValue("radius", "%u", bPipelines[bShowPreview].plocpp.radius);
 
         ImGui::EndTable();
@@ -129,6 +165,7 @@ void Benchmark::ProcessGUI(State& state)
 
         printConfigValue("b. volume", "%s", to_string(bPipelines[bShowPreview].compression.bv).c_str());
         printConfigValue("comp. layout", "%s", to_string(bPipelines[bShowPreview].compression.layout).c_str());
+        printConfigValue("node order", "%s", to_string(bPipelines[bShowPreview].reordering.order).c_str());
 
         ImGui::EndTable();
     }
@@ -0,0 +1,305 @@
+#include "GeometryCodec.h"
+
+#include <cmath>
+#include <cstring>
+#include <zlib.h>
+
+namespace scene::codec {
+
+static_assert(std::is_trivially_copyable_v<StreamHeader>);
+static_assert(std::is_trivially_copyable_v<ChunkEntry>);
+
+// serializes the per-chunk payloads produced by 'encodeChunk' into a single block
+template<typename EncodeChunk>
+static std::vector<std::byte> encodeStream(u32 elementCount, u32 chunkElements, StreamHeader header, bool deflate, EncodeChunk encodeChunk)
+{
+    header.elementCount = elementCount;
+    header.chunkElements = chunkElements;
+    header.chunkCount = (elementCount + chunkElements - 1) / chunkElements;
+
+    std::vector<ChunkEntry> chunks(header.chunkCount);
+    std::vector<std::byte> payload;
+    std::vector<std::byte> raw;
+    std::vector<Bytef> compressed;
+
+    for (u32 c = 0; c < header.chunkCount; ++c) {
+        u32 const begin { c * chunkElements };
+        u32 const end { std::min(elementCount, begin + chunkElements) };
+
+        raw.clear();
+        encodeChunk(begin, end, raw);
+
+        auto& chunk { chunks[c] };
+        chunk.offset = payload.size();
+        chunk.rawSize = csize<u32>(raw);
+        chunk.encodedSize = chunk.rawSize;
+
+        if (deflate) {
+            uLongf compressedSize { compressBound(static_cast<uLong>(raw.size())) };
+            compressed.resize(compressedSize);
+            if (compress2(compressed.data(), &compressedSize, reinterpret_cast<Bytef const*>(raw.data()), static_cast<uLong>(raw.size()), Z_BEST_SPEED) == Z_OK
+                && compressedSize < raw.size()) {
+                chunk.encodedSize = static_cast<u32>(compressedSize);
+                payload.insert(payload.end(), reinterpret_cast<std::byte const*>(compressed.data()), reinterpret_cast<std::byte const*>(compressed.data()) + compressedSize);
+                continue;
+            }
+        }
+        payload.insert(payload.end(), raw.begin(), raw.end());
+    }
+
+    size_t const tableSize { sizeof(StreamHeader) + sizeof(ChunkEntry) * chunks.size() };
+    for (auto& chunk : chunks)
+        chunk.offset += tableSize;
+
+    std::vector<std::byte> result(tableSize + payload.size());
+    memcpy(result.data(), &header, sizeof(StreamHeader));
+    memcpy(result.data() + sizeof(StreamHeader), chunks.data(), sizeof(ChunkEntry) * chunks.size());
+    memcpy(result.data() + tableSize, payload.data(), payload.size());
+    return result;
+}
+
+template<typename T>
+static void append(std::vector<std::byte>& out, T const& value)
+{
+    auto const* bytes { reinterpret_cast<std::byte const*>(&value) };
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// returns the raw (inflated) bytes of the chunk, 'scratch' backs them if inflating is needed
+//   the raw size is checked against the size the chunk elements can take before anything is allocated
+static std::span<std::byte const> chunkData(std::span<std::byte const> block, u32 chunkId, u64 minRawSize, u64 maxRawSize, std::vector<std::byte>& scratch)
+{
+    auto const h { header(block) };
+    if (chunkId >= h.chunkCount)
+        return {};
+
+    ChunkEntry chunk;
+    memcpy(&chunk, block.data() + sizeof(StreamHeader) + sizeof(ChunkEntry) * chunkId, sizeof(ChunkEntry));
+    if (chunk.rawSize < minRawSize || chunk.rawSize > maxRawSize || chunk.encodedSize > chunk.rawSize)
+        return {};
+    if (chunk.offset > block.size() || chunk.encodedSize > block.size() - chunk.offset)
+        return {};
+
+    auto const encoded { block.subspan(chunk.offset, chunk.encodedSize) };
+    if (chunk.encodedSize == chunk.rawSize)
+        return encoded;
+
+    scratch.resize(chunk.rawSize);
+    uLongf rawSize { chunk.rawSize };
+    if (uncompress(reinterpret_cast<Bytef*>(scratch.data()), &rawSize, reinterpret_cast<Bytef const*>(encoded.data()), chunk.encodedSize) != Z_OK || rawSize != chunk.rawSize)
+        return {};
+    return scratch;
+}
+
+// chunk payloads start at any byte offset, elements are copied out
+template<typename T>
+static T load(std::byte const* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+static u32 chunkBegin(StreamHeader const& h, u32 chunkId)
+{
+    return chunkId * h.chunkElements;
+}
+
+static u32 chunkEnd(StreamHeader const& h, u32 chunkId)
+{
+    return static_cast<u32>(std::min<u64>(h.elementCount, (static_cast<u64>(chunkId) + 1) * h.chunkElements));
+}
+
+StreamHeader header(std::span<std::byte const> block)
+{
+    return load<StreamHeader>(block.data());
+}
+
+bool valid(std::span<std::byte const> block)
+{
+    if (block.size() < sizeof(StreamHeader))
+        return false;
+    auto const h { header(block) };
+    if (h.chunkElements == 0 || h.chunkCount != (static_cast<u64>(h.elementCount) + h.chunkElements - 1) / h.chunkElements)
+        return false;
+    if (h.chunkCount > (block.size() - sizeof(StreamHeader)) / sizeof(ChunkEntry))
+        return false;
+
+    for (u32 c = 0; c < h.chunkCount; ++c) {
+        ChunkEntry chunk;
+        memcpy(&chunk, block.data() + sizeof(StreamHeader) + sizeof(ChunkEntry) * c, sizeof(ChunkEntry));
+        if (chunk.offset > block.size() || chunk.encodedSize > block.size() - chunk.offset)
+            return false;
+    }
+    return true;
+}
+
+std::vector<std::byte> encodePositions(std::span<glm::vec3 const> positions, bool deflate)
+{
+    // the stored geometry AABB is not guaranteed to bound the scaled vertices, refit it
+    glm::vec3 min { std::numeric_limits<f32>::max() };
+    glm::vec3 max { std::numeric_limits<f32>::lowest() };
+    for (auto const& p : positions) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    static constexpr f32 Q_MAX { static_cast<f32>((1u << POSITION_BITS) - 1) };
+    StreamHeader h;
+    if (!positions.empty()) {
+        h.quantizationMin = min;
+        h.quantizationScale = (max - min) / Q_MAX;
+    }
+    glm::vec3 const invScale {
+        h.quantizationScale.x > 0.f ? 1.f / h.quantizationScale.x : 0.f,
+        h.quantizationScale.y > 0.f ? 1.f / h.quantizationScale.y : 0.f,
+        h.quantizationScale.z > 0.f ? 1.f / h.quantizationScale.z : 0.f,
+    };
+
+    return encodeStream(csize<u32>(positions), CHUNK_ELEMENTS, h, deflate, [&](u32 begin, u32 end, std::vector<std::byte>& out) {
+        out.reserve((end - begin) * 3 * sizeof(u16));
+        for (u32 i = begin; i < end; ++i) {
+            auto const q { glm::clamp(glm::round((positions[i] - min) * invScale), 0.f, Q_MAX) };
+            append(out, static_cast<u16>(q.x));
+            append(out, static_cast<u16>(q.y));
+            append(out, static_cast<u16>(q.z));
+        }
+    });
+}
+
+bool decodePositions(std::span<std::byte const> block, u32 chunk, std::span<glm::vec3> out)
+{
+    static constexpr u64 ELEMENT_SIZE { 3 * sizeof(u16) };
+    auto const h { header(block) };
+    u32 const begin { chunkBegin(h, chunk) };
+    u32 const end { chunkEnd(h, chunk) };
+    std::vector<std::byte> scratch;
+    auto const data { chunkData(block, chunk, (end - begin) * ELEMENT_SIZE, (end - begin) * ELEMENT_SIZE, scratch) };
+    if (data.size() != (end - begin) * ELEMENT_SIZE || out.size() < end)
+        return false;
+
+    auto const* q { data.data() };
+    for (u32 i = begin; i < end; ++i, q += ELEMENT_SIZE) {
+        glm::vec3 const v(load<u16>(q), load<u16>(q + sizeof(u16)), load<u16>(q + 2 * sizeof(u16)));
+        out[i] = h.quantizationMin + v * h.quantizationScale;
+    }
+    return true;
+}
+
+static f32 signNotZero(f32 v)
+{
+    return v >= 0.f ? 1.f : -1.f;
+}
+
+static i16 toSnorm16(f32 v)
+{
+    return static_cast<i16>(std::round(std::clamp(v, -1.f, 1.f) * 32767.f));
+}
+
+std::vector<std::byte> encodeNormals(std::span<glm::vec3 const> normals, bool deflate)
+{
+    return encodeStream(csize<u32>(normals), CHUNK_ELEMENTS, {}, deflate, [&](u32 begin, u32 end, std::vector<std::byte>& out) {
+        out.reserve((end - begin) * 2 * sizeof(i16));
+        for (u32 i = begin; i < end; ++i) {
+            auto const& n { normals[i] };
+            f32 const l1 { std::abs(n.x) + std::abs(n.y) + std::abs(n.z) };
+            f32 x { l1 > 0.f ? n.x / l1 : 0.f };
+            f32 y { l1 > 0.f ? n.y / l1 : 0.f };
+            if (n.z < 0.f) {
+                f32 const ox { x };
+                x = (1.f - std::abs(y)) * signNotZero(ox);
+                y = (1.f - std::abs(ox)) * signNotZero(y);
+            }
+            append(out, toSnorm16(x));
+            append(out, toSnorm16(y));
+        }
+    });
+}
+
+bool decodeNormals(std::span<std::byte const> block, u32 chunk, std::span<glm::vec3> out)
+{
+    static constexpr u64 ELEMENT_SIZE { 2 * sizeof(i16) };
+    auto const h { header(block) };
+    u32 const begin { chunkBegin(h, chunk) };
+    u32 const end { chunkEnd(h, chunk) };
+    std::vector<std::byte> scratch;
+    auto const data { chunkData(block, chunk, (end - begin) * ELEMENT_SIZE, (end - begin) * ELEMENT_SIZE, scratch) };
+    if (data.size() != (end - begin) * ELEMENT_SIZE || out.size() < end)
+        return false;
+
+    auto const* e { data.data() };
+    for (u32 i = begin; i < end; ++i, e += ELEMENT_SIZE) {
+        glm::vec3 n { std::max(load<i16>(e) / 32767.f, -1.f), std::max(load<i16>(e + sizeof(i16)) / 32767.f, -1.f), 0.f };
+        n.z = 1.f - std::abs(n.x) - std::abs(n.y);
+        f32 const t { std::max(-n.z, 0.f) };
+        n.x += n.x >= 0.f ? -t : t;
+        n.y += n.y >= 0.f ? -t : t;
+        out[i] = glm::normalize(n);
+    }
+    return true;
+}
+
+std::vector<std::byte> encodeIndices(std::span<u32 const> indices, bool deflate)
+{
+    // chunks hold whole triangles, delta coding restarts in every chunk
+    return encodeStream(csize<u32>(indices), CHUNK_ELEMENTS * 3, {}, deflate, [&](u32 begin, u32 end, std::vector<std::byte>& out) {
+        out.reserve((end - begin) * 2);
+        u32 prev { 0 };
+        for (u32 i = begin; i < end; ++i) {
+            auto const delta { static_cast<i32>(indices[i] - prev) };
+            auto zigzag { (static_cast<u32>(delta) << 1) ^ static_cast<u32>(delta >> 31) };
+            prev = indices[i];
+            while (zigzag >= 0x80) {
+                out.push_back(static_cast<std::byte>((zigzag & 0x7F) | 0x80));
+                zigzag >>= 7;
+            }
+            out.push_back(static_cast<std::byte>(zigzag));
+        }
+    });
+}
+
+bool decodeIndices(std::span<std::byte const> block, u32 chunk, std::span<u32> out)
+{
+    // a varint takes 1 to 5 bytes
+    auto const h { header(block) };
+    u32 const begin { chunkBegin(h, chunk) };
+    u32 const end { chunkEnd(h, chunk) };
+    std::vector<std::byte> scratch;
+    auto const data { chunkData(block, chunk, end - begin, (end - begin) * u64 { 5 }, scratch) };
+    if (out.size() < end || (data.empty() && end > begin))
+        return false;
+
+    size_t pos { 0 };
+    u32 prev { 0 };
+    for (u32 i = begin; i < end; ++i) {
+        u32 zigzag { 0 };
+        for (u32 shift = 0;; shift += 7) {
+            if (pos >= data.size() || shift > 28)
+                return false;
+            auto const byte { static_cast<u32>(data[pos++]) };
+            zigzag |= (byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        auto const delta { static_cast<i32>(zigzag >> 1) ^ -static_cast<i32>(zigzag & 1) };
+        prev += static_cast<u32>(delta);
+        out[i] = prev;
+    }
+    return pos == data.size();
+}
+
+bool decode(Stream stream, std::span<std::byte const> block, u32 chunk, void* out)
+{
+    u32 const count { header(block).elementCount };
+    switch (stream) {
+    case Stream::ePositions:
+        return decodePositions(block, chunk, { static_cast<glm::vec3*>(out), count });
+    case Stream::eNormals:
+        return decodeNormals(block, chunk, { static_cast<glm::vec3*>(out), count });
+    case Stream::eIndices:
+        return decodeIndices(block, chunk, { static_cast<u32*>(out), count });
+    }
+    return false;
+}
+
+}
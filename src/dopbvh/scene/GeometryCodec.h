@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vLime/types.h>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace scene::codec {
+
+// per-geometry encoding of the '*.ob' geometry blocks, bit flags
+enum class Encoding : u32 {
+    eNone = 0,
+    eQuantizedPositions = 1 << 0,
+    eOctahedralNormals = 1 << 1,
+    eDeltaIndices = 1 << 2,
+    eDeflate = 1 << 3,
+
+    eAll = eQuantizedPositions | eOctahedralNormals | eDeltaIndices | eDeflate,
+};
+
+[[nodiscard]] inline constexpr Encoding operator|(Encoding a, Encoding b)
+{
+    return static_cast<Encoding>(static_cast<u32>(a) | static_cast<u32>(b));
+}
+
+[[nodiscard]] inline constexpr bool has(Encoding flags, Encoding bit)
+{
+    return (static_cast<u32>(flags) & static_cast<u32>(bit)) != 0;
+}
+
+enum class Stream : u32 {
+    ePositions,
+    eNormals,
+    eIndices,
+};
+
+// encoded block: StreamHeader, ChunkEntry[chunkCount], chunk data
+// each chunk decodes independently, chunks are deflated only when it pays off
+struct StreamHeader {
+    u32 elementCount { 0 };
+    u32 chunkCount { 0 };
+    u32 chunkElements { 0 };
+    u32 padding { 0 };
+    // positions only: value = min + q * scale
+    glm::vec3 quantizationMin { 0.f };
+    glm::vec3 quantizationScale { 0.f };
+};
+
+struct ChunkEntry {
+    u64 offset { 0 };
+    u32 encodedSize { 0 };
+    u32 rawSize { 0 };
+};
+
+inline constexpr u32 POSITION_BITS { 16 };
+inline constexpr u32 CHUNK_ELEMENTS { 1 << 16 };
+
+// positions are quantized against their AABB to POSITION_BITS per axis, max error is half a step per axis
+[[nodiscard]] std::vector<std::byte> encodePositions(std::span<glm::vec3 const> positions, bool deflate);
+// normals are octahedral-encoded into 2x snorm16
+[[nodiscard]] std::vector<std::byte> encodeNormals(std::span<glm::vec3 const> normals, bool deflate);
+// indices are delta coded against the previous index, zig-zag and varint packed
+[[nodiscard]] std::vector<std::byte> encodeIndices(std::span<u32 const> indices, bool deflate);
+
+[[nodiscard]] StreamHeader header(std::span<std::byte const> block);
+// the header, the chunk table and every chunk lie within the block and the chunks cover the elements
+[[nodiscard]] bool valid(std::span<std::byte const> block);
+// decodes one chunk into its slot of 'out', 'out' holds the whole stream
+bool decodePositions(std::span<std::byte const> block, u32 chunk, std::span<glm::vec3> out);
+bool decodeNormals(std::span<std::byte const> block, u32 chunk, std::span<glm::vec3> out);
+bool decodeIndices(std::span<std::byte const> block, u32 chunk, std::span<u32> out);
+
+bool decode(Stream stream, std::span<std::byte const> block, u32 chunk, void* out);
+
+}
@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace scene {
+
+MappedFile::MappedFile(std::filesystem::path const& path)
+{
+#if defined(_WIN32)
+    HANDLE const file { CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER fileSize {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE const mapping { CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+    if (!mapping) {
+        CloseHandle(file);
+        return;
+    }
+
+    void const* ptr { MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+    if (!ptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return;
+    }
+
+    hFile = file;
+    hMapping = mapping;
+    data = static_cast<std::byte const*>(ptr);
+    size = static_cast<u64>(fileSize.QuadPart);
+#else
+    int const fd { open(path.c_str(), O_RDONLY) };
+    if (fd < 0)
+        return;
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    void* ptr { mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0) };
+    // the mapping keeps its own reference to the file
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return;
+    madvise(ptr, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+
+    data = static_cast<std::byte const*>(ptr);
+    size = static_cast<u64>(st.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data(std::exchange(other.data, nullptr))
+    , size(std::exchange(other.size, 0))
+#if defined(_WIN32)
+    , hFile(std::exchange(other.hFile, nullptr))
+    , hMapping(std::exchange(other.hMapping, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+#if defined(_WIN32)
+        hFile = std::exchange(other.hFile, nullptr);
+        hMapping = std::exchange(other.hMapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::unmap()
+{
+    if (!data)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(hMapping);
+    CloseHandle(hFile);
+    hMapping = nullptr;
+    hFile = nullptr;
+#else
+    munmap(const_cast<std::byte*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+}
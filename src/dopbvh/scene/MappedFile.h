@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vLime/types.h>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace scene {
+
+// read-only memory mapping of a whole file, the mapping lives as long as the object
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(std::filesystem::path const& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    [[nodiscard]] bool IsValid() const
+    {
+        return data != nullptr;
+    }
+
+    [[nodiscard]] std::span<std::byte const> Data() const
+    {
+        return { data, size };
+    }
+
+    // 'count' aligned elements of T starting at 'offset' lie within the file
+    template<typename T>
+    [[nodiscard]] bool Contains(u64 offset, u64 count) const
+    {
+        return offset <= size && offset % alignof(T) == 0 && count <= (size - offset) / sizeof(T);
+    }
+
+    // empty if the range does not fit into the file
+    template<typename T>
+    [[nodiscard]] std::span<T const> View(u64 offset, u64 count) const
+    {
+        if (!Contains<T>(offset, count))
+            return {};
+        return { reinterpret_cast<T const*>(data + offset), count };
+    }
+
+private:
+    std::byte const* data { nullptr };
+    u64 size { 0 };
+
+#if defined(_WIN32)
+    void* hFile { nullptr };
+    void* hMapping { nullptr };
+#endif
+
+    void unmap();
+};
+
+}
@@ -4,8 +4,10 @@
 #include <filesystem>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/glm.hpp>
+#include <memory>
 #include <queue>
 #include <ranges>
+#include <span>
 #include <stack>
 #include <string>
 #include <unordered_map>
@@ -13,6 +15,8 @@
 
 namespace scene {
 
+class MappedFile;
+
 enum class Axis : u8 {
     eX,
     eY,
@@ -93,6 +97,26 @@ struct Scene {
         AABB aabb;
         f32 surfaceArea { 0.f };
         f32 surfaceAreaToAabbRatio { 0.f };
+
+        // zero-copy views into Scene::storage, used instead of the vectors when set
+        struct {
+            std::span<glm::vec3 const> vertices;
+            std::span<glm::vec3 const> normals;
+            std::span<u32 const> indices;
+        } mapped;
+
+        [[nodiscard]] std::span<glm::vec3 const> Vertices() const
+        {
+            return mapped.vertices.empty() ? std::span<glm::vec3 const> { vertices } : mapped.vertices;
+        }
+        [[nodiscard]] std::span<glm::vec3 const> Normals() const
+        {
+            return mapped.normals.empty() ? std::span<glm::vec3 const> { normals } : mapped.normals;
+        }
+        [[nodiscard]] std::span<u32 const> Indices() const
+        {
+            return mapped.indices.empty() ? std::span<u32 const> { indices } : mapped.indices;
+        }
     };
 
     struct Node {
@@ -113,6 +137,9 @@ struct Scene {
     std::vector<Node> nodes;
     u32 triangleCount { 0 };
 
+    // backing memory of Geometry::mapped views
+    std::shared_ptr<scene::MappedFile const> storage;
+
     template<typename PerNodeFunction>
     void NodeBFS(PerNodeFunction f)
     {
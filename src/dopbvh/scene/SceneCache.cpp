@@ -0,0 +1,97 @@
+#include "SceneCache.h"
+
+#include "MappedFile.h"
+#include "Serialization.h"
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+
+namespace scene::cache {
+
+// bump when the import itself changes without changing flags or scale
+static constexpr u64 CACHE_VERSION { 1 };
+
+static constexpr u64 PRIME_1 { 0x9E3779B185EBCA87ull };
+static constexpr u64 PRIME_2 { 0xC2B2AE3D27D4EB4Full };
+
+static u64 mix(u64 h, u64 v)
+{
+    h ^= std::rotl(v * PRIME_2, 31) * PRIME_1;
+    return std::rotl(h, 27) * PRIME_1 + 0x85EBCA77C2B2AE63ull;
+}
+
+static u64 finalize(u64 h)
+{
+    h ^= h >> 33;
+    h *= PRIME_2;
+    h ^= h >> 29;
+    h *= 0x165667B19E3779F9ull;
+    h ^= h >> 32;
+    return h;
+}
+
+// word-wise hash, four independent lanes to keep the multiplier pipelines busy on large files
+u64 hashBytes(std::span<std::byte const> data)
+{
+    std::array<u64, 4> lanes { PRIME_1, PRIME_2, ~PRIME_1, ~PRIME_2 };
+
+    size_t i { 0 };
+    for (; i + 32 <= data.size(); i += 32)
+        for (size_t l = 0; l < 4; ++l) {
+            u64 v;
+            memcpy(&v, data.data() + i + l * 8, sizeof(u64));
+            lanes[l] = mix(lanes[l], v);
+        }
+
+    u64 h { data.size() };
+    for (auto const lane : lanes)
+        h = mix(h, lane);
+    for (; i < data.size(); ++i)
+        h = mix(h, static_cast<u64>(data[i]));
+    return finalize(h);
+}
+
+u64 hashCombine(u64 h, u64 v)
+{
+    return mix(h, v);
+}
+
+u64 Key::Hash() const
+{
+    u64 h { mix(CACHE_VERSION, contentHash) };
+    h = mix(h, importFlags);
+    h = mix(h, std::bit_cast<u32>(globalScale));
+    return finalize(h);
+}
+
+Key makeKey(std::filesystem::path const& source, u32 importFlags, f32 globalScale)
+{
+    Key key {
+        .importFlags = importFlags,
+        .globalScale = globalScale,
+    };
+
+    MappedFile const file { source };
+    if (file.IsValid())
+        key.contentHash = hashBytes(file.Data());
+    return key;
+}
+
+std::filesystem::path entry(std::filesystem::path const& cacheDir, Key const& key)
+{
+    return cacheDir / std::format("{:016x}.ob", key.Hash());
+}
+
+bool store(std::filesystem::path const& entry, Scene const& scene)
+{
+    if (scene.nodes.empty())
+        return false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(entry.parent_path(), ec);
+    serializeToFile(scene, entry);
+    return true;
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Scene.h"
+#include <vLime/types.h>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace scene::cache {
+
+// key of an imported scene: source file content + everything that changes the import result
+struct Key {
+    u64 contentHash { 0 };
+    u32 importFlags { 0 };
+    f32 globalScale { 1.f };
+
+    [[nodiscard]] u64 Hash() const;
+};
+
+// the hash of the keys, also used by the BVH cache (backend/cpu/bvh/Cache.h)
+[[nodiscard]] u64 hashBytes(std::span<std::byte const> data);
+// order dependent, not finalized
+[[nodiscard]] u64 hashCombine(u64 h, u64 v);
+
+[[nodiscard]] Key makeKey(std::filesystem::path const& source, u32 importFlags, f32 globalScale);
+// cached '*.ob' file for the key, it may not exist yet
+[[nodiscard]] std::filesystem::path entry(std::filesystem::path const& cacheDir, Key const& key);
+// writes the imported scene to its entry, a failed (empty) import is not cached, every later load would hit it
+bool store(std::filesystem::path const& entry, Scene const& scene);
+
+}
@@ -1,7 +1,7 @@
 #pragma once
 
-#include "../backend/data/Input.h"
-#include "../backend/vulkan/Vulkan.h"
+#include "../core/Profiler.h"
+#include "../core/Taskflow.h"
 #include "Scene.h"
 #include <assimp/Importer.hpp>
 #include <assimp/ProgressHandler.hpp>
@@ -9,6 +9,7 @@
 #include <assimp/scene.h>
 #include <berries/lib_helper/spdlog.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstring>
 
 class SceneIO {
     class Progress : public Assimp::ProgressHandler {
@@ -32,17 +33,21 @@ public:
     Assimp::Importer importer;
     std::unique_ptr<Assimp::ProgressHandler> handler;
 
+    // part of the scene cache key, see scene::cache::Key
+    static constexpr unsigned IMPORT_FLAGS {
+        static_cast<unsigned>(aiProcess_GenBoundingBoxes)
+        // | aiProcess_FlipWindingOrder | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals
+        | aiProcess_Triangulate | aiProcess_GenNormals
+        | aiProcess_JoinIdenticalVertices
+        // | aiProcess_SortByPType
+    };
+
     void ImportScene(std::string_view path, f32* progress = nullptr)
     {
+        PROFILE_ZONE("scene import");
         handler = std::make_unique<Progress>(progress);
         importer.SetProgressHandler(handler.get());
-        unsigned flags { static_cast<unsigned>(aiProcess_GenBoundingBoxes) };
-        // flags |= aiProcess_FlipWindingOrder | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals;
-        flags |= aiProcess_Triangulate | aiProcess_GenNormals;
-        flags |= aiProcess_JoinIdenticalVertices;
-        // flags |= aiProcess_SortByPType;
-
-        importer.ReadFile(path.data(), flags);
+        importer.ReadFile(path.data(), IMPORT_FLAGS);
         importer.SetProgressHandler(nullptr);
     }
 
@@ -119,11 +124,10 @@ public:
         u32 nextId { 0 };
     } nodeIdGenerator;
 
-    Scene CreateScene()
+    template<typename PerMeshFunction>
+    void CreateNodes(Scene& result, aiScene const* scene, PerMeshFunction perMeshFunction)
     {
-        Scene result;
         nodeIdGenerator.reset();
-        auto const* scene { importer.GetScene() };
 
         u32 nodeCount { 1 };
         ProcessAssimpNodesBFS(scene->mRootNode, [&nodeCount](aiNode* node) {
@@ -134,8 +138,7 @@ public:
         result.geometries.resize(scene->mNumMeshes);
 
         std::queue<u32> parents;
-        ProcessAssimpNodesBFS(scene->mRootNode, [this, scene = &result, &parents](aiNode* aiNode) {
-            auto const* aiScene { importer.GetScene() };
+        ProcessAssimpNodesBFS(scene->mRootNode, [this, scene = &result, &parents, &perMeshFunction](aiNode* aiNode) {
             auto const nodeId { nodeIdGenerator.getId() };
             auto& node { scene->nodes[nodeId] };
 
@@ -147,40 +150,8 @@ public:
             // create and reference all meshes
             node.geometry.resize(aiNode->mNumMeshes);
             for (u32 m = 0; m < aiNode->mNumMeshes; m++) {
-                auto const& mesh { aiScene->mMeshes[aiNode->mMeshes[m]] };
-                auto& g { scene->geometries[aiNode->mMeshes[m]] };
                 node.geometry[m] = aiNode->mMeshes[m];
-
-                if (g.id == Scene::INVALID_ID) {
-                    g.id = aiNode->mMeshes[m];
-                    g.name = mesh->mName.C_Str();
-
-                    for (u32 i = 0; i < mesh->mNumVertices; i++) {
-                        pointAssimpToDopBVHInPlace(mesh->mVertices[i], 10.f);
-                        // pointAssimpToDopBVHInPlace(mesh->mVertices[i], GEOMETRY_GLOBAL_SCALE);
-                        pointAssimpToDopBVHInPlace(mesh->mNormals[i]);
-                    }
-
-                    g.vertices.resize(mesh->mNumVertices);
-                    g.normals.resize(mesh->mNumVertices);
-                    memcpy(g.vertices.data(), mesh->mVertices, sizeof(aiVector3D) * g.vertices.size());
-                    memcpy(g.normals.data(), mesh->mNormals, sizeof(aiVector3D) * g.normals.size());
-
-                    g.indices.resize(mesh->mNumFaces * 3);
-                    scene->triangleCount += mesh->mNumFaces;
-                    for (u32 j { 0 }; j < mesh->mNumFaces; j++) {
-                        g.indices[j * 3] = mesh->mFaces[j].mIndices[0];
-                        g.indices[j * 3 + 1] = mesh->mFaces[j].mIndices[1];
-                        g.indices[j * 3 + 2] = mesh->mFaces[j].mIndices[2];
-                        g.surfaceArea += scene::triangleArea(g.vertices[g.indices[j * 3]], g.vertices[g.indices[j * 3 + 1]], g.vertices[g.indices[j * 3 + 2]]);
-                    }
-
-                    pointAssimpToDopBVHInPlace(mesh->mAABB.mMin, GEOMETRY_GLOBAL_SCALE);
-                    pointAssimpToDopBVHInPlace(mesh->mAABB.mMax, GEOMETRY_GLOBAL_SCALE);
-                    g.aabb = aabbAssimpToSceneNormalize(mesh->mAABB);
-                    ExpandAABB(scene->aabb, g.aabb);
-                    g.surfaceAreaToAabbRatio = g.surfaceArea / g.aabb.Area();
-                }
+                perMeshFunction(aiNode->mMeshes[m]);
             }
 
             // record the parent-children relationship
@@ -196,131 +167,93 @@ public:
                     parents.pop();
             }
         });
-
-        return result;
     }
-};
 
-static inline void UploadScene(Scene& scene, backend::vulkan::Vulkan& backend)
-{
-    backend.scenes.emplace_back();
-    backend.scenes.back().data = &backend.deviceData;
+    static void ConvertMesh(aiMesh* mesh, Scene::Geometry& g)
+    {
+        for (u32 i = 0; i < mesh->mNumVertices; i++) {
+            pointAssimpToDopBVHInPlace(mesh->mVertices[i], 10.f);
+            // pointAssimpToDopBVHInPlace(mesh->mVertices[i], GEOMETRY_GLOBAL_SCALE);
+            pointAssimpToDopBVHInPlace(mesh->mNormals[i]);
+        }
 
-    std::unordered_map<u32, backend::vulkan::data::ID_Geometry> geometryMap;
+        g.vertices.resize(mesh->mNumVertices);
+        g.normals.resize(mesh->mNumVertices);
+        memcpy(g.vertices.data(), mesh->mVertices, sizeof(aiVector3D) * g.vertices.size());
+        memcpy(g.normals.data(), mesh->mNormals, sizeof(aiVector3D) * g.normals.size());
+
+        g.indices.resize(mesh->mNumFaces * 3);
+        for (u32 j { 0 }; j < mesh->mNumFaces; j++) {
+            g.indices[j * 3] = mesh->mFaces[j].mIndices[0];
+            g.indices[j * 3 + 1] = mesh->mFaces[j].mIndices[1];
+            g.indices[j * 3 + 2] = mesh->mFaces[j].mIndices[2];
+            g.surfaceArea += scene::triangleArea(g.vertices[g.indices[j * 3]], g.vertices[g.indices[j * 3 + 1]], g.vertices[g.indices[j * 3 + 2]]);
+        }
 
-    for (auto const& geometry : scene.geometries) {
-        backend::input::Geometry g {
-            .vertexCount = static_cast<u32>(geometry.vertices.size()),
-            .indexCount = static_cast<u32>(geometry.indices.size()),
-            .vertexData = geometry.vertices.data(),
-            .indexData = geometry.indices.data(),
-            .uvData = nullptr,
-            .normalData = geometry.normals.data(),
-        };
+        pointAssimpToDopBVHInPlace(mesh->mAABB.mMin, GEOMETRY_GLOBAL_SCALE);
+        pointAssimpToDopBVHInPlace(mesh->mAABB.mMax, GEOMETRY_GLOBAL_SCALE);
+        g.aabb = aabbAssimpToSceneNormalize(mesh->mAABB);
+        g.surfaceAreaToAabbRatio = g.surfaceArea / g.aabb.Area();
+    }
 
-        auto gId { backend.AddGeometry(g) };
-        geometryMap[geometry.id] = gId;
+    Scene CreateScene()
+    {
+        Scene result;
+        auto const* scene { importer.GetScene() };
 
-        backend.scenes.back().geometries.emplace_back(gId);
+        CreateNodes(result, scene, [scene, &result](u32 meshId) {
+            auto& g { result.geometries[meshId] };
+            if (g.id != Scene::INVALID_ID)
+                return;
 
-        // TODO: for PLOC, this might have to be tracked per node, not per geometry
-        backend.scenes.back().totalTriangleCount += g.indexCount / 3;
-    }
+            auto* mesh { scene->mMeshes[meshId] };
+            g.id = meshId;
+            g.name = mesh->mName.C_Str();
+            ConvertMesh(mesh, g);
 
-    // upload aabbs
-    backend.scenes.back().aabb = scene.aabb;
-    struct PaddedAABB_TMP {
-        glm::vec4 min {};
-        glm::vec4 max {};
-        glm::vec4 dynamicUniformPadding[2] {};
-    };
-    std::vector<PaddedAABB_TMP> aabbs;
-    aabbs.reserve(scene.geometries.size());
-    for (auto const& g : scene.geometries)
-        aabbs.push_back({ .min = glm::vec4(g.aabb.min, 1.f), .max = glm::vec4(g.aabb.max, 1.f) });
-
-    backend::input::Buffer aabbInput {
-        .size = sizeof(PaddedAABB_TMP) * aabbs.size(),
-        .data = aabbs.data(),
-    };
-    backend.scenes.back().addAABBs_TMP(aabbInput);
-
-    aabbs.clear();
-    aabbs.push_back({ .min = glm::vec4(scene.aabb.min, 1.f), .max = glm::vec4(scene.aabb.max, 1.f) });
-    aabbInput.size = sizeof(PaddedAABB_TMP);
-    aabbInput.data = aabbs.data();
-
-    // update matrices
-    scene.NodeDFS([&scene](Scene::Node& node) {
-        node.transformWorld = node.transformLocal;
-        if (node.parent != Scene::INVALID_ID)
-            node.transformWorld = scene.nodes[node.parent].transformWorld * node.transformLocal;
-    });
-
-    struct WorldTransform {
-        glm::mat4 toWorld;
-        glm::mat4 toLocal;
-    };
+            result.triangleCount += mesh->mNumFaces;
+            ExpandAABB(result.aabb, g.aabb);
+        });
 
-    std::vector<WorldTransform> transforms;
-    transforms.reserve(scene.nodes.size());
-    backend.scenes.back().nodeGeometry.reserve(scene.nodes.size());
-    backend.scenes.back().localGeometryId.reserve(scene.nodes.size());
-    backend.scenes.back().toWorld.reserve(scene.nodes.size());
-    backend.scenes.back().sceneNodeToRenderedNodes.reserve(scene.nodes.size());
-    for (auto const& node : scene.nodes) {
-        backend.scenes.back().sceneNodeToRenderedNodes.emplace_back();
-        for (auto const& gId : node.geometry) {
-            backend.scenes.back().sceneNodeToRenderedNodes.back().emplace_back(gId);
-
-            transforms.push_back({ .toWorld = node.transformWorld, .toLocal = glm::inverse(glm::transpose(node.transformWorld)) });
-            backend.scenes.back().nodeGeometry.emplace_back(geometryMap[gId]);
-            backend.scenes.back().localGeometryId.emplace_back(gId);
-            // TODO: transpose for AS builder, might be problem if used elsewhere
-            backend.scenes.back().toWorld.push_back(*reinterpret_cast<std::array<f32, 16> const*>(glm::value_ptr(glm::transpose(node.transformWorld))));
-        }
+        return result;
     }
 
-    backend::input::Buffer transformInput {
-        .size = sizeof(WorldTransform) * transforms.size(),
-        .data = transforms.data(),
-    };
-
-    backend.scenes.back().addTransforms_TMP(transformInput);
-    backend.scenes.back().data->SetSceneDescription_TMP();
-}
-
-static inline void RecomputeMatrices(Scene& scene, backend::vulkan::Vulkan& backend)
-{
-    scene.NodeDFS([&scene](Scene::Node& node) {
-        node.transformWorld = node.transformLocal;
-        if (node.parent != Scene::INVALID_ID)
-            node.transformWorld = scene.nodes[node.parent].transformWorld * node.transformLocal;
-    });
-
-    struct WorldTransform {
-        glm::mat4 toWorld;
-        glm::mat4 toLocal;
-    };
+    // Bounded memory variant of CreateScene: takes the aiScene over from the importer and releases every mesh
+    // right after its conversion, so the peak is one imported scene plus the meshes in flight, not two full copies.
+    Scene CreateSceneStreaming(Executor& executor)
+    {
+        PROFILE_ZONE("scene create");
+        Scene result;
+        std::unique_ptr<aiScene> scene { importer.GetOrphanedScene() };
+        if (!scene)
+            return result;
 
-    std::vector<WorldTransform> transforms;
-    transforms.reserve(scene.nodes.size());
+        std::vector<u8> referenced(scene->mNumMeshes, 0);
+        CreateNodes(result, scene.get(), [&referenced](u32 meshId) {
+            referenced[meshId] = 1;
+        });
 
-    backend.scenes.back().toWorld.clear();
-    backend.scenes.back().toWorld.reserve(scene.nodes.size());
+        Taskflow taskflow;
+        taskflow.for_each_index(u32 { 0 }, scene->mNumMeshes, u32 { 1 }, [&scene, &result, &referenced](u32 meshId) {
+            std::unique_ptr<aiMesh> mesh { std::exchange(scene->mMeshes[meshId], nullptr) };
+            if (!referenced[meshId])
+                return;
+
+            PROFILE_ZONE("convert mesh");
+            auto& g { result.geometries[meshId] };
+            g.id = meshId;
+            g.name = mesh->mName.C_Str();
+            ConvertMesh(mesh.get(), g);
+        });
+        runAndWait(executor, taskflow);
 
-    for (auto const& node : scene.nodes) {
-        for (auto const& gId : node.geometry) {
-            static_cast<void>(gId);
-            transforms.push_back({ .toWorld = node.transformWorld, .toLocal = glm::inverse(glm::transpose(node.transformWorld)) });
-            backend.scenes.back().toWorld.push_back(*reinterpret_cast<std::array<f32, 16> const*>(glm::value_ptr(glm::transpose(node.transformWorld))));
+        for (auto const& g : result.geometries) {
+            if (g.id == Scene::INVALID_ID)
+                continue;
+            result.triangleCount += csize<u32>(g.indices) / 3;
+            ExpandAABB(result.aabb, g.aabb);
         }
-    }
 
-    backend::input::Buffer transformInput {
-        .size = sizeof(WorldTransform) * transforms.size(),
-        .data = transforms.data(),
-    };
-
-    backend.scenes.back().addTransforms_TMP(transformInput);
-}
+        return result;
+    }
+};
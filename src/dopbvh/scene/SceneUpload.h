@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../backend/data/Input.h"
+#include "../core/Profiler.h"
+#include "../backend/vulkan/Vulkan.h"
+#include "Scene.h"
+#include <glm/gtc/type_ptr.hpp>
+
+// scene upload to the vulkan backend, kept apart from SceneIO so the importer builds without Vulkan
+
+static inline void UploadScene(Scene& scene, backend::vulkan::Vulkan& backend)
+{
+    PROFILE_ZONE("scene upload");
+    backend.scenes.emplace_back();
+    backend.scenes.back().data = &backend.deviceData;
+
+    std::unordered_map<u32, backend::vulkan::data::ID_Geometry> geometryMap;
+
+    for (auto const& geometry : scene.geometries) {
+        auto const vertices { geometry.Vertices() };
+        auto const indices { geometry.Indices() };
+        backend::input::Geometry g {
+            .vertexCount = csize<u32>(vertices),
+            .indexCount = csize<u32>(indices),
+            .vertexData = vertices.data(),
+            .indexData = indices.data(),
+            .uvData = nullptr,
+            .normalData = geometry.Normals().data(),
+        };
+
+        auto gId { backend.AddGeometry(g) };
+        geometryMap[geometry.id] = gId;
+
+        backend.scenes.back().geometries.emplace_back(gId);
+
+        // TODO: for PLOC, this might have to be tracked per node, not per geometry
+        backend.scenes.back().totalTriangleCount += g.indexCount / 3;
+    }
+
+    // upload aabbs
+    backend.scenes.back().aabb = scene.aabb;
+    struct PaddedAABB_TMP {
+        glm::vec4 min {};
+        glm::vec4 max {};
+        glm::vec4 dynamicUniformPadding[2] {};
+    };
+    std::vector<PaddedAABB_TMP> aabbs;
+    aabbs.reserve(scene.geometries.size());
+    for (auto const& g : scene.geometries)
+        aabbs.push_back({ .min = glm::vec4(g.aabb.min, 1.f), .max = glm::vec4(g.aabb.max, 1.f) });
+
+    backend::input::Buffer aabbInput {
+        .size = sizeof(PaddedAABB_TMP) * aabbs.size(),
+        .data = aabbs.data(),
+    };
+    backend.scenes.back().addAABBs_TMP(aabbInput);
+
+    aabbs.clear();
+    aabbs.push_back({ .min = glm::vec4(scene.aabb.min, 1.f), .max = glm::vec4(scene.aabb.max, 1.f) });
+    aabbInput.size = sizeof(PaddedAABB_TMP);
+    aabbInput.data = aabbs.data();
+
+    // update matrices
+    scene.NodeDFS([&scene](Scene::Node& node) {
+        node.transformWorld = node.transformLocal;
+        if (node.parent != Scene::INVALID_ID)
+            node.transformWorld = scene.nodes[node.parent].transformWorld * node.transformLocal;
+    });
+
+    struct WorldTransform {
+        glm::mat4 toWorld;
+        glm::mat4 toLocal;
+    };
+
+    std::vector<WorldTransform> transforms;
+    transforms.reserve(scene.nodes.size());
+    backend.scenes.back().nodeGeometry.reserve(scene.nodes.size());
+    backend.scenes.back().localGeometryId.reserve(scene.nodes.size());
+    backend.scenes.back().toWorld.reserve(scene.nodes.size());
+    backend.scenes.back().sceneNodeToRenderedNodes.reserve(scene.nodes.size());
+    for (auto const& node : scene.nodes) {
+        backend.scenes.back().sceneNodeToRenderedNodes.emplace_back();
+        for (auto const& gId : node.geometry) {
+            backend.scenes.back().sceneNodeToRenderedNodes.back().emplace_back(gId);
+
+            transforms.push_back({ .toWorld = node.transformWorld, .toLocal = glm::inverse(glm::transpose(node.transformWorld)) });
+            backend.scenes.back().nodeGeometry.emplace_back(geometryMap[gId]);
+            backend.scenes.back().localGeometryId.emplace_back(gId);
+            // TODO: transpose for AS builder, might be problem if used elsewhere
+            backend.scenes.back().toWorld.push_back(*reinterpret_cast<std::array<f32, 16> const*>(glm::value_ptr(glm::transpose(node.transformWorld))));
+        }
+    }
+
+    backend::input::Buffer transformInput {
+        .size = sizeof(WorldTransform) * transforms.size(),
+        .data = transforms.data(),
+    };
+
+    backend.scenes.back().addTransforms_TMP(transformInput);
+    backend.scenes.back().data->SetSceneDescription_TMP();
+}
+
+static inline void RecomputeMatrices(Scene& scene, backend::vulkan::Vulkan& backend)
+{
+    scene.NodeDFS([&scene](Scene::Node& node) {
+        node.transformWorld = node.transformLocal;
+        if (node.parent != Scene::INVALID_ID)
+            node.transformWorld = scene.nodes[node.parent].transformWorld * node.transformLocal;
+    });
+
+    struct WorldTransform {
+        glm::mat4 toWorld;
+        glm::mat4 toLocal;
+    };
+
+    std::vector<WorldTransform> transforms;
+    transforms.reserve(scene.nodes.size());
+
+    backend.scenes.back().toWorld.clear();
+    backend.scenes.back().toWorld.reserve(scene.nodes.size());
+
+    for (auto const& node : scene.nodes) {
+        for (auto const& gId : node.geometry) {
+            static_cast<void>(gId);
+            transforms.push_back({ .toWorld = node.transformWorld, .toLocal = glm::inverse(glm::transpose(node.transformWorld)) });
+            backend.scenes.back().toWorld.push_back(*reinterpret_cast<std::array<f32, 16> const*>(glm::value_ptr(glm::transpose(node.transformWorld))));
+        }
+    }
+
+    backend::input::Buffer transformInput {
+        .size = sizeof(WorldTransform) * transforms.size(),
+        .data = transforms.data(),
+    };
+
+    backend.scenes.back().addTransforms_TMP(transformInput);
+}
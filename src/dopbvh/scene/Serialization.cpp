@@ -1,25 +1,45 @@
 #include "Serialization.h"
 
+#include "../core/Profiler.h"
+#include "GeometryCodec.h"
+#include "MappedFile.h"
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <spanstream>
 #include <vLime/types.h>
 
 template<typename T>
-inline static void write(std::ofstream& file, T const& data)
+inline static void write(std::ostream& file, T const& data)
 {
     file.write(reinterpret_cast<char const*>(&data), sizeof(T));
 }
 
 template<typename T>
-inline static T read(std::ifstream& file)
+inline static T read(std::istream& file)
 {
     T data {};
     file.read(reinterpret_cast<char*>(&data), sizeof(T));
     return data;
 }
 
+template<typename T>
+inline static void writeArray(std::ostream& file, std::span<T const> data)
+{
+    file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size_bytes()));
+}
+
+template<typename T>
+inline static void readArray(std::istream& file, std::vector<T>& data, u32 count)
+{
+    data.resize(count);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
 template<>
-inline void write(std::ofstream& file, Scene::Node const& data)
+inline void write(std::ostream& file, Scene::Node const& data)
 {
     write<u32>(file, data.id);
     // write<std::string>(file, data.name);
@@ -36,7 +56,7 @@ inline void write(std::ofstream& file, Scene::Node const& data)
 }
 
 template<>
-inline Scene::Node read(std::ifstream& file)
+inline Scene::Node read(std::istream& file)
 {
     Scene::Node data;
     data.id = read<u32>(file);
@@ -44,98 +64,402 @@ inline Scene::Node read(std::ifstream& file)
     data.transformLocal = read<glm::mat4>(file);
     data.transformWorld = data.transformLocal;
 
+    // the counts are not trusted, stop at the end of the stream
     u32 const childCount { read<u32>(file) };
-    data.children.reserve(childCount);
-    for (u32 i = 0; i < childCount; ++i)
+    for (u32 i = 0; i < childCount && file; ++i)
         data.children.push_back(read<u32>(file));
 
     u32 const geometryCount { read<u32>(file) };
-    data.geometry.reserve(geometryCount);
-    for (u32 i = 0; i < geometryCount; ++i)
+    for (u32 i = 0; i < geometryCount && file; ++i)
         data.geometry.push_back(read<u32>(file));
 
     return data;
 }
 
+// v1 geometry record, kept for reading legacy files
 template<>
-inline void write(std::ofstream& file, Scene::Geometry const& data)
+inline Scene::Geometry read(std::istream& file)
 {
-    write<u32>(file, data.id);
-    // write<std::string>(file, data.name);
-    write<Scene::AABB>(file, data.aabb);
-    write<f32>(file, data.surfaceArea);
-    write<f32>(file, data.surfaceAreaToAabbRatio);
+    Scene::Geometry data;
+    data.id = read<u32>(file);
+    data.aabb = read<Scene::AABB>(file);
+    data.surfaceArea = read<f32>(file);
+    data.surfaceAreaToAabbRatio = read<f32>(file);
 
-    write<u32>(file, csize<u32>(data.vertices));
-    for (auto v : data.vertices)
-        write<glm::vec3>(file, v);
+    readArray(file, data.vertices, read<u32>(file));
+    readArray(file, data.normals, read<u32>(file));
+    readArray(file, data.indices, read<u32>(file));
 
-    write<u32>(file, csize<u32>(data.normals));
-    for (auto n : data.normals)
-        write<glm::vec3>(file, n);
+    return data;
+}
 
-    write<u32>(file, csize<u32>(data.indices));
-    for (auto i : data.indices)
-        write<u32>(file, i);
+namespace scene::ob {
+
+// "DOB2" in little endian, v1 files start directly with the triangle count
+inline constexpr u32 MAGIC { 0x32424F44 };
+// 3: geometry records carry their own normal count
+inline constexpr u32 VERSION { 3 };
+inline constexpr u64 ALIGNMENT { 64 };
+
+enum class Section : u32 {
+    eNodes,
+    eGeometries,
+    eVertices,
+    eNormals,
+    eIndices,
+    eCount,
+};
+
+struct Header {
+    u32 magic { MAGIC };
+    u32 version { VERSION };
+    u32 sectionCount { static_cast<u32>(Section::eCount) };
+    u32 triangleCount { 0 };
+    Scene::AABB aabb;
+    u64 nodeCount { 0 };
+    u64 geometryCount { 0 };
+};
+
+struct SectionEntry {
+    Section type { Section::eCount };
+    u32 padding { 0 };
+    u64 offset { 0 };
+    u64 size { 0 };
+};
+
+// offsets are absolute within the file and ALIGNMENT aligned
+struct GeometryRecord {
+    u32 id { Scene::INVALID_ID };
+    u32 vertexCount { 0 };
+    // 0 for geometries without normals
+    u32 normalCount { 0 };
+    u32 indexCount { 0 };
+    f32 surfaceArea { 0.f };
+    f32 surfaceAreaToAabbRatio { 0.f };
+    Scene::AABB aabb;
+    // blocks of encoded streams hold codec::StreamHeader + chunks instead of raw arrays
+    codec::Encoding encoding { codec::Encoding::eNone };
+    u32 padding { 0 };
+    u64 vertexOffset { 0 };
+    u64 normalOffset { 0 };
+    u64 indexOffset { 0 };
+};
+
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(std::is_trivially_copyable_v<SectionEntry>);
+static_assert(std::is_trivially_copyable_v<GeometryRecord>);
+
+inline static u64 alignUp(u64 value)
+{
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
 }
 
-template<>
-inline Scene::Geometry read(std::ifstream& file)
+inline static void pad(std::ostream& file)
 {
-    Scene::Geometry data;
-    data.id = read<u32>(file);
-    data.aabb = read<Scene::AABB>(file);
-    data.surfaceArea = read<f32>(file);
-    data.surfaceAreaToAabbRatio = read<f32>(file);
+    static constexpr char zeros[ALIGNMENT] {};
+    auto const pos { static_cast<u64>(file.tellp()) };
+    file.write(zeros, static_cast<std::streamsize>(alignUp(pos) - pos));
+}
+
+static void writeStream(std::ostream& file, Scene::Geometry const& g, codec::Stream stream, codec::Encoding encoding)
+{
+    bool const deflate { codec::has(encoding, codec::Encoding::eDeflate) };
+    switch (stream) {
+    case codec::Stream::ePositions:
+        if (codec::has(encoding, codec::Encoding::eQuantizedPositions))
+            writeArray<std::byte>(file, codec::encodePositions(g.Vertices(), deflate));
+        else
+            writeArray(file, g.Vertices());
+        break;
+    case codec::Stream::eNormals:
+        if (codec::has(encoding, codec::Encoding::eOctahedralNormals))
+            writeArray<std::byte>(file, codec::encodeNormals(g.Normals(), deflate));
+        else
+            writeArray(file, g.Normals());
+        break;
+    case codec::Stream::eIndices:
+        if (codec::has(encoding, codec::Encoding::eDeltaIndices))
+            writeArray<std::byte>(file, codec::encodeIndices(g.Indices(), deflate));
+        else
+            writeArray(file, g.Indices());
+        break;
+    }
+}
+
+static void serialize(Scene const& scene, std::ofstream& file, codec::Encoding encoding)
+{
+    Header const header {
+        .triangleCount = scene.triangleCount,
+        .aabb = scene.aabb,
+        .nodeCount = scene.nodes.size(),
+        .geometryCount = scene.geometries.size(),
+    };
+    std::array<SectionEntry, static_cast<size_t>(Section::eCount)> sections {};
+    std::vector<GeometryRecord> records(scene.geometries.size());
+
+    // header and tables are rewritten once all the offsets are known
+    write<Header>(file, header);
+    writeArray<SectionEntry>(file, sections);
+
+    auto const beginSection { [&file, &sections](Section type) -> SectionEntry& {
+        pad(file);
+        auto& s { sections[static_cast<size_t>(type)] };
+        s.type = type;
+        s.offset = static_cast<u64>(file.tellp());
+        return s;
+    } };
+    auto const endSection { [&file](SectionEntry& s) {
+        s.size = static_cast<u64>(file.tellp()) - s.offset;
+    } };
+
+    auto& sNodes { beginSection(Section::eNodes) };
+    for (auto const& node : scene.nodes)
+        write<Scene::Node>(file, node);
+    endSection(sNodes);
+
+    auto& sGeometries { beginSection(Section::eGeometries) };
+    writeArray<GeometryRecord>(file, records);
+    endSection(sGeometries);
+
+    auto const writeBlocks { [&](Section type, codec::Stream stream, auto getOffset) {
+        auto& s { beginSection(type) };
+        for (size_t i { 0 }; i < scene.geometries.size(); ++i) {
+            pad(file);
+            getOffset(records[i]) = static_cast<u64>(file.tellp());
+            writeStream(file, scene.geometries[i], stream, encoding);
+        }
+        endSection(s);
+    } };
+    writeBlocks(Section::eVertices, codec::Stream::ePositions, [](auto& r) -> u64& { return r.vertexOffset; });
+    writeBlocks(Section::eNormals, codec::Stream::eNormals, [](auto& r) -> u64& { return r.normalOffset; });
+    writeBlocks(Section::eIndices, codec::Stream::eIndices, [](auto& r) -> u64& { return r.indexOffset; });
+    pad(file);
+
+    for (size_t i { 0 }; i < scene.geometries.size(); ++i) {
+        auto const& g { scene.geometries[i] };
+        auto& r { records[i] };
+        r.id = g.id;
+        r.vertexCount = csize<u32>(g.Vertices());
+        r.normalCount = csize<u32>(g.Normals());
+        r.indexCount = csize<u32>(g.Indices());
+        r.surfaceArea = g.surfaceArea;
+        r.surfaceAreaToAabbRatio = g.surfaceAreaToAabbRatio;
+        r.aabb = g.aabb;
+        r.encoding = encoding;
+    }
+
+    file.seekp(0);
+    write<Header>(file, header);
+    writeArray<SectionEntry>(file, sections);
+    file.seekp(static_cast<std::streamoff>(sGeometries.offset));
+    writeArray<GeometryRecord>(file, records);
+}
 
-    u32 const vertexCount { read<u32>(file) };
-    data.vertices.reserve(vertexCount);
-    for (u32 i = 0; i < vertexCount; ++i)
-        data.vertices.push_back(read<glm::vec3>(file));
+// one chunk of an encoded stream, decoded into already allocated geometry vectors
+struct DecodeJob {
+    std::span<std::byte const> block;
+    codec::Stream stream { codec::Stream::ePositions };
+    u32 chunk { 0 };
+    void* out { nullptr };
 
-    u32 const normalCount { read<u32>(file) };
-    data.normals.reserve(normalCount);
-    for (u32 i = 0; i < normalCount; ++i)
-        data.normals.push_back(read<glm::vec3>(file));
+    [[nodiscard]] bool Run() const
+    {
+        return codec::decode(stream, block, chunk, out);
+    }
+};
 
-    u32 const indexCount { read<u32>(file) };
-    data.indices.reserve(indexCount);
-    for (u32 i = 0; i < indexCount; ++i)
-        data.indices.push_back(read<u32>(file));
+static Scene deserialize(std::shared_ptr<MappedFile const> mapped, std::vector<DecodeJob>& decodeJobs)
+{
+    Scene result;
+
+    auto const data { mapped->Data() };
+    std::array<SectionEntry, static_cast<size_t>(Section::eCount)> sections;
+    if (data.size() < sizeof(Header) + sizeof(sections))
+        return result;
+
+    Header header;
+    memcpy(&header, data.data(), sizeof(Header));
+    if (header.magic != MAGIC || header.version != VERSION || header.sectionCount != static_cast<u32>(Section::eCount))
+        return result;
+
+    memcpy(sections.data(), data.data() + sizeof(Header), sizeof(sections));
+    for (size_t i = 0; i < sections.size(); ++i) {
+        auto const& s { sections[i] };
+        if (s.type != static_cast<Section>(i) || s.offset > data.size() || s.size > data.size() - s.offset) {
+            std::cout << "Scene deserialization: corrupted section table\n";
+            return result;
+        }
+    }
+
+    // 'count' elements of 'elementSize' starting at 'offset' lie within the section, so within the file
+    auto const inSection { [&sections](Section type, u64 offset, u64 count, u64 elementSize) {
+        auto const& s { sections[static_cast<size_t>(type)] };
+        return offset >= s.offset && offset - s.offset <= s.size && count <= (s.size - (offset - s.offset)) / elementSize;
+    } };
+
+    // node hierarchy is small, parse it into owned memory, a node takes at least its fixed part
+    static constexpr u64 NODE_MIN_SIZE { 4 * sizeof(u32) + sizeof(glm::mat4) };
+    auto const& sNodes { sections[static_cast<size_t>(Section::eNodes)] };
+    if (header.nodeCount > sNodes.size / NODE_MIN_SIZE) {
+        std::cout << "Scene deserialization: corrupted node section\n";
+        return result;
+    }
+    std::ispanstream nodeStream { std::span<char const> { reinterpret_cast<char const*>(data.data() + sNodes.offset), sNodes.size } };
+    result.nodes.reserve(header.nodeCount);
+    for (u64 i = 0; i < header.nodeCount; ++i)
+        result.nodes.push_back(read<Scene::Node>(nodeStream));
+    if (!nodeStream) {
+        std::cout << "Scene deserialization: corrupted node section\n";
+        return {};
+    }
+
+    auto const sGeometries { sections[static_cast<size_t>(Section::eGeometries)] };
+    if (!inSection(Section::eGeometries, sGeometries.offset, header.geometryCount, sizeof(GeometryRecord))
+        || !mapped->Contains<GeometryRecord>(sGeometries.offset, header.geometryCount)) {
+        std::cout << "Scene deserialization: corrupted geometry section\n";
+        return {};
+    }
+
+    result.triangleCount = header.triangleCount;
+    result.aabb = header.aabb;
+
+    auto const records { mapped->View<GeometryRecord>(sGeometries.offset, header.geometryCount) };
+    result.geometries.resize(header.geometryCount);
+    for (u64 i = 0; i < header.geometryCount; ++i) {
+        auto const& r { records[i] };
+        auto& g { result.geometries[i] };
+        g.id = r.id;
+        g.aabb = r.aabb;
+        g.surfaceArea = r.surfaceArea;
+        g.surfaceAreaToAabbRatio = r.surfaceAreaToAabbRatio;
+
+        // an encoded block is limited to the rest of its section
+        auto const addJobs { [&](codec::Stream stream, Section type, u64 offset, auto& target, u32 count) -> bool {
+            if (!inSection(type, offset, 0, 1))
+                return false;
+            auto const& s { sections[static_cast<size_t>(type)] };
+            auto const block { data.subspan(offset, s.offset + s.size - offset) };
+            if (!codec::valid(block))
+                return false;
+            auto const h { codec::header(block) };
+            if (h.elementCount != count)
+                return false;
+            target.resize(count);
+            for (u32 c = 0; c < h.chunkCount; ++c)
+                decodeJobs.push_back({ .block = block, .stream = stream, .chunk = c, .out = target.data() });
+            return true;
+        } };
+
+        // raw arrays are mapped in place, they have to lie within their section
+        auto const addView { [&]<typename T>(Section type, u64 offset, std::span<T const>& target, u32 count) -> bool {
+            if (!inSection(type, offset, count, sizeof(T)) || !mapped->Contains<T>(offset, count))
+                return false;
+            target = mapped->View<T>(offset, count);
+            return true;
+        } };
+
+        bool valid { true };
+        if (codec::has(r.encoding, codec::Encoding::eQuantizedPositions))
+            valid &= addJobs(codec::Stream::ePositions, Section::eVertices, r.vertexOffset, g.vertices, r.vertexCount);
+        else
+            valid &= addView(Section::eVertices, r.vertexOffset, g.mapped.vertices, r.vertexCount);
+        if (codec::has(r.encoding, codec::Encoding::eOctahedralNormals))
+            valid &= addJobs(codec::Stream::eNormals, Section::eNormals, r.normalOffset, g.normals, r.normalCount);
+        else
+            valid &= addView(Section::eNormals, r.normalOffset, g.mapped.normals, r.normalCount);
+        if (codec::has(r.encoding, codec::Encoding::eDeltaIndices))
+            valid &= addJobs(codec::Stream::eIndices, Section::eIndices, r.indexOffset, g.indices, r.indexCount);
+        else
+            valid &= addView(Section::eIndices, r.indexOffset, g.mapped.indices, r.indexCount);
+
+        if (!valid) {
+            // the queued jobs point into the mapping released with the result
+            decodeJobs.clear();
+            std::cout << "Scene deserialization: corrupted geometry stream\n";
+            return {};
+        }
+    }
+
+    result.storage = std::move(mapped);
+    return result;
+}
 
-    return data;
 }
 
 namespace scene {
 
-void serialize(Scene const& scene, std::filesystem::path const& dir)
+void serialize(Scene const& scene, std::filesystem::path const& dir, codec::Encoding encoding)
+{
+    serializeToFile(scene, dir / scene.path.stem().concat(".ob"), encoding);
+}
+
+void serializeToFile(Scene const& scene, std::filesystem::path const& path, codec::Encoding encoding)
 {
-    std::filesystem::path const path { dir / scene.path.stem().concat(".ob") };
+    PROFILE_ZONE("scene serialize");
+    // the target might be mmap-ed by the scene being serialized, write aside and swap
+    std::filesystem::path tmpPath { path };
+    tmpPath.concat(".tmp");
 
     std::cout << "Scene serialization: " << path << "\n";
 
-    std::ofstream file { path, std::ios::binary };
+    std::ofstream file { tmpPath, std::ios::binary };
     if (!file.is_open())
         return;
 
-    write<u32>(file, scene.triangleCount);
-    write<Scene::AABB>(file, scene.aabb);
+    ob::serialize(scene, file, encoding);
+    file.close();
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec)
+        std::cout << "Scene serialization: " << ec.message() << "\n";
+}
 
-    write<size_t>(file, scene.nodes.size());
-    for (auto const& node : scene.nodes)
-        write<Scene::Node>(file, node);
+u32 binaryVersion(std::filesystem::path const& path)
+{
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open())
+        return 0;
 
-    write<size_t>(file, scene.geometries.size());
-    for (auto const& g : scene.geometries)
-        write<Scene::Geometry>(file, g);
+    auto const magic { read<u32>(file) };
+    auto const version { read<u32>(file) };
+    if (!file)
+        return 0;
+    return magic == ob::MAGIC ? version : 1;
+}
 
-    file.close();
+// besides the current version only v1 has a reader, v2 geometry records lack the normal count
+static bool isV1(std::filesystem::path const& path, u32 version)
+{
+    if (version == 1)
+        return true;
+    if (version != 0)
+        std::cout << "Scene deserialization: unsupported version " << version << " of " << path << "\n";
+    return false;
 }
 
 Scene deserialize(std::filesystem::path const& path)
 {
     Scene result;
 
+    auto const version { binaryVersion(path) };
+    if (version == ob::VERSION) {
+        auto mapped { std::make_shared<MappedFile const>(path) };
+        if (!mapped->IsValid())
+            return result;
+
+        std::vector<ob::DecodeJob> decodeJobs;
+        result = ob::deserialize(std::move(mapped), decodeJobs);
+        for (auto const& job : decodeJobs)
+            if (!job.Run()) {
+                std::cout << "Scene deserialization: geometry decode failed\n";
+                return {};
+            }
+        return result;
+    }
+    if (!isV1(path, version))
+        return result;
+
     std::ifstream file { path, std::ios::binary };
     if (!file.is_open())
         return result;
@@ -158,4 +482,139 @@ Scene deserialize(std::filesystem::path const& path)
     return result;
 }
 
+// v1 has no index, locate the geometry records by skipping over their arrays
+static std::vector<u64> indexGeometriesV1(std::ifstream& file, size_t geometryCount)
+{
+    std::vector<u64> offsets;
+    offsets.reserve(geometryCount);
+
+    auto const skipArray { [&file](size_t elementSize) {
+        file.seekg(static_cast<std::streamoff>(elementSize * read<u32>(file)), std::ios::cur);
+    } };
+    for (size_t i = 0; i < geometryCount; ++i) {
+        offsets.push_back(static_cast<u64>(file.tellg()));
+        file.seekg(sizeof(u32) + sizeof(Scene::AABB) + 2 * sizeof(f32), std::ios::cur);
+        skipArray(sizeof(glm::vec3));
+        skipArray(sizeof(glm::vec3));
+        skipArray(sizeof(u32));
+    }
+    return offsets;
+}
+
+// touches every page of the block so that the page faults are taken in parallel, not during the upload
+static u64 prefault(std::span<std::byte const> block)
+{
+    static constexpr size_t PAGE_SIZE { 4096 };
+    u64 sum { 0 };
+    for (size_t i = 0; i < block.size(); i += PAGE_SIZE)
+        sum += static_cast<u8>(block[i]);
+    return sum;
+}
+
+Scene deserialize(std::filesystem::path const& path, Executor& executor, std::function<void(std::string_view)> const& onPhase)
+{
+    PROFILE_ZONE("scene deserialize");
+    auto const phase { [&onPhase](std::string_view name) {
+        if (onPhase)
+            onPhase(name);
+    } };
+
+    Scene result;
+    Taskflow taskflow;
+
+    auto const version { binaryVersion(path) };
+    if (version == ob::VERSION) {
+        auto mapped { std::make_shared<MappedFile const>(path) };
+        if (!mapped->IsValid())
+            return result;
+        phase("  mapped");
+
+        std::vector<ob::DecodeJob> decodeJobs;
+        result = ob::deserialize(std::move(mapped), decodeJobs);
+        phase("  indexed");
+
+        // encoded streams are decoded per chunk, raw blocks are only faulted in
+        std::atomic<u64> sink { 0 };
+        std::atomic<bool> decoded { true };
+        taskflow.for_each_index(size_t { 0 }, decodeJobs.size(), size_t { 1 }, [&decodeJobs, &decoded](size_t i) {
+            PROFILE_ZONE("decode geometry");
+            if (!decodeJobs[i].Run())
+                decoded.store(false, std::memory_order_relaxed);
+        });
+        taskflow.for_each_index(size_t { 0 }, result.geometries.size(), size_t { 1 }, [&result, &sink](size_t i) {
+            PROFILE_ZONE("prefault geometry");
+            auto const& g { result.geometries[i] };
+            u64 sum { 0 };
+            if (!g.mapped.vertices.empty())
+                sum += prefault(std::as_bytes(g.mapped.vertices));
+            if (!g.mapped.normals.empty())
+                sum += prefault(std::as_bytes(g.mapped.normals));
+            if (!g.mapped.indices.empty())
+                sum += prefault(std::as_bytes(g.mapped.indices));
+            sink.fetch_add(sum, std::memory_order_relaxed);
+        });
+        runAndWait(executor, taskflow);
+        if (!decoded) {
+            std::cout << "Scene deserialization: geometry decode failed\n";
+            return {};
+        }
+        phase("  geometry loaded");
+        return result;
+    }
+    if (!isV1(path, version))
+        return result;
+
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open())
+        return result;
+
+    result.triangleCount = read<u32>(file);
+    result.aabb = read<Scene::AABB>(file);
+
+    size_t const nodeCount { read<size_t>(file) };
+    result.nodes.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i)
+        result.nodes.push_back(read<Scene::Node>(file));
+
+    size_t const geometryCount { read<size_t>(file) };
+    auto const offsets { indexGeometriesV1(file, geometryCount) };
+    file.close();
+    phase("  indexed");
+
+    // contiguous ranges of geometries, each read through its own stream
+    result.geometries.resize(geometryCount);
+    size_t const chunkCount { std::min<size_t>(geometryCount, executor.num_workers()) };
+    for (size_t c = 0; c < chunkCount; ++c) {
+        taskflow.emplace([&, c]() {
+            PROFILE_ZONE("read geometries");
+            size_t const begin { geometryCount * c / chunkCount };
+            size_t const end { geometryCount * (c + 1) / chunkCount };
+
+            std::ifstream chunk { path, std::ios::binary };
+            chunk.seekg(static_cast<std::streamoff>(offsets[begin]));
+            for (size_t i = begin; i < end; ++i)
+                result.geometries[i] = read<Scene::Geometry>(chunk);
+        });
+    }
+    runAndWait(executor, taskflow);
+    phase("  geometry loaded");
+
+    return result;
+}
+
+bool convert(std::filesystem::path const& path, std::filesystem::path const& dir)
+{
+    auto const version { binaryVersion(path) };
+    if (version != 1)
+        return false;
+
+    Scene scene { deserialize(path) };
+    if (scene.nodes.empty())
+        return false;
+
+    scene.path = path;
+    serialize(scene, dir);
+    return true;
+}
+
 }
@@ -1,11 +1,24 @@
 #pragma once
 
+#include "../core/Taskflow.h"
+#include "GeometryCodec.h"
 #include "Scene.h"
 #include <filesystem>
+#include <functional>
 
 namespace scene {
 
-void serialize(Scene const& scene, std::filesystem::path const& dir);
+// '*.ob' v3: header, section table and 64B aligned vertex/normal/index blocks, loaded via mmap
+// '*.ob' v1: legacy stream of per-element records, still readable, v2 files are rejected
+// v3 geometry blocks are optionally stored encoded, see codec::Encoding
+void serialize(Scene const& scene, std::filesystem::path const& dir, codec::Encoding encoding = codec::Encoding::eNone);
+void serializeToFile(Scene const& scene, std::filesystem::path const& path, codec::Encoding encoding = codec::Encoding::eNone);
 Scene deserialize(std::filesystem::path const& path);
+// geometry blocks are processed concurrently on the executor, onPhase is called after each load phase
+Scene deserialize(std::filesystem::path const& path, Executor& executor, std::function<void(std::string_view)> const& onPhase = {});
 
-}
\ No newline at end of file
+[[nodiscard]] u32 binaryVersion(std::filesystem::path const& path);
+// rewrites a v1 '*.ob' into the current version, returns false if nothing was written
+bool convert(std::filesystem::path const& path, std::filesystem::path const& dir);
+
+}
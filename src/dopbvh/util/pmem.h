@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vLime/types.h>
+
+#if defined(_WIN32)
+#    include <windows.h>
+#    include <psapi.h>
+#else
+#    include <fstream>
+#    include <sys/resource.h>
+#    include <unistd.h>
+#endif
+
+namespace pmem {
+
+// resident set size of the process in bytes
+inline static u64 get_current_rss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.WorkingSetSize;
+#else
+    u64 pages { 0 };
+    u64 resident { 0 };
+    std::ifstream statm { "/proc/self/statm" };
+    statm >> pages >> resident;
+    return resident * static_cast<u64>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// peak resident set size of the process in bytes, since its start
+inline static u64 get_peak_rss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<u64>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+inline static f32 to_MiB(u64 bytes)
+{
+    return static_cast<f32>(bytes) / (1024.f * 1024.f);
+}
+
+}
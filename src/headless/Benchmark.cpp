@@ -0,0 +1,142 @@
+#include "Benchmark.h"
+#include "HeatMap.h"
+
+#include "scene/Scene.h"
+
+#include <berries/lib_helper/spdlog.h>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace headless {
+
+std::string fileName(std::string_view name)
+{
+    std::string result { name };
+    for (auto& c : result)
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+            c = '_';
+    return result;
+}
+
+f32 buildTimeMs(backend::stats::BVHPipeline const& stats)
+{
+    return stats.plocpp.timeTotal + stats.collapsing.timeTotal + stats.transformation.timeTotal + stats.compression.timeTotal + stats.reordering.timeTotal;
+}
+
+// cost of the last enabled stage
+static f32 outputCost(backend::config::BVHPipeline const& pipeline, backend::stats::BVHPipeline const& stats)
+{
+    if (pipeline.compression.bv != backend::config::BV::eNone)
+        return stats.compression.costTotal;
+    if (pipeline.transformation.bv != backend::config::BV::eNone)
+        return stats.transformation.costTotal;
+    if (pipeline.collapsing.bv != backend::config::BV::eNone)
+        return stats.collapsing.costTotal;
+    return stats.plocpp.costTotal;
+}
+
+// orbits the scene AABB center from -Y with Z up, the default orientation of Camera
+static Camera frameScene(Scene const& scene)
+{
+    auto const extent { scene.aabb.max - scene.aabb.min };
+    Camera camera;
+    camera.pivot = .5f * (scene.aabb.min + scene.aabb.max);
+    camera.position = { 0.f, -1.5f * glm::length(extent), 0.f };
+    return camera;
+}
+
+std::vector<Camera> loadViews(std::string_view cameraPath, Scene const& scene)
+{
+    std::vector<Camera> views;
+    if (!cameraPath.empty() && std::filesystem::exists(cameraPath)) {
+        std::ifstream in { std::string(cameraPath) };
+        Camera c;
+        while (in >> c)
+            views.emplace_back(c);
+    }
+    if (views.empty())
+        views.emplace_back(frameScene(scene));
+    return views;
+}
+
+Benchmark::Benchmark(Executor& executor, BenchmarkSettings settings)
+    : settings(settings)
+    , builder(executor)
+    , tracer(executor)
+{
+    tracer.mode = settings.traceMode;
+}
+
+std::optional<BenchmarkResult> Benchmark::Run(std::string_view sceneName, Scene const& scene, std::span<Camera const> views, backend::config::BVHPipeline const& pipeline)
+{
+    BenchmarkResult result {
+        .scene = std::string(sceneName),
+        .pipeline = pipeline.name,
+        .triangleCount = scene.triangleCount,
+    };
+
+    // every repetition starts over from PLOC++, the stages would skip an unchanged config otherwise
+    builder.SetPipelineConfiguration(pipeline);
+    for (u32 i = 0; i < settings.warmupCount + settings.repetitionCount; ++i) {
+        builder.Invalidate();
+        builder.Build(scene);
+        if (builder.Failed()) {
+            berry::Log::error("  pipeline '{}' failed to build, skipped", pipeline.name);
+            return {};
+        }
+        if (i < settings.warmupCount)
+            continue;
+
+        auto const& stats { builder.GetStatsBuild() };
+        result.builds.push_back(stats);
+        berry::Log::info("  build {}/{}: {:.2f} ms, cost {:.2f}", result.builds.size(), settings.repetitionCount, buildTimeMs(stats), outputCost(pipeline, stats));
+    }
+
+    // only compressed BVHs are traced, see cpu::bvh::Tracer
+    if (pipeline.compression.bv == backend::config::BV::eNone || pipeline.tracer.bv == backend::config::BV::eNone) {
+        berry::Log::warn("  pipeline '{}' has no compressed BVH or tracer BV, not traced", pipeline.name);
+        return result;
+    }
+
+    auto const& bvh { builder.GetBVH() };
+    for (u32 v = 0; v < views.size(); ++v) {
+        auto camera { views[v] };
+        camera.ScreenResize(settings.resolution.x, settings.resolution.y);
+        camera.UpdateCamera();
+
+        backend::cpu::bvh::Tracer::Runtime rt {
+            .x = camera.screenResolution.x,
+            .y = camera.screenResolution.y,
+            .samplesComputed = 0,
+            .viewInv = glm::inverse(camera.viewMat),
+            .projectionInv = glm::inverse(camera.projectionVulkan),
+        };
+
+        auto& traces { result.traces.emplace_back() };
+        for (u32 i = 0; i < settings.warmupCount + settings.repetitionCount; ++i) {
+            // the sample index seeds the jitter and the bounces, repetitions trace different but reproducible rays
+            rt.samplesComputed = i;
+            tracer.Trace(pipeline.tracer, rt, scene, bvh);
+            if (i < settings.warmupCount)
+                continue;
+
+            auto const& stats { traces.emplace_back(tracer.GetStats()) };
+            berry::Log::info("  view {} trace {}/{}: {:.2f} primary MRays/s, {:.2f} secondary MRays/s", v, traces.size(), settings.repetitionCount, stats.PrimaryMRaysPerSecond(),
+                stats.SecondaryMRaysPerSecond());
+        }
+
+        if (!settings.heatMapDir.empty()) {
+            rt.samplesComputed = 0;
+            tracer.recordCosts = true;
+            tracer.Trace(pipeline.tracer, rt, scene, bvh);
+            tracer.recordCosts = false;
+            auto const prefix { settings.heatMapDir / fmt::format("{}_{}_view{}", fileName(sceneName), fileName(pipeline.name), v) };
+            if (writeCostMaps(prefix, tracer.GetCostMaps()))
+                berry::Log::info("  view {} heat maps: '{}_*'", v, prefix.generic_string());
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "backend/Config.h"
+#include "backend/Stats.h"
+#include "backend/cpu/Builder.h"
+#include "backend/cpu/bvh/Tracer.h"
+#include "scene/Camera.h"
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct Scene;
+
+namespace headless {
+
+// frame-loop-free counterpart of module::Benchmark on the CPU engines
+//   each pipeline is built warm-up + repetition times from scratch, then each view is traced warm-up + repetition times,
+//   every repetition is kept, nothing is sampled across frames
+struct BenchmarkSettings {
+    u32 warmupCount { 1 };
+    u32 repetitionCount { 5 };
+    glm::u32vec2 resolution { 1280, 720 };
+    backend::cpu::bvh::Tracer::Mode traceMode { backend::cpu::bvh::Tracer::Mode::eSingleRay };
+    // one more untimed trace of each view with per ray costs, written as <scene>_<pipeline>_view<index>_* heat maps, see HeatMap.h
+    std::filesystem::path heatMapDir;
+};
+
+struct BenchmarkResult {
+    std::string scene;
+    std::string pipeline;
+    u32 triangleCount { 0 };
+
+    // per repetition
+    std::vector<backend::stats::BVHPipeline> builds;
+    // per view, per repetition, empty if the pipeline is not traceable
+    std::vector<std::vector<backend::stats::Trace>> traces;
+};
+
+// pipeline names are free text in benchmark.toml, e.g. "->DOP14s"
+[[nodiscard]] std::string fileName(std::string_view name);
+
+// sum of the stage times, the same as the build time of Benchmark::ExportPipeline plus reordering
+[[nodiscard]] f32 buildTimeMs(backend::stats::BVHPipeline const& stats);
+
+// the views of the camera file, or a single view of the whole scene if there is none
+[[nodiscard]] std::vector<Camera> loadViews(std::string_view cameraPath, Scene const& scene);
+
+class Benchmark {
+public:
+    Benchmark(Executor& executor, BenchmarkSettings settings);
+
+    // empty if the pipeline failed to build
+    [[nodiscard]] std::optional<BenchmarkResult> Run(std::string_view sceneName, Scene const& scene, std::span<Camera const> views, backend::config::BVHPipeline const& pipeline);
+
+private:
+    BenchmarkSettings settings;
+    backend::cpu::Builder builder;
+    backend::cpu::bvh::Tracer tracer;
+};
+
+}
@@ -0,0 +1,144 @@
+#include "HeatMap.h"
+
+#include <algorithm>
+#include <array>
+#include <berries/lib_helper/spdlog.h>
+#include <fstream>
+#include <numeric>
+#include <vector>
+#include <zlib.h>
+
+namespace headless {
+
+using CostMaps = backend::cpu::bvh::Tracer::CostMaps;
+
+static void putU32(std::vector<u8>& out, u32 v)
+{
+    for (i32 shift = 24; shift >= 0; shift -= 8)
+        out.push_back(static_cast<u8>(v >> shift));
+}
+
+// length, type, data, CRC of type and data
+static void putChunk(std::vector<u8>& out, char const (&type)[5], std::span<u8 const> data)
+{
+    putU32(out, static_cast<u32>(data.size()));
+    auto const begin { out.size() };
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    putU32(out, static_cast<u32>(crc32(0, out.data() + begin, static_cast<uInt>(out.size() - begin))));
+}
+
+bool writePng16(std::filesystem::path const& path, u32 x, u32 y, std::span<u16 const> values)
+{
+    if (x == 0 || y == 0 || values.size() < size_t { x } * y)
+        return false;
+
+    // no filtering, each row starts with filter type 0, samples are big endian
+    std::vector<u8> raw;
+    raw.reserve(size_t { y } * (1 + 2 * size_t { x }));
+    for (u32 row = 0; row < y; ++row) {
+        raw.push_back(0);
+        for (auto const v : values.subspan(size_t { row } * x, x)) {
+            raw.push_back(static_cast<u8>(v >> 8));
+            raw.push_back(static_cast<u8>(v));
+        }
+    }
+
+    auto compressedSize { compressBound(static_cast<uLong>(raw.size())) };
+    std::vector<u8> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, raw.data(), static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK)
+        return false;
+    compressed.resize(compressedSize);
+
+    // width, height, bit depth 16, grayscale, deflate, adaptive filtering, no interlace
+    std::vector<u8> header;
+    putU32(header, x);
+    putU32(header, y);
+    header.insert(header.end(), { 16, 0, 0, 0, 0 });
+
+    std::vector<u8> png { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", compressed);
+    putChunk(png, "IEND", {});
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<char const*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(out);
+}
+
+static bool writeMap(std::filesystem::path const& path, CostMaps const& maps, std::span<u32 const> values)
+{
+    std::vector<u16> pixels(values.size());
+    std::ranges::transform(values, pixels.begin(), [](u32 v) { return static_cast<u16>(std::min(v, 0xFFFFu)); });
+    return writePng16(path, maps.x, maps.y, pixels);
+}
+
+// nearest rank, costs are not empty
+static std::string histogramRow(std::string_view depth, std::string_view metric, std::vector<u32>& costs)
+{
+    static constexpr std::array percentiles { .1, .25, .5, .75, .9, .95, .99 };
+
+    std::ranges::sort(costs);
+    auto const mean { std::accumulate(costs.begin(), costs.end(), 0., [](f64 sum, u32 v) { return sum + v; }) / static_cast<f64>(costs.size()) };
+    auto row { fmt::format("{},{},{},{:.3f}", depth, metric, costs.size(), mean) };
+    for (auto const p : percentiles)
+        row += fmt::format(",{}", costs[static_cast<size_t>(p * static_cast<f64>(costs.size() - 1) + .5)]);
+    return row + fmt::format(",{}\n", costs.back());
+}
+
+bool writeCostMaps(std::filesystem::path const& prefix, CostMaps const& maps)
+{
+    auto const pixelCount { size_t { maps.x } * maps.y };
+    if (pixelCount == 0 || maps.pathLength.size() != pixelCount) {
+        berry::Log::error("Heat map: no costs recorded");
+        return false;
+    }
+
+    auto const file { [&prefix](std::string_view suffix) {
+        auto path { prefix };
+        path += suffix;
+        return path;
+    } };
+
+    std::ofstream histogram(file("_histogram.csv"));
+    if (!histogram) {
+        berry::Log::error("Heat map: can't write '{}'", file("_histogram.csv").generic_string());
+        return false;
+    }
+    histogram << "depth,metric,rays,mean,p10,p25,p50,p75,p90,p95,p99,max\n";
+
+    auto const depthCount { static_cast<u32>(*std::ranges::max_element(maps.pathLength)) };
+    bool ok { true };
+    std::vector<u32> pathNodes(pixelCount, 0);
+    std::vector<u32> pathTriangles(pixelCount, 0);
+    std::vector<u32> nodes;
+    std::vector<u32> triangles;
+    for (u32 depth = 0; depth < depthCount; ++depth) {
+        nodes.clear();
+        triangles.clear();
+        for (size_t i = 0; i < pixelCount; ++i) {
+            if (maps.pathLength[i] <= depth)
+                continue;
+            nodes.push_back(maps.traversedNodes[depth][i]);
+            triangles.push_back(maps.testedTriangles[depth][i]);
+            pathNodes[i] += maps.traversedNodes[depth][i];
+            pathTriangles[i] += maps.testedTriangles[depth][i];
+        }
+        histogram << histogramRow(fmt::format("{}", depth), "traversed_nodes", nodes);
+        histogram << histogramRow(fmt::format("{}", depth), "tested_triangles", triangles);
+
+        ok &= writeMap(file(fmt::format("_d{}_nodes.png", depth)), maps, maps.traversedNodes[depth]);
+        ok &= writeMap(file(fmt::format("_d{}_triangles.png", depth)), maps, maps.testedTriangles[depth]);
+    }
+
+    ok &= writeMap(file("_nodes.png"), maps, pathNodes);
+    ok &= writeMap(file("_triangles.png"), maps, pathTriangles);
+    histogram << histogramRow("path", "traversed_nodes", pathNodes);
+    histogram << histogramRow("path", "tested_triangles", pathTriangles);
+
+    if (!ok || !histogram)
+        berry::Log::error("Heat map: can't write all of '{}*'", prefix.generic_string());
+    return ok && static_cast<bool>(histogram);
+}
+
+}
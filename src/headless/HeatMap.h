@@ -0,0 +1,21 @@
+#pragma once
+
+#include "backend/cpu/bvh/Tracer.h"
+
+#include <filesystem>
+#include <span>
+
+namespace headless {
+
+// offline counterpart of the *_heat.comp kernels, from cpu::bvh::Tracer::CostMaps
+//   heat maps are 16-bit grayscale PNGs of the raw counts, saturated at 65535, maps of different pipelines compare as they are
+//   histograms are percentiles of the per ray counts over the rays of each depth, "path" is the sum over the depths of each pixel
+
+// grayscale, row 0 is the top of the image
+bool writePng16(std::filesystem::path const& path, u32 x, u32 y, std::span<u16 const> values);
+
+// <prefix>_nodes.png, <prefix>_triangles.png of whole paths, <prefix>_d<depth>_nodes.png, <prefix>_d<depth>_triangles.png of each traced depth,
+//   <prefix>_histogram.csv with the columns depth,metric,rays,mean,p10,p25,p50,p75,p90,p95,p99,max
+bool writeCostMaps(std::filesystem::path const& prefix, backend::cpu::bvh::Tracer::CostMaps const& maps);
+
+}
@@ -0,0 +1,321 @@
+#include "Report.h"
+
+#include <algorithm>
+#include <berries/lib_helper/spdlog.h>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+namespace headless {
+
+Summary summarize(std::span<f64 const> samples)
+{
+    Summary s;
+    s.count = static_cast<u32>(samples.size());
+    if (samples.empty())
+        return s;
+
+    std::vector<f64> sorted { samples.begin(), samples.end() };
+    std::ranges::sort(sorted);
+    auto const percentile { [&sorted](f64 p) {
+        auto const rank { p * static_cast<f64>(sorted.size() - 1) };
+        auto const lo { static_cast<size_t>(rank) };
+        auto const hi { std::min(lo + 1, sorted.size() - 1) };
+        return sorted[lo] + (rank - static_cast<f64>(lo)) * (sorted[hi] - sorted[lo]);
+    } };
+
+    s.mean = std::accumulate(sorted.begin(), sorted.end(), 0.) / static_cast<f64>(sorted.size());
+    s.median = percentile(.5);
+    s.p95 = percentile(.95);
+    s.min = sorted.front();
+    s.max = sorted.back();
+    if (sorted.size() > 1) {
+        f64 sum { 0. };
+        for (auto const v : sorted)
+            sum += (v - s.mean) * (v - s.mean);
+        s.stddev = std::sqrt(sum / static_cast<f64>(sorted.size() - 1));
+    }
+    return s;
+}
+
+static char const* to_string(Metric::Better better)
+{
+    switch (better) {
+    case Metric::Better::eLower:
+        return "lower";
+    case Metric::Better::eHigher:
+        return "higher";
+    case Metric::Better::eNone:
+        break;
+    }
+    return "";
+}
+
+// one metric per entry, samples appended per repetition
+class MetricSet {
+public:
+    MetricSet(std::vector<Metric>& metrics, BenchmarkResult const& result, std::string view)
+        : metrics(metrics)
+        , first(metrics.size())
+        , result(result)
+        , view(std::move(view))
+    {
+    }
+
+    void Add(std::string_view name, Metric::Better better, f64 value)
+    {
+        auto const it { std::find_if(metrics.begin() + static_cast<std::ptrdiff_t>(first), metrics.end(), [name](Metric const& m) { return m.name == name; }) };
+        if (it != metrics.end()) {
+            it->samples.push_back(value);
+            return;
+        }
+        metrics.push_back({ .scene = result.scene, .pipeline = result.pipeline, .view = view, .name = std::string(name), .better = better, .samples = { value } });
+    }
+
+    template<typename StageStats>
+    void AddStage(std::string_view stage, StageStats const& s)
+    {
+        auto const key { [stage](std::string_view name) { return fmt::format("{}.{}", stage, name); } };
+        Add(key("time_ms"), Metric::Better::eLower, s.timeTotal);
+        Add(key("cost_total"), Metric::Better::eLower, s.costTotal);
+        Add(key("sa_intersect"), Metric::Better::eLower, s.saIntersect);
+        Add(key("sa_traverse"), Metric::Better::eLower, s.saTraverse);
+        Add(key("node_count_total"), Metric::Better::eNone, s.nodeCountTotal);
+        Add(key("leaf_size_min"), Metric::Better::eNone, s.leafSizeMin);
+        Add(key("leaf_size_max"), Metric::Better::eNone, s.leafSizeMax);
+        Add(key("leaf_size_avg"), Metric::Better::eNone, s.leafSizeAvg);
+    }
+
+    void AddTrace(backend::stats::Trace const& t)
+    {
+        Add("primary_mrays_per_s", Metric::Better::eHigher, t.PrimaryMRaysPerSecond());
+        Add("secondary_mrays_per_s", Metric::Better::eHigher, t.SecondaryMRaysPerSecond());
+        auto const& p { t.data[0] };
+        if (p.rayCount > 0) {
+            Add("primary_nodes_per_ray", Metric::Better::eLower, static_cast<f64>(p.traversedNodes) / p.rayCount);
+            Add("primary_triangles_per_ray", Metric::Better::eLower, static_cast<f64>(p.testedTriangles) / p.rayCount);
+        }
+    }
+
+private:
+    std::vector<Metric>& metrics;
+    size_t first;
+    BenchmarkResult const& result;
+    std::string view;
+};
+
+std::vector<Metric> collectMetrics(std::span<BenchmarkResult const> results, std::span<backend::config::BVHPipeline const> pipelines)
+{
+    using backend::config::BV;
+    std::vector<Metric> metrics;
+    for (auto const& result : results) {
+        auto const config { std::ranges::find(pipelines, result.pipeline, &backend::config::BVHPipeline::name) };
+        if (config == pipelines.end())
+            continue;
+
+        MetricSet build { metrics, result, {} };
+        for (auto const& s : result.builds) {
+            build.Add("build.time_ms", Metric::Better::eLower, buildTimeMs(s));
+            build.AddStage("plocpp", s.plocpp);
+            if (s.plocpp.times.size() >= 4) {
+                build.Add("plocpp.init_ms", Metric::Better::eLower, s.plocpp.times[0]);
+                build.Add("plocpp.sort_ms", Metric::Better::eLower, s.plocpp.times[1]);
+                build.Add("plocpp.copy_ms", Metric::Better::eLower, s.plocpp.times[2]);
+                build.Add("plocpp.iterations_ms", Metric::Better::eLower, s.plocpp.times[3]);
+            }
+            if (config->collapsing.bv != BV::eNone)
+                build.AddStage("collapsing", s.collapsing);
+            if (config->transformation.bv != BV::eNone)
+                build.AddStage("transformation", s.transformation);
+            if (config->compression.bv != BV::eNone) {
+                build.AddStage("compression", s.compression);
+                build.Add("compression.memory_bytes", Metric::Better::eLower, static_cast<f64>(s.compression.memorySize));
+                if (config->reordering.order != backend::config::NodeOrder::eNone)
+                    build.Add("reordering.time_ms", Metric::Better::eLower, s.reordering.timeTotal);
+            }
+        }
+
+        for (u32 v = 0; v < result.traces.size(); ++v) {
+            MetricSet view { metrics, result, std::to_string(v) };
+            for (auto const& t : result.traces[v])
+                view.AddTrace(t);
+        }
+
+        // repetition r of all views as one trace
+        if (result.traces.size() > 1) {
+            MetricSet all { metrics, result, "all" };
+            for (u32 r = 0; r < result.traces.front().size(); ++r) {
+                backend::stats::Trace sum;
+                for (auto const& view : result.traces)
+                    for (u32 d = 0; d < sum.data.size(); ++d) {
+                        sum.data[d].rayCount += view[r].data[d].rayCount;
+                        sum.data[d].traceTimeMs += view[r].data[d].traceTimeMs;
+                        sum.data[d].traversedNodes += view[r].data[d].traversedNodes;
+                        sum.data[d].testedTriangles += view[r].data[d].testedTriangles;
+                        sum.data[d].dopTests += view[r].data[d].dopTests;
+                    }
+                all.AddTrace(sum);
+            }
+        }
+    }
+    return metrics;
+}
+
+static std::string jsonString(std::string_view s)
+{
+    std::string result { "\"" };
+    for (auto const c : s) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            result += fmt::format("\\u{:04x}", static_cast<u32>(c));
+        else
+            result += c;
+    }
+    return result + "\"";
+}
+
+// non-finite values are not valid JSON
+static f64 finite(f64 v)
+{
+    return std::isfinite(v) ? v : 0.;
+}
+
+bool writeJson(std::filesystem::path const& path, BenchmarkSettings const& settings, std::span<BenchmarkResult const> results, std::span<Metric const> metrics)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    out << "{\n";
+    out << fmt::format("  \"settings\": {{ \"warmup_count\": {}, \"repetition_count\": {}, \"resolution\": [{}, {}] }},\n", settings.warmupCount, settings.repetitionCount,
+        settings.resolution.x, settings.resolution.y);
+
+    out << "  \"runs\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto const& r { results[i] };
+        out << fmt::format("    {{ \"scene\": {}, \"pipeline\": {}, \"triangle_count\": {}, \"view_count\": {} }}{}\n", jsonString(r.scene), jsonString(r.pipeline), r.triangleCount,
+            r.traces.size(), i + 1 < results.size() ? "," : "");
+    }
+    out << "  ],\n";
+
+    out << "  \"metrics\": [\n";
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        auto const& m { metrics[i] };
+        auto const s { summarize(m.samples) };
+        std::vector<f64> samples;
+        std::ranges::transform(m.samples, std::back_inserter(samples), finite);
+        out << fmt::format("    {{ \"scene\": {}, \"pipeline\": {}, \"view\": {}, \"metric\": {}, \"better\": {}, ", jsonString(m.scene), jsonString(m.pipeline), jsonString(m.view),
+            jsonString(m.name), jsonString(to_string(m.better)));
+        out << fmt::format("\"count\": {}, \"mean\": {}, \"median\": {}, \"stddev\": {}, \"p95\": {}, \"min\": {}, \"max\": {}, \"samples\": [{}] }}{}\n", s.count, finite(s.mean),
+            finite(s.median), finite(s.stddev), finite(s.p95), finite(s.min), finite(s.max), fmt::join(samples, ", "), i + 1 < metrics.size() ? "," : "");
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+// RFC 4180, pipeline names are free text
+static std::string csvField(std::string_view s)
+{
+    if (s.find_first_of(",\"\n") == std::string_view::npos)
+        return std::string(s);
+    std::string result { "\"" };
+    for (auto const c : s) {
+        if (c == '"')
+            result += '"';
+        result += c;
+    }
+    return result + "\"";
+}
+
+static std::vector<std::string> splitCsv(std::string_view line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted { false };
+    for (size_t i = 0; i < line.size(); ++i) {
+        auto const c { line[i] };
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+                fields.back() += line[++i];
+            else if (c == '"')
+                quoted = false;
+            else
+                fields.back() += c;
+        } else if (c == '"')
+            quoted = true;
+        else if (c == ',')
+            fields.emplace_back();
+        else if (c != '\r')
+            fields.back() += c;
+    }
+    return fields;
+}
+
+static constexpr std::string_view CSV_HEADER { "scene,pipeline,view,metric,better,count,mean,median,stddev,p95,min,max" };
+static constexpr size_t CSV_MEDIAN { 7 };
+
+bool writeCsv(std::filesystem::path const& path, std::span<Metric const> metrics)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    out << CSV_HEADER << "\n";
+    for (auto const& m : metrics) {
+        auto const s { summarize(m.samples) };
+        out << fmt::format("{},{},{},{},{},{},{},{},{},{},{},{}\n", csvField(m.scene), csvField(m.pipeline), csvField(m.view), csvField(m.name), to_string(m.better), s.count, s.mean,
+            s.median, s.stddev, s.p95, s.min, s.max);
+    }
+    return static_cast<bool>(out);
+}
+
+i32 compare(std::span<Metric const> metrics, std::filesystem::path const& baseline, f64 threshold)
+{
+    std::ifstream in(baseline);
+    std::string line;
+    if (!in || !std::getline(in, line) || !line.starts_with(CSV_HEADER)) {
+        berry::Log::error("Can't read baseline '{}'", baseline.generic_string());
+        return -1;
+    }
+
+    using Key = std::tuple<std::string, std::string, std::string, std::string>;
+    std::map<Key, f64> medians;
+    while (std::getline(in, line)) {
+        auto const fields { splitCsv(line) };
+        if (fields.size() <= CSV_MEDIAN)
+            continue;
+        medians[{ fields[0], fields[1], fields[2], fields[3] }] = std::strtod(fields[CSV_MEDIAN].c_str(), nullptr);
+    }
+
+    i32 regressions { 0 };
+    u32 improvements { 0 };
+    u32 compared { 0 };
+    for (auto const& m : metrics) {
+        if (m.better == Metric::Better::eNone)
+            continue;
+        auto const it { medians.find({ m.scene, m.pipeline, m.view, m.name }) };
+        if (it == medians.end() || it->second == 0.)
+            continue;
+
+        ++compared;
+        auto const current { summarize(m.samples).median };
+        auto const change { (current - it->second) / std::abs(it->second) };
+        auto const worse { m.better == Metric::Better::eLower ? change : -change };
+        auto const where { fmt::format("{} / {}{}{}: {}", m.scene, m.pipeline, m.view.empty() ? "" : " / view ", m.view, m.name) };
+        if (worse > threshold) {
+            ++regressions;
+            berry::Log::warn("Regression {}: {:.4g} -> {:.4g} ({:+.2f} %)", where, it->second, current, 100. * change);
+        } else if (worse < -threshold) {
+            ++improvements;
+            berry::Log::info("Improvement {}: {:.4g} -> {:.4g} ({:+.2f} %)", where, it->second, current, 100. * change);
+        }
+    }
+    berry::Log::info("Compared {} metrics against '{}' at {:.1f} %: {} regression(s), {} improvement(s)", compared, baseline.generic_string(), 100. * threshold, regressions, improvements);
+    return regressions;
+}
+
+}
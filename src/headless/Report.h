@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Benchmark.h"
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace headless {
+
+// mean, median, stddev (sample) and p95 (linear between the closest ranks) over the repetitions
+struct Summary {
+    u32 count { 0 };
+    f64 mean { 0. };
+    f64 median { 0. };
+    f64 stddev { 0. };
+    f64 p95 { 0. };
+    f64 min { 0. };
+    f64 max { 0. };
+};
+
+[[nodiscard]] Summary summarize(std::span<f64 const> samples);
+
+// one measured value of a (scene, pipeline, view) over all repetitions
+//   view is empty for the build metrics, "all" for the rays of all views together, as pMRps / sMRps of Benchmark::ExportPipeline
+struct Metric {
+    enum class Better {
+        eNone,
+        eLower,
+        eHigher,
+    };
+
+    std::string scene;
+    std::string pipeline;
+    std::string view;
+    std::string name;
+    Better better { Better::eNone };
+    std::vector<f64> samples;
+};
+
+[[nodiscard]] std::vector<Metric> collectMetrics(std::span<BenchmarkResult const> results, std::span<backend::config::BVHPipeline const> pipelines);
+
+// the JSON also keeps the samples, the CSV has one summary per row and is the baseline format of compare()
+bool writeJson(std::filesystem::path const& path, BenchmarkSettings const& settings, std::span<BenchmarkResult const> results, std::span<Metric const> metrics);
+bool writeCsv(std::filesystem::path const& path, std::span<Metric const> metrics);
+
+// medians against the baseline CSV, a metric regresses if it gets worse by more than threshold (relative)
+//   metrics without a direction or missing in the baseline are skipped, returns the regression count or -1 if the baseline can't be read
+i32 compare(std::span<Metric const> metrics, std::filesystem::path const& baseline, f64 threshold);
+
+}
@@ -0,0 +1,458 @@
+// dopbvh-build: batch BVH construction on the CPU, no window and no Vulkan
+//   builds every (scene, pipeline) pair of benchmark.toml, or the ones given on the command line, and writes
+//   <out>/<scene>/<pipeline>.bvh (see backend/cpu/bvh/Serialization.h) and <out>/<scene>/<pipeline>.stats.toml
+//   with --evaluate it only loads '*.bvh' files and logs their SAH cost and tree shape
+//   with --cache the built BVHs are also kept by scene and pipeline hash, later runs load them instead of building
+//   with --run it benchmarks build and trace of every (scene, pipeline, camera view) instead, see Benchmark.h
+//     the summaries over the repetitions go to --json / --csv, --compare checks them against a baseline CSV, see Report.h
+//     --heat-maps adds per pixel traversal cost maps and histograms of each view, see HeatMap.h
+//   with --profile the profiler zones of the whole run are written as a Chrome trace, see core/Profiler.h
+
+#include "Benchmark.h"
+#include "Report.h"
+#include "backend/cpu/Builder.h"
+#include "backend/cpu/bvh/Serialization.h"
+#include "core/Config.h"
+#include "core/Profiler.h"
+#include "scene/SceneCache.h"
+#include "scene/SceneIO.h"
+#include "scene/Serialization.h"
+#include "util/pexec.h"
+
+#include <berries/lib_helper/spdlog.h>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+struct Arguments {
+    std::filesystem::path res;
+    std::filesystem::path sceneConfig;
+    std::filesystem::path benchmarkConfig;
+    std::filesystem::path out { "bvh" };
+    std::vector<std::string> scenes;
+    std::vector<std::string> pipelines;
+    std::vector<std::filesystem::path> evaluate;
+    std::filesystem::path cache;
+    std::filesystem::path profile;
+    u32 threadCount { std::thread::hardware_concurrency() };
+
+    bool run { false };
+    headless::BenchmarkSettings benchmark;
+    std::filesystem::path json;
+    std::filesystem::path csv;
+    std::filesystem::path baseline;
+    f64 threshold { .05 };
+};
+
+void printUsage()
+{
+    fmt::print("usage: dopbvh-build [options]\n"
+               "  -c, --config <file>     scene list, default <res>/scene.toml\n"
+               "  -b, --benchmark <file>  pipelines, default <res>/benchmark.toml\n"
+               "  -s, --scene <name>      scene to build, repeatable, default benchmark_scenes\n"
+               "  -p, --pipeline <name>   pipeline to build, repeatable, default benchmark_config\n"
+               "  -o, --out <dir>         output directory, default ./bvh\n"
+               "  -j, --threads <count>   worker threads, default all hardware threads\n"
+               "      --cache <dir>       BVH cache, built BVHs are loaded from and stored to it, default off\n"
+               "      --profile <file>    Chrome trace of the profiler zones, open in ui.perfetto.dev\n"
+               "  -e, --evaluate <file>   stats of a stored '*.bvh' instead of building, repeatable,\n"
+               "                          stats constants of the first pipeline\n"
+               "  -r, --run               build and trace each camera view of the scenes instead, nothing is written\n"
+               "      --warmup <count>    untimed builds and traces before the repetitions, default 1\n"
+               "      --repetitions <n>   timed builds and traces per pipeline and view, default 5\n"
+               "      --resolution <WxH>  traced resolution, default 1280x720\n"
+               "      --trace-mode <mode> primary ray kernel, [single, packet, stream], default single\n"
+               "      --heat-maps <dir>   16-bit PNG traversal cost maps and cost percentiles of each view\n"
+               "      --json <file>       benchmark summaries and samples\n"
+               "      --csv <file>        benchmark summaries, one metric per row\n"
+               "      --compare <file>    fails on regressions of the medians against a --csv file of an earlier run\n"
+               "      --threshold <pct>   relative change counted as regression, default 5\n");
+}
+
+// same lookup as the viewer: 'data' next to the binary, in the working directory or in any parent of the binary
+std::filesystem::path locateResources()
+{
+    auto const bin { pexec::get_path_to_executable().parent_path() };
+    if (auto const res { bin / "data" }; std::filesystem::exists(res))
+        return res;
+    if (auto const res { std::filesystem::current_path() / "data" }; std::filesystem::exists(res))
+        return res;
+    for (auto path { bin }; path != bin.root_path(); path = path.parent_path())
+        if (auto const res { path / "data" }; std::filesystem::exists(res))
+            return res;
+    return {};
+}
+
+bool parseArguments(int argc, char* argv[], Arguments& args)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg { argv[i] };
+        if (arg == "-h" || arg == "--help")
+            return false;
+        if (arg == "-r" || arg == "--run") {
+            args.run = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            berry::Log::error("Missing value for '{}'", arg);
+            return false;
+        }
+
+        std::string_view const value { argv[++i] };
+        if (arg == "-c" || arg == "--config")
+            args.sceneConfig = value;
+        else if (arg == "-b" || arg == "--benchmark")
+            args.benchmarkConfig = value;
+        else if (arg == "-s" || arg == "--scene")
+            args.scenes.emplace_back(value);
+        else if (arg == "-p" || arg == "--pipeline")
+            args.pipelines.emplace_back(value);
+        else if (arg == "-o" || arg == "--out")
+            args.out = value;
+        else if (arg == "-j" || arg == "--threads")
+            args.threadCount = std::max(1u, static_cast<u32>(std::stoul(std::string(value))));
+        else if (arg == "-e" || arg == "--evaluate")
+            args.evaluate.emplace_back(value);
+        else if (arg == "--cache")
+            args.cache = value;
+        else if (arg == "--profile")
+            args.profile = value;
+        else if (arg == "--warmup")
+            args.benchmark.warmupCount = static_cast<u32>(std::stoul(std::string(value)));
+        else if (arg == "--repetitions")
+            args.benchmark.repetitionCount = std::max(1u, static_cast<u32>(std::stoul(std::string(value))));
+        else if (arg == "--resolution") {
+            auto const x { value.find('x') };
+            if (x == std::string_view::npos) {
+                berry::Log::error("Resolution '{}' is not <width>x<height>", value);
+                return false;
+            }
+            args.benchmark.resolution = { static_cast<u32>(std::stoul(std::string(value.substr(0, x)))), static_cast<u32>(std::stoul(std::string(value.substr(x + 1)))) };
+        } else if (arg == "--trace-mode") {
+            using Mode = backend::cpu::bvh::Tracer::Mode;
+            if (value == "single")
+                args.benchmark.traceMode = Mode::eSingleRay;
+            else if (value == "packet")
+                args.benchmark.traceMode = Mode::ePacket;
+            else if (value == "stream")
+                args.benchmark.traceMode = Mode::eStream;
+            else {
+                berry::Log::error("Unknown trace mode '{}'", value);
+                return false;
+            }
+        } else if (arg == "--heat-maps")
+            args.benchmark.heatMapDir = value;
+        else if (arg == "--json")
+            args.json = value;
+        else if (arg == "--csv")
+            args.csv = value;
+        else if (arg == "--compare")
+            args.baseline = value;
+        else if (arg == "--threshold")
+            args.threshold = std::stod(std::string(value)) * .01;
+        else {
+            berry::Log::error("Unknown option '{}'", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+// '*.ob' directly, imported scenes through the same cache as the viewer
+Scene loadScene(Config::Scene const& config, std::filesystem::path const& res, Executor& executor)
+{
+    if (!config.bin.empty())
+        return scene::deserialize(config.bin, executor);
+
+    std::filesystem::path const path { config.path };
+    if (!std::filesystem::exists(path)) {
+        berry::Log::error("File does not exist: {}", config.path);
+        return {};
+    }
+
+    auto const cacheDir { res / "scene" / "cache" };
+    auto const cachePath { scene::cache::entry(cacheDir, scene::cache::makeKey(path, SceneIO::IMPORT_FLAGS, SceneIO::GEOMETRY_GLOBAL_SCALE)) };
+    if (std::filesystem::exists(cachePath)) {
+        auto result { scene::deserialize(cachePath, executor) };
+        if (!result.nodes.empty())
+            return result;
+    }
+
+    SceneIO io;
+    io.ImportScene(path.generic_string());
+    auto result { io.CreateSceneStreaming(executor) };
+    static_cast<void>(scene::cache::store(cachePath, result));
+    return result;
+}
+
+template<typename StageStats>
+void writeStage(std::ostream& out, std::string_view stage, StageStats const& s)
+{
+    out << fmt::format("\n[{}]\n", stage);
+    out << fmt::format("time_total_ms = {}\n", s.timeTotal);
+    out << fmt::format("cost_total = {}\n", s.costTotal);
+    out << fmt::format("sa_intersect = {}\n", s.saIntersect);
+    out << fmt::format("sa_traverse = {}\n", s.saTraverse);
+    out << fmt::format("node_count_total = {}\n", s.nodeCountTotal);
+    out << fmt::format("leaf_size_min = {}\n", s.leafSizeMin);
+    out << fmt::format("leaf_size_max = {}\n", s.leafSizeMax);
+    out << fmt::format("leaf_size_avg = {}\n", s.leafSizeAvg);
+}
+
+void writeShape(std::ostream& out, backend::stats::Shape const& s)
+{
+    std::vector<u32> interiorCount, leafCount, triangleCount;
+    std::vector<f32> saTraverse, saIntersect;
+    for (auto const& d : s.depths) {
+        interiorCount.push_back(d.interiorCount);
+        leafCount.push_back(d.leafCount);
+        triangleCount.push_back(d.triangleCount);
+        saTraverse.push_back(d.saTraverse);
+        saIntersect.push_back(d.saIntersect);
+    }
+
+    out << "\n[shape]\n";
+    out << fmt::format("time_total_ms = {}\n", s.timeTotal);
+    out << fmt::format("sa_overlap = {}\n", s.saOverlap);
+    out << fmt::format("epo = {}\n", s.epo);
+    out << fmt::format("epo_sample_count = {}\n", s.epoSampleCount);
+    out << fmt::format("leaf_size_histogram = [{}]\n", fmt::join(s.leafSizeHistogram, ", "));
+    out << fmt::format("interior_count_per_depth = [{}]\n", fmt::join(interiorCount, ", "));
+    out << fmt::format("leaf_count_per_depth = [{}]\n", fmt::join(leafCount, ", "));
+    out << fmt::format("triangle_count_per_depth = [{}]\n", fmt::join(triangleCount, ", "));
+    out << fmt::format("sa_traverse_per_depth = [{}]\n", fmt::join(saTraverse, ", "));
+    out << fmt::format("sa_intersect_per_depth = [{}]\n", fmt::join(saIntersect, ", "));
+}
+
+void writeReport(std::filesystem::path const& path, std::string_view sceneName, Scene const& scene, backend::config::BVHPipeline const& pipeline, backend::stats::BVHPipeline const& stats)
+{
+    std::ofstream out(path);
+    out << fmt::format("scene = \"{}\"\n", sceneName);
+    out << fmt::format("pipeline = \"{}\"\n", pipeline.name);
+    out << fmt::format("triangle_count = {}\n", scene.triangleCount);
+
+    writeStage(out, "plocpp", stats.plocpp);
+    out << fmt::format("times_ms = [{}]\n", fmt::join(stats.plocpp.times, ", "));
+    out << fmt::format("iteration_count = {}\n", stats.plocpp.iterationCount);
+    if (pipeline.collapsing.bv != backend::config::BV::eNone)
+        writeStage(out, "collapsing", stats.collapsing);
+    if (pipeline.transformation.bv != backend::config::BV::eNone)
+        writeStage(out, "transformation", stats.transformation);
+    if (pipeline.compression.bv != backend::config::BV::eNone) {
+        writeStage(out, "compression", stats.compression);
+        out << fmt::format("memory_bytes = {}\n", stats.compression.memorySize);
+    }
+    if (pipeline.compression.bv != backend::config::BV::eNone && pipeline.reordering.order != backend::config::NodeOrder::eNone) {
+        out << "\n[reordering]\n";
+        out << fmt::format("time_total_ms = {}\n", stats.reordering.timeTotal);
+        out << fmt::format("page_local_ratio = {}\n", stats.reordering.pageLocalRatio);
+    }
+    if (!stats.shape.depths.empty())
+        writeShape(out, stats.shape);
+}
+
+// the scene is unknown, its AABB is fitted to the stored triangles
+i32 evaluate(std::vector<std::filesystem::path> const& paths, backend::config::Stats config, Executor& executor)
+{
+    backend::cpu::bvh::Stats stats { executor };
+    i32 failures { 0 };
+    for (auto const& path : paths) {
+        auto const bvh { backend::cpu::bvh::deserialize(path) };
+        if (bvh.nodeCountTotal == 0) {
+            berry::Log::error("Can't read '{}'", path.generic_string());
+            ++failures;
+            continue;
+        }
+
+        config.bv = bvh.bv;
+        stats.Compute(config, bvh);
+        stats.ComputeShape(config, bvh);
+        auto const& d { stats.data };
+        berry::Log::info("{}: {} nodes, {} triangles", path.generic_string(), bvh.nodeCountTotal, bvh.triangles.size());
+        berry::Log::info("    Cost total: {:.2f}", d.costIntersect + d.costTraverse);
+        berry::Log::info("{:>17.2f}  - area intersect", d.saIntersect);
+        berry::Log::info("{:>17.2f}  - area traverse", d.saTraverse);
+        stats.shape.print();
+    }
+    return failures;
+}
+
+
+// every run is logged as it finishes, the scene is loaded once for all pipelines, regressions count as failures
+i32 runBenchmark(Arguments const& args, std::vector<backend::config::BVHPipeline> const& pipelines, Executor& executor)
+{
+    if (!args.benchmark.heatMapDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(args.benchmark.heatMapDir, ec);
+    }
+
+    headless::Benchmark benchmark { executor, args.benchmark };
+    berry::Log::info("dopbvh-build --run: {} scene(s) x {} pipeline(s), {} warm-up + {} repetitions, {}x{}, {} threads", args.scenes.size(), args.pipelines.size(),
+        args.benchmark.warmupCount, args.benchmark.repetitionCount, args.benchmark.resolution.x, args.benchmark.resolution.y, executor.num_workers());
+
+    i32 failures { 0 };
+    std::vector<headless::BenchmarkResult> results;
+    for (auto const& sceneName : args.scenes) {
+        auto const sceneConfig { Config::GetScene(sceneName) };
+        if (sceneConfig.name.empty()) {
+            berry::Log::error("Unknown scene '{}'", sceneName);
+            ++failures;
+            continue;
+        }
+        auto const scene { loadScene(sceneConfig, args.res, executor) };
+        if (scene.triangleCount == 0) {
+            berry::Log::error("Scene '{}' failed to load", sceneName);
+            ++failures;
+            continue;
+        }
+        auto const views { headless::loadViews(sceneConfig.camera, scene) };
+        berry::Log::info("Scene '{}': {} triangles, {} view(s)", sceneName, scene.triangleCount, views.size());
+
+        for (auto const& pipelineName : args.pipelines) {
+            auto const pipeline { std::ranges::find(pipelines, pipelineName, &backend::config::BVHPipeline::name) };
+            if (pipeline == pipelines.end()) {
+                berry::Log::error("Unknown pipeline '{}'", pipelineName);
+                ++failures;
+                continue;
+            }
+
+            berry::Log::info("{} / {}:", sceneName, pipelineName);
+            auto result { benchmark.Run(sceneName, scene, views, *pipeline) };
+            if (!result) {
+                ++failures;
+                continue;
+            }
+            results.push_back(std::move(*result));
+        }
+    }
+
+    auto const metrics { headless::collectMetrics(results, pipelines) };
+    if (!args.json.empty() && !headless::writeJson(args.json, args.benchmark, results, metrics)) {
+        berry::Log::error("Can't write '{}'", args.json.generic_string());
+        ++failures;
+    }
+    if (!args.csv.empty() && !headless::writeCsv(args.csv, metrics)) {
+        berry::Log::error("Can't write '{}'", args.csv.generic_string());
+        ++failures;
+    }
+    if (!args.baseline.empty()) {
+        auto const regressions { headless::compare(metrics, args.baseline, args.threshold) };
+        failures += regressions < 0 ? 1 : regressions;
+    }
+    return failures;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    berry::Log::Init();
+
+    Arguments args;
+    if (!parseArguments(argc, argv, args)) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // written on every return path
+    struct ProfileExport {
+        std::filesystem::path path;
+        ~ProfileExport()
+        {
+            if (!path.empty())
+                profiler::ExportChromeTrace(path);
+        }
+    } const profileExport { args.profile };
+    if (!args.profile.empty()) {
+        profiler::SetThreadName("main");
+        profiler::Enable(true);
+    }
+
+    args.res = locateResources();
+    if (args.sceneConfig.empty())
+        args.sceneConfig = args.res / "scene.toml";
+    if (args.benchmarkConfig.empty())
+        args.benchmarkConfig = args.res / "benchmark.toml";
+    if (!std::filesystem::exists(args.sceneConfig) || !std::filesystem::exists(args.benchmarkConfig)) {
+        berry::Log::error("Can't locate '{}' or '{}'.", args.sceneConfig.generic_string(), args.benchmarkConfig.generic_string());
+        return EXIT_FAILURE;
+    }
+
+    Config::ReadConfigFile(args.sceneConfig, args.res);
+    std::vector<std::string> benchmarkScenes;
+    std::vector<std::string> benchmarkPipelines;
+    auto const pipelines { Config::GetBVHPipelines(args.benchmarkConfig, benchmarkScenes, benchmarkPipelines) };
+    if (args.scenes.empty())
+        args.scenes = benchmarkScenes;
+    if (args.pipelines.empty())
+        args.pipelines = benchmarkPipelines;
+
+    Executor executor { args.threadCount };
+    if (!args.evaluate.empty()) {
+        auto const pipeline { args.pipelines.empty() ? pipelines.end() : std::ranges::find(pipelines, args.pipelines.front(), &backend::config::BVHPipeline::name) };
+        return evaluate(args.evaluate, pipeline == pipelines.end() ? backend::config::Stats {} : pipeline->stats, executor) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (args.run)
+        return runBenchmark(args, pipelines, executor) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    backend::cpu::Builder builder { executor };
+    builder.SetCacheDirectory(args.cache);
+    berry::Log::info("dopbvh-build: {} scene(s) x {} pipeline(s), {} threads", args.scenes.size(), args.pipelines.size(), executor.num_workers());
+
+    i32 failures { 0 };
+    for (auto const& sceneName : args.scenes) {
+        auto const sceneConfig { Config::GetScene(sceneName) };
+        if (sceneConfig.name.empty()) {
+            berry::Log::error("Unknown scene '{}'", sceneName);
+            ++failures;
+            continue;
+        }
+
+        auto const loadStart { std::chrono::steady_clock::now() };
+        auto const scene { loadScene(sceneConfig, args.res, executor) };
+        if (scene.triangleCount == 0) {
+            berry::Log::error("Scene '{}' failed to load", sceneName);
+            ++failures;
+            continue;
+        }
+        berry::Log::info("Scene '{}': {} triangles, loaded in {:.2f} s", sceneName, scene.triangleCount, std::chrono::duration<f32>(std::chrono::steady_clock::now() - loadStart).count());
+
+        auto const outDir { args.out / headless::fileName(sceneName) };
+        std::error_code ec;
+        std::filesystem::create_directories(outDir, ec);
+
+        builder.Invalidate();
+        for (auto const& pipelineName : args.pipelines) {
+            auto const pipeline { std::ranges::find(pipelines, pipelineName, &backend::config::BVHPipeline::name) };
+            if (pipeline == pipelines.end()) {
+                berry::Log::error("Unknown pipeline '{}'", pipelineName);
+                ++failures;
+                continue;
+            }
+
+            builder.SetPipelineConfiguration(*pipeline);
+            builder.Build(scene);
+            if (builder.Failed()) {
+                berry::Log::error("{} / {}: build failed", sceneName, pipelineName);
+                ++failures;
+                continue;
+            }
+
+            berry::Log::info("{} / {}:", sceneName, pipelineName);
+            builder.GetStatsBuild().print();
+
+            auto const path { outDir / headless::fileName(pipelineName) };
+            if (!backend::cpu::bvh::serializeToFile(builder.GetBVH(), path.generic_string() + ".bvh")) {
+                berry::Log::error("Can't write '{}.bvh'", path.generic_string());
+                ++failures;
+                continue;
+            }
+            writeReport(path.generic_string() + ".stats.toml", sceneName, scene, *pipeline, builder.GetStatsBuild());
+        }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "backend/cpu/Builder.h"
+#include "scene/Scene.h"
+#include <berries/lib_helper/spdlog.h>
+#include <cstring>
+#include <random>
+
+using namespace backend;
+
+// small triangles spread over a box, different seeds give different scenes
+static Scene randomScene(u32 seed, u32 triangleCount)
+{
+    std::mt19937 gen { seed };
+    std::uniform_real_distribution<f32> coord { -1.f, 1.f };
+    std::uniform_real_distribution<f32> offset { -.05f, .05f };
+    Scene scene;
+    auto& g { scene.geometries.emplace_back() };
+    for (u32 i = 0; i < triangleCount; ++i) {
+        glm::vec3 const center { coord(gen), coord(gen), coord(gen) };
+        for (u32 v = 0; v < 3; ++v) {
+            g.indices.push_back(static_cast<u32>(g.vertices.size()));
+            scene.aabb.Fit(g.vertices.emplace_back(center + glm::vec3 { offset(gen), offset(gen), offset(gen) }));
+        }
+    }
+    scene.triangleCount = triangleCount;
+    return scene;
+}
+
+static config::BVHPipeline aabbPipeline(f32 c_t)
+{
+    config::BVHPipeline p;
+    p.plocpp.bv = config::BV::eAABB;
+    p.collapsing.bv = config::BV::eAABB;
+    p.collapsing.c_t = c_t;
+    p.compression.bv = config::BV::eAABB;
+    return p;
+}
+
+static bool sameBvh(cpu::bvh::Bvh const& a, cpu::bvh::Bvh const& b)
+{
+    return a.nodeCountTotal == b.nodeCountTotal && a.nodeCountLeaf == b.nodeCountLeaf && a.layout == b.layout && a.nodes == b.nodes && a.aux == b.aux
+        && a.triangleIDs.size() == b.triangleIDs.size() && std::memcmp(a.triangleIDs.data(), b.triangleIDs.data(), a.triangleIDs.size() * sizeof(data_bvh::BvhTriangleIndex)) == 0;
+}
+
+// the pipelines share PLOC++, a scene change must not keep the PLOC++ tree of the previous scene
+TEST_CASE("Builder rebuilds every stage after a scene change", "[builder]")
+{
+    // the stages log their progress
+    berry::Log::Init();
+    Executor executor { 2 };
+    auto const sceneA { randomScene(1, 3000) };
+    auto const sceneB { randomScene(2, 2000) };
+    auto const pipeline0 { aabbPipeline(3.f) };
+    auto const pipeline1 { aabbPipeline(6.f) };
+
+    cpu::Builder builder { executor };
+    for (auto const& p : { pipeline0, pipeline1 }) {
+        builder.SetPipelineConfiguration(p);
+        REQUIRE(builder.Build(sceneA));
+    }
+
+    builder.Invalidate();
+    for (auto const& p : { pipeline0, pipeline1 }) {
+        builder.SetPipelineConfiguration(p);
+        REQUIRE(builder.Build(sceneB));
+
+        cpu::Builder fresh { executor };
+        fresh.SetPipelineConfiguration(p);
+        REQUIRE(fresh.Build(sceneB));
+        REQUIRE(builder.GetBVH().nodeCountTotal > 0);
+        REQUIRE(sameBvh(builder.GetBVH(), fresh.GetBVH()));
+    }
+}
+
+// a rejected compression leaves no BVH behind, not even the one of the previous pipeline
+TEST_CASE("Builder reports a rejected compression as failed", "[builder]")
+{
+    berry::Log::Init();
+    Executor executor { 2 };
+    auto const scene { randomScene(3, 2000) };
+    auto const pipeline { aabbPipeline(3.f) };
+
+    cpu::Builder builder { executor };
+    builder.SetPipelineConfiguration(pipeline);
+    REQUIRE(builder.Build(scene));
+    REQUIRE_FALSE(builder.Failed());
+
+    auto mismatched { pipeline };
+    mismatched.compression.bv = config::BV::eDOP14;
+    builder.SetPipelineConfiguration(mismatched);
+    builder.Build(scene);
+    REQUIRE(builder.Failed());
+    REQUIRE(builder.GetBVH().nodeCountTotal == 0);
+
+    // only the reordering runs again, on the empty compressed BVH
+    mismatched.reordering.order = config::NodeOrder::eDFS;
+    builder.SetPipelineConfiguration(mismatched);
+    builder.Build(scene);
+    REQUIRE(builder.Failed());
+    REQUIRE(builder.GetBVH().nodeCountTotal == 0);
+
+    builder.SetPipelineConfiguration(pipeline);
+    REQUIRE(builder.Build(scene));
+    REQUIRE_FALSE(builder.Failed());
+    cpu::Builder fresh { executor };
+    fresh.SetPipelineConfiguration(pipeline);
+    REQUIRE(fresh.Build(scene));
+    REQUIRE(sameBvh(builder.GetBVH(), fresh.GetBVH()));
+}
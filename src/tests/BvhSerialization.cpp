@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "backend/cpu/bvh/Serialization.h"
+#include <fstream>
+#include <iterator>
+
+using namespace backend;
+using namespace backend::cpu::bvh;
+
+// 2 leaves under a root, the buffers are only checked for their sizes
+static Bvh smallBvh()
+{
+    Bvh bvh;
+    bvh.bv = config::BV::eAABB;
+    bvh.layout = Bvh::Layout::eBinaryStandard;
+    bvh.nodeCountLeaf = 2;
+    bvh.nodeCountTotal = 3;
+    bvh.nodes.resize(3 * sizeof(data_bvh::NodeBvhBinary));
+    for (size_t i = 0; i < bvh.nodes.size(); ++i)
+        bvh.nodes[i] = static_cast<std::byte>(i);
+    bvh.triangles.resize(2);
+    bvh.triangleIDs.resize(2);
+    return bvh;
+}
+
+static std::vector<char> readFile(std::filesystem::path const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(in), {} };
+}
+
+static void writeFile(std::filesystem::path const& path, std::vector<char> const& data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+TEST_CASE("BVH files round trip and foreign ones are rejected", "[bvh]")
+{
+    auto const path { std::filesystem::temp_directory_path() / "dopbvh_test.bvh" };
+    auto const bvh { smallBvh() };
+    REQUIRE(serializeToFile(bvh, path));
+    auto const original { readFile(path) };
+
+    auto const loaded { deserialize(path) };
+    REQUIRE(loaded.nodeCountTotal == 3);
+    REQUIRE(loaded.nodes == bvh.nodes);
+    REQUIRE(loaded.triangleIDs.size() == 2);
+
+    // header: magic, version, section count, bv, layout, leaf count, total count
+    auto const patched { [&](size_t offset, u32 value) {
+        auto data { original };
+        memcpy(data.data() + offset, &value, sizeof(value));
+        writeFile(path, data);
+        return deserialize(path).nodeCountTotal;
+    } };
+    REQUIRE(patched(12, 7) == 0);
+    REQUIRE(patched(16, 42) == 0);
+    REQUIRE(patched(16, static_cast<u32>(Bvh::Layout::eBinaryCompressed)) == 0);
+    REQUIRE(patched(20, 3) == 0);
+    REQUIRE(patched(24, 4) == 0);
+    REQUIRE(patched(24, 0) == 0);
+    // section table after the 32 B header: type, padding, offset, size of nodes, triangles, triangle ids, aux
+    REQUIRE(patched(32 + 24 + 16, static_cast<u32>(2 * sizeof(data_bvh::BvhTriangle) - 4)) == 0);
+    REQUIRE(patched(32 + 24, 0) == 0);
+
+    SECTION("truncated")
+    {
+        for (auto const size : { size_t { 16 }, size_t { 40 }, original.size() - 1 }) {
+            writeFile(path, { original.begin(), original.begin() + static_cast<std::ptrdiff_t>(size) });
+            REQUIRE(deserialize(path).nodeCountTotal == 0);
+        }
+    }
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,311 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "scene/GeometryCodec.h"
+#include "scene/Serialization.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace scene;
+
+static std::vector<glm::vec3> randomPositions(u32 count, f32 extent)
+{
+    std::mt19937 gen { 42 };
+    std::uniform_real_distribution<f32> dist { -extent, extent };
+    std::vector<glm::vec3> result(count);
+    for (auto& p : result)
+        p = { dist(gen), dist(gen) * .5f, dist(gen) * .1f };
+    return result;
+}
+
+static std::vector<glm::vec3> randomNormals(u32 count)
+{
+    std::mt19937 gen { 7 };
+    std::normal_distribution<f32> dist;
+    std::vector<glm::vec3> result(count);
+    for (auto& n : result)
+        n = glm::normalize(glm::vec3 { dist(gen), dist(gen), dist(gen) });
+    // axis aligned normals hit the octahedron folds
+    result[0] = { 0.f, 0.f, 1.f };
+    result[1] = { 0.f, 0.f, -1.f };
+    result[2] = { -1.f, 0.f, 0.f };
+    result[3] = { 0.f, 1.f, 0.f };
+    return result;
+}
+
+static std::vector<u32> randomIndices(u32 triangleCount, u32 vertexCount)
+{
+    std::mt19937 gen { 3 };
+    std::uniform_int_distribution<u32> local { 0, 64 };
+    std::uniform_int_distribution<u32> any { 0, vertexCount - 1 };
+    std::vector<u32> result(triangleCount * 3);
+    for (u32 i = 0; i < result.size(); ++i)
+        result[i] = (i % 97 == 0) ? any(gen) : std::min(vertexCount - 1, i / 3 + local(gen));
+    return result;
+}
+
+template<typename T, typename Decode>
+static std::vector<T> decodeAll(std::vector<std::byte> const& block, Decode decode)
+{
+    std::vector<T> result(codec::header(block).elementCount);
+    for (u32 c = 0; c < codec::header(block).chunkCount; ++c)
+        REQUIRE(decode(block, c, std::span<T> { result }));
+    return result;
+}
+
+TEST_CASE("Geometry codec round trip", "[codec]")
+{
+    // spans more than one chunk to cover chunk boundaries
+    u32 constexpr vertexCount { codec::CHUNK_ELEMENTS + 1234 };
+    auto const positions { randomPositions(vertexCount, 250.f) };
+    auto const normals { randomNormals(vertexCount) };
+    auto const indices { randomIndices(vertexCount, vertexCount) };
+
+    for (bool const deflate : { false, true }) {
+        SECTION(deflate ? "deflate" : "no entropy stage")
+        {
+            auto const pBlock { codec::encodePositions(positions, deflate) };
+            auto const h { codec::header(pBlock) };
+            REQUIRE(h.chunkCount == 2);
+            auto const pDecoded { decodeAll<glm::vec3>(pBlock, codec::decodePositions) };
+            REQUIRE(pDecoded.size() == positions.size());
+
+            // half a quantization step per axis, plus float rounding of the reconstruction
+            auto const bound { h.quantizationScale * .5f + glm::vec3(1e-4f) };
+            for (size_t i = 0; i < positions.size(); ++i) {
+                auto const err { glm::abs(pDecoded[i] - positions[i]) };
+                REQUIRE(err.x <= bound.x);
+                REQUIRE(err.y <= bound.y);
+                REQUIRE(err.z <= bound.z);
+            }
+
+            auto const nDecoded { decodeAll<glm::vec3>(codec::encodeNormals(normals, deflate), codec::decodeNormals) };
+            REQUIRE(nDecoded.size() == normals.size());
+            for (size_t i = 0; i < normals.size(); ++i) {
+                REQUIRE(std::abs(glm::length(nDecoded[i]) - 1.f) < 1e-5f);
+                // snorm16 octahedral encoding keeps the angular error below 1e-4 rad
+                REQUIRE(glm::length(nDecoded[i] - normals[i]) < 1e-4f);
+            }
+
+            auto const iBlock { codec::encodeIndices(indices, deflate) };
+            REQUIRE(iBlock.size() < indices.size() * sizeof(u32));
+            REQUIRE(decodeAll<u32>(iBlock, codec::decodeIndices) == indices);
+        }
+    }
+
+    SECTION("empty streams")
+    {
+        REQUIRE(codec::header(codec::encodePositions({}, true)).chunkCount == 0);
+        REQUIRE(codec::header(codec::encodeIndices({}, true)).elementCount == 0);
+    }
+}
+
+TEST_CASE("Corrupted stream blocks are rejected", "[codec]")
+{
+    auto const block { codec::encodeIndices(randomIndices(100'000, 1000), false) };
+    REQUIRE(codec::header(block).chunkCount == 2);
+    REQUIRE(codec::valid(block));
+    REQUIRE_FALSE(codec::valid(std::span { block }.first(sizeof(codec::StreamHeader) - 1)));
+    REQUIRE_FALSE(codec::valid(std::span { block }.first(sizeof(codec::StreamHeader) + sizeof(codec::ChunkEntry))));
+    REQUIRE_FALSE(codec::valid(std::span { block }.first(block.size() - 1)));
+
+    auto const patched { [&](size_t offset, auto value) {
+        auto data { block };
+        memcpy(data.data() + offset, &value, sizeof(value));
+        return codec::valid(data);
+    } };
+    // header: element count, chunk count, chunk elements; chunk table: offset, encoded size, raw size
+    REQUIRE_FALSE(patched(4, u32 { 3 }));
+    REQUIRE_FALSE(patched(4, ~u32 { 0 }));
+    REQUIRE_FALSE(patched(8, u32 { 0 }));
+    REQUIRE_FALSE(patched(sizeof(codec::StreamHeader), ~u64 { 0 }));
+    REQUIRE_FALSE(patched(sizeof(codec::StreamHeader) + 8, ~u32 { 0 }));
+
+    // the raw size is bounded by the chunk elements before the chunk is inflated
+    auto const pBlock { codec::encodePositions(randomPositions(1000, 10.f), false) };
+    std::vector<glm::vec3> out(1000);
+    auto const decodedWithRawSize { [&](u32 rawSize) {
+        auto data { pBlock };
+        memcpy(data.data() + sizeof(codec::StreamHeader) + 12, &rawSize, sizeof(rawSize));
+        return codec::valid(data) && codec::decodePositions(data, 0, out);
+    } };
+    REQUIRE(decodedWithRawSize(1000 * 3 * sizeof(u16)));
+    REQUIRE_FALSE(decodedWithRawSize(~u32 { 0 }));
+    REQUIRE_FALSE(decodedWithRawSize(1000 * 3 * sizeof(u16) + 2));
+    REQUIRE_FALSE(decodedWithRawSize(10));
+}
+
+// a raw chunk behind a deflated one of odd size starts at an odd offset
+TEST_CASE("Misaligned chunks decode", "[codec]")
+{
+    auto const positions { randomPositions(1000, 10.f) };
+    auto const normals { randomNormals(1000) };
+    auto const misaligned { [](std::vector<std::byte> block) {
+        codec::ChunkEntry chunk;
+        memcpy(&chunk, block.data() + sizeof(codec::StreamHeader), sizeof(chunk));
+        block.insert(block.begin() + static_cast<std::ptrdiff_t>(chunk.offset), std::byte { 0 });
+        ++chunk.offset;
+        memcpy(block.data() + sizeof(codec::StreamHeader), &chunk, sizeof(chunk));
+        return block;
+    } };
+
+    auto const pExpected { decodeAll<glm::vec3>(codec::encodePositions(positions, false), codec::decodePositions) };
+    auto const pBlock { misaligned(codec::encodePositions(positions, false)) };
+    REQUIRE(codec::valid(pBlock));
+    REQUIRE(decodeAll<glm::vec3>(pBlock, codec::decodePositions) == pExpected);
+
+    auto const nExpected { decodeAll<glm::vec3>(codec::encodeNormals(normals, false), codec::decodeNormals) };
+    auto const nBlock { misaligned(codec::encodeNormals(normals, false)) };
+    REQUIRE(codec::valid(nBlock));
+    REQUIRE(decodeAll<glm::vec3>(nBlock, codec::decodeNormals) == nExpected);
+}
+
+TEST_CASE("Encoded scene round trip", "[codec][serialization]")
+{
+    Scene scene;
+    scene.path = "codec_round_trip.fbx";
+    scene.nodes.resize(1);
+    scene.nodes[0].id = 0;
+    scene.nodes[0].geometry = { 0 };
+
+    auto& g { scene.geometries.emplace_back() };
+    g.id = 0;
+    g.vertices = randomPositions(1000, 10.f);
+    g.normals = randomNormals(1000);
+    g.indices = randomIndices(500, 1000);
+    scene.triangleCount = 500;
+
+    auto const dir { std::filesystem::temp_directory_path() };
+    serialize(scene, dir, codec::Encoding::eAll);
+
+    Scene const loaded { deserialize(dir / "codec_round_trip.ob") };
+    REQUIRE(loaded.geometries.size() == 1);
+    auto const& l { loaded.geometries[0] };
+    REQUIRE(l.Vertices().size() == g.vertices.size());
+    REQUIRE(l.Normals().size() == g.normals.size());
+    REQUIRE(std::ranges::equal(l.Indices(), g.indices));
+    for (size_t i = 0; i < g.vertices.size(); ++i)
+        REQUIRE(glm::length(l.Vertices()[i] - g.vertices[i]) < 1e-3f);
+
+    std::filesystem::remove(dir / "codec_round_trip.ob");
+}
+
+// the normal blocks of the geometries differ in size, a geometry must not take the normals of the next one
+TEST_CASE("Scenes with normal-less geometries round trip", "[codec][serialization]")
+{
+    Scene scene;
+    scene.path = "no_normals.fbx";
+    scene.nodes.resize(1);
+    scene.nodes[0].id = 0;
+    scene.nodes[0].geometry = { 0, 1 };
+
+    for (u32 i = 0; i < 2; ++i) {
+        auto& g { scene.geometries.emplace_back() };
+        g.id = i;
+        g.vertices = randomPositions(1000, 10.f);
+        g.indices = randomIndices(500, 1000);
+    }
+    scene.geometries[1].normals = randomNormals(1000);
+    scene.triangleCount = 1000;
+
+    auto const dir { std::filesystem::temp_directory_path() };
+    for (auto const encoding : { codec::Encoding::eNone, codec::Encoding::eAll }) {
+        serialize(scene, dir, encoding);
+        Scene const loaded { deserialize(dir / "no_normals.ob") };
+        REQUIRE(loaded.geometries.size() == 2);
+        REQUIRE(loaded.geometries[0].Vertices().size() == 1000);
+        REQUIRE(loaded.geometries[0].Normals().empty());
+        REQUIRE(loaded.geometries[1].Normals().size() == 1000);
+        REQUIRE(std::ranges::equal(loaded.geometries[1].Indices(), scene.geometries[1].indices));
+    }
+
+    std::filesystem::remove(dir / "no_normals.ob");
+}
+
+static std::vector<char> readFile(std::filesystem::path const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(in), {} };
+}
+
+static void writeFile(std::filesystem::path const& path, std::vector<char> const& data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+TEST_CASE("Corrupted scene files are rejected", "[serialization]")
+{
+    Scene scene;
+    scene.path = "corrupted.fbx";
+    scene.nodes.resize(1);
+    scene.nodes[0].id = 0;
+    scene.nodes[0].geometry = { 0 };
+
+    auto& g { scene.geometries.emplace_back() };
+    g.id = 0;
+    g.vertices = randomPositions(1000, 10.f);
+    g.normals = randomNormals(1000);
+    g.indices = randomIndices(500, 1000);
+    scene.triangleCount = 500;
+
+    auto const path { std::filesystem::temp_directory_path() / "corrupted.ob" };
+    serialize(scene, path.parent_path(), codec::Encoding::eNone);
+    auto const original { readFile(path) };
+    REQUIRE(deserialize(path).geometries.size() == 1);
+
+    auto const patched { [&](size_t offset, u64 value, size_t size = sizeof(u64)) {
+        auto data { original };
+        memcpy(data.data() + offset, &value, size);
+        writeFile(path, data);
+        return deserialize(path).geometries.size();
+    } };
+    // header: magic, version, section count, triangle count, aabb, node count, geometry count
+    REQUIRE(patched(40, 1'000'000) == 0);
+    REQUIRE(patched(48, 2) == 0);
+    REQUIRE(patched(48, u64 { 1 } << 60) == 0);
+    // section table after the 56 B header: type, padding, offset, size of nodes, geometries, vertices, normals, indices
+    REQUIRE(patched(56 + 2 * 24 + 8, original.size() + 1) == 0);
+    REQUIRE(patched(56 + 2 * 24 + 16, ~u64 { 0 }) == 0);
+
+    u64 geometriesOffset;
+    memcpy(&geometriesOffset, original.data() + 56 + 24 + 8, sizeof(u64));
+    // geometry record: id, vertex, normal and index counts, area, ratio, aabb, encoding, padding, vertex, normal and index offsets
+    REQUIRE(patched(geometriesOffset + 4, 2000, sizeof(u32)) == 0);
+    REQUIRE(patched(geometriesOffset + 8, 2000, sizeof(u32)) == 0);
+    REQUIRE(patched(geometriesOffset + 56, original.size() - 4) == 0);
+    REQUIRE(patched(geometriesOffset + 72, ~u64 { 0 }) == 0);
+
+    SECTION("encoded")
+    {
+        serialize(scene, path.parent_path(), codec::Encoding::eAll);
+        auto const encoded { readFile(path) };
+        REQUIRE(deserialize(path).geometries.size() == 1);
+
+        u64 indicesOffset;
+        memcpy(&indicesOffset, encoded.data() + 56 + 4 * 24 + 8, sizeof(u64));
+        auto const patchedEncoded { [&](size_t offset, u64 value, size_t size = sizeof(u64)) {
+            auto data { encoded };
+            memcpy(data.data() + offset, &value, size);
+            writeFile(path, data);
+            return deserialize(path).geometries.size();
+        } };
+        REQUIRE(patchedEncoded(geometriesOffset + 72, encoded.size() + 64) == 0);
+        REQUIRE(patchedEncoded(geometriesOffset + 72, ~u64 { 0 } - 63) == 0);
+        // the index block starts the section: element count, chunk count, ...
+        REQUIRE(patchedEncoded(indicesOffset + 4, 1000, sizeof(u32)) == 0);
+        REQUIRE(patchedEncoded(indicesOffset + sizeof(codec::StreamHeader), u64 { 1 } << 40) == 0);
+    }
+
+    // the file ends with less than 64 B of padding
+    SECTION("truncated")
+    {
+        for (auto const size : { size_t { 60 }, size_t { 100 }, original.size() - 64 }) {
+            writeFile(path, { original.begin(), original.begin() + static_cast<std::ptrdiff_t>(size) });
+            REQUIRE(deserialize(path).geometries.empty());
+        }
+    }
+
+    std::filesystem::remove(path);
+}
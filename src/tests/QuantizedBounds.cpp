@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "backend/cpu/bvh/Compressed.h"
+#include "backend/cpu/bvh/Quantized.h"
+#include <random>
+
+using namespace backend::cpu;
+using namespace backend::cpu::bvh;
+
+// children of one node, far from the origin and close to it, from point sized to scene sized
+template<typename Dist>
+static bv::Aabb randomAabb(std::mt19937& gen, Dist& dist, glm::vec3 const& center, f32 size)
+{
+    glm::vec3 const p { center + size * glm::vec3 { dist(gen), dist(gen), dist(gen) } };
+    bv::Aabb result { p, p };
+    for (u32 i = 0; i < 3; ++i)
+        bv::bvFit(result, center + size * glm::vec3 { dist(gen), dist(gen), dist(gen) });
+    return result;
+}
+
+template<typename Dist>
+static bv::Dop14 randomDop14(std::mt19937& gen, Dist& dist, glm::vec3 const& center, f32 size)
+{
+    auto result { bv::dopInit(center + size * glm::vec3 { dist(gen), dist(gen), dist(gen) }) };
+    for (u32 i = 0; i < 3; ++i)
+        bv::bvFit(result, center + size * glm::vec3 { dist(gen), dist(gen), dist(gen) });
+    return result;
+}
+
+// every dequantized bound contains the float one, and is at most two quantization steps looser
+template<typename Q, u32 K, typename NodeCompressed>
+static void checkNode(NodeCompressed const& node)
+{
+    NodeBvhBinaryQuantized<Q, K> quantized;
+    quantize(node, quantized);
+    NodeCompressed decoded;
+    dequantizeNode(quantized, decoded);
+
+    for (u32 j = 0; j < 4 * K; ++j) {
+        auto const step { quantizedScale(quantized.exponent[quantizedSlab<K>(j)]) };
+        if (j & 1) {
+            REQUIRE(decoded.bv[j] >= node.bv[j]);
+            REQUIRE(decoded.bv[j] - node.bv[j] <= 2.f * step);
+        } else {
+            REQUIRE(decoded.bv[j] <= node.bv[j]);
+            REQUIRE(node.bv[j] - decoded.bv[j] <= 2.f * step);
+        }
+    }
+    REQUIRE(decoded.c0 == node.c0);
+    REQUIRE(decoded.c1 == node.c1);
+    REQUIRE(decoded.parent == node.parent);
+}
+
+static constexpr f32 CENTERS[] { 0.f, 1e-3f, 3.f, -250.f, 1e5f };
+static constexpr f32 SIZES[] { 0.f, 1e-6f, 1e-2f, 1.f, 1e3f };
+
+TEST_CASE("Quantized AABB children contain the float ones", "[quantized]")
+{
+    std::mt19937 gen { 11 };
+    std::uniform_real_distribution<f32> dist { -1.f, 1.f };
+    for (auto const center : CENTERS) {
+        for (auto const size : SIZES) {
+            for (u32 i = 0; i < 200; ++i) {
+                data_bvh::NodeBvhBinaryCompressed node {};
+                node.c0 = static_cast<i32>(i);
+                node.c1 = encodeLeaf(-3, static_cast<i32>(i));
+                node.parent = static_cast<i32>(i) - 1;
+                glm::vec3 const c { center, -center, .5f * center };
+                setBoxC0(node, randomAabb(gen, dist, c, size));
+                // the small child sits anywhere within the big one
+                setBoxC1(node, randomAabb(gen, dist, c + size * glm::vec3 { dist(gen), dist(gen), dist(gen) }, size * (i % 2 ? 1.f : 1e-3f)));
+
+                checkNode<u8, 3>(node);
+                checkNode<u16, 3>(node);
+            }
+        }
+    }
+}
+
+TEST_CASE("Quantized DOP14 children contain the float ones", "[quantized]")
+{
+    std::mt19937 gen { 13 };
+    std::uniform_real_distribution<f32> dist { -1.f, 1.f };
+    for (auto const center : CENTERS) {
+        for (auto const size : SIZES) {
+            for (u32 i = 0; i < 200; ++i) {
+                data_bvh::NodeBvhBinaryDOP14Compressed node {};
+                node.c0 = static_cast<i32>(i);
+                node.c1 = encodeLeaf(-3, static_cast<i32>(i));
+                glm::vec3 const c { -center, center, .25f * center };
+                setBoxC0(node, randomDop14(gen, dist, c, size));
+                setBoxC1(node, randomDop14(gen, dist, c + size * glm::vec3 { dist(gen), dist(gen), dist(gen) }, size * (i % 2 ? 1.f : 1e-3f)));
+
+                checkNode<u8, 7>(node);
+                checkNode<u16, 7>(node);
+            }
+        }
+    }
+
+    SECTION("dummy DOP14")
+    {
+        data_bvh::NodeBvhBinaryDOP14Compressed node {};
+        setBoxC0(node, bv::dopDummy());
+        setBoxC1(node, bv::dopInit(glm::vec3 { 1.f, 2.f, 3.f }));
+        checkNode<u8, 7>(node);
+        checkNode<u16, 7>(node);
+    }
+}
@@ -0,0 +1,35 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "scene/SceneCache.h"
+#include "scene/Serialization.h"
+
+using namespace scene;
+
+// a failed import must not turn into a cache entry that every later load hits
+TEST_CASE("Only non-empty imports are cached", "[cache]")
+{
+    auto const cacheDir { std::filesystem::temp_directory_path() / "dopbvh_scene_cache" };
+    std::filesystem::remove_all(cacheDir);
+    auto const path { cache::entry(cacheDir, cache::Key { .contentHash = 1 }) };
+
+    REQUIRE_FALSE(cache::store(path, Scene {}));
+    REQUIRE_FALSE(std::filesystem::exists(path));
+
+    Scene scene;
+    scene.nodes.resize(1);
+    scene.nodes[0].id = 0;
+    scene.nodes[0].geometry = { 0 };
+    auto& g { scene.geometries.emplace_back() };
+    g.id = 0;
+    g.vertices = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f } };
+    g.indices = { 0, 1, 2 };
+    scene.triangleCount = 1;
+
+    REQUIRE(cache::store(path, scene));
+    auto const loaded { deserialize(path) };
+    REQUIRE(loaded.nodes.size() == 1);
+    REQUIRE(loaded.geometries.size() == 1);
+    REQUIRE(loaded.geometries[0].Indices().size() == 3);
+
+    std::filesystem::remove_all(cacheDir);
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "backend/cpu/Builder.h"
+#include "backend/cpu/bvh/Tracer.h"
+#include "scene/Scene.h"
+#include <berries/lib_helper/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace backend;
+
+// nested triangles facing -x, each one larger than all before it, so PLOC++ merges the next triangle into the cluster of the smaller ones
+static Scene caterpillarScene(u32 triangleCount)
+{
+    Scene scene;
+    auto& g { scene.geometries.emplace_back() };
+    for (u32 i = 0; i < triangleCount; ++i) {
+        auto const x { 1.f + 1e-3f * static_cast<f32>(i) };
+        auto const s { std::pow(1.07f, static_cast<f32>(i)) };
+        for (glm::vec3 const v : { glm::vec3 { x, -s, -s }, glm::vec3 { x, s, -s }, glm::vec3 { x, 0.f, s } }) {
+            g.indices.push_back(static_cast<u32>(g.vertices.size()));
+            scene.aabb.Fit(g.vertices.emplace_back(v));
+        }
+    }
+    scene.triangleCount = triangleCount;
+    return scene;
+}
+
+static u32 depth(cpu::bvh::Bvh const& bvh)
+{
+    auto const nodes { bvh.Nodes<data_bvh::NodeBvhBinaryCompressed>() };
+    u32 result { 0 };
+    std::vector<std::pair<i32, u32>> stack { { 0, 1 } };
+    while (!stack.empty()) {
+        auto const [nodeId, d] { stack.back() };
+        stack.pop_back();
+        result = std::max(result, d);
+        if (nodeId < 0)
+            continue;
+        stack.emplace_back(nodes[nodeId].c0, d + 1);
+        stack.emplace_back(nodes[nodeId].c1, d + 1);
+    }
+    return result;
+}
+
+// rays along the x axis hit every node, the far children are pushed at every level
+//   the binary tree is deeper than the stack of the 8-wide traversal
+TEST_CASE("Traversal of a tree deeper than the stack", "[traversal]")
+{
+    berry::Log::Init();
+    Executor executor { 2 };
+    auto const scene { caterpillarScene(600) };
+
+    config::BVHPipeline pipeline;
+    pipeline.plocpp.bv = config::BV::eAABB;
+    pipeline.collapsing.bv = config::BV::eAABB;
+    pipeline.compression.bv = config::BV::eAABB;
+    cpu::Builder builder { executor };
+    builder.SetPipelineConfiguration(pipeline);
+    REQUIRE(builder.Build(scene));
+    REQUIRE(depth(builder.GetBVH()) > 8 * cpu::bvh::traversal::STACK_SIZE);
+
+    std::vector<data_bvh::Ray> rays;
+    for (u32 i = 0; i < 64; ++i) {
+        auto const offset { 1e-3f * static_cast<f32>(i % 8) };
+        rays.push_back({ { 0.f, offset, -offset, 0.f }, { 1.f, 0.f, 0.f, 1e30f } });
+    }
+    std::vector<data_bvh::RayTraceResult> results(rays.size());
+
+    cpu::bvh::Tracer tracer { executor };
+    auto const requireClosestHits { [&] {
+        std::ranges::fill(results, data_bvh::RayTraceResult {});
+        static_cast<void>(tracer.TraceRays(builder.GetBVH(), rays, results));
+        for (auto const& r : results) {
+            REQUIRE(r.primitiveId == 0);
+            REQUIRE(std::abs(r.t - 1.f) < 1e-4f);
+        }
+    } };
+
+    for (auto const mode : { cpu::bvh::Tracer::Mode::eSingleRay, cpu::bvh::Tracer::Mode::ePacket, cpu::bvh::Tracer::Mode::eStream }) {
+        tracer.mode = mode;
+        requireClosestHits();
+    }
+
+    // the wide layouts are traced one ray at a time
+    for (auto const layout : { config::CompressedLayout::eWide4, config::CompressedLayout::eWide8 }) {
+        pipeline.compression.layout = layout;
+        builder.SetPipelineConfiguration(pipeline);
+        REQUIRE(builder.Build(scene));
+        requireClosestHits();
+    }
+}